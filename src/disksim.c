@@ -43,6 +43,9 @@
  * holders.
  */
 
+#include <sys/time.h>
+#include <sys/stat.h>
+
 #include "disksim_global.h"
 #include "disksim_ioface.h"
 #include "disksim_pfface.h"
@@ -56,6 +59,10 @@ extern void iotrace_set_format();
 
 extern int closedios;
 extern double closedthinktime;
+extern int iotrace_records;
+extern int synthio_iocnt;
+extern int synthio_endiocnt;
+extern double synthio_endtime;
 
 int endian = _LITTLE_ENDIAN;
 int traceformat = ASCII;
@@ -76,6 +83,7 @@ event *intq = NULL;
 event *extraq = NULL;
 int intqlen = 0;
 int extraqlen = 0;
+int extraqtotal = 0;
 
 double simtime = 0.0;
 int stop_sim = FALSE;
@@ -86,6 +94,21 @@ int warmup_iocnt = 0;
 double warmuptime = 0.0;
 timer_event *warmup_event = NULL;
 
+/* Progress heartbeat.  When heartbeat_interval (wall-clock seconds) is  */
+/* non-zero, the main loop counts down HEARTBEAT_CHECK events at a time  */
+/* and only then reads the wall clock, so a disabled heartbeat costs a   */
+/* single compare per event.                                              */
+
+#define HEARTBEAT_CHECK		1024
+
+double heartbeat_interval = 0.0;
+int heartbeat_countdown = 0;
+double heartbeat_events = 0.0;
+double heartbeat_lastevents = 0.0;
+double heartbeat_wallstart = 0.0;
+double heartbeat_walllast = 0.0;
+double heartbeat_tracesize = 0.0;
+
 
 void allocateextra()
 {
@@ -103,6 +126,7 @@ void allocateextra()
    temp[((ALLOCSIZE/DISKSIM_EVENT_SIZE)-1)].next = NULL;
    extraq = temp;
    extraqlen = ALLOCSIZE / DISKSIM_EVENT_SIZE;
+   extraqtotal += ALLOCSIZE / DISKSIM_EVENT_SIZE;
 }
 
 
@@ -187,6 +211,7 @@ event *temp;
       exit(0);
    }
 
+   intqlen++;
    if (intq == NULL) {
       intq = temp;
       temp->next = NULL;
@@ -223,6 +248,7 @@ event * getfromintq()
    }
    temp = intq;
    intq = intq->next;
+   intqlen--;
    if (intq != NULL) {
       intq->prev = NULL;
    }
@@ -247,6 +273,7 @@ event *curr;
    if (tmp == NULL) {
       return(FALSE);
    }
+   intqlen--;
    if (curr->next != NULL) {
       curr->next->prev = curr->prev;
    }
@@ -303,6 +330,29 @@ int parmaxval;
 }
 
 
+void getparam_lbn(parfile, parname, parptr, parchecks, parminval, parmaxval)
+FILE *parfile;
+char *parname;
+lbn_t *parptr;
+int parchecks;
+lbn_t parminval;
+lbn_t parmaxval;
+{
+   char line[201];
+
+   sprintf(line, "%s: %s\n", parname, "%lld");
+   if (fscanf(parfile, line, parptr) != 1) {
+      fprintf(stderr, "Error reading '%s'\n", parname);
+      exit(0);
+   }
+   if (((parchecks & 1) && (*parptr < parminval)) || ((parchecks & 2) && (*parptr > parmaxval))) {
+      fprintf(stderr, "Invalid value for '%s': %lld\n", parname, *parptr);
+      exit(0);
+   }
+   fprintf (outputfile, "%s: %lld\n", parname, *parptr);
+}
+
+
 void getparam_double(parfile, parname, parptr, parchecks, parminval, parmaxval)
 FILE *parfile;
 char *parname;
@@ -478,6 +528,26 @@ FILE *parfile;
 }
 
 
+void disksim_param_override(paramname, paramval)
+char *paramname;
+char *paramval;
+{
+   if (strcmp(paramname, "heartbeat") == 0) {
+      if (sscanf(paramval, "%lf", &heartbeat_interval) != 1) {
+         fprintf(stderr, "Error reading heartbeat interval\n");
+         exit(0);
+      }
+      if (heartbeat_interval < 0.0) {
+         fprintf(stderr, "Invalid value for heartbeat interval - %f\n", heartbeat_interval);
+         exit(0);
+      }
+   } else {
+      fprintf(stderr, "Unsupported param to override at disksim_param_override: %s\n", paramname);
+      exit(0);
+   }
+}
+
+
 void doparamoverrides(overrides, overcnt)
 char **overrides;
 int overcnt;
@@ -506,6 +576,8 @@ int overcnt;
 	 io_param_override(CONTROLLER, overrides[(i+2)], overrides[(i+3)], first, last);
       } else if (strcmp(overrides[i], "bus") == 0) {
 	 io_param_override(BUS, overrides[(i+2)], overrides[(i+3)], first, last);
+      } else if (strcmp(overrides[i], "disksim") == 0) {
+	 disksim_param_override(overrides[(i+2)], overrides[(i+3)]);
       } else {
 	 fprintf(stderr, "Structure with parameter to override not supported: %s\n", overrides[i]);
 	 exit(0);
@@ -611,6 +683,98 @@ event * getnextevent()
 }
 
 
+double heartbeat_wallclock()
+{
+   struct timeval now;
+
+   gettimeofday(&now, NULL);
+   return((double) now.tv_sec + ((double) now.tv_usec / (double) 1000000.0));
+}
+
+
+void heartbeat_initialize()
+{
+   struct stat tracestat;
+
+   heartbeat_wallstart = heartbeat_wallclock();
+   heartbeat_walllast = heartbeat_wallstart;
+   heartbeat_countdown = HEARTBEAT_CHECK;
+   heartbeat_events = 0.0;
+   heartbeat_lastevents = 0.0;
+   heartbeat_tracesize = 0.0;
+   if ((iotrace) && (fstat(fileno(iotracefile), &tracestat) == 0) && (S_ISREG(tracestat.st_mode))) {
+      heartbeat_tracesize = (double) tracestat.st_size;
+   }
+}
+
+
+/* Estimates the fraction of the run completed so far, or returns a     */
+/* negative value when there is nothing to estimate it from (e.g., a    */
+/* trace read from a pipe).                                             */
+
+double heartbeat_fraction_done(tracepos)
+double tracepos;
+{
+   double done = -1.0;
+
+   if ((iotrace) && (heartbeat_tracesize > 0.0) && (tracepos >= 0.0)) {
+      done = tracepos / heartbeat_tracesize;
+   } else if (synthgen) {
+      if (synthio_endtime > 0.0) {
+         done = simtime / synthio_endtime;
+      }
+      if ((synthio_endiocnt > 0) && (((double) synthio_iocnt / (double) synthio_endiocnt) > done)) {
+         done = (double) synthio_iocnt / (double) synthio_endiocnt;
+      }
+   }
+   return((done > 1.0) ? 1.0 : done);
+}
+
+
+void heartbeat_report(final)
+int final;
+{
+   double now = heartbeat_wallclock();
+   double elapsed = now - heartbeat_wallstart;
+   double rate = 0.0;
+   double tracepos = -1.0;
+   double done;
+
+   if (now > heartbeat_walllast) {
+      rate = (heartbeat_events - heartbeat_lastevents) / (now - heartbeat_walllast);
+   }
+   fprintf(stderr, "heartbeat%s: wall %.1fs, simtime %.3f ms, events %.0f (%.0f/s)", ((final) ? " (done)" : ""), elapsed, simtime, heartbeat_events, rate);
+   if (simtime > 0.0) {
+      fprintf(stderr, ", wall/sim %.4f", (elapsed / (simtime / (double) 1000.0)));
+   }
+   fprintf(stderr, ", intq %d, events in use %d/%d (%d KB)", intqlen, (extraqtotal - extraqlen), extraqtotal, ((extraqtotal * DISKSIM_EVENT_SIZE) / 1024));
+   if (iotrace) {
+      tracepos = (double) ftell(iotracefile);
+      fprintf(stderr, ", trace %d records", iotrace_records);
+      if (tracepos >= 0.0) {
+         fprintf(stderr, " (%.0f KB)", (tracepos / (double) 1024.0));
+      }
+   }
+   done = heartbeat_fraction_done(tracepos);
+   if ((!final) && (done > 0.0)) {
+      fprintf(stderr, ", %.1f%% done, ETA %.1fs", (done * (double) 100.0), (elapsed * ((double) 1.0 - done) / done));
+   }
+   fprintf(stderr, "\n");
+   heartbeat_walllast = now;
+   heartbeat_lastevents = heartbeat_events;
+}
+
+
+void heartbeat_check()
+{
+   heartbeat_countdown = HEARTBEAT_CHECK;
+   heartbeat_events += (double) HEARTBEAT_CHECK;
+   if ((heartbeat_wallclock() - heartbeat_walllast) >= heartbeat_interval) {
+      heartbeat_report(FALSE);
+   }
+}
+
+
 void simstop()
 {
    stop_sim = TRUE;
@@ -763,8 +927,20 @@ fflush(outputfile);
       return;
    }
 
-   while (stop_sim == FALSE) {
-      disksim_simulate_event();
+   if (heartbeat_interval > 0.0) {
+      heartbeat_initialize();
+      while (stop_sim == FALSE) {
+         disksim_simulate_event();
+         if (--heartbeat_countdown == 0) {
+            heartbeat_check();
+         }
+      }
+      heartbeat_events += (double) (HEARTBEAT_CHECK - heartbeat_countdown);
+      heartbeat_report(TRUE);
+   } else {
+      while (stop_sim == FALSE) {
+         disksim_simulate_event();
+      }
    }
 fprintf(outputfile, "Simulation complete\n");
 fflush(outputfile);
@@ -46,6 +46,7 @@
 #include "disksim_global.h"
 #include "disksim_iosim.h"
 #include "disksim_bus.h"
+#include "disksim_timeline.h"
 
 int numbuses = 0;
 bus *buses = NULL;
@@ -194,6 +195,9 @@ ioreq_event *curr;
    tmp->devtype = devtype;
    tmp->delayed_event = curr;
    addtointq((event *) tmp);
+   if (TIMELINE_ON) {
+      timeline_span(((devtype == DISK) ? TIMELINE_DISK : TIMELINE_CONTROLLER), devno, "overhead", simtime, tmp->time, timeline_sampled(curr));
+   }
 }
 
 
@@ -204,6 +208,11 @@ bus_event *curr;
       ASSERT(curr == buses[curr->busno].arbwinner);
       buses[curr->busno].arbwinner = NULL;
       stat_update (&buses[curr->busno].arbwaitstats, (simtime - curr->wait_start));
+      if (TIMELINE_ON) {
+         buses[curr->busno].ownedstart = simtime;
+         buses[curr->busno].ownerreqid = timeline_sampled(curr->delayed_event);
+         timeline_span(((curr->devtype == DISK) ? TIMELINE_DISK : TIMELINE_CONTROLLER), curr->devno, "bus wait", curr->wait_start, simtime, buses[curr->busno].ownerreqid);
+      }
    }
    switch (curr->devtype) {
 
@@ -348,6 +357,10 @@ int busno;
 fprintf (outputfile, "Bus ownership being released - %d\n", busno);
 */
    ASSERT(buses[busno].arbwinner == NULL);
+   if ((TIMELINE_ON) && (buses[busno].ownerreqid)) {
+      timeline_span(TIMELINE_BUS, busno, "owned", buses[busno].ownedstart, simtime, buses[busno].ownerreqid);
+      buses[busno].ownerreqid = 0;
+   }
    if (buses[busno].owners == NULL) {
 /*
 fprintf (outputfile, "Bus has become free - %d\n", busno);
@@ -702,6 +715,7 @@ void bus_initialize()
    StaticAssert (sizeof(bus_event) <= DISKSIM_EVENT_SIZE);
    for (i=0; i<numbuses; i++) {
       buses[i].state = BUS_FREE;
+      buses[i].ownerreqid = 0;
       addlisttoextraq((event *) &buses[i].owners);
       stat_initialize (statdeffile, statdesc_arbwaitstats, &buses[i].arbwaitstats);
       stat_initialize (statdeffile, statdesc_busidlestats, &buses[i].busidlestats);
@@ -99,6 +99,8 @@ typedef struct {
    int          numslots;
    slot        *slots;
    double	lastowned;
+   double	ownedstart;    /* for the timeline: start of current tenure */
+   int		ownerreqid;
    double	runidletime;
    statgen	arbwaitstats;
    statgen	busidlestats;
@@ -136,8 +136,8 @@ typedef struct cacheatom {
    struct cacheatom *hash_prev;
    struct cacheatom *line_next;
    struct cacheatom *line_prev;
+   lbn_t lbn;
    int devno;
-   int lbn;
    int state;
    struct cacheatom *lru_next;
    struct cacheatom *lru_prev;
@@ -157,14 +157,14 @@ typedef struct cacheevent {
    void *doneparam;		/* parameter for donefunc */
    int flags;
    ioreq_event *req;
-   int accblkno;		/* start blkno of waited for ioacc */
+   lbn_t accblkno;		/* start blkno of waited for ioacc */
    cache_atom *cleaned;
    cache_atom *lineprev;
    int locktype;
-   int lockstop;
-   int allocstop;
+   lbn_t lockstop;
+   lbn_t allocstop;
    struct cacheevent *waitees;
-   int validpoint;
+   lbn_t validpoint;
 } cache_event;
 
 typedef struct {
@@ -270,16 +270,16 @@ ioreq_event *req;
 
 int cache_concatok(cache, blkno1, bcount1, blkno2, bcount2)
 cache_def *cache;
-int blkno1;
+lbn_t blkno1;
 int bcount1;
-int blkno2;
+lbn_t blkno2;
 int bcount2;
 {
    if ((cache->size) && (cache->maxscatgath != 0)) {
       int linesize = max(cache->linesize, 1);
-      int lineno1 = blkno1 / linesize;
-      int lineno2 = (blkno2 + bcount2 - 1) / linesize;
-      int scatgathcnt = lineno2 - lineno1;
+      lbn_t lineno1 = blkno1 / linesize;
+      lbn_t lineno2 = (blkno2 + bcount2 - 1) / linesize;
+      lbn_t scatgathcnt = lineno2 - lineno1;
       if (scatgathcnt > cache->maxscatgath) {
 	 return(0);
       }
@@ -360,7 +360,7 @@ cache_def *cache;
 cache_atom * cache_find_atom(cache, devno, lbn)
 cache_def *cache;
 int devno;
-int lbn;
+lbn_t lbn;
 {
    cache_atom *tmp = cache->hash[(lbn & CACHE_HASHMASK)];
 /*
@@ -376,7 +376,7 @@ fprintf (outputfile, "Entered cache_find_atom: devno %d, lbn %d, CACHE_HASHMASK
 void cache_remove_lbn_from_hash(cache, devno, lbn)
 cache_def *cache;
 int devno;
-int lbn;
+lbn_t lbn;
 {
    cache_atom *tmp;
 
@@ -389,7 +389,7 @@ int lbn;
 void cache_check_for_residence(cache, devno, lbn, size, miss)
 cache_def *cache;
 int devno;
-int lbn; 
+lbn_t lbn;
 int size;
 int *miss;
 {
@@ -415,7 +415,7 @@ int *miss;
 void cache_set_state(cache, devno, lbn, size, mask)
 cache_def *cache;
 int devno;
-int lbn;
+lbn_t lbn;
 int size;
 int mask;
 {
@@ -440,7 +440,7 @@ int mask;
 void cache_reset_state(cache, devno, lbn, size, mask)
 cache_def *cache;
 int devno;
-int lbn;
+lbn_t lbn;
 int size;
 int mask;
 {
@@ -530,7 +530,7 @@ cache_atom *line;
    while (line->line_prev) {
       line = line->line_prev;
    }
-   set = (cache->mapmask) ? (line->lbn % cache->mapmask) : 0;
+   set = (cache->mapmask) ? (int) (line->lbn % cache->mapmask) : 0;
    if (line->lru_next) {
       segnum = line->state & CACHE_SEGNUM;
       cache_remove_from_lrulist(&cache->map[set], line, segnum);
@@ -753,14 +753,14 @@ cache_event *rwdesc;
 {
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_get_write_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "Entered cache_get_write_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    while (target->lbn % cache->lockgran) {
       target = target->line_prev;
    }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "doing cache_get_write_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "doing cache_get_write_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    if (target->writelock == rwdesc->req) {
       return(cache->lockgran);
@@ -782,14 +782,14 @@ ioreq_event *owner;
 {
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_free_write_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "Entered cache_free_write_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    while (target->lbn % cache->lockgran) {
       target = target->line_prev;
    }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "doing cache_free_write_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "doing cache_free_write_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    if (owner == target->writelock) {
       target->writelock = NULL;
@@ -808,7 +808,7 @@ cache_event *rwdesc;
 {
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_get_read_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "Entered cache_get_read_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    if (!cache->sharedreadlocks) {
       return(cache_get_write_lock(cache, target, rwdesc));
@@ -818,7 +818,7 @@ fprintf (outputfile, "Entered cache_get_read_lock: target %p, lbn %d, lockgran %
    }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "doing cache_get_read_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "doing cache_get_read_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    if ((target->writelock) && (target->writelock != rwdesc->req)) {
       rwdesc->locktype = 0;
@@ -845,14 +845,14 @@ ioreq_event *owner;
    int i;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_free_read_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "Entered cache_free_read_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    if (!cache->sharedreadlocks) {
       return(cache_free_write_lock(cache, target, owner));
    }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "doing cache_free_read_lock: target %p, lbn %d, lockgran %d\n", target, target->lbn, cache->lockgran);
+fprintf (outputfile, "doing cache_free_read_lock: target %p, lbn %lld, lockgran %d\n", target, target->lbn, cache->lockgran);
 
    while (target->lbn % cache->lockgran) {
       target = target->line_prev;
@@ -889,14 +889,14 @@ fprintf (outputfile, "doing cache_free_read_lock: target %p, lbn %d, lockgran %d
 
 void cache_get_read_lock_range(cache, start, end, startatom, waiter)
 cache_def *cache;
-int start;
-int end;
+lbn_t start;
+lbn_t end;
 cache_atom *startatom;
 cache_event *waiter;
 {
    cache_atom *line = (startatom->lbn == start) ? startatom : NULL;
    int lockgran = 1;
-   int i;
+   lbn_t i;
 
    for (i=start; i<=end; i++) {
       if (line == NULL) {
@@ -915,8 +915,8 @@ cache_event *waiter;
 
 int cache_issue_flushreq(cache, start, end, startatom, waiter)
 cache_def *cache;
-int start;
-int end;
+lbn_t start;
+lbn_t end;
 cache_atom *startatom;
 cache_event *waiter;
 {
@@ -925,22 +925,26 @@ cache_event *waiter;
    int waiting = (cache->IOwaiters == waiter) ? 1 : 0;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered issue_flushreq: start %d, end %d\n", start, end);
+fprintf (outputfile, "Entered issue_flushreq: start %lld, end %lld\n", start, end);
 
    flushreq = (ioreq_event *) getfromextraq();
    flushreq->devno = startatom->devno;
    flushreq->blkno = start;
-   flushreq->bcount = end - start + 1;
+   flushreq->bcount = (int) (end - start + 1);
    flushreq->busno = startatom->busno;
    flushreq->slotno = startatom->slotno;
    flushreq->type = IO_ACCESS_ARRIVE;
    flushreq->flags = 0;
+   flushreq->cause = 0;
+   flushreq->flow = 0;
 
    flushwait = (ioreq_event *) getfromextraq();
    flushwait->type = IO_REQUEST_ARRIVE;
    flushwait->devno = flushreq->devno;
    flushwait->blkno = flushreq->blkno;
    flushwait->bcount = flushreq->bcount;
+   flushwait->cause = 0;
+   flushwait->flow = 0;
    flushwait->next = waiter->req;
    flushwait->prev = NULL;
    if (waiter->req) {
@@ -953,22 +957,22 @@ fprintf (outputfile, "Entered issue_flushreq: start %d, end %d\n", start, end);
    }
    waiter->accblkno = -1;
    cache->stat.destagewrites++;
-   cache->stat.destagewriteatoms += end - start + 1;
+   cache->stat.destagewriteatoms += (int) (end - start + 1);
 
    cache_get_read_lock_range(cache, start, end, startatom, waiter);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Issueing dirty block write-back: blkno %d, bcount %d, devno %d\n", flushreq->blkno, flushreq->bcount, flushreq->devno);
+fprintf (outputfile, "Issueing dirty block write-back: blkno %lld, bcount %d, devno %d\n", flushreq->blkno, flushreq->bcount, flushreq->devno);
 
    cache->issuefunc(cache->issueparam, flushreq);
    return(1);
 }
 
 
-int cache_flush_cluster(cache, devno, blkno, linecnt, dir)
+lbn_t cache_flush_cluster(cache, devno, blkno, linecnt, dir)
 cache_def *cache;
 int devno;
-int blkno;
+lbn_t blkno;
 int linecnt;
 int dir;
 {
@@ -1008,13 +1012,13 @@ cache_atom *dirtyline;
 cache_event *allocdesc;
 {
    cache_atom *dirtyatom;
-   int dirtyend;
-   int dirtystart = -1;
+   lbn_t dirtyend;
+   lbn_t dirtystart = -1;
    cache_atom *tmp = dirtyline;
    int flushcnt = 0;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_initiate_dirty_block_flush: %d\n", dirtyline->lbn);
+fprintf (outputfile, "Entered cache_initiate_dirty_block_flush: %lld\n", dirtyline->lbn);
 
    while (tmp) {
       int writelocked = cache_atom_iswritelocked(cache, tmp);
@@ -1043,7 +1047,7 @@ fprintf (outputfile, "Entered cache_initiate_dirty_block_flush: %d\n", dirtyline
       if ((cache->flush_maxlinecluster > 1) && (dirtystart == dirtyline->lbn)) {
          dirtystart = cache_flush_cluster(cache, dirtyatom->devno, dirtystart, 1, -1);
       }
-      linecnt = 1 + ((dirtyline->lbn - dirtystart) / linesize);
+      linecnt = 1 + (int) ((dirtyline->lbn - dirtystart) / linesize);
       if ((linecnt < cache->flush_maxlinecluster) && (dirtyend == (dirtyline->lbn + linesize -1))) {
 	 dirtyend = cache_flush_cluster(cache, dirtyatom->devno, dirtyend, linecnt, 1);
       }
@@ -1277,15 +1281,15 @@ cache_replace_loop_continue:
 
 int cache_get_free_atom(cache, lbn, ret, allocdesc)
 cache_def *cache;
-int lbn;
+lbn_t lbn;
 cache_atom **ret;
 cache_event *allocdesc;
 {
    int writeouts = 0;
-   int set = (cache->mapmask) ? (lbn % cache->mapmask) : 0;
+   int set = (cache->mapmask) ? (int) (lbn % cache->mapmask) : 0;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_get_free_atom: lbn %d, set %d, freelist %p\n", lbn, set, cache->map[set].freelist);
+fprintf (outputfile, "Entered cache_get_free_atom: lbn %lld, set %d, freelist %p\n", lbn, set, cache->map[set].freelist);
 
    if (cache->map[set].freelist == NULL) {
       writeouts = cache_replace(cache, set, allocdesc);
@@ -1313,14 +1317,14 @@ cache_event *allocdesc;
 */
 
    int devno = allocdesc->req->devno;
-   int lbn = allocdesc->lockstop;
-   int stop = allocdesc->allocstop;
+   lbn_t lbn = allocdesc->lockstop;
+   lbn_t stop = allocdesc->allocstop;
    cache_atom *cleaned = allocdesc->cleaned;
    cache_atom *lineprev = allocdesc->lineprev;
    int linesize = (cache->linesize) ? cache->linesize : 1;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered allocate_space_continue: lbn %d, stop %d\n", lbn, stop);
+fprintf (outputfile, "Entered allocate_space_continue: lbn %lld, stop %lld\n", lbn, stop);
 
    if (allocdesc->waitees) {
       cache_event *rwdesc = allocdesc->waitees;
@@ -1404,7 +1408,7 @@ fprintf (outputfile, "Entered allocate_space_continue: lbn %d, stop %d\n", lbn,
 
 cache_event * cache_allocate_space(cache, lbn, size, rwdesc)
 cache_def *cache;
-int lbn;
+lbn_t lbn;
 int size;
 cache_event *rwdesc;
 {
@@ -1412,7 +1416,7 @@ cache_event *rwdesc;
    int linesize = max(1, cache->linesize);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_allocate_space: lbn %d, size %d, linesize %d\n", lbn, size, cache->linesize);
+fprintf (outputfile, "Entered cache_allocate_space: lbn %lld, size %d, linesize %d\n", lbn, size, cache->linesize);
 
    allocdesc->type = CACHE_EVENT_ALLOCATE;
    allocdesc->req = rwdesc->req;
@@ -1443,11 +1447,11 @@ int stop;
    cache_atom *tmp = line;
    int j = 0;
 
-   int lbn = rwdesc->req->blkno;
+   lbn_t lbn = rwdesc->req->blkno;
    int devno = rwdesc->req->devno;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_get_rw_lock: lbn %d, i %d, stop %d, locktype %d\n", line->lbn, i, stop, locktype);
+fprintf (outputfile, "Entered cache_get_rw_lock: lbn %lld, i %d, stop %d, locktype %d\n", line->lbn, i, stop, locktype);
 
    while (j < stop) {
       if (locktype == 1) {
@@ -1460,7 +1464,7 @@ fprintf (outputfile, "Entered cache_get_rw_lock: lbn %d, i %d, stop %d, locktype
       }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "got lock: lockgran %d, lbn %d\n", lockgran, tmp->lbn);
+fprintf (outputfile, "got lock: lockgran %d, lbn %lld\n", lockgran, tmp->lbn);
 
       if (lockgran == 0) {
          return(1);
@@ -1491,8 +1495,8 @@ fprintf (outputfile, "got lock: lockgran %d, lbn %d\n", lockgran, tmp->lbn);
 
 int cache_issue_fillreq(cache, start, end, rwdesc, prefetchtype)
 cache_def *cache;
-int start;
-int end;
+lbn_t start;
+lbn_t end;
 cache_event *rwdesc;
 int prefetchtype;
 {
@@ -1500,11 +1504,11 @@ int prefetchtype;
    int linesize = max(cache->linesize, 1);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_issue_fillreq: start %d, end %d, prefetchtype %d\n", start, end, prefetchtype);
+fprintf (outputfile, "Entered cache_issue_fillreq: start %lld, end %lld, prefetchtype %d\n", start, end, prefetchtype);
 
    if (prefetchtype & CACHE_PREFETCH_FRONTOFLINE) {
       cache_atom *line = cache_find_atom(cache, rwdesc->req->devno, start);
-      int validstart = -1;
+      lbn_t validstart = -1;
       int lockgran = cache->lockgran;
       while (start % linesize) {
          line = line->line_prev;
@@ -1543,7 +1547,7 @@ fprintf (outputfile, "already valid backwards: lbn %d\n", line->lbn);
    }
    if (prefetchtype & CACHE_PREFETCH_RESTOFLINE) {
       cache_atom *line = cache_find_atom(cache, rwdesc->req->devno, end);
-      int validend = -1;
+      lbn_t validend = -1;
       int lockgran = cache->lockgran;
       while ((end+1) % linesize) {
          line = line->line_next;
@@ -1583,19 +1587,19 @@ fprintf (outputfile, "already valid forwards: lbn %d\n", line->lbn);
 
    fillreq  = (ioreq_event *) event_copy(rwdesc->req);
    fillreq->blkno = start;
-   fillreq->bcount = end - start + 1;
+   fillreq->bcount = (int) (end - start + 1);
    fillreq->type = IO_ACCESS_ARRIVE;
    fillreq->flags |= READ;
-   rwdesc->req->tempint1 = start;
-   rwdesc->req->tempint2 = end;
+   rwdesc->req->tempint1 = (int) (start - rwdesc->req->blkno);
+   rwdesc->req->tempint2 = (int) (end - rwdesc->req->blkno);
    rwdesc->type = (rwdesc->type == CACHE_EVENT_READ) ? CACHE_EVENT_READEXTRA : CACHE_EVENT_WRITEFILLEXTRA;
    cache_waitfor_IO(cache, 1, rwdesc, fillreq);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "%f: Issueing line fill request: blkno %d, bcount %d\n", simtime, fillreq->blkno, fillreq->bcount);
+fprintf (outputfile, "%f: Issueing line fill request: blkno %lld, bcount %d\n", simtime, fillreq->blkno, fillreq->bcount);
 
    cache->issuefunc(cache->issueparam, fillreq);
-   return(end - start + 1);
+   return((int) (end - start + 1));
 }
 
 
@@ -1603,13 +1607,13 @@ void cache_unlock_attached_prefetch(cache, rwdesc)
 cache_def *cache;
 cache_event *rwdesc;
 {
-   int fillstart = rwdesc->req->tempint1;
-   int fillend = rwdesc->req->tempint2 + 1;  /* one beyond, actually */
-   int reqstart = rwdesc->req->blkno;
-   int reqend = reqstart + rwdesc->req->bcount;  /* one beyond, actually */
+   lbn_t reqstart = rwdesc->req->blkno;
+   lbn_t reqend = reqstart + rwdesc->req->bcount;  /* one beyond, actually */
+   lbn_t fillstart = reqstart + rwdesc->req->tempint1;
+   lbn_t fillend = reqstart + rwdesc->req->tempint2 + 1;  /* one beyond, actually */
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_unlock_attached_prefetch: fillstart %d, fillend %d, reqstart %d, reqend %d\n", fillstart, fillend, reqstart, reqend);
+fprintf (outputfile, "Entered cache_unlock_attached_prefetch: fillstart %lld, fillend %lld, reqstart %lld, reqend %lld\n", fillstart, fillend, reqstart, reqend);
 
    if (fillstart < reqstart) {
       int lockgran = cache->lockgran;
@@ -1673,9 +1677,9 @@ cache_event *readdesc;
 
    int linesize = max(1, cache->linesize);
    int devno = readdesc->req->devno;
-   int lbn = readdesc->req->blkno;
+   lbn_t lbn = readdesc->req->blkno;
    int size = readdesc->req->bcount;
-   int validpoint = readdesc->validpoint;
+   lbn_t validpoint = readdesc->validpoint;
 
    if (cache->size == 0) {
       cache_waitfor_IO(cache, 1, readdesc, readdesc->req);
@@ -1686,10 +1690,10 @@ cache_event *readdesc;
       cache->issuefunc(cache->issueparam, ioreq_copy(readdesc->req));
       return(1);
    }
-   i = readdesc->lockstop;
+   i = (int) readdesc->lockstop;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_read_continue: lbn %d, size %d, i %d\n", lbn, size, i);
+fprintf (outputfile, "Entered cache_read_continue: lbn %lld, size %d, i %d\n", lbn, size, i);
 
 read_cont_loop:
    while (i < size) {
@@ -1703,12 +1707,12 @@ read_cont_loop:
             continue;
          }
       }
-      stop = min(rounduptomult((size - i), cache->atomsperbit), (linesize - ((lbn + i) % linesize)));
+      stop = min(rounduptomult((size - i), cache->atomsperbit), (linesize - (int) ((lbn + i) % linesize)));
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "stop %d, lbn %d, atomsperbit %d, i %d, size %d, linesize %d\n", stop, lbn, cache->atomsperbit, i, size, linesize);
+fprintf (outputfile, "stop %d, lbn %lld, atomsperbit %d, i %d, size %d, linesize %d\n", stop, lbn, cache->atomsperbit, i, size, linesize);
 if (cachedebugprinthack)  
-fprintf (outputfile, "validpoint %d, i %d\n", validpoint, i);
+fprintf (outputfile, "validpoint %lld, i %d\n", validpoint, i);
 
       j = 0;
       tmp = line;
@@ -1718,7 +1722,7 @@ fprintf (outputfile, "validpoint %d, i %d\n", validpoint, i);
          int locktype = (tmp->state & CACHE_VALID) ? 1 : 2;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "j %d, valid %d, validpoint %d, curlock %d, lockgran %d\n", j, (tmp->state & CACHE_VALID), validpoint, curlock, lockgran);
+fprintf (outputfile, "j %d, valid %d, validpoint %lld, curlock %d, lockgran %d\n", j, (tmp->state & CACHE_VALID), validpoint, curlock, lockgran);
 
          if (locktype > curlock) {
             curlock = locktype;
@@ -1766,7 +1770,7 @@ fprintf (outputfile, "Going to issue_fillreq on partial line\n");
          tmp = tmp->line_next;
          j++;
       }
-      if ((validpoint != -1) && ((cache->read_line_by_line) || (!cache_concatok(cache, validpoint, 1, (validpoint+1), (line->lbn + stop - validpoint))))) {
+      if ((validpoint != -1) && ((cache->read_line_by_line) || (!cache_concatok(cache, validpoint, 1, (validpoint+1), (int) (line->lbn + stop - validpoint))))) {
          /* Start fill of the line */
          readdesc->allocstop |= 1;
          cache->stat.fillreads++;
@@ -1778,10 +1782,10 @@ fprintf (outputfile, "Going to issue_fillreq on full line\n");
          readdesc->validpoint = -1;
          return(1);
       }
-      i += linesize - ((lbn + i) % linesize);
+      i += linesize - (int) ((lbn + i) % linesize);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "validpoint %d, i %d\n", validpoint, i);
+fprintf (outputfile, "validpoint %lld, i %d\n", validpoint, i);
 
    }
    if (validpoint != -1) {
@@ -1825,24 +1829,24 @@ cache_event *writedesc;
    cache_atom *tmp;
    int lockgran;
    int i, j;
-   int startfillstart;
-   int startfillstop;
-   int endfillstart;
-   int endfillstop;
+   lbn_t startfillstart;
+   lbn_t startfillstop;
+   lbn_t endfillstart;
+   lbn_t endfillstop;
    int ret;
 
    int devno = writedesc->req->devno;
-   int lbn = writedesc->req->blkno;
+   lbn_t lbn = writedesc->req->blkno;
    int size = writedesc->req->bcount;
    int linesize = (cache->linesize > 1) ? cache->linesize : 1;
 
    if (cache->size == 0) {
       return(0);
    }
-   i = writedesc->lockstop;
+   i = (int) writedesc->lockstop;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Entered cache_write_continue: lbn %d, size %d, i %d\n", lbn, size, i);
+fprintf (outputfile, "Entered cache_write_continue: lbn %lld, size %d, i %d\n", lbn, size, i);
 
 write_cont_loop:
 
@@ -1863,7 +1867,7 @@ write_cont_loop:
             }
          }
       }
-      stop = min(rounduptomult((size - i), cache->atomsperbit), (linesize - ((lbn + i) % linesize)));
+      stop = min(rounduptomult((size - i), cache->atomsperbit), (linesize - (int) ((lbn + i) % linesize)));
       j = 0;
       tmp = line;
       lockgran = 0;
@@ -1888,7 +1892,7 @@ write_cont_loop:
             }
             startfillstop = tmp->lbn;
          } else if ((tmp->state & CACHE_VALID) == 0) {
-            int tmpval = tmp->lbn - (lbn + size - 1);
+            lbn_t tmpval = tmp->lbn - (lbn + size - 1);
             writedesc->allocstop |= 2;
             if ((tmpval > 0) && (tmpval < (cache->atomsperbit - ((lbn + size - 1) % cache->atomsperbit)))) {
                tmp->state |= CACHE_VALID;
@@ -1908,19 +1912,19 @@ write_cont_loop:
       /* (fill) first -- flag undo of allocation to bypass (no bypass for now */
 
       if ((startfillstart != -1) || (endfillstart != -1)) {
-         int fillblkno = (startfillstart != -1) ? startfillstart : endfillstart;
-         int fillbcount = 1 - fillblkno;
+         lbn_t fillblkno = (startfillstart != -1) ? startfillstart : endfillstart;
+         lbn_t fillbcount = 1 - fillblkno;
          fillbcount += ((startfillstart != -1) && (endfillstart == -1)) ? startfillstop : endfillstop;
          cache->stat.writeinducedfills++;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "Write induced fill: blkno %d, bcount %d\n", fillblkno, fillbcount);
+fprintf (outputfile, "Write induced fill: blkno %lld, bcount %lld\n", fillblkno, fillbcount);
 
          cache->stat.writeinducedfillatoms += cache_issue_fillreq(cache, fillblkno, (fillblkno + fillbcount - 1), writedesc, cache->writefill_prefetch_type);
          return(1);
       }
 
-      i += linesize - ((lbn + i) % linesize);
+      i += linesize - (int) ((lbn + i) % linesize);
    }
    cache->stat.writes++;
    cache->stat.writeatoms += writedesc->req->bcount;
@@ -1977,7 +1981,7 @@ fprintf (outputfile, "%.5f: Entered cache_get_block: rw %d, devno %d, blkno %d,
    }
 
 if (cachedebugprinthack)
-fprintf (outputfile, "rwdesc %p, ret %x, validpoint %d\n", rwdesc, ret, rwdesc->validpoint);
+fprintf (outputfile, "rwdesc %p, ret %x, validpoint %lld\n", rwdesc, ret, rwdesc->validpoint);
 
    if (ret == 0) {
       donefunc(doneparam, req);
@@ -2001,7 +2005,7 @@ ioreq_event *req;
    int i;
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "%.5f: Entered cache_free_block_clean: blkno %d, bcount %d, devno %d\n", simtime, req->blkno, req->bcount, req->devno);
+fprintf (outputfile, "%.5f: Entered cache_free_block_clean: blkno %lld, bcount %d, devno %d\n", simtime, req->blkno, req->bcount, req->devno);
 
    cache->stat.freeblockcleans++;
    if (cache->size == 0) {
@@ -2045,8 +2049,8 @@ int reqdone;
 
       tmp = (cache_event *) getfromextraq();
       tmp->req = writedesc->req;
-      tmp->locktype = writedesc->req->blkno;
-      tmp->lockstop = writedesc->req->bcount;
+      tmp->lockstop = writedesc->req->blkno;
+      tmp->locktype = writedesc->req->bcount;
       tmp->next = cache->partwrites;
       tmp->prev = NULL;
       if (tmp->next) {
@@ -2055,11 +2059,11 @@ int reqdone;
       cache->partwrites = tmp;
    }
    if (reqdone) {
-      tmp->req->bcount = tmp->accblkno - flushreq->blkno;
+      tmp->req->bcount = (int) (tmp->accblkno - flushreq->blkno);
       tmp->req->blkno = flushreq->blkno;
       tmp->req->type = 0;
       cache_free_block_clean(cache, tmp->req);
-      if (tmp->accblkno >= (tmp->locktype + tmp->lockstop)) {
+      if (tmp->accblkno >= (tmp->lockstop + tmp->locktype)) {
          if (tmp->prev) {
             tmp->prev->next = tmp->next;
          } else {
@@ -2068,12 +2072,12 @@ int reqdone;
          if (tmp->next) {
             tmp->next->prev = tmp->prev;
          }
-         tmp->req->blkno = tmp->locktype;
-         tmp->req->bcount = tmp->lockstop;
+         tmp->req->blkno = tmp->lockstop;
+         tmp->req->bcount = tmp->locktype;
          writedesc->donefunc(writedesc->doneparam, tmp->req);
          addtoextraq((event *) tmp);
       } else {
-         tmp->req->bcount = tmp->locktype + tmp->lockstop - tmp->accblkno;
+         tmp->req->bcount = (int) (tmp->lockstop + tmp->locktype - tmp->accblkno);
          tmp->req->blkno = tmp->accblkno;
 	 cache->linebylinetmp = 1;
          cache_free_block_dirty(cache, tmp->req, writedesc->donefunc, writedesc->doneparam);
@@ -2099,7 +2103,7 @@ void *doneparam;
    ioreq_event *flushreq;
    cache_event *writedesc;
    int lockgran = 0;
-   int flushblkno = req->blkno;
+   lbn_t flushblkno = req->blkno;
    int flushbcount = req->bcount;
    int linebyline = cache->linebylinetmp;
    int i;
@@ -2107,7 +2111,7 @@ void *doneparam;
    int writethru = (cache->size == 0) || (cache->writescheme != CACHE_WRITE_BACK);
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "%.5f, Entered cache_free_block_dirty: blkno %d, size %d, writethru %d\n", simtime, req->blkno, req->bcount, writethru);
+fprintf (outputfile, "%.5f, Entered cache_free_block_dirty: blkno %lld, size %d, writethru %d\n", simtime, req->blkno, req->bcount, writethru);
 
    cache->linebylinetmp = 0;
    cache->stat.freeblockdirtys++;
@@ -2133,15 +2137,14 @@ fprintf (outputfile, "%.5f, Entered cache_free_block_dirty: blkno %d, size %d, w
    }
 
 if (cachedebugprinthack)  
-fprintf (outputfile, "flushblkno %d, reqblkno %d, atomsperbit %d\n", flushblkno, req->blkno, cache->atomsperbit);
+fprintf (outputfile, "flushblkno %lld, reqblkno %lld, atomsperbit %d\n", flushblkno, req->blkno, cache->atomsperbit);
 
    flushblkno -= (req->blkno % cache->atomsperbit);
-   flushbcount += (req->blkno % cache->atomsperbit);
-   i = flushblkno + flushbcount;
-   flushbcount += rounduptomult(i, cache->atomsperbit) - i;
+   flushbcount += (int) (req->blkno % cache->atomsperbit);
+   flushbcount += (int) (rounduptomult((flushblkno + flushbcount), cache->atomsperbit) - (flushblkno + flushbcount));
 
 if (cachedebugprinthack)
-fprintf (outputfile, "in free_block_dirty: flushblkno %d, flushsize %d\n", flushblkno, flushbcount);
+fprintf (outputfile, "in free_block_dirty: flushblkno %lld, flushsize %d\n", flushblkno, flushbcount);
 
    for (i=0; i<flushbcount; i++) {
       if (line == NULL) {
@@ -2183,7 +2186,7 @@ fprintf (outputfile, "in free_block_dirty: flushblkno %d, flushsize %d\n", flush
       cache_waitfor_IO(cache, 1, writedesc, flushreq);
 
 if (cachedebugprinthack)
-fprintf (outputfile, "Issueing dirty block flush: writedesc %p, req %p, blkno %d, bcount %d, devno %d\n", writedesc, writedesc->req, flushreq->blkno, flushreq->bcount, flushreq->devno);
+fprintf (outputfile, "Issueing dirty block flush: writedesc %p, req %p, blkno %lld, bcount %d, devno %d\n", writedesc, writedesc->req, flushreq->blkno, flushreq->bcount, flushreq->devno);
 
       cache->issuefunc(cache->issueparam, flushreq);
       if (cache->writescheme == CACHE_WRITE_SYNCONLY) {
@@ -2217,7 +2220,7 @@ ioreq_event *curr;
    cache_event *tmp = cache->IOwaiters;
 
 if (cachedebugprinthack)
-fprintf (outputfile, "Entered cache_disk_access_complete: blkno %d, bcount %d, devno %d\n", curr->blkno, curr->bcount, curr->devno);
+fprintf (outputfile, "Entered cache_disk_access_complete: blkno %lld, bcount %d, devno %d\n", curr->blkno, curr->bcount, curr->devno);
 
    while (tmp) {
       req = tmp->req;
@@ -2225,7 +2228,7 @@ fprintf (outputfile, "Entered cache_disk_access_complete: blkno %d, bcount %d, d
          if ((curr->devno == req->devno) && ((curr->blkno == tmp->accblkno) || ((tmp->accblkno == -1) && ((req->next) || (tmp->type == CACHE_EVENT_SYNC) || (tmp->type == CACHE_EVENT_IDLESYNC)) && (curr->blkno == req->blkno)))) {
 
 if (cachedebugprinthack)
-fprintf (outputfile, "Matched: tmp %p, req %p, blkno %d, accblkno %d, reqblkno %d\n", tmp, req, curr->blkno, tmp->accblkno, req->blkno);
+fprintf (outputfile, "Matched: tmp %p, req %p, blkno %lld, accblkno %lld, reqblkno %lld\n", tmp, req, curr->blkno, tmp->accblkno, req->blkno);
 
             goto completed_access;
          }
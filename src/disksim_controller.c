@@ -206,7 +206,7 @@ int ctlno;
 int devno;
 {
    double tmptime;
-   int tmpblks;
+   lbn_t tmpblks;
    controller *currctlr = &controllers[ctlno];
    ioreq_event *tmp = currctlr->datatransfers;
 /*
@@ -248,6 +248,7 @@ double arbdelay;
 {
    controller *currctlr = &controllers[ctlno];
    ioreq_event *tmp;
+   reqtiming *timing;
    ASSERT1((ctlno >= 0) && (ctlno < numcontrollers), "ctlno", ctlno);
 /*
 fprintf (outputfile, "Ownership granted for bus %d - ctlno %d\n", busno, ctlno);
@@ -271,6 +272,9 @@ fprintf (outputfile, "Ownership granted for bus %d - ctlno %d\n", busno, ctlno);
                exit(0);
    }
    currctlr->waitingforbus += arbdelay;
+   if ((timing = IO_TIMING(tmp))) {
+      timing->buswait += arbdelay;
+   }
    bus_delay(busno, CONTROLLER, currctlr->ctlno, tmp->time, tmp);
    tmp->time = (double) -1.0;
    controller_disown_busno(&controllers[ctlno], busno);
@@ -743,7 +747,7 @@ int last;
       exit(0);
    }
    for (i=first; i<=last; i++) {
-      if ((strcmp(paramname, "ioqueue_schedalg") == 0) || (strcmp(paramname, "ioqueue_seqscheme") == 0) || (strcmp(paramname, "ioqueue_cylmaptype") == 0) || (strcmp(paramname, "ioqueue_to_time") == 0) || (strcmp(paramname, "ioqueue_timeout_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_mix") == 0)) {
+      if (strncmp(paramname, "ioqueue_", 8) == 0) {
          ioqueue_param_override(controllers[i].queue, paramname, paramval);
       } else if ((strcmp(paramname, "cache_size") == 0) || (strcmp(paramname, "cache_segcount") == 0) || (strcmp(paramname, "cache_linesize") == 0) || (strcmp(paramname, "cache_bitgran") == 0) || (strcmp(paramname, "cache_lockgran") == 0) || (strcmp(paramname, "cache_readshare") == 0) || (strcmp(paramname, "cache_maxreqsize") == 0) || (strcmp(paramname, "cache_replace") == 0) || (strcmp(paramname, "cache_writescheme") == 0) || (strcmp(paramname, "cache_readprefetch") == 0) || (strcmp(paramname, "cache_writeprefetch") == 0) || (strcmp(paramname, "cache_linebyline") == 0)) {
          cache_param_override(controllers[i].cache, paramname, paramval);
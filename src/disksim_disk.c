@@ -76,6 +76,7 @@ int disk_printxferstats;
 int disk_printacctimestats;
 int disk_printinterferestats;
 int disk_printbufferstats;
+int disk_printestimatestats = FALSE;
 
 char *statdesc_seekdiststats	=	"Seek distance";
 char *statdesc_seektimestats	=	"Seek time";
@@ -88,6 +89,11 @@ extern double reading_buffer_partial_servtime;
 extern double buffer_whole_servtime;
 extern double reading_buffer_whole_servtime;
 
+void band_read_defect_file();
+void disk_model_attach();
+int disk_model_private();
+void disk_model_set_rpm();
+
 
 int disk_get_numdisks()
 {
@@ -123,7 +129,7 @@ int last;
    i = first;
    for (i=first; i<=last; i++) {
 
-      if ((strcmp(paramname, "ioqueue_schedalg") == 0) || (strcmp(paramname, "ioqueue_seqscheme") == 0) || (strcmp(paramname, "ioqueue_cylmaptype") == 0) || (strcmp(paramname, "ioqueue_to_time") == 0) || (strcmp(paramname, "ioqueue_timeout_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_mix") == 0)) {
+      if (strncmp(paramname, "ioqueue_", 8) == 0) {
          ioqueue_param_override(disks[i].queue, paramname, paramval);
 
       } else if (strcmp(paramname, "reading_buffer_whole_servtime") == 0) {
@@ -180,6 +186,28 @@ int last;
             fprintf(stderr, "Invalid value for writecomb in disk_param_override: %d\n", disks[i].writecomb);
             exit(0);
          }
+      } else if (strcmp(paramname, "printestimatestats") == 0) {
+         if (sscanf(paramval, "%d\n", &disk_printestimatestats) != 1) {
+            fprintf(stderr, "Error reading printestimatestats in disk_param_override\n");
+            exit(0);
+         }
+         if ((disk_printestimatestats != TRUE) && (disk_printestimatestats != FALSE)) {
+            fprintf(stderr, "Invalid value for printestimatestats in disk_param_override: %d\n", disk_printestimatestats);
+            exit(0);
+         }
+      } else if (strcmp(paramname, "mapcache") == 0) {
+         if (sscanf(paramval, "%d\n", &disks[i].mapcache) != 1) {
+            fprintf(stderr, "Error reading mapcache in disk_param_override\n");
+            exit(0);
+         }
+         if ((disks[i].mapcache < 0) || (disks[i].mapcache > 2)) {
+            fprintf(stderr, "Invalid value for mapcache in disk_param_override: %d\n", disks[i].mapcache);
+            exit(0);
+         }
+      } else if (strcmp(paramname, "defectfile") == 0) {
+         if (disk_model_private(i, first, last)) {
+            band_read_defect_file(&disks[i], paramval);
+         }
       } else if (strcmp(paramname, "maxqlen") == 0) {
          if (sscanf(paramval, "%d\n", &disks[i].maxqlen) != 1) {
             fprintf(stderr, "Error reading maxqlen in disk_param_override\n");
@@ -314,7 +342,7 @@ int last;
             exit(0);
          }
          if ((disks[i].segsize < 1) ||
-	     (disks[i].segsize > disks[i].numblocks)) {
+	     (disks[i].segsize > disks[i].model->numblocks)) {
             fprintf(stderr, "Invalid value for segsize in disk_param_override: %d\n", disks[i].segsize);
             exit(0);
          }
@@ -402,29 +430,43 @@ int firsttime;
    stat->requestedbus = 0.0;
    stat->waitingforbus = 0.0;
    stat->numbuswaits = 0;
+   stat->estimates = 0.0;
 }
 
 
+/* Each disk (or synchronized set of disks) spins at its own speed,    */
+/* within rpmerr percent of the spec, so when rpmerr is nonzero the     */
+/* disks end up on models of their own.                                 */
+
 void disk_syncset_init()
 {
    int i, j;
    int synced[128];
+   diskmodel *model;
+   double rpm;
 
    for (i=1; i<=numsyncsets; i++) {
       synced[i] = 0;
    }
    for (i=0; i<numdisks; i++) {
+      model = disks[i].model;
       if (disks[i].syncset == 0) {
-         disks[i].rpm -= (disks[i].rpm * disks[i].rpmerr * (double) 0.01 *
+         rpm = model->rpm - (model->rpm * model->rpmerr * (double) 0.01 *
 			 ((double) 1 - ((double) 2 * drand48())));
+         disk_model_set_rpm(i, rpm);
          disks[i].currangle = drand48();
       } else if ((disks[i].syncset > 0) && (synced[(disks[i].syncset)] == 0)) {
-         disks[i].rpm -= (disks[i].rpm * disks[i].rpmerr * (double) 0.01 *
+         rpm = model->rpm - (model->rpm * model->rpmerr * (double) 0.01 *
 			 ((double) 1 - ((double) 2 * drand48())));
+         disk_model_set_rpm(i, rpm);
          disks[i].currangle = drand48();
          for (j=i; j<numdisks; j++) {
 	    if (disks[j].syncset == disks[i].syncset) {
-	       disks[j].rpm = disks[i].rpm;
+	       if (disks[j].model == model) {
+		  disk_model_attach(&disks[j], disks[i].model);
+	       } else {
+		  disk_model_set_rpm(j, rpm);
+	       }
 	       disks[j].currangle = disks[i].currangle;
 	    }
 	 }
@@ -434,15 +476,80 @@ void disk_syncset_init()
 }
 
 
-void disk_initialize()
+/* Converts the band skews (given in sectors or as special values) to   */
+/* times and precomputes the seek curve and tables, once per model.     */
+/* All of this depends on the rotation speed, so must follow           */
+/* disk_syncset_init.                                                  */
+
+void disk_model_initialize(diskno)
+int diskno;
 {
-   int i, j;
-   diskreq *tmpdiskreq;
-   segment *tmpseg;
+   disk *currdisk = &disks[diskno];
+   diskmodel *model = currdisk->model;
+   int j;
    double tmptime;
    double rotblks;
    double tmpfull;
    double tmpavg;
+
+   if (model->initialized) {
+      return;
+   }
+   model->rotatetime = (double) MSECS_PER_MIN / model->rpm;
+   for (j=0; j<model->numbands; j++) {
+      tmptime = max(diskseektime(currdisk, 0, 1, 0), diskseektime(currdisk, 0, 1, 1));
+      rotblks = (double) model->bands[j].blkspertrack / model->rotatetime;
+      model->bands[j].firstblkno = model->bands[j].firstblkno / rotblks;
+      if (model->bands[j].trackskew == -1.0) {
+         model->bands[j].trackskew = tmptime;
+      } else if (model->bands[j].trackskew == -2.0) {
+         tmptime = (double) ((int) (tmptime * rotblks + 0.999999999));
+         model->bands[j].trackskew = tmptime / rotblks;
+      } else {
+         model->bands[j].trackskew = model->bands[j].trackskew / rotblks;
+      }
+      tmptime = max(diskseektime(currdisk, 1, 0, 0), diskseektime(currdisk, 1, 0, 1));
+      if (model->bands[j].cylskew == -1.0) {
+         model->bands[j].cylskew = tmptime;
+      } else if (model->bands[j].cylskew == -2.0) {
+         tmptime = (double) ((int) (tmptime * rotblks + 0.99999999));
+         model->bands[j].cylskew = tmptime / rotblks;
+      } else {
+         model->bands[j].cylskew = model->bands[j].cylskew / rotblks;
+      }
+   }
+   if ((model->seektime == THREEPOINT_CURVE) && (model->seekavg > model->seekone)) {
+fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", model->seekone, model->seekavg, model->seekfull);
+      tmpfull = model->seekfull;
+      tmpavg = model->seekavg;
+      tmptime = (double) -10.0 * model->seekone;
+      tmptime += (double) 15.0 * model->seekavg;
+      tmptime += (double) -5.0 * model->seekfull;
+      tmptime = tmptime / ((double) 3 * sqrt((double) (model->numcyls)));
+      model->seekavg *= (double) -15.0;
+      model->seekavg += (double) 7.0 * model->seekone;
+      model->seekavg += (double) 8.0 * model->seekfull;
+      model->seekavg = model->seekavg / (double) (3 * model->numcyls);
+      model->seekfull = tmptime;
+fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", model->seekone, model->seekavg, model->seekfull);
+fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", diskseektime(currdisk, 1, 0, 1), diskseektime(currdisk, (model->numcyls / 3), 0, 1), diskseektime(currdisk, (model->numcyls - 1), 0, 1));
+      if ((model->seekavg < 0.0) || (model->seekfull < 0.0)) {
+         model->seektime = THREEPOINT_CURVE;
+         model->seekfull = tmpfull;
+         model->seekavg = tmpavg;
+      }
+   }
+   disk_seektime_table_initialize(diskno);
+   disk_check_numblocks(currdisk);
+   model->initialized = TRUE;
+}
+
+
+void disk_initialize()
+{
+   int i, j;
+   diskreq *tmpdiskreq;
+   segment *tmpseg;
 /*
 fprintf (outputfile, "Entered disk_initialize - numdisks %d\n", numdisks);
 */
@@ -515,7 +622,6 @@ fprintf (outputfile, "Entered disk_initialize - numdisks %d\n", numdisks);
       disks[i].currsurface = 0;
       disks[i].currtime = 0.0;
       disks[i].lastflags = READ;
-      disks[i].rotatetime = (double) MSECS_PER_MIN / disks[i].rpm;
       disks[i].lastgen = -1;
       disks[i].busowned = -1;
       disks[i].numdirty = 0;
@@ -557,51 +663,9 @@ fprintf (outputfile, "Entered disk_initialize - numdisks %d\n", numdisks);
          addlisttoextraq((event *) &tmpseg->access);
 	 tmpseg = tmpseg->next;
       }
-      for (j=0; j<disks[i].numbands; j++) {
-	 tmptime = max(diskseektime(&disks[i], 0, 1, 0), diskseektime(&disks[i], 0, 1, 1));
-	 rotblks = (double) disks[i].bands[j].blkspertrack / disks[i].rotatetime;
-         disks[i].bands[j].firstblkno = disks[i].bands[j].firstblkno / rotblks;
-	 if (disks[i].bands[j].trackskew == -1.0) {
-	    disks[i].bands[j].trackskew = tmptime;
-	 } else if (disks[i].bands[j].trackskew == -2.0) {
-	    tmptime = (double) ((int) (tmptime * rotblks + 0.999999999));
-	    disks[i].bands[j].trackskew = tmptime / rotblks;
-	 } else {
-	    disks[i].bands[j].trackskew = disks[i].bands[j].trackskew / rotblks;
-	 }
-	 tmptime = max(diskseektime(&disks[i], 1, 0, 0), diskseektime(&disks[i], 1, 0, 1));
-	 if (disks[i].bands[j].cylskew == -1.0) {
-	    disks[i].bands[j].cylskew = tmptime;
-	 } else if (disks[i].bands[j].cylskew == -2.0) {
-	    tmptime = (double) ((int) (tmptime * rotblks + 0.99999999));
-	    disks[i].bands[j].cylskew = tmptime / rotblks;
-	 } else {
-	    disks[i].bands[j].cylskew = disks[i].bands[j].cylskew / rotblks;
-	 }
-      }
-      if ((disks[i].seektime == THREEPOINT_CURVE) && (disks[i].seekavg > disks[i].seekone)) {
-fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", disks[i].seekone, disks[i].seekavg, disks[i].seekfull);
-	 tmpfull = disks[i].seekfull;
-	 tmpavg = disks[i].seekavg;
-	 tmptime = (double) -10.0 * disks[i].seekone;
-	 tmptime += (double) 15.0 * disks[i].seekavg;
-	 tmptime += (double) -5.0 * disks[i].seekfull;
-	 tmptime = tmptime / ((double) 3 * sqrt((double) (disks[i].numcyls)));
-	 disks[i].seekavg *= (double) -15.0;
-	 disks[i].seekavg += (double) 7.0 * disks[i].seekone;
-	 disks[i].seekavg += (double) 8.0 * disks[i].seekfull;
-	 disks[i].seekavg = disks[i].seekavg / (double) (3 * disks[i].numcyls);
-	 disks[i].seekfull = tmptime;
-fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", disks[i].seekone, disks[i].seekavg, disks[i].seekfull);
-fprintf (outputfile, "seekone %f, seekavg %f, seekfull %f\n", diskseektime(&disks[i], 1, 0, 1), diskseektime(&disks[i], (disks[i].numcyls / 3), 0, 1), diskseektime(&disks[i], (disks[i].numcyls - 1), 0, 1));
-	 if ((disks[i].seekavg < 0.0) || (disks[i].seekfull < 0.0)) {
-	    disks[i].seektime = THREEPOINT_CURVE;
-	    disks[i].seekfull = tmpfull;
-	    disks[i].seekavg = tmpavg;
-	 }
-      }
+      disk_model_initialize(i);
       diskstatinit(i, TRUE);
-      disk_check_numblocks(&disks[i]);
+      disk_map_initialize(&disks[i]);
    }
 }
 
@@ -634,6 +698,20 @@ FILE *parfile;
 }
 
 
+lbn_t * band_alloc_list(count)
+int count;
+{
+   lbn_t *list;
+
+   if (count == 0) {
+      return(NULL);
+   }
+   list = (lbn_t *) malloc(count * sizeof(lbn_t));
+   ASSERT(list != NULL);
+   return(list);
+}
+
+
 void bandcopy(destbands, srcbands, numbands)
 band *destbands;
 band *srcbands;
@@ -653,6 +731,10 @@ int numbands;
       destbands[i].sparecnt = srcbands[i].sparecnt;
       destbands[i].numslips = srcbands[i].numslips;
       destbands[i].numdefects = srcbands[i].numdefects;
+      destbands[i].slip = band_alloc_list(srcbands[i].numslips);
+      destbands[i].defect = band_alloc_list(srcbands[i].numdefects);
+      destbands[i].remap = band_alloc_list(srcbands[i].numdefects);
+      destbands[i].remapindex = NULL;
       for (j=0; j<srcbands[i].numslips; j++) {
          destbands[i].slip[j] = srcbands[i].slip[j];
       }
@@ -664,6 +746,114 @@ int numbands;
 }
 
 
+diskmodel * disk_model_copy(model)
+diskmodel *model;
+{
+   diskmodel *copy;
+
+   ASSERT(model->initialized == FALSE);
+   copy = (diskmodel *) malloc(sizeof(diskmodel));
+   ASSERT(copy != NULL);
+   *copy = *model;
+   copy->refcnt = 0;
+   copy->bands = (band *) malloc(model->numbands * sizeof(band));
+   ASSERT(copy->bands != NULL);
+   bandcopy(copy->bands, model->bands, model->numbands);
+   return(copy);
+}
+
+
+void disk_model_free(model)
+diskmodel *model;
+{
+   int i;
+
+   for (i=0; i<model->numbands; i++) {
+      if (model->bands[i].slip) {
+         free(model->bands[i].slip);
+      }
+      if (model->bands[i].defect) {
+         free(model->bands[i].defect);
+         free(model->bands[i].remap);
+      }
+   }
+   free(model->bands);
+   free(model);
+}
+
+
+/* Moves a disk onto another model, freeing the old one if no disk is   */
+/* left using it.  (The extracted seek curve is shared between a model */
+/* and its copies, so is never freed.)                                 */
+
+void disk_model_attach(currdisk, model)
+disk *currdisk;
+diskmodel *model;
+{
+   diskmodel *old = currdisk->model;
+
+   if (old == model) {
+      return;
+   }
+   model->refcnt++;
+   currdisk->model = model;
+   old->refcnt--;
+   if (old->refcnt == 0) {
+      disk_model_free(old);
+   }
+}
+
+
+/* Prepares for a change to the model of disks[diskno] that applies to  */
+/* disks first through last: any disks outside that range still using  */
+/* the model are left with the original, and those inside are moved    */
+/* together onto a copy.  Returns FALSE if the model is one that an     */
+/* earlier disk in the range has already had changed, so that each      */
+/* change is made once per model rather than once per disk.             */
+
+int disk_model_private(diskno, first, last)
+int diskno;
+int first;
+int last;
+{
+   diskmodel *model = disks[diskno].model;
+   diskmodel *copy;
+   int users = 0;
+   int i;
+
+   for (i=first; i<diskno; i++) {
+      if (disks[i].model == model) {
+         return(FALSE);
+      }
+   }
+   for (i=diskno; i<=last; i++) {
+      if (disks[i].model == model) {
+         users++;
+      }
+   }
+   if (users < model->refcnt) {
+      copy = disk_model_copy(model);
+      for (i=diskno; i<=last; i++) {
+         if (disks[i].model == model) {
+            disk_model_attach(&disks[i], copy);
+         }
+      }
+   }
+   return(TRUE);
+}
+
+
+void disk_model_set_rpm(diskno, rpm)
+int diskno;
+double rpm;
+{
+   if (disks[diskno].model->rpm != rpm) {
+      (void) disk_model_private(diskno, diskno, diskno);
+      disks[diskno].model->rpm = rpm;
+   }
+}
+
+
 void band_read_specs(bands, numbands, parfile, numsurfaces, sparescheme)
 band *bands;
 int numbands;
@@ -681,8 +871,8 @@ int sparescheme;
    int sparecnt;
    int numslips;
    int numdefects;
-   int defect;
-   int remap;
+   lbn_t defect;
+   lbn_t remap;
 
    for (bandno_expected=1; bandno_expected<=numbands; bandno_expected++) {
       if (fscanf(parfile, "Band #%d\n", &bandno) != 1) {
@@ -716,26 +906,30 @@ int sparescheme;
       getparam_int(parfile, "Number of spares", &sparecnt, 1, 0, 0);
       bands[bandno].sparecnt = sparecnt;
 
-      getparam_int(parfile, "Number of slips", &numslips, 3, 0, MAXSLIPS);
+      getparam_int(parfile, "Number of slips", &numslips, 1, 0, 0);
       bands[bandno].numslips = numslips;
+      bands[bandno].slip = band_alloc_list(numslips);
       for (i=0; i<numslips; i++) {
-         getparam_int(parfile, "Slip", &bands[bandno].slip[i], 1, 0, 0);
+         getparam_lbn(parfile, "Slip", &bands[bandno].slip[i], 1, (lbn_t) 0, (lbn_t) 0);
       }
 
-      getparam_int(parfile, "Number of defects", &numdefects, 3, 0, MAXDEFECTS);
+      getparam_int(parfile, "Number of defects", &numdefects, 1, 0, 0);
       bands[bandno].numdefects = numdefects;
+      bands[bandno].defect = band_alloc_list(numdefects);
+      bands[bandno].remap = band_alloc_list(numdefects);
+      bands[bandno].remapindex = NULL;
       for (i=0; i<numdefects; i++) {
-         if (fscanf(parfile, "Defect: %d %d\n", &defect, &remap) != 2) {
+         if (fscanf(parfile, "Defect: %lld %lld\n", &defect, &remap) != 2) {
 	    fprintf(stderr, "Error reading defect #%d\n", i);
 	    exit(0);
          }
          if ((defect < 0) || (remap < 0)) {
-	    fprintf(stderr, "Invalid value(s) for defect - %d %d\n", defect, remap);
+	    fprintf(stderr, "Invalid value(s) for defect - %lld %lld\n", defect, remap);
 	    exit(0);
          }
          bands[bandno].defect[i] = defect;
          bands[bandno].remap[i] = remap;
-         fprintf (outputfile, "Defect: %d %d\n", defect, remap);
+         fprintf (outputfile, "Defect: %lld %lld\n", defect, remap);
       }
 
       if ((sparescheme == TRACK_SPARING) && ((numslips + numdefects) > sparecnt)) {
@@ -743,16 +937,117 @@ int sparescheme;
 	 exit(0);
       }
 
-      bands[bandno].blksinband = (endcyl-startcyl+1)*blkspertrack*numsurfaces;
+      bands[bandno].blksinband = (lbn_t) (endcyl-startcyl+1) * blkspertrack * numsurfaces;
       bands[bandno].blksinband -= deadspace;
       if (sparescheme == TRACK_SPARING) {
 	 bands[bandno].blksinband -= sparecnt * blkspertrack;
       } else if (sparescheme == SECTPERCYL_SPARING) {
 	 bands[bandno].blksinband -= sparecnt * (endcyl - startcyl + 1);
       } else if (sparescheme == SECTPERTRACK_SPARING) {
-	 bands[bandno].blksinband -= sparecnt * (endcyl-startcyl+1) * numsurfaces;
+	 bands[bandno].blksinband -= (lbn_t) sparecnt * (endcyl-startcyl+1) * numsurfaces;
+      }
+fprintf (outputfile, "blksinband %lld, sparecnt %d, blkspertrack %d, numtracks %d\n", bands[bandno].blksinband, sparecnt, blkspertrack, ((endcyl-startcyl+1)*numsurfaces));
+   }
+}
+
+
+/* Adds the slips and defects listed in a separate defect list file to  */
+/* the disk's bands, so that a drive's full (grown) defect list need not */
+/* be pasted into the disk specs.  Each line is "Slip: <band> <slip>" or */
+/* "Defect: <band> <defect> <remap>", using the spec file's band numbers */
+/* and units; blank lines and lines starting with '#' are skipped.  The  */
+/* file is read twice: once to size each band's lists, once to fill them. */
+
+void band_read_defect_file(currdisk, filename)
+disk *currdisk;
+char *filename;
+{
+   FILE *defectfile;
+   char line[201];
+   int *newslips;
+   int *newdefects;
+   int pass;
+   int lineno;
+   int bandno;
+   lbn_t value;
+   lbn_t remap;
+   int isslip;
+   int i;
+   char word[2];
+   band *currband;
+
+   if ((defectfile = fopen(filename, "r")) == NULL) {
+      fprintf(stderr, "Defect list file %s cannot be opened for read access\n", filename);
+      exit(0);
+   }
+   newslips = (int *) malloc(currdisk->model->numbands * sizeof(int));
+   newdefects = (int *) malloc(currdisk->model->numbands * sizeof(int));
+   ASSERT((newslips != NULL) && (newdefects != NULL));
+   for (i=0; i<currdisk->model->numbands; i++) {
+      newslips[i] = 0;
+      newdefects[i] = 0;
+   }
+   for (pass=0; pass<2; pass++) {
+      rewind(defectfile);
+      lineno = 0;
+      while (fgets(line, 200, defectfile)) {
+	 lineno++;
+	 if (sscanf(line, "Slip: %d %lld", &bandno, &value) == 2) {
+	    isslip = TRUE;
+	    remap = 0;
+	 } else if (sscanf(line, "Defect: %d %lld %lld", &bandno, &value, &remap) == 3) {
+	    isslip = FALSE;
+	 } else if ((line[0] == '#') || (sscanf(line, "%1s", word) != 1)) {
+	    continue;
+	 } else {
+	    fprintf(stderr, "Error reading line %d of defect list file %s\n", lineno, filename);
+	    exit(0);
+	 }
+	 if ((bandno < 1) || (bandno > currdisk->model->numbands) || (value < 0) || (remap < 0)) {
+	    fprintf(stderr, "Invalid value(s) on line %d of defect list file %s\n", lineno, filename);
+	    exit(0);
+	 }
+	 currband = &currdisk->model->bands[(bandno-1)];
+	 if (isslip) {
+	    if (pass == 0) {
+	       newslips[(bandno-1)]++;
+	    } else {
+	       currband->slip[currband->numslips] = value;
+	       currband->numslips++;
+	    }
+	 } else {
+	    if (pass == 0) {
+	       newdefects[(bandno-1)]++;
+	    } else {
+	       currband->defect[currband->numdefects] = value;
+	       currband->remap[currband->numdefects] = remap;
+	       currband->numdefects++;
+	    }
+	 }
+      }
+      for (i=0; (pass == 0) && (i<currdisk->model->numbands); i++) {
+	 currband = &currdisk->model->bands[i];
+	 if (newslips[i]) {
+	    currband->slip = (lbn_t *) realloc(currband->slip, (currband->numslips + newslips[i]) * sizeof(lbn_t));
+	    ASSERT(currband->slip != NULL);
+	 }
+	 if (newdefects[i]) {
+	    currband->defect = (lbn_t *) realloc(currband->defect, (currband->numdefects + newdefects[i]) * sizeof(lbn_t));
+	    currband->remap = (lbn_t *) realloc(currband->remap, (currband->numdefects + newdefects[i]) * sizeof(lbn_t));
+	    ASSERT((currband->defect != NULL) && (currband->remap != NULL));
+	 }
+      }
+   }
+   fclose(defectfile);
+   free(newslips);
+   free(newdefects);
+
+   for (i=0; i<currdisk->model->numbands; i++) {
+      currband = &currdisk->model->bands[i];
+      if ((currdisk->model->sparescheme == TRACK_SPARING) && ((currband->numslips + currband->numdefects) > currband->sparecnt)) {
+	 fprintf(stderr, "Defects and slips outnumber the available spares: %d < %d + %d\n", currband->sparecnt, currband->numdefects, currband->numslips);
+	 exit(0);
       }
-fprintf (outputfile, "blksinband %d, sparecnt %d, blkspertrack %d, numtracks %d\n", bands[bandno].blksinband, sparecnt, blkspertrack, ((endcyl-startcyl+1)*numsurfaces));
    }
 }
 
@@ -813,6 +1108,7 @@ FILE *parfile;
    double hp1, hp2, hp3, hp4, hp5, hp6;
    double first10seeks[10];
    disk *currdisk;
+   diskmodel *model;
    int useded;
 
    getparam_int(parfile, "\nNumber of disks", &numdisks, 3, 0, MAXDISKS);
@@ -825,6 +1121,8 @@ FILE *parfile;
 
    while (diskno < numdisks) {
       currdisk = &disks[diskno];
+      model = (diskmodel *) malloc(sizeof(diskmodel));
+      ASSERT(model != NULL);
       if (fscanf(parfile, "\nDisk Spec #%d\n", &specno) != 1) {
 	 fprintf(stderr, "Error reading disk spec number\n");
 	 exit(0);
@@ -875,7 +1173,7 @@ FILE *parfile;
          exit(0);
       }
 
-      getparam_double(specfile, "Single cylinder seek time", &currdisk->seekone, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Single cylinder seek time", &model->seekone, 1, (double) 0.0, (double) 0.0);
 
       if (fscanf(specfile, "Average seek time: %s\n", seekinfo) != 1) {
 	 fprintf(stderr, "Error reading average seek time\n");
@@ -896,8 +1194,8 @@ FILE *parfile;
       }
       fprintf (outputfile, "Average seek time: %s\n", seekinfo);
 
-      getparam_double(specfile, "Full strobe seek time", &currdisk->seekfull, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Add. write settling delay", &currdisk->seekwritedelta, 0, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Full strobe seek time", &model->seekfull, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Add. write settling delay", &model->seekwritedelta, 0, (double) 0.0, (double) 0.0);
 
       if (fscanf(specfile, "HPL seek equation values: %lf %lf %lf %lf %lf %lf\n", &hp1, &hp2, &hp3, &hp4, &hp5, &hp6) != 6) {
 	 fprintf(stderr, "Error reading HPL seek equation values\n");
@@ -909,7 +1207,7 @@ FILE *parfile;
       }
       fprintf (outputfile, "HPL seek equation values: %f %f %f %f %f %f\n", hp1, hp2, hp3, hp4, hp5, hp6);
       if (hp6 != -1) {
-	 currdisk->seekone = hp6;
+	 model->seekone = hp6;
       }
 
       if ((j = fscanf(specfile, "First 10 seek times: %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf\n", &first10seeks[0], &first10seeks[1], &first10seeks[2], &first10seeks[3], &first10seeks[4], &first10seeks[5], &first10seeks[6], &first10seeks[7], &first10seeks[8], &first10seeks[9])) == 0) {
@@ -926,21 +1224,21 @@ FILE *parfile;
          fprintf (outputfile, "First 10 seek times:    %f\n", first10seeks[0]);
       }
 
-      getparam_double(specfile, "Head switch time", &currdisk->headswitch, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Head switch time", &model->headswitch, 1, (double) 0.0, (double) 0.0);
 
-      getparam_double(specfile, "Rotation speed (in rpms)", &currdisk->rpm, 4, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Percent error in rpms", &currdisk->rpmerr, 3, (double) 0.0, (double) 100.0);
+      getparam_double(specfile, "Rotation speed (in rpms)", &model->rpm, 4, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Percent error in rpms", &model->rpmerr, 3, (double) 0.0, (double) 100.0);
 
-      getparam_int(specfile, "Number of data surfaces", &currdisk->numsurfaces, 1, 1, 0);
-      getparam_int(specfile, "Number of cylinders", &currdisk->numcyls, 1, 1, 0);
-      getparam_int(specfile, "Blocks per disk", &currdisk->numblocks, 1, 1, 0);
+      getparam_int(specfile, "Number of data surfaces", &model->numsurfaces, 1, 1, 0);
+      getparam_int(specfile, "Number of cylinders", &model->numcyls, 1, 1, 0);
+      getparam_lbn(specfile, "Blocks per disk", &model->numblocks, 1, (lbn_t) 1, (lbn_t) 0);
 
-      getparam_int(specfile, "Sparing scheme used", &currdisk->sparescheme, 3, NO_SPARING, MAXSPARESCHEME);
+      getparam_int(specfile, "Sparing scheme used", &model->sparescheme, 3, NO_SPARING, MAXSPARESCHEME);
 
-      getparam_double(specfile, "Per-request overhead time", &currdisk->overhead, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Time scale for overheads", &currdisk->timescale, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Per-request overhead time", &model->overhead, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Time scale for overheads", &model->timescale, 1, (double) 0.0, (double) 0.0);
 
-      getparam_double(specfile, "Bulk sector transfer time", &currdisk->blktranstime, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Bulk sector transfer time", &model->blktranstime, 1, (double) 0.0, (double) 0.0);
       getparam_bool(specfile, "Hold bus entire read xfer:", &currdisk->hold_bus_for_whole_read_xfer);
       getparam_bool(specfile, "Hold bus entire write xfer:", &currdisk->hold_bus_for_whole_write_xfer);
 
@@ -953,14 +1251,14 @@ FILE *parfile;
       getparam_int(specfile, "Preseeking level", &currdisk->preseeking, 3, 0, 2);
       getparam_bool(specfile, "Never disconnect:", &currdisk->neverdisconnect);
       getparam_bool(specfile, "Print stats for disk:", &currdisk->printstats);
-      getparam_int(specfile, "Avg sectors per cylinder", &currdisk->sectpercyl, 3, 1, currdisk->numblocks);
+      getparam_int(specfile, "Avg sectors per cylinder", &model->sectpercyl, 3, 1, (int) min(model->numblocks, INT_MAX));
 
       getparam_int(specfile, "Max queue length at disk", &currdisk->maxqlen, 1, 0, 0);
       currdisk->queue = ioqueue_readparams(specfile, disk_printqueuestats, disk_printcritstats, disk_printidlestats, disk_printintarrstats, disk_printsizestats);
 
       getparam_int(specfile, "Number of buffer segments", &currdisk->numsegs, 1, 1, 0);
       getparam_int(specfile, "Maximum number of write segments", &currdisk->numwritesegs, 3, 1, currdisk->numsegs);
-      getparam_int(specfile, "Segment size (in blks)", &currdisk->segsize, 3, 1, currdisk->numblocks);
+      getparam_int(specfile, "Segment size (in blks)", &currdisk->segsize, 3, 1, (int) min(model->numblocks, INT_MAX));
       getparam_bool(specfile, "Use separate write segment:", &useded);
       currdisk->dedicatedwriteseg = NULL;
       if ((currdisk->numsegs > 1) && (useded)) {
@@ -1019,90 +1317,69 @@ FILE *parfile;
       getparam_bool(specfile, "Read directly to buffer:", &currdisk->read_direct_to_buffer);
       getparam_bool(specfile, "Immed transfer partial hit:", &currdisk->immedtrans_any_readhit);
 
-      getparam_double(specfile, "Read hit over. after read", &currdisk->overhead_command_readhit_afterread, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read hit over. after write", &currdisk->overhead_command_readhit_afterwrite, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read miss over. after read", &currdisk->overhead_command_readmiss_afterread, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read miss over. after write", &currdisk->overhead_command_readmiss_afterwrite, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Write over. after read", &currdisk->overhead_command_write_afterread, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Write over. after write", &currdisk->overhead_command_write_afterwrite, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read completion overhead", &currdisk->overhead_complete_read, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Write completion overhead", &currdisk->overhead_complete_write, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Data preparation overhead", &currdisk->overhead_data_prep, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "First reselect overhead", &currdisk->overhead_reselect_first, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Other reselect overhead", &currdisk->overhead_reselect_other, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read disconnect afterread", &currdisk->overhead_disconnect_read_afterread, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Read disconnect afterwrite", &currdisk->overhead_disconnect_read_afterwrite, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Write disconnect overhead", &currdisk->overhead_disconnect_write, 1, (double) 0.0, (double) 0.0);
-
-      getparam_bool(specfile, "Extra write disconnect:", &currdisk->extra_write_disconnect);
-      getparam_double(specfile, "Extradisc command overhead", &currdisk->extradisc_command, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Extradisc disconnect overhead", &currdisk->extradisc_disconnect1, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Extradisc inter-disconnect delay", &currdisk->extradisc_inter_disconnect, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Extradisc 2nd disconnect overhead", &currdisk->extradisc_disconnect2, 1, (double) 0.0, (double) 0.0);
-      getparam_double(specfile, "Extradisc seek delta", &currdisk->extradisc_seekdelta, 1, (double) 0.0, (double) 0.0);
-
-      getparam_double(specfile, "Minimum seek delay", &currdisk->minimum_seek_delay, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read hit over. after read", &model->overhead_command_readhit_afterread, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read hit over. after write", &model->overhead_command_readhit_afterwrite, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read miss over. after read", &model->overhead_command_readmiss_afterread, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read miss over. after write", &model->overhead_command_readmiss_afterwrite, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Write over. after read", &model->overhead_command_write_afterread, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Write over. after write", &model->overhead_command_write_afterwrite, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read completion overhead", &model->overhead_complete_read, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Write completion overhead", &model->overhead_complete_write, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Data preparation overhead", &model->overhead_data_prep, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "First reselect overhead", &model->overhead_reselect_first, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Other reselect overhead", &model->overhead_reselect_other, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read disconnect afterread", &model->overhead_disconnect_read_afterread, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Read disconnect afterwrite", &model->overhead_disconnect_read_afterwrite, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Write disconnect overhead", &model->overhead_disconnect_write, 1, (double) 0.0, (double) 0.0);
+
+      getparam_bool(specfile, "Extra write disconnect:", &model->extra_write_disconnect);
+      getparam_double(specfile, "Extradisc command overhead", &model->extradisc_command, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Extradisc disconnect overhead", &model->extradisc_disconnect1, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Extradisc inter-disconnect delay", &model->extradisc_inter_disconnect, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Extradisc 2nd disconnect overhead", &model->extradisc_disconnect2, 1, (double) 0.0, (double) 0.0);
+      getparam_double(specfile, "Extradisc seek delta", &model->extradisc_seekdelta, 1, (double) 0.0, (double) 0.0);
+
+      getparam_double(specfile, "Minimum seek delay", &model->minimum_seek_delay, 1, (double) 0.0, (double) 0.0);
 
       getparam_int(specfile, "Number of bands", &numbands, 1, 1, 0);
 
+      model->refcnt = 0;
+      model->initialized = FALSE;
+      model->acctime = acctime;
+      model->seektime = seektime;
+      model->seekavg = seekavg;
+      model->hpseek[0] = hp1;
+      model->hpseek[1] = hp2;
+      model->hpseek[2] = hp3;
+      model->hpseek[3] = hp4;
+      model->hpseek[4] = hp5;
+      model->hpseek[5] = hp6;
+      for (j=0; j<10; j++) {
+	 model->first10seeks[j] = first10seeks[j];
+      }
+      model->extractseekcnt = extractseekcnt;
+      model->extractseekdists = extractseekdists;
+      model->extractseektimes = extractseektimes;
+      model->seektablen = 0;
+      model->seektable = NULL;
+      model->seekfloor = NULL;
+      model->numbands = numbands;
+      model->bandstarts = NULL;
+      model->bands = (band *) malloc(numbands*(sizeof(band)));
+      ASSERT(model->bands != NULL);
+      band_read_specs(model->bands, numbands, specfile, model->numsurfaces, model->sparescheme);
+
       for (i=diskno; i<(diskno+copies); i++) {
-         disks[i].acctime = acctime;
-         disks[i].seektime = seektime;
-         disks[i].seekone = currdisk->seekone;
-         disks[i].seekavg = seekavg;
-         disks[i].seekfull = currdisk->seekfull;
-	 disks[i].seekwritedelta = currdisk->seekwritedelta;
-         disks[i].hpseek[0] = hp1;
-         disks[i].hpseek[1] = hp2;
-         disks[i].hpseek[2] = hp3;
-         disks[i].hpseek[3] = hp4;
-         disks[i].hpseek[4] = hp5;
-         disks[i].hpseek[5] = hp6;
-	 for (j=0; j<10; j++) {
-	    disks[i].first10seeks[j] = first10seeks[j];
-	 }
-	 disks[i].extractseekcnt = extractseekcnt;
-	 disks[i].extractseekdists = extractseekdists;
-	 disks[i].extractseektimes = extractseektimes;
-         disks[i].headswitch = currdisk->headswitch;
-         disks[i].rpm = currdisk->rpm;
-         disks[i].rpmerr = currdisk->rpmerr;
-         disks[i].numsurfaces = currdisk->numsurfaces;
-         disks[i].numcyls = currdisk->numcyls;
-         disks[i].numblocks = currdisk->numblocks;
-         disks[i].sparescheme = currdisk->sparescheme;
+	 disks[i].model = model;
+	 model->refcnt++;
+	 disks[i].posbatch = NULL;
          disks[i].printstats = currdisk->printstats;
-         disks[i].sectpercyl = currdisk->sectpercyl;
 	 disks[i].devno = i;
          disks[i].maxqlen = currdisk->maxqlen;
          disks[i].write_hit_stop_readahead = currdisk->write_hit_stop_readahead;
          disks[i].read_direct_to_buffer = currdisk->read_direct_to_buffer;
          disks[i].immedtrans_any_readhit = currdisk->immedtrans_any_readhit;
-         disks[i].extra_write_disconnect = currdisk->extra_write_disconnect;
-         disks[i].overhead_command_readhit_afterread = currdisk->overhead_command_readhit_afterread;
-         disks[i].overhead_command_readhit_afterwrite = currdisk->overhead_command_readhit_afterwrite;
-         disks[i].overhead_command_readmiss_afterread = currdisk->overhead_command_readmiss_afterread;
-         disks[i].overhead_command_readmiss_afterwrite = currdisk->overhead_command_readmiss_afterwrite;
-         disks[i].overhead_command_write_afterread = currdisk->overhead_command_write_afterread;
-         disks[i].overhead_command_write_afterwrite = currdisk->overhead_command_write_afterwrite;
-         disks[i].overhead_complete_read = currdisk->overhead_complete_read;
-         disks[i].overhead_complete_write = currdisk->overhead_complete_write;
-         disks[i].overhead_data_prep = currdisk->overhead_data_prep;
-         disks[i].overhead_reselect_first = currdisk->overhead_reselect_first;
-         disks[i].overhead_reselect_other = currdisk->overhead_reselect_other;
-         disks[i].overhead_disconnect_read_afterread = currdisk->overhead_disconnect_read_afterread;
-         disks[i].overhead_disconnect_read_afterwrite = currdisk->overhead_disconnect_read_afterwrite;
-         disks[i].overhead_disconnect_write = currdisk->overhead_disconnect_write;
-         disks[i].extradisc_command = currdisk->extradisc_command;
-         disks[i].extradisc_disconnect1 = currdisk->extradisc_disconnect1;
-         disks[i].extradisc_inter_disconnect = currdisk->extradisc_inter_disconnect;
-         disks[i].extradisc_disconnect2 = currdisk->extradisc_disconnect2;
-         disks[i].extradisc_seekdelta = currdisk->extradisc_seekdelta;
-         disks[i].minimum_seek_delay = currdisk->minimum_seek_delay;
          disks[i].readanyfreeblocks = currdisk->readanyfreeblocks;
-         disks[i].overhead = currdisk->overhead;
-         disks[i].timescale = currdisk->timescale;
-         disks[i].blktranstime = currdisk->blktranstime;
          disks[i].hold_bus_for_whole_read_xfer = currdisk->hold_bus_for_whole_read_xfer;
          disks[i].hold_bus_for_whole_write_xfer = currdisk->hold_bus_for_whole_write_xfer;
          disks[i].almostreadhits = currdisk->almostreadhits;
@@ -1141,17 +1418,10 @@ FILE *parfile;
 	 disks[i].effectivebus = NULL;
 	 disks[i].pendxfer = NULL;
 	 disks[i].outwait = NULL;
-         disks[i].numbands = numbands;
+         disks[i].mapcache = 1;
 	 if (i != diskno) {
 	    disks[i].queue = ioqueue_copy(currdisk->queue);
 	 }
-         disks[i].bands = (band *) malloc(numbands*(sizeof(band)));
-	 ASSERT(disks[i].bands != NULL);
-	 if (i == diskno) {
-            band_read_specs(currdisk->bands, numbands, specfile, currdisk->numsurfaces, currdisk->sparescheme);
-         } else {
-	    bandcopy(disks[i].bands, currdisk->bands, numbands);
-	 }
       }
       diskno += copies;
    }
@@ -1308,6 +1578,24 @@ char *prefix;
 }
 
 
+void disk_estimate_printstats(set, setsize, prefix)
+int *set;
+int setsize;
+char *prefix;
+{
+   double estimates = 0.0;
+   int i;
+
+   if (disk_printestimatestats == FALSE)
+      return;
+
+   for (i=0; i<setsize; i++) {
+      estimates += disks[(set[i])].stat.estimates;
+   }
+   fprintf(outputfile, "%sPositioning estimates:        %.0f\n", prefix, estimates);
+}
+
+
 void disk_seek_printstats(set, setsize, prefix)
 int *set;
 int setsize;
@@ -1356,7 +1644,7 @@ char *prefix;
       statset[i] = &disks[(set[i])].stat.rotlatstats;
    }
    if (setsize == 1) {
-      fprintf (outputfile, "%sFull rotation time:      %f\n", prefix, disks[(set[0])].rotatetime);
+      fprintf (outputfile, "%sFull rotation time:      %f\n", prefix, disks[(set[0])].model->rotatetime);
    }
    zerofrac = (double) zeros / (double) stat_get_count_set(statset, setsize);
    fprintf (outputfile, "%sZero rotate latency:\t%d\t%f\n", prefix, zeros, zerofrac);
@@ -1462,6 +1750,7 @@ void disk_printstats()
    disk_acctime_printstats(set, numdisks, prefix);
    disk_interfere_printstats(set, numdisks, prefix);
    disk_buffer_printstats(set, numdisks, prefix);
+   disk_estimate_printstats(set, numdisks, prefix);
    fprintf (outputfile, "\n\n");
 
    if (numdisks <= 1) {
@@ -1477,7 +1766,7 @@ void disk_printstats()
 	 continue;
       }
       fprintf(outputfile, "Disk #%d:\n\n", i);
-      fprintf(outputfile, "Disk #%d highest block number requested: %d\n", i, disks[i].stat.highblkno);
+      fprintf(outputfile, "Disk #%d highest block number requested: %lld\n", i, disks[i].stat.highblkno);
       sprintf(prefix, "Disk #%d ", i);
       ioqueue_printstats(&disks[i].queue, 1, prefix);
       disk_seek_printstats(&set[i], 1, prefix);
@@ -1486,6 +1775,7 @@ void disk_printstats()
       disk_acctime_printstats(&set[i], 1, prefix);
       disk_interfere_printstats(&set[i], 1, prefix);
       disk_buffer_printstats(&set[i], 1, prefix);
+      disk_estimate_printstats(&set[i], 1, prefix);
       fprintf (outputfile, "\n\n");
    }
 }
@@ -49,9 +49,6 @@
 #include "disksim_stat.h"
 #include "disksim_ioqueue.h"
 
-#define MAXSLIPS	32
-#define MAXDEFECTS	256
-
 /* Seek types */
 
 #define THREEPOINT_LINE         -1.0
@@ -143,16 +140,16 @@ typedef struct seg {
    int          state;
    struct seg  *next;
    struct seg  *prev;
-   int          startblkno;
-   int          endblkno;
+   lbn_t        startblkno;
+   lbn_t        endblkno;
    int          outstate;
    int		outbcount;
-   int		minreadaheadblkno;      /* min prefetch blkno + 1 */
-   int		maxreadaheadblkno;      /* max prefetch blkno + 1 */
+   lbn_t	minreadaheadblkno;      /* min prefetch blkno + 1 */
+   lbn_t	maxreadaheadblkno;      /* max prefetch blkno + 1 */
    struct diskreq_t *diskreqlist;       /* sorted by ascendingly first blkno */
    int          size;
    ioreq_event *access;
-   int		hold_blkno; 		/* used for prepending */
+   lbn_t	hold_blkno; 		/* used for prepending */
    int		hold_bcount;		/* sequential writes   */
    struct diskreq_t *recyclereq;        /* diskreq to recycle this seg */
 } segment;
@@ -162,8 +159,8 @@ typedef struct diskreq_t {
    ioreq_event 	       *ioreqlist;	/* sorted by ascending blkno */
    struct diskreq_t    *seg_next;
    struct diskreq_t    *bus_next;
-   int			outblkno;
-   int			inblkno;
+   lbn_t		outblkno;
+   lbn_t		inblkno;
    segment	       *seg;
    int          	watermark;
    int			hittype;
@@ -178,7 +175,7 @@ typedef struct {
    int     seekdistance;
    int     zeroseeks;
    int     zerolatency;
-   int     highblkno;
+   lbn_t   highblkno;
    statgen seekdiststats;
    statgen seektimestats;
    statgen rotlatstats;
@@ -200,6 +197,7 @@ typedef struct {
    double  requestedbus;
    double  waitingforbus;
    int     numbuswaits;
+   double  estimates;
 } diskstat;
 
 typedef struct {
@@ -210,16 +208,80 @@ typedef struct {
    double firstblkno;
    double cylskew;
    double trackskew;
-   int    blksinband;
+   lbn_t  blksinband;
    int    sparecnt;
    int    numslips;
    int    numdefects;
-   int    slip[MAXSLIPS];
-   int    defect[MAXDEFECTS];
-   int    remap[MAXDEFECTS];
+   lbn_t *slip;		/* numslips entries, NULL if none */
+   lbn_t *defect;	/* numdefects entries each, NULL if none */
+   lbn_t *remap;
+   int   *remapindex;	/* defect indices in ascending remap order */
 } band;
 
+/* Candidate accesses for disk_position_batch, as parallel arrays: the   */
+/* target track and first sector on it, the sectors to access there,     */
+/* read flag, immediate-access flag and the time the access could start. */
+/* seektimes and postimes (seek plus rotational positioning, as for      */
+/* DISKSERVTIME) are filled in.  ids is free for the caller's use.       */
+
+typedef struct {
+   int      count;
+   int      size;		/* allocated length of each array */
+   int     *ids;
+   band   **bands;
+   int     *cylnos;
+   int     *surfaces;
+   int     *blknos;
+   int     *bcounts;
+   int     *reads;
+   int     *immeds;
+   double  *starttimes;
+   double  *seektimes;
+   double  *postimes;
+} diskbatch;
+
+/* One track in the translation cache (see disk_translate_lbn_to_pbn).  */
+/* Only tracks whose LBNs run straight across their sectors, with no     */
+/* slips or defects in between, are cached, so any LBN in [startlbn,     */
+/* endlbn) is on sector firstblkno + (lbn - startlbn).                   */
+
+#define MAPCACHE_SIZE	4
+
 typedef struct {
+   band   *currband;		/* NULL if the entry is unused */
+   int     cylno;
+   int     surfaceno;
+   lbn_t   startlbn;
+   lbn_t   endlbn;
+   int     firstblkno;
+   double  skew;
+} mapcacheentry;
+
+/* Breakdown of a positioning computation (see disk_position).           */
+
+typedef struct {
+   int     seekdistance;
+   int     trackstart;		/* first sector transferred on the track */
+   double  seektime;
+   double  latency;		/* includes addtolatency */
+   double  addtolatency;	/* extra rotation when wrapping the track */
+   double  xfertime;
+} disktiming;
+
+/* Parameters shared by every disk built from one disk spec: geometry,   */
+/* the seek curve, rotation speed and the fixed overheads.  A spec for   */
+/* hundreds of identical disks is read (and its bands and seek tables    */
+/* built) once.  refcnt counts the disks using the model; anything that  */
+/* would change it for some of them (a per-disk override, spindle speed  */
+/* error) first moves those disks onto a copy (see disk_model_private).  */
+/* Models are read-only once disk_model_initialize has run.              */
+
+typedef struct diskmodel {
+   int		refcnt;
+   int		initialized;
+   double       rpm;
+   double	rpmerr;
+   double	rotatetime;
    double       acctime;
    double       seektime;
    double       seekone;
@@ -231,22 +293,87 @@ typedef struct {
    int		extractseekcnt;
    int *	extractseekdists;
    double *	extractseektimes;
+   int		seektablen;	/* distances covered by seektable */
+   double *	seektable;	/* see disk_seektime_table_initialize */
+   double *	seekfloor;	/* ditto */
    double       headswitch;
-   double	rotatetime;
-   double	rpmerr;
-   double       rpm;
    double	overhead;
    double	timescale;
-   int		devno;
-   int          syncset;
+   double	blktranstime;
    int          numsurfaces;
-   int          numblocks;
+   lbn_t        numblocks;
    int          numcyls;
    int          numbands;
    int		sparescheme;
+   int		sectpercyl;     /* "Avg" value used in suboptimal schedulers */
    band        *bands;
+   lbn_t       *bandstarts;	/* first LBN of each band, then numblocks */
+   double	overhead_command_readhit_afterread;
+   double	overhead_command_readhit_afterwrite;
+   double	overhead_command_readmiss_afterread;
+   double	overhead_command_readmiss_afterwrite;
+   double	overhead_command_write_afterread;
+   double	overhead_command_write_afterwrite;
+   double	overhead_complete_read;
+   double	overhead_complete_write;
+   double	overhead_data_prep;
+   double	overhead_reselect_first;
+   double	overhead_reselect_other;
+   double	overhead_disconnect_read_afterread;
+   double	overhead_disconnect_read_afterwrite;
+   double	overhead_disconnect_write;
+   int		extra_write_disconnect;
+   double	extradisc_command;
+   double	extradisc_disconnect1;
+   double	extradisc_inter_disconnect;
+   double	extradisc_disconnect2;
+   double	extradisc_seekdelta;
+   double	minimum_seek_delay;
+} diskmodel;
+
+/* Per-disk state.  The fields touched on nearly every event (head       */
+/* position, bus and buffer ownership) come first, filling the first two */
+/* cache lines on LP64 machines; configuration and bookkeeping follow.   */
+
+typedef struct {
+   diskmodel   *model;
    struct ioq  *queue;
-   int		sectpercyl;     /* "Avg" value used in suboptimal schedulers */
+   double       currangle;
+   double       currtime;
+   int          currcylno;
+   int          currsurface;
+   int          busy;
+   int		outstate;
+   int		busowned;
+   int		lastflags;
+   int          qlen;
+   int		blksdone;
+   diskreq     *currenthda;
+   diskreq     *effectivehda;
+   diskreq     *currentbus;
+   diskreq     *effectivebus;
+   diskreq     *pendxfer;
+   ioreq_event *buswait;
+   ioreq_event *outwait;
+   double	starttrans;
+   int		immed;
+   int          lastgen;
+   lbn_t	immedstart;
+   lbn_t	immedend;
+   lbn_t	firstblkontrack;
+   lbn_t	endoftrack;
+   segment     *seglist;
+   int		numdirty;
+   int		prev_readahead_min;
+   int		translatesectbysect;
+   int		devno;
+   int          syncset;
+   int          maxqlen;
+   int		mapcache;	/* 0 off, 1 on, 2 on and cross-checked */
+   int		mapcachenext;	/* entry to replace next */
+   lbn_t	mapcachelast;	/* last LBN translated without the cache */
+   mapcacheentry mapcacheentries[MAPCACHE_SIZE];
+   diskbatch *	posbatch;	/* scratch for disk_get_servtime_batch */
    int		hold_bus_for_whole_read_xfer;
    int		hold_bus_for_whole_write_xfer;
    int		almostreadhits;
@@ -257,10 +384,6 @@ typedef struct {
    int		writeprebuffering;
    int		preseeking;
    int		neverdisconnect;
-   int          qlen;
-   int          maxqlen;
-   int          busy;
-   int		prev_readahead_min;
    int		write_hit_stop_readahead;
    int		read_direct_to_buffer;
    int		immedtrans_any_readhit;
@@ -273,7 +396,6 @@ typedef struct {
    double	readwater;
    int		reqwater;
    int		sectbysect;
-   int		translatesectbysect;
    int		enablecache;
    int		contread;
    int		minreadahead;
@@ -281,59 +403,13 @@ typedef struct {
    int		keeprequestdata;
    int		readaheadifidle;
    int		fastwrites;
-   int		numdirty;
    int		immedread;
    int		immedwrite;
-   int		immed;
    int		writecomb;
    int		stopinsector;
    int		disconnectinseek;
-   int		immedstart;
-   int		immedend;
-   segment     *seglist;
-   double	overhead_command_readhit_afterread;
-   double	overhead_command_readhit_afterwrite;
-   double	overhead_command_readmiss_afterread;
-   double	overhead_command_readmiss_afterwrite;
-   double	overhead_command_write_afterread;
-   double	overhead_command_write_afterwrite;
-   double	overhead_complete_read;
-   double	overhead_complete_write;
-   double	overhead_data_prep;
-   double	overhead_reselect_first;
-   double	overhead_reselect_other;
-   double	overhead_disconnect_read_afterread;
-   double	overhead_disconnect_read_afterwrite;
-   double	overhead_disconnect_write;
    struct diskreq_t *extradisc_diskreq;
-   int		extra_write_disconnect;
-   double	extradisc_command;
-   double	extradisc_disconnect1;
-   double	extradisc_inter_disconnect;
-   double	extradisc_disconnect2;
-   double	extradisc_seekdelta;
-   double	minimum_seek_delay;
-   int		firstblkontrack;
-   int		endoftrack;
-   int          currcylno;
-   int          currsurface;
-   double       currangle;
-   double       currtime;
-   int          lastgen;
-   int		lastflags;
    int          printstats;
-   double	starttrans;
-   double	blktranstime;
-   int		outstate;
-   diskreq     *pendxfer;
-   diskreq     *currenthda;
-   diskreq     *effectivehda;
-   diskreq     *currentbus;
-   diskreq     *effectivebus;
-   int		blksdone;
-   int		busowned;
-   ioreq_event *buswait;
-   ioreq_event *outwait;
    int          numinbuses;
    int          inbuses[MAXINBUSES];
    int          depth[MAXINBUSES];
@@ -366,7 +442,17 @@ extern void disk_activate_write();
 extern int diskspecialseektime();
 extern int diskspecialaccesstime();
 extern void disk_read_extracted_seek_curve();
+extern void disk_seektime_table_initialize();
 extern double diskseektime();
+extern double disk_pbn_angle();
+extern double disk_head_get_blkno();
+extern double disk_head_latency();
+extern double disk_head_xfertime();
+extern double disk_position();
+extern void disk_position_batch();
+extern void disk_position_batch_entry();
+extern double disk_seektime_floor();
+extern diskbatch * disk_batch_reserve();
 extern double disklatency();
 extern double diskxfertime();
 extern double diskacctime();
@@ -391,10 +477,11 @@ extern int disk_buffer_stopable_access();
 /* disksim_diskmap.c functions */
 
 extern band * disk_translate_lbn_to_pbn();
-extern int disk_translate_pbn_to_lbn();
+extern lbn_t disk_translate_pbn_to_lbn();
 extern double disk_map_pbn_skew();
 extern void disk_get_lbn_boundaries_for_track();
 extern void disk_check_numblocks();
+extern void disk_map_initialize();
 
 /* disksim_diskcache.c functions */
 
@@ -402,7 +489,7 @@ extern segment * disk_buffer_select_segment();
 extern segment * disk_buffer_recyclable_segment();
 extern diskreq * disk_buffer_seg_owner();
 extern int disk_buffer_attempt_seg_ownership();
-extern int disk_buffer_get_max_readahead();
+extern lbn_t disk_buffer_get_max_readahead();
 extern int disk_buffer_block_available();
 extern int disk_buffer_reusable_segment_check();
 extern int disk_buffer_overlap();
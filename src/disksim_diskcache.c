@@ -56,7 +56,7 @@ int LRU_at_seg_list_head = 0;
 
 int disk_buffer_segment_wrap_needed(seg, endblkno)
 segment *seg;
-int endblkno;
+lbn_t endblkno;
 {
    return(seg->startblkno < (endblkno - seg->size));
 }
@@ -64,7 +64,7 @@ int endblkno;
 
 void disk_buffer_segment_wrap(seg, endblkno)
 segment *seg;
-int endblkno;
+lbn_t endblkno;
 {
    seg->startblkno = max(seg->startblkno, (endblkno - seg->size));
 }
@@ -74,7 +74,7 @@ int disk_buffer_overlap(seg, curr)
 segment *seg;
 ioreq_event *curr;
 {
-   int tmp;
+   lbn_t tmp;
 
    if ((curr->blkno >= seg->startblkno) && (curr->blkno < seg->endblkno)) {
       return(TRUE);
@@ -180,7 +180,7 @@ fprintf (outputfile, "%12.6f            Entering disk_buffer_reusable_segment_ch
 fflush(outputfile);
 }
 
-   if (currdisk->acctime < 0.0 && !currseg->recyclereq && currdiskreq && 
+   if (currdisk->model->acctime < 0.0 && !currseg->recyclereq && currdiskreq && 
        !currdiskreq->seg_next && currdiskreq->ioreqlist && 
        !(currdiskreq->flags & COMPLETION_RECEIVED)) {
       if (currdiskreq->ioreqlist->flags & READ) {
@@ -245,7 +245,7 @@ fprintf (outputfile, "%12.6f            Entering disk_buffer_recyclable_segment_
 fflush(outputfile);
 }
 
-   if (currdisk->acctime < 0.0 && !currseg->recyclereq && currdiskreq && 
+   if (currdisk->model->acctime < 0.0 && !currseg->recyclereq && currdiskreq && 
        !currdiskreq->seg_next && currdiskreq->ioreqlist && 
        !(currdiskreq->flags & COMPLETION_RECEIVED)) {
       if (currdiskreq->ioreqlist->flags & READ) {
@@ -315,7 +315,7 @@ fprintf (outputfile, "                        numdirty = %d\n", currdisk->numdir
 fflush(outputfile);
 }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       return(NULL);
    }
 
@@ -350,7 +350,7 @@ fflush(outputfile);
 int disk_buffer_block_available(currdisk, seg, blkno)
 disk *currdisk;
 segment *seg;
-int blkno;
+lbn_t blkno;
 {
    diskreq *seg_owner;
 
@@ -377,7 +377,7 @@ int blkno;
 	 return(FALSE);
       }
       if ((currdisk->effectivehda->ioreqlist) && 
-	  (currdisk->extra_write_disconnect)) {
+	  (currdisk->model->extra_write_disconnect)) {
 	 if (currdisk->effectivehda->ioreqlist->bcount < 45) {
 	    if ((seg->endblkno - seg->startblkno) < 
 		min(currdisk->effectivehda->ioreqlist->bcount, 10)) {
@@ -484,7 +484,7 @@ int hittype;
          break;
 
       default:
-	 fprintf(stderr, "Invalid hittype in disk_buffer_stats - blkno %d, bcount %d, state %d\n", curr->blkno, curr->bcount, seg->state);
+	 fprintf(stderr, "Invalid hittype in disk_buffer_stats - blkno %lld, bcount %d, state %d\n", curr->blkno, curr->bcount, seg->state);
          exit(0);
    }
    return;
@@ -961,7 +961,7 @@ int set_extradisc;
 {
    segment *seg;
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       currdiskreq->seg = NULL;
       currdiskreq->hittype = BUFFER_NOMATCH;
       return(NULL);
@@ -981,7 +981,7 @@ int set_extradisc;
    /* and this is a write following a non-sequential write, set the        */
    /* EXTRA_WRITE_DISCONNECT diskreq flag.  */
 
-   if (set_extradisc && currdisk->extra_write_disconnect && 
+   if (set_extradisc && currdisk->model->extra_write_disconnect && 
        !currdisk->neverdisconnect && !currdisk->extradisc_diskreq && 
        !(currdiskreq->ioreqlist->flags & READ) && seg && 
        ((LRU_at_seg_list_head && !seg->prev) ||
@@ -1291,7 +1291,7 @@ fflush(outputfile);
 	 break;
 
       default:
-	 fprintf(stderr, "Invalid segment state in disk_buffer_set_segment - blkno %d, bcount %d, state %d\n", currdiskreq->ioreqlist->blkno, currdiskreq->ioreqlist->bcount, seg->state);
+	 fprintf(stderr, "Invalid segment state in disk_buffer_set_segment - blkno %lld, bcount %d, state %d\n", currdiskreq->ioreqlist->blkno, currdiskreq->ioreqlist->bcount, seg->state);
          exit(0);
    }
 
@@ -1451,7 +1451,7 @@ fflush(outputfile);
                   exit(0);
 	       }
                seg->hold_blkno = seg->startblkno;
-	       seg->hold_bcount = seg->endblkno - seg->startblkno;
+	       seg->hold_bcount = (int) (seg->endblkno - seg->startblkno);
 	    }
 	 } else {
 	    break;
@@ -1511,8 +1511,8 @@ fflush(outputfile);
 	    while (currioreq->next) {
 	       currioreq = currioreq->next;
 	    }
-	    seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((currioreq->blkno + currioreq->bcount + currdisk->minreadahead), currdisk->numblocks));
-	    seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,currioreq), currdisk->numblocks));
+	    seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((currioreq->blkno + currioreq->bcount + currdisk->minreadahead), currdisk->model->numblocks));
+	    seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,currioreq), currdisk->model->numblocks));
 
 	    if ((seg->endblkno >= (currioreq->blkno + currioreq->bcount)) &&
 	        (currdisk->effectivehda == currdiskreq)) {
@@ -1559,12 +1559,12 @@ fflush(outputfile);
 }
 
 
-int disk_buffer_get_max_readahead(currdisk, seg, curr)
+lbn_t disk_buffer_get_max_readahead(currdisk, seg, curr)
 disk *currdisk;
 segment *seg;
 ioreq_event *curr;
 {
-   int endreq;
+   lbn_t endreq;
 
    if (!(curr->flags & READ)) {
       fprintf(stderr, "No read-ahead for write accesses, in disk_buffer_get_max_readahead\n");
@@ -1576,8 +1576,8 @@ ioreq_event *curr;
    if (currdisk->contread == BUFFER_NO_READ_AHEAD) {
       return(endreq);
    } else if (currdisk->contread == BUFFER_DEC_PREFETCH_SCHEME) {
-      int startlbn;
-      int endlbn;
+      lbn_t startlbn;
+      lbn_t endlbn;
       int cylno;
       int surface;
       int blkno;
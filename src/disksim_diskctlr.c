@@ -49,6 +49,7 @@
 #include "disksim_disk.h"
 #include "disksim_ioqueue.h"
 #include "disksim_bus.h"
+#include "disksim_timeline.h"
 
 extern int disk_printhack;
 extern double disk_printhacktime;
@@ -78,8 +79,12 @@ extern double disk_seek_stoptime;
 extern int remapsector;
 extern double addtolatency;
 extern int trackstart;
+extern double disk_positionings;
+
+/* Service/access time estimates handed out to schedulers so far */
+
+double disk_estimates = 0.0;
 
-int bandstart;
 
 double disk_get_servtime(diskno, req, checkcache, maxtime)
 int diskno;
@@ -90,11 +95,233 @@ double maxtime;
    double servtime;
 
    ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   disk_estimates++;
+   disks[diskno].stat.estimates++;
    servtime = disk_buffer_estimate_servtime(&disks[diskno], req, checkcache, maxtime);
    return(servtime);
 }
 
 
+/* Sets up a batch of candidate requests for disk_get_servtime_batch_entry */
+/* and fills in a lower bound on each one's service time (the shortest    */
+/* seek that could reach its cylinder).  Buffer hits, and all requests    */
+/* when the disk has a fixed access time, are resolved right away.        */
+/* Nothing here touches the disk's state.                                 */
+
+void disk_bound_servtime_batch(diskno, reqs, checkcache)
+int diskno;
+servbatch *reqs;
+int checkcache;
+{
+   disk *currdisk;
+   diskbatch *batch;
+   ioreq_event tmp;
+   int hittype;
+   int buffer_reading;
+   lbn_t lastontrack;
+   int cause;
+   int i, j;
+
+   ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   currdisk = &disks[diskno];
+   batch = disk_batch_reserve(currdisk, reqs->count);
+   for (i=0; i<reqs->count; i++) {
+      reqs->entries[i] = -1;
+      reqs->seektimes[i] = 0.0;
+      if (currdisk->model->acctime >= 0.0) {
+	 reqs->servtimes[i] = currdisk->model->acctime;
+	 reqs->bounds[i] = reqs->servtimes[i];
+	 continue;
+      }
+      if (checkcache) {
+	 tmp.devno = diskno;
+	 tmp.blkno = reqs->blknos[i];
+	 tmp.bcount = reqs->bcounts[i];
+	 tmp.flags = reqs->flags[i];
+	 tmp.time = reqs->times[i];
+	 buffer_reading = FALSE;
+	 hittype = disk_buffer_check_segments(currdisk, &tmp, &buffer_reading);
+	 if (hittype != BUFFER_NOMATCH) {
+	    if (hittype == BUFFER_APPEND) {
+	       reqs->servtimes[i] = 0.0;
+	    } else if (hittype == BUFFER_WHOLE) {
+	       reqs->servtimes[i] = (buffer_reading) ? reading_buffer_whole_servtime : buffer_whole_servtime;
+	    } else {
+	       reqs->servtimes[i] = (buffer_reading) ? reading_buffer_partial_servtime : buffer_partial_servtime;
+	    }
+	    reqs->bounds[i] = reqs->servtimes[i];
+	    continue;
+	 }
+      }
+      j = batch->count;
+      batch->ids[j] = i;
+      batch->bands[j] = disk_translate_lbn_to_pbn(currdisk, reqs->blknos[i], MAP_FULL, &batch->cylnos[j], &batch->surfaces[j], &cause);
+      disk_get_lbn_boundaries_for_track(currdisk, batch->bands[j], batch->cylnos[j], batch->surfaces[j], NULL, &lastontrack);
+      batch->blknos[j] = cause;
+      batch->bcounts[j] = (int) min(reqs->bcounts[i], (lastontrack - reqs->blknos[i]));
+      batch->reads[j] = reqs->flags[i] & READ;
+      batch->immeds[j] = (batch->reads[j]) ? currdisk->immedread : currdisk->immedwrite;
+      batch->starttimes[j] = reqs->times[i];
+      batch->count++;
+      reqs->entries[i] = j;
+      reqs->bounds[i] = disk_seektime_floor(currdisk, (batch->cylnos[j] - currdisk->currcylno));
+   }
+}
+
+
+/* Copies the result for entry j of currdisk's batch back to the request. */
+
+void disk_servtime_batch_result(currdisk, reqs, batch, j)
+disk *currdisk;
+servbatch *reqs;
+diskbatch *batch;
+int j;
+{
+   int i = batch->ids[j];
+
+   reqs->seektimes[i] = batch->seektimes[j];
+   reqs->servtimes[i] = batch->postimes[j];
+   if ((!batch->reads[j]) && (reqs->servtimes[i] < currdisk->model->minimum_seek_delay)) {
+      reqs->servtimes[i] = currdisk->model->minimum_seek_delay;
+   }
+}
+
+
+/* Batch estimates all start from the disk's current head state. */
+
+void disk_get_servtime_batch_head(currdisk, head)
+disk *currdisk;
+diskhead *head;
+{
+   head->cylno = currdisk->currcylno;
+   head->surface = currdisk->currsurface;
+   head->angle = currdisk->currangle;
+   head->time = currdisk->currtime;
+}
+
+
+/* Fills in the service time estimates for a batch of candidate requests, */
+/* as disk_get_servtime (with a maxtime too large to matter) would for    */
+/* each one, but without touching the disk's state.  The cache check and */
+/* mapping are done per request and then all the mechanical positioning  */
+/* is handed to disk_position_batch in one go.                           */
+
+void disk_get_servtime_batch(diskno, reqs, checkcache)
+int diskno;
+servbatch *reqs;
+int checkcache;
+{
+   disk *currdisk;
+   diskbatch *batch;
+   diskhead head;
+   int j;
+
+   disk_bound_servtime_batch(diskno, reqs, checkcache);
+   disk_estimates += reqs->count;
+   currdisk = &disks[diskno];
+   currdisk->stat.estimates += reqs->count;
+   batch = currdisk->posbatch;
+   disk_get_servtime_batch_head(currdisk, &head);
+   disk_position_batch(currdisk, &head, batch);
+   for (j=0; j<batch->count; j++) {
+      disk_servtime_batch_result(currdisk, reqs, batch, j);
+   }
+}
+
+
+/* Returns (and fills in) the service time estimate for request i of a    */
+/* batch set up by disk_bound_servtime_batch.                             */
+
+double disk_get_servtime_batch_entry(diskno, reqs, i)
+int diskno;
+servbatch *reqs;
+int i;
+{
+   disk *currdisk;
+   diskhead head;
+
+   ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   ASSERT((i >= 0) && (i < reqs->count));
+   disk_estimates++;
+   disks[diskno].stat.estimates++;
+   if (reqs->entries[i] >= 0) {
+      currdisk = &disks[diskno];
+      disk_get_servtime_batch_head(currdisk, &head);
+      disk_position_batch_entry(currdisk, &head, currdisk->posbatch, reqs->entries[i]);
+      disk_servtime_batch_result(currdisk, reqs, currdisk->posbatch, reqs->entries[i]);
+   }
+   return(reqs->servtimes[i]);
+}
+
+
+/* Fills in *head with diskno's current head state. */
+
+void disk_get_servtime_head(diskno, head)
+int diskno;
+diskhead *head;
+{
+   ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   disk_get_servtime_batch_head(&disks[diskno], head);
+}
+
+
+/* Returns the service time estimate that disk_get_servtime_batch (with  */
+/* no cache check) would give a request that could start at time, but    */
+/* from the head state *head rather than the disk's own, and fills in    */
+/* *endhead with where the head would be once the request's media access */
+/* is done.  Chaining these lets a scheduler evaluate whole sequences of */
+/* requests.  Tracks after the first are taken at the media rate, with   */
+/* no time for the switches between them, so for requests that cross     */
+/* tracks endhead->time is approximate.  Nothing here touches the disk.  */
+
+double disk_get_servtime_from(diskno, head, blkno, bcount, flags, time, endhead)
+int diskno;
+diskhead *head;
+lbn_t blkno;
+int bcount;
+int flags;
+double time;
+diskhead *endhead;
+{
+   disk *currdisk;
+   band *currband;
+   disktiming timing;
+   lbn_t lastontrack;
+   int cylno;
+   int surfaceno;
+   int physblkno;
+   int count;
+   int read = flags & READ;
+   double servtime;
+
+   ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   currdisk = &disks[diskno];
+   disk_estimates++;
+   currdisk->stat.estimates++;
+   *endhead = *head;
+   if (currdisk->model->acctime >= 0.0) {
+      endhead->time = time + currdisk->model->acctime;
+      return(currdisk->model->acctime);
+   }
+   currband = disk_translate_lbn_to_pbn(currdisk, blkno, MAP_FULL, &cylno, &surfaceno, &physblkno);
+   disk_get_lbn_boundaries_for_track(currdisk, currband, cylno, surfaceno, NULL, &lastontrack);
+   count = (int) min(bcount, (lastontrack - blkno));
+   disk_position(currdisk, currband, endhead, DISKACCTIME, read, time, cylno, surfaceno, physblkno, count, ((read) ? currdisk->immedread : currdisk->immedwrite), &timing);
+   servtime = timing.seektime + timing.latency;
+   if ((!read) && (servtime < currdisk->model->minimum_seek_delay)) {
+      servtime = currdisk->model->minimum_seek_delay;
+   }
+   if (count < bcount) {
+      currband = disk_translate_lbn_to_pbn(currdisk, (blkno + bcount - 1), MAP_FULL, &cylno, &surfaceno, &physblkno);
+      endhead->cylno = cylno;
+      endhead->surface = surfaceno;
+      endhead->angle = disk_pbn_angle(currdisk, currband, cylno, surfaceno, ((physblkno + 1) % currband->blkspertrack));
+      endhead->time += ((double) (bcount - count) / (double) currband->blkspertrack) * currdisk->model->rotatetime;
+   }
+   return(servtime);
+}
+
+
 double disk_get_acctime(diskno, req, maxtime)
 int diskno;
 ioreq_event *req;
@@ -103,11 +330,27 @@ double maxtime;
    double acctime;
 
    ASSERT1((diskno >= 0) && (diskno < numdisks), "diskno", diskno);
+   disk_estimates++;
+   disks[diskno].stat.estimates++;
    acctime = disk_buffer_estimate_acctime(&disks[diskno], req, maxtime);
    return(acctime);
 }
 
 
+/* Fills in the number of estimates handed out by the functions above,  */
+/* and the number of mechanical positionings computed (for any reason), */
+/* so far.  Callers take differences to find the cost of their work.   */
+/* The counts are kept as doubles, as long runs can exceed an int.     */
+
+void disk_get_estimate_counts(estimates, positionings)
+double *estimates;
+double *positionings;
+{
+   *estimates = disk_estimates;
+   *positionings = disk_positionings;
+}
+
+
 int disk_set_depth(diskno, inbusno, depth, slotno)
 int diskno;
 int inbusno;
@@ -168,8 +411,8 @@ ioreq_event *curr;
    double tmptime;
 
    tmptime = bus_get_transfer_time(disk_get_busno(curr), 1, (curr->flags & READ));
-   if (tmptime < disks[(curr->devno)].blktranstime) {
-      tmptime = disks[(curr->devno)].blktranstime;
+   if (tmptime < disks[(curr->devno)].model->blktranstime) {
+      tmptime = disks[(curr->devno)].model->blktranstime;
    }
    return(tmptime);
 }
@@ -233,6 +476,7 @@ int busno;
 double arbdelay;
 {
    ioreq_event *tmp;
+   reqtiming *timing;
 
    if ((devno < 0) || (devno > numdisks)) {
       fprintf(stderr, "Event arrive for illegal disk - devno %d, numdisks %d\n", devno, numdisks);
@@ -251,6 +495,9 @@ double arbdelay;
    disks[devno].stat.waitingforbus += simtime - disks[devno].stat.requestedbus;
    ASSERT (arbdelay == (simtime - disks[devno].stat.requestedbus));
    disks[devno].stat.numbuswaits++;
+   if ((timing = IO_TIMING(tmp))) {
+      timing->buswait += simtime - disks[devno].stat.requestedbus;
+   }
    bus_delay(busno, DISK, devno, tmp->time, tmp);
 }
 
@@ -276,7 +523,7 @@ fprintf (outputfile, "Entered disk_bus_delay_complete\n");
    } else {
       fprintf(stderr, "Must have multiple pending messages - need to fix or handle\n");
       fprintf(stderr, "%f, Completed delay %p, expected %p, next %p\n", simtime, curr, disks[devno].buswait, disks[devno].buswait->next);
-      fprintf(stderr, "type1 %d, type2 %d, cause1 %d, cause2 %d, blkno1 %d, blkno2 %d\n", curr->type, disks[devno].buswait->type, curr->cause, disks[devno].buswait->cause, curr->blkno, disks[devno].buswait->blkno);
+      fprintf(stderr, "type1 %d, type2 %d, cause1 %d, cause2 %d, blkno1 %lld, blkno2 %lld\n", curr->type, disks[devno].buswait->type, curr->cause, disks[devno].buswait->cause, curr->blkno, disks[devno].buswait->blkno);
       exit(0);
    }
    busno.value = curr->busno;
@@ -322,7 +569,7 @@ segment *seg;
       tmp->time = seg->time + disklatency(currdisk, tmp->tempptr1, seg->time, tmp->cause, tmp->bcount, 0);
       if (tmp->time < simtime) {
 	 blks = (double) ((band *) tmp->tempptr1)->blkspertrack;
-	 blks = (blks / currdisk->rotatetime) * (simtime - tmp->time);
+	 blks = (blks / currdisk->model->rotatetime) * (simtime - tmp->time);
 	 if (seg->state == BUFFER_READING) {
 	    seg->endblkno = tmp->blkno + (int) blks;
          } else {
@@ -431,7 +678,7 @@ fflush(outputfile);
 
    currdiskreq->flags |= COMPLETION_SENT;
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       if (currdiskreq->flags & HDA_OWNED) {
          fprintf(stderr, "disk_request_complete:  HDA_OWNED set for fixed-access-time disk\n");
          exit(0);
@@ -504,11 +751,11 @@ fflush(outputfile);
    curr->time = simtime;
    curr->type = IO_INTERRUPT_ARRIVE;
    curr->cause = COMPLETION;
-   delay = (curr->flags & READ) ? currdisk->overhead_complete_read : currdisk->overhead_complete_write;
-   if (currdisk->acctime >= 0.0) {
+   delay = (curr->flags & READ) ? currdisk->model->overhead_complete_read : currdisk->model->overhead_complete_write;
+   if (currdisk->model->acctime >= 0.0) {
       delay = 0.0;
    }
-   disk_send_event_up_path(curr, (delay * currdisk->timescale));
+   disk_send_event_up_path(curr, (delay * currdisk->model->timescale));
    currdisk->outstate = DISK_WAIT_FOR_CONTROLLER;
 }
 
@@ -575,11 +822,11 @@ fflush(outputfile);
       curr->type = IO_INTERRUPT_ARRIVE;
       curr->cause = DISCONNECT;
       if (tmpioreq->flags & READ) {
-         delay = ((currdisk->lastflags & READ) ? currdisk->overhead_disconnect_read_afterread : currdisk->overhead_disconnect_read_afterwrite);
+         delay = ((currdisk->lastflags & READ) ? currdisk->model->overhead_disconnect_read_afterread : currdisk->model->overhead_disconnect_read_afterwrite);
       } else {
-         delay = ((currdiskreq->flags & EXTRA_WRITE_DISCONNECT) ? currdisk->extradisc_disconnect2 : currdisk->overhead_disconnect_write);
+         delay = ((currdiskreq->flags & EXTRA_WRITE_DISCONNECT) ? currdisk->model->extradisc_disconnect2 : currdisk->model->overhead_disconnect_write);
       }
-      disk_send_event_up_path(curr, (delay * currdisk->timescale));
+      disk_send_event_up_path(curr, (delay * currdisk->model->timescale));
       currdisk->outstate = DISK_WAIT_FOR_CONTROLLER;
    } else if (curr->bcount == 0) {
       disk_request_complete(currdisk, currdiskreq, curr);
@@ -815,7 +1062,7 @@ int check_watermark;
       return(NULL);
    }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
        if ((currdiskreq == currdisk->currenthda) && 
 	   (currdiskreq->overhead_done <= simtime)) {
           if (currdisk->outwait) {
@@ -862,7 +1109,7 @@ int check_watermark;
                busioreq->type = IO_INTERRUPT_ARRIVE;
                busioreq->cause = RECONNECT;
 	    }
-	    busioreq->bcount = min(seg->endblkno,(tmpioreq->blkno + tmpioreq->bcount)) - currdiskreq->outblkno;
+	    busioreq->bcount = (int) (min(seg->endblkno,(tmpioreq->blkno + tmpioreq->bcount)) - currdiskreq->outblkno);
 	 }
       } else {			/* WRITE */
          seg_owner = disk_buffer_seg_owner(seg,FALSE);
@@ -892,7 +1139,7 @@ int check_watermark;
 	        (currdiskreq->hittype != BUFFER_APPEND)) {
                busioreq->bcount = min(tmpioreq->bcount,seg->size);
 	    } else {
-               busioreq->bcount = min((tmpioreq->blkno + tmpioreq->bcount - currdiskreq->outblkno),(seg->size - seg->endblkno + seg_owner->inblkno));
+               busioreq->bcount = (int) min((tmpioreq->blkno + tmpioreq->bcount - currdiskreq->outblkno),(seg->size - seg->endblkno + seg_owner->inblkno));
 	    }
 	 }
       }
@@ -996,8 +1243,8 @@ fflush(outputfile);
 	       } else {
 if (disk_printhack && (simtime >= disk_printhacktime)) {
 fprintf (outputfile, "%12.6f         sneakyintermediatereadhits removed diskreq from seg\n",simtime);
-fprintf (outputfile, "                       seg = %d-%d\n", currdiskreq->seg->startblkno, currdiskreq->seg->endblkno);
-fprintf (outputfile, "                       diskreq = %d, %d, %d (1==R)\n",currdiskreq->ioreqlist->blkno, currdiskreq->ioreqlist->bcount, (currdiskreq->ioreqlist->flags & READ));
+fprintf (outputfile, "                       seg = %lld-%lld\n", currdiskreq->seg->startblkno, currdiskreq->seg->endblkno);
+fprintf (outputfile, "                       diskreq = %lld, %d, %d (1==R)\n",currdiskreq->ioreqlist->blkno, currdiskreq->ioreqlist->bcount, (currdiskreq->ioreqlist->flags & READ));
 fflush(outputfile);
 }
 	          disk_buffer_remove_from_seg(currdiskreq);
@@ -1199,21 +1446,21 @@ fflush(outputfile);
 	 }
          if (currdisk->extradisc_diskreq == nextdiskreq) {
             currdisk->extradisc_diskreq = NULL;
-	    delay = currdisk->overhead_reselect_first;
+	    delay = currdisk->model->overhead_reselect_first;
          } else {
-            delay = ((nextdiskreq->flags & EXTRA_WRITE_DISCONNECT) ? currdisk->overhead_reselect_other : currdisk->overhead_reselect_first);
+            delay = ((nextdiskreq->flags & EXTRA_WRITE_DISCONNECT) ? currdisk->model->overhead_reselect_other : currdisk->model->overhead_reselect_first);
 	 }
 	 if (busioreq->bcount > 0) {
-            delay += currdisk->overhead_data_prep;
+            delay += currdisk->model->overhead_data_prep;
 	 }
-	 if (currdisk->acctime >= 0.0) {
+	 if (currdisk->model->acctime >= 0.0) {
 	    delay = 0.0;
 	 } else {
             nextdiskreq->seg->outstate = BUFFER_CONTACTING;
 	 }
 
          currdisk->outstate = DISK_WAIT_FOR_CONTROLLER;
-         disk_send_event_up_path(busioreq, (delay * currdisk->timescale));
+         disk_send_event_up_path(busioreq, (delay * currdisk->model->timescale));
 
       } else if (busioreq->cause == DISK_DATA_TRANSFER_COMPLETE) {
 	 disk_reconnection_or_transfer_complete(busioreq);
@@ -1250,7 +1497,7 @@ ioreq_event *curr;
    if (((currdiskreq != seg->recyclereq) && disk_buffer_block_available(currdisk, seg, curr->blkno)) || ((curr->flags & READ) && (!currdisk->read_direct_to_buffer))) {
       curr->type = DISK_GOT_REMAPPED_SECTOR;
    } else {
-      curr->time -= ((double) 1 / (double) ((band *) curr->tempptr1)->blkspertrack) * currdisk->rotatetime;
+      curr->time -= ((double) 1 / (double) ((band *) curr->tempptr1)->blkspertrack) * currdisk->model->rotatetime;
       curr->type = DISK_GOTO_REMAPPED_SECTOR;
    }
 }
@@ -1273,12 +1520,12 @@ ioreq_event *curr;
       return;
    }
    if ((currdiskreq != seg->recyclereq) && disk_buffer_block_available(currdisk, seg, curr->blkno)) {
-      curr->time += ((double) 1 / (double) ((band *) curr->tempptr1)->blkspertrack) * currdisk->rotatetime;
+      curr->time += ((double) 1 / (double) ((band *) curr->tempptr1)->blkspertrack) * currdisk->model->rotatetime;
       curr->type = DISK_GOT_REMAPPED_SECTOR;
    } else {
-      seg->time += currdisk->rotatetime;
-      currdisk->stat.xfertime += currdisk->rotatetime;
-      curr->time += currdisk->rotatetime;
+      seg->time += currdisk->model->rotatetime;
+      currdisk->stat.xfertime += currdisk->model->rotatetime;
+      curr->time += currdisk->model->rotatetime;
       curr->type = DISK_GOTO_REMAPPED_SECTOR;
    }
    addtointq((event *) curr);
@@ -1296,7 +1543,7 @@ double mintime;
    double seektime;
 
 if (disk_printhack && (simtime >= disk_printhacktime)) {
-fprintf (outputfile, "%12.6f            Entering disk_initiate_seek to %d for disk %d\n", simtime, curr->blkno, curr->devno);
+fprintf (outputfile, "%12.6f            Entering disk_initiate_seek to %lld for disk %d\n", simtime, curr->blkno, curr->devno);
 fflush(outputfile);
 }
 
@@ -1360,7 +1607,7 @@ fprintf (outputfile, "%12.6f  %8p  Entering disk_check_hda for disk %d\n", simti
 fflush(outputfile);
 }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       return;
    }
 
@@ -1453,8 +1700,8 @@ fflush(outputfile);
 	          seg->access->blkno = seg->endblkno;
 	       }
 	       if (!seg->recyclereq) {
-	          seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((nextioreq->blkno + nextioreq->bcount + currdisk->minreadahead), currdisk->numblocks));
-	          seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,nextioreq), currdisk->numblocks));
+	          seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((nextioreq->blkno + nextioreq->bcount + currdisk->minreadahead), currdisk->model->numblocks));
+	          seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,nextioreq), currdisk->model->numblocks));
 	       }
 	       currdisk->immed = currdisk->immedread;
 	       seg->state = BUFFER_READING;
@@ -1492,7 +1739,7 @@ fflush(outputfile);
 		   (seg->access->blkno != nextdiskreq->ioreqlist->blkno) ||
 		   (seg->access->bcount != 1) ||
 		   (seg->access->time != simtime)) {
-                  mintime = currdisk->minimum_seek_delay;
+                  mintime = currdisk->model->minimum_seek_delay;
 	       } 
 /*
 	       else {
@@ -1679,8 +1926,8 @@ fflush(outputfile);
 	 }
          seg->access->flags = currioreq->flags;
 
-         seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((currioreq->blkno + currioreq->bcount + currdisk->minreadahead), currdisk->numblocks));
-         seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,currioreq), currdisk->numblocks));
+         seg->minreadaheadblkno = max(seg->minreadaheadblkno, min((currioreq->blkno + currioreq->bcount + currdisk->minreadahead), currdisk->model->numblocks));
+         seg->maxreadaheadblkno = max(seg->maxreadaheadblkno, min(disk_buffer_get_max_readahead(currdisk,seg,currioreq), currdisk->model->numblocks));
 
          if ((seg->endblkno >= (currioreq->blkno + currioreq->bcount)) &&
              (seg->endblkno < seg->maxreadaheadblkno)) {
@@ -1724,12 +1971,12 @@ fprintf (outputfile, "                        setseg = %d\n", setseg);
 fflush(outputfile);
 }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       if (!currdisk->currenthda) {
          currdisk->currenthda = 
    	   currdisk->effectivehda = 
    	   currdisk->currentbus = currdiskreq;
-         currdiskreq->overhead_done = simtime + currdisk->acctime;
+         currdiskreq->overhead_done = simtime + currdisk->model->acctime;
          currioreq = ioreq_copy(currdiskreq->ioreqlist);
          currioreq->ioreq_hold_diskreq = currdiskreq;
          currioreq->type = DISK_PREPARE_FOR_DATA_TRANSFER;
@@ -1809,11 +2056,11 @@ fprintf (outputfile, "                        setseg = %d\n", setseg);
 fflush(outputfile);
 }
 
-   if (!currdisk->currenthda && (currdisk->acctime >= 0.0)) {
+   if (!currdisk->currenthda && (currdisk->model->acctime >= 0.0)) {
       currdisk->currenthda = 
 	currdisk->effectivehda = 
 	currdisk->currentbus = currdiskreq;
-      currdiskreq->overhead_done = simtime + currdisk->acctime;
+      currdiskreq->overhead_done = simtime + currdisk->model->acctime;
       currioreq = ioreq_copy(currdiskreq->ioreqlist);
       currioreq->ioreq_hold_diskreq = currdiskreq;
       currioreq->type = DISK_PREPARE_FOR_DATA_TRANSFER;
@@ -1888,8 +2135,8 @@ ioreq_event *curr;
    if ((curr->blkno + curr->bcount -1) > currdisk->stat.highblkno) {
       currdisk->stat.highblkno = curr->blkno + curr->bcount - 1;
    }
-   if ((curr->blkno < 0) || (curr->bcount <= 0) || ((curr->blkno + curr->bcount) > currdisk->numblocks)) {
-      fprintf(stderr, "Invalid set of blocks requested from disk - blkno %d, bcount %d, numblocks %d\n", curr->blkno, curr->bcount, currdisk->numblocks);
+   if ((curr->blkno < 0) || (curr->bcount <= 0) || ((curr->blkno + curr->bcount) > currdisk->model->numblocks)) {
+      fprintf(stderr, "Invalid set of blocks requested from disk - blkno %lld, bcount %d, numblocks %lld\n", curr->blkno, curr->bcount, currdisk->model->numblocks);
       exit(0);
    }
    currdisk->busowned = disk_get_busno(curr);
@@ -1906,7 +2153,7 @@ ioreq_event *curr;
 
 if (disk_printhack && (simtime >= disk_printhacktime)) {
 fprintf (outputfile, "%12.6f  %8p  Entering disk_request_arrive\n", simtime, new_diskreq);
-fprintf (outputfile, "                        disk = %d, blkno = %d, bcount = %d, read = %d\n",curr->devno, curr->blkno, curr->bcount, (READ & curr->flags));
+fprintf (outputfile, "                        disk = %d, blkno = %lld, bcount = %d, read = %d\n",curr->devno, curr->blkno, curr->bcount, (READ & curr->flags));
 fflush(outputfile);
 }
 
@@ -1936,8 +2183,8 @@ fflush(outputfile);
          compatible with the old simulator.
       */
 
-      new_diskreq->overhead_done = ((currdisk->lastflags & READ) ? currdisk->overhead_command_readmiss_afterread : currdisk->overhead_command_readmiss_afterwrite);
-      new_diskreq->overhead_done *= currdisk->timescale;
+      new_diskreq->overhead_done = ((currdisk->lastflags & READ) ? currdisk->model->overhead_command_readmiss_afterread : currdisk->model->overhead_command_readmiss_afterwrite);
+      new_diskreq->overhead_done *= currdisk->model->timescale;
       new_diskreq->overhead_done += simtime;
 
       switch (new_diskreq->hittype) {
@@ -1975,7 +2222,7 @@ fflush(outputfile);
             */
 	    if (currdisk->neverdisconnect || 
 		(enough_ready_to_go && !currdisk->currentbus &&
-		 (currdisk->acctime < 0.0) && 
+		 (currdisk->model->acctime < 0.0) && 
 	         ((currdisk->sneakyfullreadhits && (new_diskreq->hittype == BUFFER_WHOLE)) || 
 	          (currdisk->sneakypartialreadhits && (new_diskreq->hittype == BUFFER_PARTIAL)) || 
 	          (!currdisk->pendxfer && (!currdisk->effectivehda || disk_buffer_stopable_access(currdisk,new_diskreq)))))) {
@@ -1986,39 +2233,39 @@ fflush(outputfile);
 		  seg->outstate = BUFFER_CONTACTING;
 	       }
 	       if (new_diskreq->hittype == BUFFER_NOMATCH) {
-	          delay = ((currdisk->lastflags & READ) ? currdisk->overhead_command_readmiss_afterread : currdisk->overhead_command_readmiss_afterwrite);
+	          delay = ((currdisk->lastflags & READ) ? currdisk->model->overhead_command_readmiss_afterread : currdisk->model->overhead_command_readmiss_afterwrite);
 	       } else {
 	          delay = ((currdisk->lastflags & READ) ? 
-	                   currdisk->overhead_command_readhit_afterread : 
-		           currdisk->overhead_command_readhit_afterwrite);
+	                   currdisk->model->overhead_command_readhit_afterread : 
+		           currdisk->model->overhead_command_readhit_afterwrite);
 	       }
-               delay += currdisk->overhead_data_prep;
-	       if (currdisk->acctime >= 0.0) {
+               delay += currdisk->model->overhead_data_prep;
+	       if (currdisk->model->acctime >= 0.0) {
 		  delay = 0.0;
 	       }
-               disk_send_event_up_path(intrp, (delay * currdisk->timescale));
+               disk_send_event_up_path(intrp, (delay * currdisk->model->timescale));
 	       disk_activate_read(currdisk, new_diskreq, FALSE, TRUE);
             } else {
                intrp->cause = DISCONNECT;
-	       delay = ((currdisk->lastflags & READ) ? currdisk->overhead_command_readmiss_afterread : currdisk->overhead_command_readmiss_afterwrite);
-               delay += ((currdisk->lastflags & READ) ? currdisk->overhead_disconnect_read_afterread : currdisk->overhead_disconnect_read_afterwrite);
-	       if (currdisk->acctime >= 0.0) {
+	       delay = ((currdisk->lastflags & READ) ? currdisk->model->overhead_command_readmiss_afterread : currdisk->model->overhead_command_readmiss_afterwrite);
+               delay += ((currdisk->lastflags & READ) ? currdisk->model->overhead_disconnect_read_afterread : currdisk->model->overhead_disconnect_read_afterwrite);
+	       if (currdisk->model->acctime >= 0.0) {
 		  delay = 0.0;
 	       }
-               disk_send_event_up_path(intrp, (delay * currdisk->timescale));
+               disk_send_event_up_path(intrp, (delay * currdisk->model->timescale));
 	       disk_activate_read(currdisk, new_diskreq, TRUE, TRUE);
             }
             break;
 
          default:
-            fprintf(stderr, "Invalid read hittype in disk_request_arrive - blkno %d, bcount %d, hittype %d\n", curr->blkno, curr->bcount, new_diskreq->hittype);
+            fprintf(stderr, "Invalid read hittype in disk_request_arrive - blkno %lld, bcount %d, hittype %d\n", curr->blkno, curr->bcount, new_diskreq->hittype);
             exit(0);
       }
    } else { 				/* WRITE */
 
       /* set up overhead_done to delay any mechanical activity */
-      new_diskreq->overhead_done = ((currdisk->lastflags & READ) ? currdisk->overhead_command_write_afterread : currdisk->overhead_command_write_afterwrite);
-      new_diskreq->overhead_done *= currdisk->timescale;
+      new_diskreq->overhead_done = ((currdisk->lastflags & READ) ? currdisk->model->overhead_command_write_afterread : currdisk->model->overhead_command_write_afterwrite);
+      new_diskreq->overhead_done *= currdisk->model->timescale;
       new_diskreq->overhead_done += simtime;
 
       /* LIMITED_FASTWRITE checking is done for "free", as there will 
@@ -2027,18 +2274,18 @@ fflush(outputfile);
       */
 
       if (currdisk->neverdisconnect || 
-	  (seg && !currdisk->currentbus && (currdisk->acctime < 0.0) &&
+	  (seg && !currdisk->currentbus && (currdisk->model->acctime < 0.0) &&
 	   (currdisk->writeprebuffering || 
 	    (!currdisk->pendxfer && (!currdisk->effectivehda || disk_buffer_stopable_access(currdisk,new_diskreq)))))) {
 	 if ((new_diskreq->flags & EXTRA_WRITE_DISCONNECT) &&
-	     (currdisk->acctime < 0.0)) {
+	     (currdisk->model->acctime < 0.0)) {
             /* re-set up overhead_done to delay any mechanical activity */
-            new_diskreq->overhead_done = currdisk->extradisc_command + currdisk->extradisc_seekdelta;
-            new_diskreq->overhead_done *= currdisk->timescale;
+            new_diskreq->overhead_done = currdisk->model->extradisc_command + currdisk->model->extradisc_seekdelta;
+            new_diskreq->overhead_done *= currdisk->model->timescale;
             new_diskreq->overhead_done += simtime;
 	    currdisk->extradisc_diskreq = new_diskreq;
 	    intrp->cause = DISCONNECT;
-	    delay = currdisk->extradisc_command + currdisk->extradisc_disconnect1;
+	    delay = currdisk->model->extradisc_command + currdisk->model->extradisc_disconnect1;
 	    extra_write_disconnects++;
 	    if (seg) {
 	       seg->outstate = BUFFER_IDLE;
@@ -2046,9 +2293,9 @@ fflush(outputfile);
 	 } else {
             intrp->cause = READY_TO_TRANSFER;
 	    delay = ((currdisk->lastflags & READ) ? 
-	             currdisk->overhead_command_write_afterread : 
-	             currdisk->overhead_command_write_afterwrite);
-            delay += currdisk->overhead_data_prep;
+	             currdisk->model->overhead_command_write_afterread : 
+	             currdisk->model->overhead_command_write_afterwrite);
+            delay += currdisk->model->overhead_data_prep;
 	    if (seg) {
 	       seg->outstate = BUFFER_CONTACTING;
             }
@@ -2057,20 +2304,20 @@ fflush(outputfile);
 	 if (seg) {
 	    disk_buffer_set_segment(currdisk,new_diskreq);
 	 }
-	 if (currdisk->acctime >= 0.0) {
+	 if (currdisk->model->acctime >= 0.0) {
 	    delay = 0.0;
 	 }
-         disk_send_event_up_path(intrp, (delay * currdisk->timescale));
+         disk_send_event_up_path(intrp, (delay * currdisk->model->timescale));
 	 disk_activate_write(currdisk, new_diskreq, FALSE, TRUE);
       } else {
 	 new_diskreq->flags &= ~EXTRA_WRITE_DISCONNECT;
          intrp->cause = DISCONNECT;
-         delay = ((currdisk->lastflags & READ) ? currdisk->overhead_command_write_afterread : currdisk->overhead_command_write_afterwrite);
-         delay += currdisk->overhead_disconnect_write;
-	 if (currdisk->acctime >= 0.0) {
+         delay = ((currdisk->lastflags & READ) ? currdisk->model->overhead_command_write_afterread : currdisk->model->overhead_command_write_afterwrite);
+         delay += currdisk->model->overhead_disconnect_write;
+	 if (currdisk->model->acctime >= 0.0) {
 	    delay = 0.0;
 	 }
-         disk_send_event_up_path(intrp, (delay * currdisk->timescale));
+         disk_send_event_up_path(intrp, (delay * currdisk->model->timescale));
          disk_activate_write(currdisk, new_diskreq, TRUE, TRUE);
       }
    }
@@ -2121,7 +2368,7 @@ fflush(outputfile);
          tmpioreq = ioreq_copy(tmpioreq);
 	 tmpioreq->ioreq_hold_diskreq = currdiskreq;
          tmpioreq->type = DISK_PREPARE_FOR_DATA_TRANSFER;
-         tmpioreq->time = simtime + currdisk->extradisc_inter_disconnect;
+         tmpioreq->time = simtime + currdisk->model->extradisc_inter_disconnect;
          addtointq((event *) tmpioreq);
       } else {
          currdisk->currentbus = NULL;
@@ -2165,7 +2412,7 @@ fflush(outputfile);
    }
 
    seg = currdiskreq->seg;
-   if (!seg && currdisk->acctime < 0.0) {
+   if (!seg && currdisk->model->acctime < 0.0) {
       fprintf(stderr, "NULL seg found in effectivebus in disk_completion\n");
       exit(0);
    }
@@ -2204,7 +2451,7 @@ fflush(outputfile);
       currdisk->outstate = DISK_IDLE;
    }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       addtoextraq((event *) currdiskreq->ioreqlist);
       addtoextraq((event *) currdiskreq);
       return;
@@ -2311,8 +2558,8 @@ fprintf (outputfile, "Entered disk_event_arrive - devno %d, blkno %d, type %d, c
    switch (curr->type) {
 
       case IO_ACCESS_ARRIVE:
-         if (disks[(curr->devno)].overhead > 0.0) {
-            curr->time = simtime + (disks[(curr->devno)].overhead * disks[(curr->devno)].timescale);
+         if (disks[(curr->devno)].model->overhead > 0.0) {
+            curr->time = simtime + (disks[(curr->devno)].model->overhead * disks[(curr->devno)].model->timescale);
             curr->type = DISK_OVERHEAD_COMPLETE;
             addtointq((event *) curr);
          } else {
@@ -2375,6 +2622,29 @@ fprintf (outputfile, "Exiting disk_event arrive\n");
 }
 
 
+/* Lays the access's seek, rotational latency and media transfer out back */
+/* to back on the disk's timeline track, ending now.                       */
+
+void disk_timeline_access(currdisk, currdiskreq)
+disk    *currdisk;
+diskreq *currdiskreq;
+{
+   ioreq_event *tmpioreq = currdiskreq->ioreqlist;
+   double start;
+   int reqid = 0;
+
+   while ((tmpioreq) && ((reqid = timeline_sampled(tmpioreq)) == 0)) {
+      tmpioreq = tmpioreq->next;
+   }
+   start = simtime - currdisk->stat.seektime - currdisk->stat.latency - currdisk->stat.xfertime;
+   timeline_span(TIMELINE_DISK, currdisk->devno, "seek", start, (start + currdisk->stat.seektime), reqid);
+   start += currdisk->stat.seektime;
+   timeline_span(TIMELINE_DISK, currdisk->devno, "rotate", start, (start + currdisk->stat.latency), reqid);
+   start += currdisk->stat.latency;
+   timeline_span(TIMELINE_DISK, currdisk->devno, "transfer", start, (start + currdisk->stat.xfertime), reqid);
+}
+
+
 /* Possible improvements:
 
    As write sectors complete, appending writes may be able to put more data
@@ -2398,6 +2668,7 @@ diskreq *currdiskreq;
    int reqdone = FALSE;
    int hold_type;
    double acctime;
+   reqtiming *timing;
    int watermark = FALSE;
    ioreq_event *tmpioreq = currdiskreq->ioreqlist;
    segment *seg = currdiskreq->seg;
@@ -2484,6 +2755,18 @@ fflush(outputfile);
       if (currdisk->stat.seekdistance != -1) {
          acctime = currdisk->stat.seektime + currdisk->stat.latency + currdisk->stat.xfertime;
          disk_acctimestats(currdisk, currdisk->stat.seekdistance, currdisk->stat.seektime, currdisk->stat.latency, currdisk->stat.xfertime, acctime);
+         tmpioreq = currdiskreq->ioreqlist;
+         while (tmpioreq) {
+            if ((timing = IO_TIMING(tmpioreq))) {
+               timing->seektime += currdisk->stat.seektime;
+               timing->latency += currdisk->stat.latency;
+               timing->xfertime += currdisk->stat.xfertime;
+            }
+            tmpioreq = tmpioreq->next;
+         }
+         if (TIMELINE_ON) {
+            disk_timeline_access(currdisk, currdiskreq);
+         }
       }
       tmpioreq = currdiskreq->ioreqlist;
       while (tmpioreq) {
@@ -2551,9 +2834,9 @@ ioreq_event *curr;
    }
 
    if ((currdiskreq == seg->recyclereq) || !disk_buffer_block_available(currdisk, seg, curr->blkno)) {
-      seg->time += currdisk->rotatetime;
-      currdisk->stat.xfertime += currdisk->rotatetime;
-      curr->time += currdisk->rotatetime;
+      seg->time += currdisk->model->rotatetime;
+      currdisk->stat.xfertime += currdisk->model->rotatetime;
+      curr->time += currdisk->model->rotatetime;
       curr->type = DISK_GOT_REMAPPED_SECTOR;
       addtointq((event *) curr);
    } else {
@@ -2641,7 +2924,7 @@ fprintf (outputfile, "Entered disk_buffer_update_ongoing - devno %d\n", seg->req
    }
    disk_buffer_segment_wrap(seg, seg->endblkno);
    if ((seg->state == BUFFER_WRITING) && ((seg_owner->inblkno < seg->startblkno) || (seg_owner->inblkno > seg->endblkno))) {
-      fprintf(stderr, "Error with inblkno at disk_buffer_update_outbuffer: %d, %d, %d, %d\n", seg_owner->inblkno, seg->startblkno, seg->endblkno, blks);
+      fprintf(stderr, "Error with inblkno at disk_buffer_update_outbuffer: %lld, %lld, %lld, %d\n", seg_owner->inblkno, seg->startblkno, seg->endblkno, blks);
       exit(0);
    }
 /*
@@ -2688,7 +2971,7 @@ fprintf (outputfile, "Entered disk_buffer_transfer_size - devno %d\n", curr->dev
 fprintf (outputfile, "outstate %d, outblkno %d, outbcount %d, endblkno %d, inblkno %d\n", seg->outstate, currdiskreq->outblkno, seg->outbcount, seg->endblkno, seg->inblkno);
 */
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       if (currdiskreq->overhead_done <= simtime) {
          curr->bcount = 0;
       } else {
@@ -2740,7 +3023,7 @@ fprintf (outputfile, "outstate %d, outblkno %d, outbcount %d, endblkno %d, inblk
       }
       if (seg->endblkno > currdiskreq->outblkno) {
          seg->outstate = BUFFER_TRANSFERING;
-	 curr->bcount = seg->outbcount = min(seg->endblkno,(tmpioreq->blkno + tmpioreq->bcount)) - currdiskreq->outblkno;
+	 curr->bcount = seg->outbcount = (int) (min(seg->endblkno,(tmpioreq->blkno + tmpioreq->bcount)) - currdiskreq->outblkno);
       } else if (currdisk->hold_bus_for_whole_read_xfer || 
 		 currdisk->neverdisconnect) {
 	 seg->outstate = BUFFER_TRANSFERING;
@@ -2814,7 +3097,7 @@ fprintf (outputfile, "outstate %d, outblkno %d, outbcount %d, endblkno %d, inblk
 
       }
       seg->outstate = BUFFER_TRANSFERING;
-      curr->bcount = seg->outbcount = 
+      curr->bcount = seg->outbcount = (int)
 	min((seg->size - (currdiskreq->outblkno - seg_owner->inblkno)), 
 	    (tmpioreq->blkno + tmpioreq->bcount - currdiskreq->outblkno));
 /*
@@ -2875,7 +3158,7 @@ ioreq_event* currioreq;
       exit(0);
    }
 
-   if (currdisk->acctime >= 0.0) {
+   if (currdisk->model->acctime >= 0.0) {
       return(TRUE);
    }
 
@@ -3233,13 +3516,13 @@ ioreq_event *curr;
    diskreq *currdiskreq = currdisk->effectivehda;
    ioreq_event *tmpioreq;
    int blks_on_track;
-   int start_of_track;
-   int end_of_track;
-   int firstblkno;
-   int lastblkno;
+   lbn_t start_of_track;
+   lbn_t end_of_track;
+   lbn_t firstblkno;
+   lbn_t lastblkno;
    int endlat = 0;
-   int currblkno;
-   int currcause;
+   lbn_t currblkno;
+   lbn_t currcause;
    double mydiff;
 
    if (!currdiskreq) {
@@ -3257,9 +3540,8 @@ fprintf (outputfile, "\nEntering disk_buffer_sector_done - devno %d, bcount %d,
    if (!currdisk->translatesectbysect) {
       currblkno = (curr->blkno == start_of_track) ? (end_of_track-1) : (curr->blkno-1);
    } else {
-      currcause = (curr->cause) ? (curr->cause-1) : (blks_on_track-1);
       remapsector = FALSE;
-      currblkno = disk_translate_pbn_to_lbn(currdisk, curr->tempptr1, currdisk->currcylno, currdisk->currsurface, currcause);
+      currblkno = disk_translate_pbn_to_lbn(currdisk, curr->tempptr1, currdisk->currcylno, currdisk->currsurface, ((curr->cause) ? (curr->cause-1) : (blks_on_track-1)));
       if (remapsector | (currblkno < 0)) {
 	 currblkno = -1;
 	 if (curr->bcount) {
@@ -3274,7 +3556,7 @@ fprintf (outputfile, "Cylno %d, Surface %d\n", currdisk->currcylno, currdisk->cu
 */
 
    if (curr->bcount) {
-      currdisk->currangle += (simtime - seg->time) / currdisk->rotatetime;
+      currdisk->currangle += (simtime - seg->time) / currdisk->model->rotatetime;
       currdisk->currangle -= (double) ((int) currdisk->currangle);
       currdisk->currtime = simtime;
       if ((!currdisk->read_direct_to_buffer) && (curr->flags & READ) && (curr->bcount == 1) && (!(disk_buffer_block_available(currdisk, seg, currblkno)))) {
@@ -3289,7 +3571,7 @@ fprintf (outputfile, "trackstart %d, blkno %d, cause %d\n", trackstart, curr->bl
       /* This is purely for self-checking.  Can be removed. */
       if ((mydiff > 0.000000001) && (mydiff > (0.00000000001 * simtime))) {
          fprintf(stderr, "Times don't match in disk_buffer_sector_done - exp %f real %f\n", simtime, curr->time);
-	 fprintf(stderr, "devno %d, blkno %d, bcount %d, bandno %p, blkinband %d\n", curr->devno, curr->blkno, curr->bcount, curr->tempptr1, (curr->blkno-bandstart));
+	 fprintf(stderr, "devno %d, blkno %lld, bcount %d, bandno %p, blkinband %lld\n", curr->devno, curr->blkno, curr->bcount, curr->tempptr1, (curr->blkno - currdisk->model->bandstarts[((band *) curr->tempptr1 - currdisk->model->bands)]));
          exit(0);
       }
    }
@@ -3407,13 +3689,12 @@ fprintf (outputfile, "Leaving disk_buffer_sector_done\n");
       curr->cause = ((curr->cause+1) == blks_on_track) ? 0 : (curr->cause+1);
       curr->blkno += curr->cause;
       seg->time = simtime;
-      curr->time = seg->time + (currdisk->rotatetime / (double) blks_on_track);
+      curr->time = seg->time + (currdisk->model->rotatetime / (double) blks_on_track);
       if (!currdisk->translatesectbysect) {
          currcause = (curr->blkno == start_of_track) ? (end_of_track-1) : (curr->blkno-1);
       } else {
-         currcause = (curr->cause) ? (curr->cause-1) : (blks_on_track-1);
 	 remapsector = FALSE;
-         currcause = disk_translate_pbn_to_lbn(currdisk, curr->tempptr1, currdisk->currcylno, currdisk->currsurface, currcause);
+         currcause = disk_translate_pbn_to_lbn(currdisk, curr->tempptr1, currdisk->currcylno, currdisk->currsurface, ((curr->cause) ? (curr->cause-1) : (blks_on_track-1)));
 	 if (remapsector) {
 	    currcause = -1;
 	 }
@@ -3452,12 +3733,12 @@ double disk_estimate_acctime(currdisk, curr)
 disk *currdisk;
 ioreq_event *curr;
 {
-   int tmpblkno;
+   lbn_t tmpblkno;
    int tmpbcount;
    double runtime = 0.0;
    double starttime;
-   int firstontrack;
-   int lastontrack;
+   lbn_t firstontrack;
+   lbn_t lastontrack;
    int immed;
    int cylno;
    int surfaceno;
@@ -3472,7 +3753,7 @@ ioreq_event *curr;
       currcylno = cylno;
       currsurface = surfaceno;
       disk_get_lbn_boundaries_for_track(currdisk, curr->tempptr1, currcylno, currsurface, &firstontrack, &lastontrack);
-      curr->bcount = min((tmpblkno + tmpbcount - curr->blkno), (lastontrack - curr->blkno));
+      curr->bcount = (int) min((tmpblkno + tmpbcount - curr->blkno), (lastontrack - curr->blkno));
       curr->bcount = (remapsector) ? 1 : curr->bcount;
       curr->time = starttime + runtime;
       runtime += disklatency(currdisk, curr->tempptr1, curr->time, curr->cause, curr->bcount, immed);
@@ -3513,11 +3794,11 @@ double maxtime;
 {
    double tmptime;
    int tmpblkno;
-   int lastontrack;
+   lbn_t lastontrack;
    int hittype = BUFFER_NOMATCH;
 
-   if (currdisk->acctime >= 0.0) {
-      return(currdisk->acctime);
+   if (currdisk->model->acctime >= 0.0) {
+      return(currdisk->model->acctime);
    }
 
    if (checkcache) {
@@ -3542,13 +3823,13 @@ double maxtime;
    if (curr->time < maxtime) {
       curr->time = tmptime;
       disk_get_lbn_boundaries_for_track(currdisk, curr->tempptr1, currcylno, currsurface, NULL, &lastontrack);
-      curr->bcount = min(curr->bcount, (lastontrack - curr->blkno));
+      curr->bcount = (int) min(curr->bcount, (lastontrack - curr->blkno));
       curr->tempptr1 = disk_translate_lbn_to_pbn(currdisk, curr->blkno, MAP_FULL, &currcylno, &currsurface, &curr->cause);
       currdisk->immed = (curr->flags & READ) ? currdisk->immedread : currdisk->immedwrite;
       tmptime = diskacctime(currdisk, curr->tempptr1, DISKSERVTIME, (curr->flags & READ), curr->time, currcylno, currsurface, curr->cause, curr->bcount, currdisk->immed);
       curr->bcount = tmpblkno;
-      if ((!(curr->flags & READ)) && (tmptime < currdisk->minimum_seek_delay)) {
-         tmptime = currdisk->minimum_seek_delay;
+      if ((!(curr->flags & READ)) && (tmptime < currdisk->model->minimum_seek_delay)) {
+         tmptime = currdisk->model->minimum_seek_delay;
       }
    } else {
       tmptime = maxtime + 1.0;
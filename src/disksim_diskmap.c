@@ -51,6 +51,9 @@
 
 int remapsector = FALSE;
 
+band * disk_map_lbn_to_pbn();
+void disk_map_lbn_boundaries();
+
 
 int disk_get_numcyls(diskno)
 int diskno;
@@ -59,14 +62,14 @@ int diskno;
       fprintf(stderr, "Invalid diskno passed to disk_get_numcyls\n");
       exit(0);
    }
-   return(disks[diskno].numcyls);
+   return(disks[diskno].model->numcyls);
 }
 
 
 void disk_get_mapping(maptype, diskno, blkno, cylptr, surfaceptr, blkptr)
 int maptype;
 int diskno;
-int blkno;
+lbn_t blkno;
 int *cylptr;
 int *surfaceptr;
 int *blkptr;
@@ -79,14 +82,14 @@ int *blkptr;
 }
 
 
-int disk_get_number_of_blocks(diskno)
+lbn_t disk_get_number_of_blocks(diskno)
 int diskno;
 {
    if ((diskno < 0) || (diskno >= numdisks)) {
       fprintf(stderr, "Invalid diskno passed to disk_get_number_of_blocks\n");
       exit(0);
    }
-   return(disks[diskno].numblocks);
+   return(disks[diskno].model->numblocks);
 }
 
 
@@ -97,27 +100,216 @@ int devno;
       fprintf(stderr, "Invalid devno passed to disk_get_avg_sectpercyl: %d\n", devno);
       exit(0);
    }
-   return(disks[devno].sectpercyl);
+   return(disks[devno].model->sectpercyl);
 }
 
 
 void disk_check_numblocks(currdisk)
 disk *currdisk;
 {
-   int numblocks = 0;
+   lbn_t numblocks = 0;
    int i;
 
-   for (i=0; i < currdisk->numbands; i++) {
-      numblocks += currdisk->bands[i].blksinband;
+   for (i=0; i < currdisk->model->numbands; i++) {
+      numblocks += currdisk->model->bands[i].blksinband;
    }
-   if (numblocks != currdisk->numblocks) {
-      fprintf (outputfile, "Numblocks provided by user does not match specifications - user %d, actual %d\n", currdisk->numblocks, numblocks);
+   if (numblocks != currdisk->model->numblocks) {
+      fprintf (outputfile, "Numblocks provided by user does not match specifications - user %lld, actual %lld\n", currdisk->model->numblocks, numblocks);
    }
-   currdisk->numblocks = numblocks;
+   currdisk->model->numblocks = numblocks;
 }
 
 
-double disk_map_pbn_skew(currdisk, currband, cylno, surfaceno)
+typedef struct {
+   lbn_t value;
+   lbn_t assoc;
+   int   order;
+} mapentry;
+
+
+int disk_map_compare(a, b)
+const void *a;
+const void *b;
+{
+   mapentry *entry1 = (mapentry *) a;
+   mapentry *entry2 = (mapentry *) b;
+
+   if (entry1->value != entry2->value) {
+      return((entry1->value < entry2->value) ? -1 : 1);
+   }
+   return(entry1->order - entry2->order);
+}
+
+
+/* Sorts count values, and the parallel assoc values if any, in place.   */
+/* Equal values keep their original order, which the defect lookups      */
+/* below rely on.  If indexptr is given, it is set to a new array of the */
+/* original positions of the sorted values (and vals is left unchanged). */
+
+void disk_map_sort_list(vals, assoc, count, indexptr)
+lbn_t *vals;
+lbn_t *assoc;
+int count;
+int **indexptr;
+{
+   mapentry *entries;
+   int i;
+
+   if (count == 0) {
+      if (indexptr) {
+	 *indexptr = NULL;
+      }
+      return;
+   }
+   entries = (mapentry *) malloc(count * sizeof(mapentry));
+   ASSERT(entries != NULL);
+   for (i=0; i<count; i++) {
+      entries[i].value = vals[i];
+      entries[i].assoc = (assoc) ? assoc[i] : 0;
+      entries[i].order = i;
+   }
+   qsort(entries, count, sizeof(mapentry), disk_map_compare);
+   if (indexptr) {
+      *indexptr = (int *) malloc(count * sizeof(int));
+      ASSERT(*indexptr != NULL);
+      for (i=0; i<count; i++) {
+	 (*indexptr)[i] = entries[i].order;
+      }
+   } else {
+      for (i=0; i<count; i++) {
+	 vals[i] = entries[i].value;
+	 if (assoc) {
+	    assoc[i] = entries[i].assoc;
+	 }
+      }
+   }
+   free(entries);
+}
+
+
+/* Builds the prefix-summed band start table and puts each band's slip   */
+/* and defect lists in ascending order, so that the mapping code in both */
+/* directions can binary search them.  remapindex orders the defects by  */
+/* their remap targets for the PBN-to-LBN direction.  Bands do not       */
+/* change after the specs (and any defect list file) are read, so this   */
+/* is only done once per disk.                                           */
+
+void disk_map_initialize(currdisk)
+disk *currdisk;
+{
+   int i, j;
+   band *currband;
+
+   for (i=0; i<MAPCACHE_SIZE; i++) {
+      currdisk->mapcacheentries[i].currband = NULL;
+   }
+   currdisk->mapcachenext = 0;
+   currdisk->mapcachelast = -1;
+   if (currdisk->model->bandstarts) {
+      return;
+   }
+   currdisk->model->bandstarts = (lbn_t *) malloc((currdisk->model->numbands + 1) * sizeof(lbn_t));
+   ASSERT(currdisk->model->bandstarts != NULL);
+   currdisk->model->bandstarts[0] = 0;
+   for (i=0; i<currdisk->model->numbands; i++) {
+      currband = &currdisk->model->bands[i];
+      currdisk->model->bandstarts[(i+1)] = currdisk->model->bandstarts[i] + currband->blksinband;
+      disk_map_sort_list(currband->slip, NULL, currband->numslips, NULL);
+      for (j=1; j<currband->numslips; j++) {
+	 if (currband->slip[j] == currband->slip[(j-1)]) {
+	    fprintf(stderr, "Slip listed more than once in band %d: %lld\n", (i+1), currband->slip[j]);
+	    exit(0);
+	 }
+      }
+      disk_map_sort_list(currband->defect, currband->remap, currband->numdefects, NULL);
+      disk_map_sort_list(currband->remap, NULL, currband->numdefects, &currband->remapindex);
+   }
+}
+
+
+/* Returns the index of the first of the count ascending values that is */
+/* greater than or equal to value (count if there is none).            */
+
+int disk_map_lower_bound(vals, count, value)
+lbn_t *vals;
+int count;
+lbn_t value;
+{
+   int bottom = 0;
+   int top = count;
+   int i;
+
+   while (bottom < top) {
+      i = bottom + ((top - bottom) / 2);
+      if (vals[i] < value) {
+         bottom = i + 1;
+      } else {
+         top = i;
+      }
+   }
+   return(bottom);
+}
+
+
+/* Looks value up in the band's sorted defect list.  Where a value is     */
+/* listed more than once, the original linear scans used either the first */
+/* entry (lastmatch == FALSE) or the last one (lastmatch == TRUE).         */
+/* Returns the index into defect[] and remap[], or -1.                    */
+
+int disk_map_find_defect(currband, value, lastmatch)
+band *currband;
+lbn_t value;
+int lastmatch;
+{
+   int i = disk_map_lower_bound(currband->defect, currband->numdefects, value);
+
+   if ((i >= currband->numdefects) || (currband->defect[i] != value)) {
+      return(-1);
+   }
+   if (lastmatch) {
+      i = disk_map_lower_bound(currband->defect, currband->numdefects, (value + 1)) - 1;
+   }
+   return(i);
+}
+
+
+/* Returns the index of the last defect[] entry whose remap target is  */
+/* value, or -1 if no defect is remapped there.                        */
+
+int disk_map_find_remap(currband, value)
+band *currband;
+lbn_t value;
+{
+   int bottom = 0;
+   int top = currband->numdefects;
+   int i;
+
+   while (bottom < top) {
+      i = bottom + ((top - bottom) / 2);
+      if (currband->remap[currband->remapindex[i]] <= value) {
+	 bottom = i + 1;
+      } else {
+	 top = i;
+      }
+   }
+   if ((bottom == 0) || (currband->remap[currband->remapindex[(bottom-1)]] != value)) {
+      return(-1);
+   }
+   return(currband->remapindex[(bottom-1)]);
+}
+
+
+int disk_map_is_slipped(currband, value)
+band *currband;
+lbn_t value;
+{
+   int i = disk_map_lower_bound(currband->slip, currband->numslips, value);
+
+   return((i < currband->numslips) && (currband->slip[i] == value));
+}
+
+
+double disk_map_compute_skew(currdisk, currband, cylno, surfaceno)
 disk *currdisk;
 band *currband;
 int cylno;
@@ -128,68 +320,200 @@ int surfaceno;
    int slipoffs = 0;
 
    cylno -= currband->startcyl;
-   trackswitches = surfaceno + (currdisk->numsurfaces - 1) * cylno;
+   trackswitches = surfaceno + (currdisk->model->numsurfaces - 1) * cylno;
    skew += currband->trackskew * (double) trackswitches;
    skew += currband->cylskew * (double) cylno;
-   skew /= currdisk->rotatetime;
-   if ((currdisk->sparescheme == SECTPERCYL_SPARING) || (currdisk->sparescheme == SECTPERTRACK_SPARING)) {
-      int tracks = cylno * currdisk->numsurfaces;
-      int cutoff;
-      int i;
+   skew /= currdisk->model->rotatetime;
+   if ((currdisk->model->sparescheme == SECTPERCYL_SPARING) || (currdisk->model->sparescheme == SECTPERTRACK_SPARING)) {
+      int tracks = cylno * currdisk->model->numsurfaces;
 
-      if (currdisk->sparescheme == SECTPERTRACK_SPARING) {
+      if (currdisk->model->sparescheme == SECTPERTRACK_SPARING) {
 	 tracks += surfaceno;
       }
-      cutoff = tracks * currband->blkspertrack;
-      for (i=0; i<currband->numslips; i++) {
-	 if (currband->slip[i] < cutoff) {
-	    slipoffs++;
-	 }
-      }
+      slipoffs = disk_map_lower_bound(currband->slip, currband->numslips, ((lbn_t) tracks * currband->blkspertrack));
    }
    skew += (double) slipoffs / (double) currband->blkspertrack;
    return(skew);
 }
 
 
-int disk_pbn_to_lbn_sectpertrackspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
+/* The translation cache.  Sequential streams translate LBN after LBN on */
+/* the same track (e.g., disk_buffer_sector_done and read-ahead), and    */
+/* each lookup would otherwise find the band and work through the        */
+/* sparing all over again.  The cache remembers the last few tracks such */
+/* a stream has touched and answers disk_translate_lbn_to_pbn (MAP_FULL  */
+/* only), disk_get_lbn_boundaries_for_track and disk_map_pbn_skew for    */
+/* them directly.  A track is only cached if its mapping is a straight   */
+/* run of sectors with no defects on it, so none of the lookups it       */
+/* answers would have set remapsector.  With the disk's mapcache set to  */
+/* 2, every answer is checked against the uncached path.                 */
+
+mapcacheentry * disk_map_cache_find_lbn(currdisk, blkno)
+disk *currdisk;
+lbn_t blkno;
+{
+   mapcacheentry *entry;
+   int i;
+
+   for (i=0; i<MAPCACHE_SIZE; i++) {
+      entry = &currdisk->mapcacheentries[i];
+      if ((entry->currband) && (blkno >= entry->startlbn) && (blkno < entry->endlbn)) {
+	 return(entry);
+      }
+   }
+   return(NULL);
+}
+
+
+mapcacheentry * disk_map_cache_find_track(currdisk, currband, cylno, surfaceno)
 disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int blkno;
-int lbn;
 {
+   mapcacheentry *entry;
    int i;
-   int blkspercyl;
-   int firstblkoncyl;
 
-   blkspercyl = (currband->blkspertrack - currband->sparecnt) * currdisk->numsurfaces;
-   firstblkoncyl = (cylno - currband->startcyl) * currdisk->numsurfaces * currband->blkspertrack;
-   blkno += firstblkoncyl + (surfaceno * currband->blkspertrack);
-   for (i=(currband->numdefects-1); i>=0; i--) {
-      if (blkno == currband->defect[i]) {        /* Remapped bad block */
-	 return(-2);
+   for (i=0; i<MAPCACHE_SIZE; i++) {
+      entry = &currdisk->mapcacheentries[i];
+      if ((entry->currband == currband) && (entry->cylno == cylno) && (entry->surfaceno == surfaceno)) {
+	 return(entry);
       }
-      if (blkno == currband->remap[i]) {
-	 remapsector = TRUE;
-	 blkno = currband->defect[i];
-	 break;
+   }
+   return(NULL);
+}
+
+
+void disk_map_cache_mismatch(currdisk, what, blkno)
+disk *currdisk;
+char *what;
+lbn_t blkno;
+{
+   fprintf(stderr, "Translation cache mismatch for disk %d in %s: %lld\n", currdisk->devno, what, blkno);
+   exit(0);
+}
+
+
+/* Adds the track holding blkno to the cache, if it qualifies. */
+
+void disk_map_cache_fill(currdisk, blkno)
+disk *currdisk;
+lbn_t blkno;
+{
+   mapcacheentry *entry;
+   band *currband;
+   band *band1;
+   band *band2;
+   int cylno, surfaceno, blk;
+   int cyl1, surf1, blk1;
+   int cyl2, surf2, blk2;
+   lbn_t startlbn, endlbn;
+   int trackno;
+   lbn_t first;
+   int i;
+   int ok;
+   int saveremap = remapsector;
+
+   remapsector = FALSE;
+   currband = disk_map_lbn_to_pbn(currdisk, blkno, MAP_FULL, &cylno, &surfaceno, &blk);
+   disk_map_lbn_boundaries(currdisk, currband, cylno, surfaceno, &startlbn, &endlbn);
+   ok = ((startlbn >= 0) && (blkno >= startlbn) && (blkno < endlbn));
+   if (ok) {
+      remapsector = FALSE;
+      band1 = disk_map_lbn_to_pbn(currdisk, startlbn, MAP_FULL, &cyl1, &surf1, &blk1);
+      band2 = disk_map_lbn_to_pbn(currdisk, (endlbn - 1), MAP_FULL, &cyl2, &surf2, &blk2);
+      /* the mapping only ever moves forward, so if the ends are the  */
+      /* right distance apart, every LBN between is where it should be */
+      ok = ((!remapsector) && (band1 == currband) && (band2 == currband) && (cyl1 == cylno) && (cyl2 == cylno) && (surf1 == surfaceno) && (surf2 == surfaceno) && ((blk2 - blk1) == (endlbn - 1 - startlbn)) && ((blk - blk1) == (blkno - startlbn)));
+   }
+   if ((ok) && ((currdisk->model->sparescheme == SECTPERCYL_SPARING) || (currdisk->model->sparescheme == SECTPERTRACK_SPARING))) {
+      trackno = ((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno;
+      first = (lbn_t) trackno * currband->blkspertrack;
+      i = disk_map_lower_bound(currband->defect, currband->numdefects, first);
+      ok = ((i >= currband->numdefects) || (currband->defect[i] >= (first + currband->blkspertrack)));
+      if ((ok) && (currdisk->model->sparescheme == SECTPERTRACK_SPARING)) {
+	 /* disk_lbn_to_pbn_sectpertrackspare looks defects up this way */
+	 first = (lbn_t) trackno * (currband->blkspertrack - currband->sparecnt);
+	 i = disk_map_lower_bound(currband->defect, currband->numdefects, (first + blk1));
+	 ok = ((i >= currband->numdefects) || (currband->defect[i] > (first + blk2)));
       }
    }
-   for (i=(currband->numslips-1); i>=0; i--) {
-      if (blkno == currband->slip[i]) {          /* Slipped bad block */
-	 return(-1);
+   remapsector = saveremap;
+   if (!ok) {
+      return;
+   }
+   entry = &currdisk->mapcacheentries[currdisk->mapcachenext];
+   currdisk->mapcachenext = (currdisk->mapcachenext + 1) % MAPCACHE_SIZE;
+   entry->currband = currband;
+   entry->cylno = cylno;
+   entry->surfaceno = surfaceno;
+   entry->startlbn = startlbn;
+   entry->endlbn = endlbn;
+   entry->firstblkno = blk1;
+   entry->skew = disk_map_compute_skew(currdisk, currband, cylno, surfaceno);
+}
+
+
+double disk_map_pbn_skew(currdisk, currband, cylno, surfaceno)
+disk *currdisk;
+band *currband;
+int cylno;
+int surfaceno;
+{
+   mapcacheentry *entry;
+
+   if ((currdisk->mapcache) && ((entry = disk_map_cache_find_track(currdisk, currband, cylno, surfaceno)))) {
+      if ((currdisk->mapcache == 2) && (entry->skew != disk_map_compute_skew(currdisk, currband, cylno, surfaceno))) {
+	 disk_map_cache_mismatch(currdisk, "disk_map_pbn_skew", entry->startlbn);
       }
-      if ((blkno > currband->slip[i]) && ((currband->slip[i] / (currband->blkspertrack * currdisk->numsurfaces)) == (cylno - currband->startcyl)) && ((currband->slip[i] % (currband->blkspertrack * currdisk->numsurfaces)) == surfaceno)) {
+      return(entry->skew);
+   }
+   return(disk_map_compute_skew(currdisk, currband, cylno, surfaceno));
+}
+
+
+lbn_t disk_pbn_to_lbn_sectpertrackspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
+disk *currdisk;
+band *currband;
+int cylno;
+int surfaceno;
+lbn_t blkno;
+lbn_t lbn;
+{
+   int i;
+   int defectno;
+   int remapno;
+   int blkspercyl;
+   lbn_t firstblkoncyl;
+   int cylblks = currband->blkspertrack * currdisk->model->numsurfaces;
+
+   blkspercyl = (currband->blkspertrack - currband->sparecnt) * currdisk->model->numsurfaces;
+   firstblkoncyl = (lbn_t) (cylno - currband->startcyl) * cylblks;
+   blkno += firstblkoncyl + (surfaceno * currband->blkspertrack);
+   defectno = disk_map_find_defect(currband, blkno, TRUE);
+   remapno = disk_map_find_remap(currband, blkno);
+   if ((defectno != -1) && (defectno >= remapno)) {   /* Remapped bad block */
+      return(-2);
+   }
+   if (remapno != -1) {
+      remapsector = TRUE;
+      blkno = currband->defect[remapno];
+   }
+   if (disk_map_is_slipped(currband, blkno)) {        /* Slipped bad block */
+      return(-1);
+   }
+   i = disk_map_lower_bound(currband->slip, currband->numslips, firstblkoncyl);
+   while ((i < currband->numslips) && (currband->slip[i] < blkno) && (currband->slip[i] < (firstblkoncyl + cylblks))) {
+      if ((currband->slip[i] % cylblks) == surfaceno) {
 	 blkno--;
       }
+      i++;
    }
    blkno -= firstblkoncyl + (surfaceno * currband->blkspertrack);
    if (blkno >= (currband->blkspertrack - currband->sparecnt)) {   /* Unused spare block */
       return(-1);
    }
-   lbn += (cylno - currband->startcyl) * blkspercyl;
+   lbn += (lbn_t) (cylno - currband->startcyl) * blkspercyl;
    lbn += surfaceno * (currband->blkspertrack - currband->sparecnt);
    lbn += blkno - currband->deadspace;
    lbn = (lbn < 0) ? -1 : lbn;
@@ -197,79 +521,76 @@ int lbn;
 }
 
 
-int disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
+lbn_t disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
 disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int blkno;
-int lbn;
+lbn_t blkno;
+lbn_t lbn;
 {
-   int i;
+   int defectno;
+   int remapno;
    int blkspercyl;
-   int firstblkoncyl;
+   lbn_t firstblkoncyl;
+   lbn_t cutoff;
 
-   blkspercyl = (currband->blkspertrack * currdisk->numsurfaces) - currband->sparecnt;
-   firstblkoncyl = (cylno - currband->startcyl) * currdisk->numsurfaces * currband->blkspertrack;
+   blkspercyl = (currband->blkspertrack * currdisk->model->numsurfaces) - currband->sparecnt;
+   firstblkoncyl = (lbn_t) (cylno - currband->startcyl) * currdisk->model->numsurfaces * currband->blkspertrack;
    blkno += firstblkoncyl + (surfaceno * currband->blkspertrack);
-   for (i=(currband->numdefects-1); i>=0; i--) {
-      if (blkno == currband->defect[i]) {        /* Remapped bad block */
-	 return(-2);
-      }
-      if (blkno == currband->remap[i]) {
-	 remapsector = TRUE;
-	 blkno = currband->defect[i];
-	 break;
-      }
+   defectno = disk_map_find_defect(currband, blkno, TRUE);
+   remapno = disk_map_find_remap(currband, blkno);
+   if ((defectno != -1) && (defectno >= remapno)) {   /* Remapped bad block */
+      return(-2);
    }
-   for (i=(currband->numslips-1); i>=0; i--) {
-      if (blkno == currband->slip[i]) {          /* Slipped bad block */
-	 return(-1);
-      }
-      if ((blkno > currband->slip[i]) && ((currband->slip[i] / (currband->blkspertrack * currdisk->numsurfaces)) == (cylno - currband->startcyl))) {
-	 blkno--;
-      }
+   if (remapno != -1) {
+      remapsector = TRUE;
+      blkno = currband->defect[remapno];
+   }
+   if (disk_map_is_slipped(currband, blkno)) {        /* Slipped bad block */
+      return(-1);
+   }
+   /* each slip earlier on this cylinder shifts the block down by one */
+   cutoff = min(blkno, (firstblkoncyl + (currband->blkspertrack * currdisk->model->numsurfaces)));
+   if (cutoff > firstblkoncyl) {
+      blkno -= disk_map_lower_bound(currband->slip, currband->numslips, cutoff) - disk_map_lower_bound(currband->slip, currband->numslips, firstblkoncyl);
    }
    if (blkno >= (firstblkoncyl + blkspercyl)) {   /* Unused spare block */
       return(-1);
    }
-   lbn += (cylno - currband->startcyl) * blkspercyl;
+   lbn += (lbn_t) (cylno - currband->startcyl) * blkspercyl;
    lbn += blkno - firstblkoncyl - currband->deadspace;
    lbn = (lbn < 0) ? -1 : lbn;
    return(lbn);
 }
 
 
-int disk_pbn_to_lbn_trackspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
+lbn_t disk_pbn_to_lbn_trackspare(currdisk, currband, cylno, surfaceno, blkno, lbn)
 disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
 int blkno;
-int lbn;
+lbn_t lbn;
 {
-   int i;
-   int trackno;
-   int lasttrack;
-
-   trackno = (cylno - currband->startcyl) * currdisk->numsurfaces + surfaceno;
-   for (i=(currband->numdefects-1); i>=0; i--) {
-      if (trackno == currband->defect[i]) {   /* Remapped bad track */
-	 return(-2);
-      }
-      if (trackno == currband->remap[i]) {
-	 trackno = currband->defect[i];
-	 break;
-      }
+   int defectno;
+   int remapno;
+   lbn_t trackno;
+   lbn_t lasttrack;
+
+   trackno = (cylno - currband->startcyl) * currdisk->model->numsurfaces + surfaceno;
+   defectno = disk_map_find_defect(currband, trackno, TRUE);
+   remapno = disk_map_find_remap(currband, trackno);
+   if ((defectno != -1) && (defectno >= remapno)) {   /* Remapped bad track */
+      return(-2);
    }
-   for (i=(currband->numslips-1); i>=0; i--) {
-      if (trackno == currband->slip[i]) {     /* Slipped bad track */
-	 return(-1);
-      }
-      if (trackno > currband->slip[i]) {
-	 trackno--;
-      }
+   if (remapno != -1) {
+      trackno = currband->defect[remapno];
    }
+   if (disk_map_is_slipped(currband, trackno)) {      /* Slipped bad track */
+      return(-1);
+   }
+   trackno -= disk_map_lower_bound(currband->slip, currband->numslips, trackno);
    lasttrack = (currband->blksinband + currband->deadspace) / currband->blkspertrack;
    if (trackno > lasttrack) {                 /* Unused spare track */
       return(-1);
@@ -282,40 +603,38 @@ int lbn;
 
 /* -2 means defect, -1 means dead space (reserved, spare or slip) */
 
-int disk_translate_pbn_to_lbn(currdisk, currband, cylno, surfaceno, blkno)
+lbn_t disk_translate_pbn_to_lbn(currdisk, currband, cylno, surfaceno, blkno)
 disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
 int blkno;
 {
-   int lbn = 0;
+   lbn_t lbn = 0;
    int bandno = 0;
 
-   if ((!currband) | (cylno < 0) | (cylno < currband->startcyl) | (cylno >= currdisk->numcyls) | (surfaceno < 0) | (surfaceno >= currdisk->numsurfaces) | (blkno < 0) | (blkno >= currband->blkspertrack)) {
+   if ((!currband) | (cylno < 0) | (cylno < currband->startcyl) | (cylno >= currdisk->model->numcyls) | (surfaceno < 0) | (surfaceno >= currdisk->model->numsurfaces) | (blkno < 0) | (blkno >= currband->blkspertrack)) {
       fprintf(stderr, "Illegal PBN values at disk_translate_pbn_to_lbn: %d %d %d\n", cylno, surfaceno, blkno);
       exit(0);
    }
-   while (currband != &currdisk->bands[bandno]) {
-      lbn += currdisk->bands[bandno].blksinband;
-      bandno++;
-      if (bandno >= currdisk->numbands) {
-	 fprintf(stderr, "Currband not found in band list for currdisk\n");
-	 exit(0);
-      }
+   bandno = currband - currdisk->model->bands;
+   if ((bandno < 0) || (bandno >= currdisk->model->numbands)) {
+      fprintf(stderr, "Currband not found in band list for currdisk\n");
+      exit(0);
    }
-   if (currdisk->sparescheme == NO_SPARING) {
-      lbn += (((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno) * currband->blkspertrack;
+   lbn = currdisk->model->bandstarts[bandno];
+   if (currdisk->model->sparescheme == NO_SPARING) {
+      lbn += (lbn_t) (((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno) * currband->blkspertrack;
       lbn += blkno - currband->deadspace;
       lbn = (lbn < 0) ? -1 : lbn;
-   } else if (currdisk->sparescheme == TRACK_SPARING) {
+   } else if (currdisk->model->sparescheme == TRACK_SPARING) {
       lbn = disk_pbn_to_lbn_trackspare(currdisk, currband, cylno, surfaceno, blkno, lbn);
-   } else if (currdisk->sparescheme == SECTPERCYL_SPARING) {
-      lbn = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, blkno, lbn);
-   } else if (currdisk->sparescheme == SECTPERTRACK_SPARING) {
-      lbn = disk_pbn_to_lbn_sectpertrackspare(currdisk, currband, cylno, surfaceno, blkno, lbn);
+   } else if (currdisk->model->sparescheme == SECTPERCYL_SPARING) {
+      lbn = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, (lbn_t) blkno, lbn);
+   } else if (currdisk->model->sparescheme == SECTPERTRACK_SPARING) {
+      lbn = disk_pbn_to_lbn_sectpertrackspare(currdisk, currband, cylno, surfaceno, (lbn_t) blkno, lbn);
    } else {
-      fprintf(stderr, "Unknown sparing scheme at disk_translate_pbn_to_lbn: %d\n", currdisk->sparescheme);
+      fprintf(stderr, "Unknown sparing scheme at disk_translate_pbn_to_lbn: %d\n", currdisk->model->sparescheme);
       exit(0);
    }
 
@@ -330,16 +649,16 @@ disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int *startptr;
-int *endptr;
-int lbn;             /* equals first block in band */
+lbn_t *startptr;
+lbn_t *endptr;
+lbn_t lbn;           /* equals first block in band */
 {
    int i;
-   int blkno;
-   int temp_lbn = lbn;
+   lbn_t blkno;
+   lbn_t temp_lbn = lbn;
    int datablkspertrack = currband->blkspertrack - currband->sparecnt;
 
-   lbn += ((((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno) * datablkspertrack) - currband->deadspace;
+   lbn += ((lbn_t) (((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno) * datablkspertrack) - currband->deadspace;
    if (startptr) {
       *startptr = ((lbn + datablkspertrack) <= temp_lbn) ? -1 : max(temp_lbn, lbn);
    }
@@ -348,11 +667,10 @@ int lbn;             /* equals first block in band */
       *endptr = (lbn <= temp_lbn) ? -1 : lbn;
    }
 
-   blkno = (((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno) * currband->blkspertrack;
-   for (i=0; i<currband->numdefects; i++) {
-      if ((blkno <= currband->defect[i]) && ((blkno + currband->blkspertrack) > currband->defect[i])) {
-	 remapsector = TRUE;
-      }
+   blkno = (lbn_t) (((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno) * currband->blkspertrack;
+   i = disk_map_lower_bound(currband->defect, currband->numdefects, blkno);
+   if ((i < currband->numdefects) && (currband->defect[i] < (blkno + currband->blkspertrack))) {
+      remapsector = TRUE;
    }
 }
 
@@ -362,20 +680,21 @@ disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int *startptr;
-int *endptr;
-int lbn;             /* equals first block in band */
+lbn_t *startptr;
+lbn_t *endptr;
+lbn_t lbn;           /* equals first block in band */
 {
    int i;
    int blkno;
+   lbn_t first;
    int lbnadd;
-   int temp_lbn = lbn;
+   lbn_t temp_lbn = lbn;
 
    if (startptr) {
       lbnadd = 0;
       for (blkno=0; blkno<currband->blkspertrack; blkno++) {
 	 remapsector = FALSE;
-	 *startptr = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, blkno, lbn);
+	 *startptr = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, (lbn_t) blkno, lbn);
 	 if ((*startptr) == -2) {
             lbnadd++;
 	 }
@@ -395,7 +714,7 @@ int lbn;             /* equals first block in band */
       lbnadd = 1;
       for (blkno=(currband->blkspertrack-1); blkno>0; blkno--) {
 	 remapsector = FALSE;
-	 *endptr = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, blkno, lbn);
+	 *endptr = disk_pbn_to_lbn_sectpercylspare(currdisk, currband, cylno, surfaceno, (lbn_t) blkno, lbn);
 	 if ((*endptr) == -2) {
 	    lbnadd++;
 	 }
@@ -411,11 +730,10 @@ int lbn;             /* equals first block in band */
 	 *endptr = -1;
       }
    }
-   blkno = (((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno) * currband->blkspertrack;
-   for (i=0; i<currband->numdefects; i++) {
-      if ((blkno <= currband->defect[i]) && ((blkno + currband->blkspertrack) > currband->defect[i])) {
-	 remapsector = TRUE;
-      }
+   first = (lbn_t) (((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno) * currband->blkspertrack;
+   i = disk_map_lower_bound(currband->defect, currband->numdefects, first);
+   if ((i < currband->numdefects) && (currband->defect[i] < (first + currband->blkspertrack))) {
+      remapsector = TRUE;
    }
 }
 
@@ -425,33 +743,29 @@ disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int *startptr;
-int *endptr;
-int lbn;
+lbn_t *startptr;
+lbn_t *endptr;
+lbn_t lbn;
 {
-   int i;
-   int trackno;
-   int lasttrack;
-   int blkno;
-
-   trackno = ((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno;
-   for (i=(currband->numdefects-1); i>=0; i--) {
-      if (trackno == currband->defect[i]) {   /* Remapped bad track */
-	 lbn = -2;
-      }
-      if (trackno == currband->remap[i]) {
-	 trackno = currband->defect[i];
-	 break;
-      }
+   int defectno;
+   int remapno;
+   lbn_t trackno;
+   lbn_t lasttrack;
+   lbn_t blkno;
+
+   trackno = ((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno;
+   defectno = disk_map_find_defect(currband, trackno, TRUE);
+   remapno = disk_map_find_remap(currband, trackno);
+   if ((defectno != -1) && (defectno >= remapno)) {   /* Remapped bad track */
+      lbn = -2;
    }
-   for (i=(currband->numslips-1); i>=0; i--) {
-      if (trackno == currband->slip[i]) {     /* Slipped bad track */
-	 lbn = -1;
-      }
-      if (trackno > currband->slip[i]) {
-	 trackno--;
-      }
+   if (remapno != -1) {
+      trackno = currband->defect[remapno];
+   }
+   if (disk_map_is_slipped(currband, trackno)) {      /* Slipped bad track */
+      lbn = -1;
    }
+   trackno -= disk_map_lower_bound(currband->slip, currband->numslips, trackno);
    lasttrack = (currband->blksinband + currband->deadspace) / currband->blkspertrack;
    if (trackno > lasttrack) {                 /* Unused spare track */
       lbn = -1;
@@ -475,36 +789,31 @@ int lbn;
 }
 
 
-void disk_get_lbn_boundaries_for_track(currdisk, currband, cylno, surfaceno, startptr, endptr)
+void disk_map_lbn_boundaries(currdisk, currband, cylno, surfaceno, startptr, endptr)
 disk *currdisk;
 band *currband;
 int cylno;
 int surfaceno;
-int *startptr;
-int *endptr;
+lbn_t *startptr;
+lbn_t *endptr;
 {
-   int lbn = 0;
+   lbn_t lbn = 0;
    int bandno = 0;
 
-   if ((!startptr) && (!endptr)) {
-      return;
-   }
-   if ((!currband) | (cylno < currband->startcyl) | (cylno >= currdisk->numcyls) | (surfaceno < 0) | (surfaceno >= currdisk->numsurfaces)) {
+   if ((!currband) | (cylno < currband->startcyl) | (cylno >= currdisk->model->numcyls) | (surfaceno < 0) | (surfaceno >= currdisk->model->numsurfaces)) {
       fprintf(stderr, "Illegal PBN values at disk_get_lbn_boundaries_for_track: %d %d\n", cylno, surfaceno);
       exit(0);
    }
-   while (currband != &currdisk->bands[bandno]) {
-      lbn += currdisk->bands[bandno].blksinband;
-      bandno++;
-      if (bandno >= currdisk->numbands) {
-	 fprintf(stderr, "Currband not found in band list for currdisk\n");
-	 exit(0);
-      }
+   bandno = currband - currdisk->model->bands;
+   if ((bandno < 0) || (bandno >= currdisk->model->numbands)) {
+      fprintf(stderr, "Currband not found in band list for currdisk\n");
+      exit(0);
    }
-   if (currdisk->sparescheme == NO_SPARING) {
-      int temp_lbn = lbn;
+   lbn = currdisk->model->bandstarts[bandno];
+   if (currdisk->model->sparescheme == NO_SPARING) {
+      lbn_t temp_lbn = lbn;
 
-      lbn += ((((cylno - currband->startcyl) * currdisk->numsurfaces) + surfaceno) * currband->blkspertrack) - currband->deadspace;
+      lbn += ((lbn_t) (((cylno - currband->startcyl) * currdisk->model->numsurfaces) + surfaceno) * currband->blkspertrack) - currband->deadspace;
       if (startptr) {
          *startptr = ((lbn + currband->blkspertrack) <= temp_lbn) ? -1 : max(lbn, temp_lbn);
       }
@@ -512,19 +821,60 @@ int *endptr;
          lbn += currband->blkspertrack;
          *endptr = (lbn <= temp_lbn) ? -1 : lbn;
       }
-   } else if (currdisk->sparescheme == TRACK_SPARING) {
+   } else if (currdisk->model->sparescheme == TRACK_SPARING) {
       disk_get_lbn_boundaries_trackspare(currdisk, currband, cylno, surfaceno, startptr, endptr, lbn);
-   } else if (currdisk->sparescheme == SECTPERCYL_SPARING) {
+   } else if (currdisk->model->sparescheme == SECTPERCYL_SPARING) {
       disk_get_lbn_boundaries_sectpercylspare(currdisk, currband, cylno, surfaceno, startptr, endptr, lbn);
-   } else if (currdisk->sparescheme == SECTPERTRACK_SPARING) {
+   } else if (currdisk->model->sparescheme == SECTPERTRACK_SPARING) {
       disk_get_lbn_boundaries_sectpertrackspare(currdisk, currband, cylno, surfaceno, startptr, endptr, lbn);
    } else {
-      fprintf(stderr, "Unknown sparing scheme at disk_translate_pbn_to_lbn: %d\n", currdisk->sparescheme);
+      fprintf(stderr, "Unknown sparing scheme at disk_translate_pbn_to_lbn: %d\n", currdisk->model->sparescheme);
       exit(0);
    }
 }
 
 
+void disk_get_lbn_boundaries_for_track(currdisk, currband, cylno, surfaceno, startptr, endptr)
+disk *currdisk;
+band *currband;
+int cylno;
+int surfaceno;
+lbn_t *startptr;
+lbn_t *endptr;
+{
+   mapcacheentry *entry;
+   lbn_t startlbn, endlbn;
+   int saveremap;
+
+   if ((!startptr) && (!endptr)) {
+      return;
+   }
+   if ((currdisk->mapcache) && ((entry = disk_map_cache_find_track(currdisk, currband, cylno, surfaceno)))) {
+      if (currdisk->mapcache == 2) {
+	 saveremap = remapsector;
+	 remapsector = FALSE;
+	 disk_map_lbn_boundaries(currdisk, currband, cylno, surfaceno, &startlbn, &endlbn);
+	 if ((startlbn != entry->startlbn) || (endlbn != entry->endlbn) || (remapsector)) {
+	    disk_map_cache_mismatch(currdisk, "disk_get_lbn_boundaries_for_track", entry->startlbn);
+	 }
+	 remapsector = saveremap;
+      }
+      if (startptr) {
+	 *startptr = entry->startlbn;
+      }
+      if (endptr) {
+	 *endptr = entry->endlbn;
+      }
+      /* the uncached search over the track's sectors leaves it clear */
+      if (currdisk->model->sparescheme == SECTPERCYL_SPARING) {
+	 remapsector = FALSE;
+      }
+      return;
+   }
+   disk_map_lbn_boundaries(currdisk, currband, cylno, surfaceno, startptr, endptr);
+}
+
+
 /* NOTE:  The total number of allowable slips and remaps per track is 
 	  equal to the number of spares per track.  The following code 
 	  will produce incorrect results if this rule is violated.
@@ -537,20 +887,20 @@ int *endptr;
 void disk_lbn_to_pbn_sectpertrackspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr)
 disk *currdisk;
 band *currband;
-int blkno;
+lbn_t blkno;
 int maptype;
 int *cylptr;
 int *surfaceptr;
 int *blkptr;
 {
    int i;
-   int firstblkontrack;
+   lbn_t firstblkontrack;
 
    int blkspertrack = currband->blkspertrack;
    int datablkspertrack = blkspertrack - currband->sparecnt;
-   int blkspercyl = datablkspertrack * currdisk->numsurfaces;
-   int cyl = blkno/blkspercyl;
-   int surf = (blkno / datablkspertrack) % currdisk->numsurfaces;
+   int blkspercyl = datablkspertrack * currdisk->model->numsurfaces;
+   int cyl = (int) (blkno / blkspercyl);
+   int surf = (int) ((blkno / datablkspertrack) % currdisk->model->numsurfaces);
 
    if (cylptr) {
       *cylptr = cyl + currband->startcyl;
@@ -560,23 +910,21 @@ int *blkptr;
    }
    blkno = blkno % datablkspertrack;
    if ((maptype == MAP_ADDSLIPS) || (maptype == MAP_FULL)) {
-      firstblkontrack = datablkspertrack * (surf + (cyl * currdisk->numsurfaces));
-      for (i=0; i<currband->numslips; i++) {
-	 if ((currband->slip[i] >= firstblkontrack) && ((currband->slip[i] - firstblkontrack) <= blkno)) {
-	    blkno++;
-	 }
+      firstblkontrack = (lbn_t) datablkspertrack * (surf + (cyl * currdisk->model->numsurfaces));
+      i = disk_map_lower_bound(currband->slip, currband->numslips, firstblkontrack);
+      while ((i < currband->numslips) && ((currband->slip[i] - firstblkontrack) <= blkno)) {
+	 blkno++;
+	 i++;
       }
    }
    if (maptype == MAP_FULL) {
-      for (i=0; i<currband->numdefects; i++) {
-	 if (currband->defect[i] == (firstblkontrack + blkno)) {
-	    remapsector = TRUE;
-	    blkno = currband->remap[i];
-	 }
+      if ((i = disk_map_find_defect(currband, (firstblkontrack + blkno), TRUE)) != -1) {
+	 remapsector = TRUE;
+	 blkno = currband->remap[i];
       }
    }
    if (blkptr) {
-      *blkptr = blkno % blkspertrack;
+      *blkptr = (int) (blkno % blkspertrack);
    }
 }
 
@@ -592,7 +940,7 @@ int *blkptr;
 void disk_lbn_to_pbn_sectpercylspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr)
 disk *currdisk;
 band *currband;
-int blkno;
+lbn_t blkno;
 int maptype;
 int *cylptr;
 int *surfaceptr;
@@ -601,39 +949,34 @@ int *blkptr;
    int i;
    int blkspertrack;
    int blkspercyl;
-   int firstblkoncyl;
+   lbn_t firstblkoncyl;
    int cyl;
    int slips = 0;
 
    blkspertrack = currband->blkspertrack;
-   blkspercyl = (blkspertrack * currdisk->numsurfaces) - currband->sparecnt;
-   cyl = blkno/blkspercyl;
+   blkspercyl = (blkspertrack * currdisk->model->numsurfaces) - currband->sparecnt;
+   cyl = (int) (blkno / blkspercyl);
    if (cylptr) {
       *cylptr = cyl + currband->startcyl;
    }
    blkno = blkno % blkspercyl;
    if ((maptype == MAP_ADDSLIPS) || (maptype == MAP_FULL)) {
-      firstblkoncyl = cyl * blkspertrack * currdisk->numsurfaces;
-      for (i=0; i<currband->numslips; i++) {
-	 if ((currband->slip[i] >= firstblkoncyl) && ((currband->slip[i] - firstblkoncyl) <= blkno)) {
-	    slips++;
-	 }
-      }
+      firstblkoncyl = (lbn_t) cyl * blkspertrack * currdisk->model->numsurfaces;
+      slips = disk_map_lower_bound(currband->slip, currband->numslips, (firstblkoncyl + blkno + 1));
+      slips -= disk_map_lower_bound(currband->slip, currband->numslips, firstblkoncyl);
    }
    blkno += slips;
    if (maptype == MAP_FULL) {
-      for (i=0; i<currband->numdefects; i++) {
-	 if (currband->defect[i] == (firstblkoncyl + blkno)) {
-	    remapsector = TRUE;
-	    blkno = currband->remap[i];
-	 }
+      if ((i = disk_map_find_defect(currband, (firstblkoncyl + blkno), TRUE)) != -1) {
+	 remapsector = TRUE;
+	 blkno = currband->remap[i];
       }
    }
    if (surfaceptr) {
-      *surfaceptr = blkno / blkspertrack;
+      *surfaceptr = (int) (blkno / blkspertrack);
    }
    if (blkptr) {
-      *blkptr = blkno % blkspertrack;
+      *blkptr = (int) (blkno % blkspertrack);
    }
 }
 
@@ -651,7 +994,7 @@ int *blkptr;
 void disk_lbn_to_pbn_trackspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr)
 disk *currdisk;
 band *currband;
-int blkno;
+lbn_t blkno;
 int maptype;
 int *cylptr;
 int *surfaceptr;
@@ -659,40 +1002,48 @@ int *blkptr;
 {
    int i;
    int blkspertrack;
-   int trackno;
+   lbn_t trackno;
+   int bottom;
+   int top;
 
    blkspertrack = currband->blkspertrack;
    trackno = blkno/blkspertrack;
    if ((maptype == MAP_ADDSLIPS) || (maptype == MAP_FULL)) {
-      for (i=0; i<currband->numslips; i++) {
-	 if (currband->slip[i] <= trackno) {
-	    trackno++;
+      /* Each slip at or before the (shifted) track pushes it out by one.  */
+      /* The slips are distinct and ascending, so slip[i] - i never drops  */
+      /* and the number of slips passed can be found by binary search.     */
+      bottom = 0;
+      top = currband->numslips;
+      while (bottom < top) {
+	 i = bottom + ((top - bottom) / 2);
+	 if ((currband->slip[i] - i) <= trackno) {
+	    bottom = i + 1;
+	 } else {
+	    top = i;
 	 }
       }
+      trackno += bottom;
    }
    if (maptype == MAP_FULL) {
-      for (i=0; i<currband->numdefects; i++) {
-	 if (currband->defect[i] == trackno) {
-	    trackno = currband->remap[i];
-	    break;
-	 }
+      if ((i = disk_map_find_defect(currband, trackno, FALSE)) != -1) {
+	 trackno = currband->remap[i];
       }
    }
    if (cylptr) {
-      *cylptr = (trackno/currdisk->numsurfaces) + currband->startcyl;
+      *cylptr = (int) (trackno / currdisk->model->numsurfaces) + currband->startcyl;
    }
    if (surfaceptr) {
-      *surfaceptr = trackno % currdisk->numsurfaces;
+      *surfaceptr = (int) (trackno % currdisk->model->numsurfaces);
    }
    if (blkptr) {
-      *blkptr = blkno % blkspertrack;
+      *blkptr = (int) (blkno % blkspertrack);
    }
 }
 
 
-band * disk_translate_lbn_to_pbn(currdisk, blkno, maptype, cylptr, surfaceptr, blkptr)
+band * disk_map_lbn_to_pbn(currdisk, blkno, maptype, cylptr, surfaceptr, blkptr)
 disk *currdisk;
-int blkno;
+lbn_t blkno;
 int maptype;
 int *cylptr;
 int *surfaceptr;
@@ -700,48 +1051,93 @@ int *blkptr;
 {
    int bandno = 0;
    int blkspertrack;
-   band *currband = &currdisk->bands[0];
-   extern int bandstart;
+   band *currband = &currdisk->model->bands[0];
 
    if ((maptype > MAP_FULL) || (maptype < MAP_IGNORESPARING)) {
       fprintf(stderr, "Unimplemented mapping type at disk_translate_lbn_to_pbn: %d\n", maptype);
       exit(0);
    }
-   bandstart = 0;
-   while ((blkno >= currband->blksinband) || (blkno < 0)) {
-      bandstart += currband->blksinband;
-      blkno -= currband->blksinband;
-      bandno++;
-      currband = &currdisk->bands[bandno];
-      if ((bandno >= currdisk->numbands) || (blkno < 0)) {
-         fprintf(stderr, "blkno outside addressable space of disk: %d, %d\n", blkno, bandno);
-         exit(0);
-      }
+   if (blkno < 0) {
+      fprintf(stderr, "blkno outside addressable space of disk: %lld, %d\n", (blkno - currband->blksinband), 1);
+      exit(0);
+   } else if (blkno >= currdisk->model->bandstarts[currdisk->model->numbands]) {
+      fprintf(stderr, "blkno outside addressable space of disk: %lld, %d\n", (blkno - currdisk->model->bandstarts[currdisk->model->numbands]), currdisk->model->numbands);
+      exit(0);
    }
+   bandno = disk_map_lower_bound(&currdisk->model->bandstarts[1], currdisk->model->numbands, (blkno + 1));
+   currband = &currdisk->model->bands[bandno];
+   blkno -= currdisk->model->bandstarts[bandno];
    blkno += currband->deadspace;
-   if ((maptype == MAP_IGNORESPARING) || (currdisk->sparescheme == NO_SPARING)) {
+   if ((maptype == MAP_IGNORESPARING) || (currdisk->model->sparescheme == NO_SPARING)) {
       blkspertrack = currband->blkspertrack;
       if (cylptr) {
-         *cylptr = blkno/(blkspertrack * currdisk->numsurfaces) + currband->startcyl;
+         *cylptr = (int) (blkno / (blkspertrack * currdisk->model->numsurfaces)) + currband->startcyl;
       }
       if (surfaceptr) {
-         *surfaceptr = (blkno/blkspertrack) % currdisk->numsurfaces;
+         *surfaceptr = (int) ((blkno / blkspertrack) % currdisk->model->numsurfaces);
       }
       if (blkptr) {
-         *blkptr = blkno % blkspertrack;
+         *blkptr = (int) (blkno % blkspertrack);
       }
    } else {
-      if (currdisk->sparescheme == TRACK_SPARING) {
+      if (currdisk->model->sparescheme == TRACK_SPARING) {
 	 disk_lbn_to_pbn_trackspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr);
-      } else if (currdisk->sparescheme == SECTPERCYL_SPARING) {
+      } else if (currdisk->model->sparescheme == SECTPERCYL_SPARING) {
 	disk_lbn_to_pbn_sectpercylspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr);
-      } else if (currdisk->sparescheme == SECTPERTRACK_SPARING) {
+      } else if (currdisk->model->sparescheme == SECTPERTRACK_SPARING) {
 	disk_lbn_to_pbn_sectpertrackspare(currdisk, currband, blkno, maptype, cylptr, surfaceptr, blkptr);
       } else {
-	 fprintf(stderr, "Unknown sparing scheme at disk_translate_lbn_to_pbn: %d\n", currdisk->sparescheme);
+	 fprintf(stderr, "Unknown sparing scheme at disk_translate_lbn_to_pbn: %d\n", currdisk->model->sparescheme);
 	 exit(0);
       }
    }
    return(currband);
 }
 
+
+band * disk_translate_lbn_to_pbn(currdisk, blkno, maptype, cylptr, surfaceptr, blkptr)
+disk *currdisk;
+lbn_t blkno;
+int maptype;
+int *cylptr;
+int *surfaceptr;
+int *blkptr;
+{
+   mapcacheentry *entry;
+   band *currband;
+   int cylno, surfaceno, blk;
+   int saveremap;
+
+   if ((maptype != MAP_FULL) || (!currdisk->mapcache)) {
+      return(disk_map_lbn_to_pbn(currdisk, blkno, maptype, cylptr, surfaceptr, blkptr));
+   }
+   if ((entry = disk_map_cache_find_lbn(currdisk, blkno))) {
+      if (currdisk->mapcache == 2) {
+	 saveremap = remapsector;
+	 remapsector = FALSE;
+	 currband = disk_map_lbn_to_pbn(currdisk, blkno, maptype, &cylno, &surfaceno, &blk);
+	 if ((remapsector) || (currband != entry->currband) || (cylno != entry->cylno) || (surfaceno != entry->surfaceno) || (blk != (entry->firstblkno + (int) (blkno - entry->startlbn)))) {
+	    disk_map_cache_mismatch(currdisk, "disk_translate_lbn_to_pbn", blkno);
+	 }
+	 remapsector = saveremap;
+      }
+      if (cylptr) {
+	 *cylptr = entry->cylno;
+      }
+      if (surfaceptr) {
+	 *surfaceptr = entry->surfaceno;
+      }
+      if (blkptr) {
+	 *blkptr = entry->firstblkno + (int) (blkno - entry->startlbn);
+      }
+      return(entry->currband);
+   }
+   currband = disk_map_lbn_to_pbn(currdisk, blkno, maptype, cylptr, surfaceptr, blkptr);
+   /* only follow what looks like a sequential stream */
+   if ((currdisk->mapcachelast >= 0) && (blkno > currdisk->mapcachelast) && ((blkno - currdisk->mapcachelast) <= currband->blkspertrack)) {
+      disk_map_cache_fill(currdisk, blkno);
+   }
+   currdisk->mapcachelast = blkno;
+   return(currband);
+}
+
@@ -66,6 +66,10 @@ double disk_last_acctime = 0.0;
 int disk_last_cylno = 0;
 int disk_last_surface = 0;
 
+/* Mechanical positioning computations, real or speculative, so far */
+
+double disk_positionings = 0.0;
+
 extern int printhack;
 extern int remapsector;
 
@@ -156,12 +160,12 @@ int headswitch;
    if (cyls == 0) {
       seektime = 0.0;
    } else {
-      seektime = currdisk->seekone;
-      seektime += currdisk->seekavg * (double) (cyls - 1);
-      seektime += currdisk->seekfull * sqrt((double) (cyls - 1));
+      seektime = currdisk->model->seekone;
+      seektime += currdisk->model->seekavg * (double) (cyls - 1);
+      seektime += currdisk->model->seekfull * sqrt((double) (cyls - 1));
    }
-   if ((headswitch) && (seektime < currdisk->headswitch)) {
-      seektime = currdisk->headswitch;
+   if ((headswitch) && (seektime < currdisk->model->headswitch)) {
+      seektime = currdisk->model->headswitch;
    }
    return(seektime);
 }
@@ -178,22 +182,22 @@ int headswitch;
    int cyls;
 
    cyls = abs(distance);
-   numcyls = (double) currdisk->numcyls;
+   numcyls = (double) currdisk->model->numcyls;
    if (cyls == 1) {
-      seektime = currdisk->seekone;
+      seektime = currdisk->model->seekone;
    } else if (cyls == 0) {
       seektime = 0.0;
-   } else if (cyls <= (currdisk->numcyls / 3)) {
+   } else if (cyls <= (currdisk->model->numcyls / 3)) {
       mult = ((double)(cyls-1) / (numcyls / (double)3));
-      seektime = currdisk->seekone;
-      seektime += mult * (currdisk->seekavg - seektime);
+      seektime = currdisk->model->seekone;
+      seektime += mult * (currdisk->model->seekavg - seektime);
    } else {
       mult = ((double)(3*cyls) / ((double)2*numcyls)) - (double) 0.5;
-      seektime = currdisk->seekavg;
-      seektime += mult * (currdisk->seekfull - seektime);
+      seektime = currdisk->model->seekavg;
+      seektime += mult * (currdisk->model->seekfull - seektime);
    }
-   if ((headswitch) && (seektime < currdisk->headswitch)) {
-      seektime = currdisk->headswitch;
+   if ((headswitch) && (seektime < currdisk->model->headswitch)) {
+      seektime = currdisk->model->headswitch;
    }
    return(seektime);
 }
@@ -214,19 +218,19 @@ int headswitch;
    double *hpseek;
    int dist;
 
-   hpseek = &currdisk->hpseek[0];
+   hpseek = &currdisk->model->hpseek[0];
    dist = abs(distance);
    if (distance == 0) {
       seektime = 0.0;
    } else if ((dist == 1) && (hpseek[5] != -1)) {
-      seektime = currdisk->seekone;
+      seektime = currdisk->model->seekone;
    } else if (dist < hpseek[0]) {
       seektime = sqrt((double) dist) * hpseek[2] + hpseek[1];
    } else {
       seektime = (hpseek[4] * (double) dist) + hpseek[3];
    }
-   if ((headswitch) && (seektime < currdisk->headswitch)) {
-      seektime = currdisk->headswitch;
+   if ((headswitch) && (seektime < currdisk->model->headswitch)) {
+      seektime = currdisk->model->headswitch;
    }
    return(seektime);
 }
@@ -245,18 +249,18 @@ int headswitch;
    double *hpseek;
    int dist = abs(distance);
 
-   hpseek = &currdisk->hpseek[0];
+   hpseek = &currdisk->model->hpseek[0];
    if (distance == 0) {
       seektime = 0.0;
    } else if (dist <= 10) {
-      seektime = currdisk->first10seeks[(dist - 1)];
+      seektime = currdisk->model->first10seeks[(dist - 1)];
    } else if (dist < hpseek[0]) {
       seektime = sqrt((double) dist) * hpseek[2] + hpseek[1];
    } else {
       seektime = (hpseek[4] * (double) dist) + hpseek[3];
    }
-   if ((headswitch) && (seektime < currdisk->headswitch)) {
-      seektime = currdisk->headswitch;
+   if ((headswitch) && (seektime < currdisk->model->headswitch)) {
+      seektime = currdisk->model->headswitch;
    }
    return(seektime);
 }
@@ -315,14 +319,14 @@ int headswitch;
    int i;
 
    if (dist) {
-      for (i=0; i<currdisk->extractseekcnt; i++) {
-	 if (dist <= currdisk->extractseekdists[i]) {
-	    if (dist == currdisk->extractseekdists[i]) {
-	       seektime = currdisk->extractseektimes[i];
+      for (i=0; i<currdisk->model->extractseekcnt; i++) {
+	 if (dist <= currdisk->model->extractseekdists[i]) {
+	    if (dist == currdisk->model->extractseekdists[i]) {
+	       seektime = currdisk->model->extractseektimes[i];
 	    } else {
-	       double ddiff = (double) (dist - currdisk->extractseekdists[(i-1)]) / (double) (currdisk->extractseekdists[i] - currdisk->extractseekdists[(i-1)]);
-	       seektime = currdisk->extractseektimes[(i-1)];
-	       seektime += ddiff * (currdisk->extractseektimes[i] - currdisk->extractseektimes[(i-1)]);
+	       double ddiff = (double) (dist - currdisk->model->extractseekdists[(i-1)]) / (double) (currdisk->model->extractseekdists[i] - currdisk->model->extractseekdists[(i-1)]);
+	       seektime = currdisk->model->extractseektimes[(i-1)];
+	       seektime += ddiff * (currdisk->model->extractseektimes[i] - currdisk->model->extractseektimes[(i-1)]);
 	    }
 	    break;
 	 }
@@ -332,14 +336,14 @@ int headswitch;
 	 exit(0);
       }
    }
-   if ((headswitch) && (seektime < currdisk->headswitch)) {
-      seektime = currdisk->headswitch;
+   if ((headswitch) && (seektime < currdisk->model->headswitch)) {
+      seektime = currdisk->model->headswitch;
    }
    return(seektime);
 }
 
 
-double diskseektime(currdisk, distance, headswitch, read)
+double disk_seektime_compute(currdisk, distance, headswitch, read)
 disk *currdisk;
 int distance;
 int headswitch;
@@ -347,52 +351,178 @@ int read;
 {
    double seektime;
 
-   if (currdisk->seektime >= 0.0) {
-      seektime = currdisk->seektime;
-   } else if (currdisk->seektime == THREEPOINT_LINE) {
+   if (currdisk->model->seektime >= 0.0) {
+      seektime = currdisk->model->seektime;
+   } else if (currdisk->model->seektime == THREEPOINT_LINE) {
       seektime = disk_seektime_threepoint_line(currdisk, distance, headswitch);
-   } else if (currdisk->seektime == THREEPOINT_CURVE) {
+   } else if (currdisk->model->seektime == THREEPOINT_CURVE) {
       seektime = disk_seektime_threepoint_curve(currdisk, distance, headswitch);
-   } else if (currdisk->seektime == HPL_SEEK_EQUATION) {
+   } else if (currdisk->model->seektime == HPL_SEEK_EQUATION) {
       seektime = disk_seektime_hpl_equation(currdisk, distance, headswitch);
-   } else if (currdisk->seektime == FIRST10_PLUS_HPL_SEEK_EQUATION) {
+   } else if (currdisk->model->seektime == FIRST10_PLUS_HPL_SEEK_EQUATION) {
       seektime = disk_seektime_first10_plus_hpl_equation(currdisk, distance, headswitch);
-   } else if (currdisk->seektime == EXTRACTION_SEEK) {
+   } else if (currdisk->model->seektime == EXTRACTION_SEEK) {
       seektime = disk_seektime_extraction_seek(currdisk, distance, headswitch);
    }
    if ((!read) && (seektime != 0.0)) {
-      seektime += currdisk->seekwritedelta;
+      seektime += currdisk->model->seekwritedelta;
    }
 
    return(seektime);
 }
 
 
-/* currangle is a global that this function sets equal to the rotational     */
-/* offset (from logical zero) for the given physical blkno.                  */
+/* The seek table holds, for every seek distance the disk can produce,   */
+/* the four values disk_seektime_compute returns for that distance with  */
+/* and without a head switch and for reads and writes, side by side.     */
 
-void disk_reset_currangle(currdisk, currband, physblkno)
+#define SEEKTABLE_INDEX(dist, headswitch, read) \
+	(((dist) << 2) | (((headswitch) != 0) << 1) | ((read) != 0))
+
+int disk_seektime_params_match(currdisk, other)
+disk *currdisk;
+disk *other;
+{
+   int i;
+
+   if ((currdisk->model->seektime != other->model->seektime) || (currdisk->model->seekone != other->model->seekone) || (currdisk->model->seekavg != other->model->seekavg) || (currdisk->model->seekfull != other->model->seekfull) || (currdisk->model->seekwritedelta != other->model->seekwritedelta) || (currdisk->model->headswitch != other->model->headswitch) || (currdisk->model->numcyls != other->model->numcyls)) {
+      return(FALSE);
+   }
+   for (i=0; i<6; i++) {
+      if (currdisk->model->hpseek[i] != other->model->hpseek[i]) {
+         return(FALSE);
+      }
+   }
+   for (i=0; i<10; i++) {
+      if (currdisk->model->first10seeks[i] != other->model->first10seeks[i]) {
+         return(FALSE);
+      }
+   }
+   return((currdisk->model->extractseekcnt == other->model->extractseekcnt) && (currdisk->model->extractseekdists == other->model->extractseekdists) && (currdisk->model->extractseektimes == other->model->extractseektimes));
+}
+
+
+/* Builds the seek table (and seek floor table, see disk_seektime_floor)  */
+/* for the model of disks[diskno], or shares the tables of an earlier     */
+/* disk's model with the same seek parameters (e.g., copies of a model    */
+/* that differ only in rotation speed).  Must be called once the seek     */
+/* parameters are final.                                                  */
+/* Extracted seek curves are only tabulated out to their last measured   */
+/* distance, so longer seeks still reach the model and its error check.  */
+
+void disk_seektime_table_initialize(diskno)
+int diskno;
+{
+   disk *currdisk = &disks[diskno];
+   int len = currdisk->model->numcyls;
+   int dist;
+   int i;
+
+   currdisk->model->seektablen = 0;
+   currdisk->model->seektable = NULL;
+   currdisk->model->seekfloor = NULL;
+   if (currdisk->model->seektime >= 0.0) {
+      return;
+   }
+   for (i=0; i<diskno; i++) {
+      if ((disks[i].model->seektable) && (disk_seektime_params_match(currdisk, &disks[i]))) {
+         currdisk->model->seektablen = disks[i].model->seektablen;
+         currdisk->model->seektable = disks[i].model->seektable;
+         currdisk->model->seekfloor = disks[i].model->seekfloor;
+         return;
+      }
+   }
+   if ((currdisk->model->seektime == EXTRACTION_SEEK) && (currdisk->model->extractseekcnt > 0)) {
+      len = min(len, (currdisk->model->extractseekdists[(currdisk->model->extractseekcnt-1)] + 1));
+   }
+   if (len <= 0) {
+      return;
+   }
+   currdisk->model->seektable = (double *) malloc(len * 4 * sizeof(double));
+   ASSERT(currdisk->model->seektable != NULL);
+   for (dist=0; dist<len; dist++) {
+      currdisk->model->seektable[SEEKTABLE_INDEX(dist, 0, 0)] = disk_seektime_compute(currdisk, dist, 0, 0);
+      currdisk->model->seektable[SEEKTABLE_INDEX(dist, 0, 1)] = disk_seektime_compute(currdisk, dist, 0, 1);
+      currdisk->model->seektable[SEEKTABLE_INDEX(dist, 1, 0)] = disk_seektime_compute(currdisk, dist, 1, 0);
+      currdisk->model->seektable[SEEKTABLE_INDEX(dist, 1, 1)] = disk_seektime_compute(currdisk, dist, 1, 1);
+   }
+   currdisk->model->seekfloor = (double *) malloc(len * sizeof(double));
+   ASSERT(currdisk->model->seekfloor != NULL);
+   for (dist=(len-1); dist>=0; dist--) {
+      currdisk->model->seekfloor[dist] = min(currdisk->model->seektable[SEEKTABLE_INDEX(dist, 0, 0)], currdisk->model->seektable[SEEKTABLE_INDEX(dist, 0, 1)]);
+      currdisk->model->seekfloor[dist] = min(currdisk->model->seekfloor[dist], currdisk->model->seektable[SEEKTABLE_INDEX(dist, 1, 0)]);
+      currdisk->model->seekfloor[dist] = min(currdisk->model->seekfloor[dist], currdisk->model->seektable[SEEKTABLE_INDEX(dist, 1, 1)]);
+      if (dist < (len-1)) {
+         currdisk->model->seekfloor[dist] = min(currdisk->model->seekfloor[dist], currdisk->model->seekfloor[(dist+1)]);
+      }
+   }
+   currdisk->model->seektablen = len;
+}
+
+
+/* Returns a lower bound on the time of any seek covering at least the   */
+/* given distance (with or without a head switch, read or write).  The   */
+/* seek table holds the minimum over all longer tabulated distances;     */
+/* beyond the table, or without one, nothing better than 0 is known.     */
+
+double disk_seektime_floor(currdisk, distance)
+disk *currdisk;
+int distance;
+{
+   int dist = abs(distance);
+
+   if (dist < currdisk->model->seektablen) {
+      return(currdisk->model->seekfloor[dist]);
+   }
+   return(0.0);
+}
+
+
+double diskseektime(currdisk, distance, headswitch, read)
+disk *currdisk;
+int distance;
+int headswitch;
+int read;
+{
+   int dist = abs(distance);
+
+   if (dist < currdisk->model->seektablen) {
+      return(currdisk->model->seektable[SEEKTABLE_INDEX(dist, headswitch, read)]);
+   }
+   return(disk_seektime_compute(currdisk, distance, headswitch, read));
+}
+
+
+/* Returns the rotational offset (from logical zero) of the given physical */
+/* block on the given track.                                              */
+
+double disk_pbn_angle(currdisk, currband, cylno, surfaceno, physblkno)
 disk *currdisk;
 band *currband;
+int cylno;
+int surfaceno;
 int physblkno;
 {
-   currangle = (double) physblkno / (double) currband->blkspertrack;
-   currangle += disk_map_pbn_skew(currdisk, currband, currcylno, currsurface);
-   currangle = currangle - ((int) currangle);
+   double angle;
+
+   angle = (double) physblkno / (double) currband->blkspertrack;
+   angle += disk_map_pbn_skew(currdisk, currband, cylno, surfaceno);
+   angle = angle - ((int) angle);
+   return(angle);
 }
 
 
-/* currangle is a global, set to equal the rotational offset (from logical */
-/* zero) of the read/write head (or media, depending on one's viewpoint).  */
+/* Returns the (fractional) physical block under the head. */
 
-double disk_get_blkno_from_currangle(currdisk, currband)
+double disk_head_get_blkno(currdisk, currband, head)
 disk *currdisk;
 band *currband;
+diskhead *head;
 {
-   double rotloc = currangle;
+   double rotloc = head->angle;
    int introtloc;
 
-   rotloc -= disk_map_pbn_skew(currdisk, currband, currcylno, currsurface);
+   rotloc -= disk_map_pbn_skew(currdisk, currband, head->cylno, head->surface);
    if (rotloc > 0.0) {
       introtloc = (int) rotloc;
    } else {
@@ -407,27 +537,37 @@ band *currband;
 }
 
 
-double disklatency(currdisk, currband, rotstarttime, blkno, bcount, immedaccess)
+/* Returns the rotational latency until blkno (or, for immediate accesses, */
+/* any sector of the request) passes under a head that is on the target   */
+/* track at rotstarttime.  The head is rotated forward to rotstarttime,   */
+/* and *trackstartptr is set to the sector the media access begins with.  */
+
+double disk_head_latency(currdisk, currband, head, rotstarttime, blkno, bcount, immedaccess, trackstartptr)
 disk *currdisk;
 band *currband;
+diskhead *head;
 double rotstarttime;
 int blkno;
 int bcount;
 int immedaccess;
+int *trackstartptr;
 {
    double latency;
    double rotloc;
    double rotdistance;
    int endblock;
+   int trackstart;
    double blkspertrack;
 
-   if (currdisk->acctime == AVGROTATE) {
-      return((double) 0.5 * currdisk->rotatetime);
+   if (currdisk->model->acctime == AVGROTATE) {
+      *trackstartptr = blkno;
+      return((double) 0.5 * currdisk->model->rotatetime);
    }
    blkspertrack = (double) currband->blkspertrack;
-   currangle += (rotstarttime - currtime) / currdisk->rotatetime;
-   currangle = currangle - (double) ((int) currangle);
-   rotloc = disk_get_blkno_from_currangle(currdisk, currband);
+   head->angle += (rotstarttime - head->time) / currdisk->model->rotatetime;
+   head->angle = head->angle - (double) ((int) head->angle);
+   head->time = rotstarttime;
+   rotloc = disk_head_get_blkno(currdisk, currband, head);
    if (fabs((double) blkno - rotloc) < 0.0001) {
       rotloc = (double) blkno;
    }
@@ -459,16 +599,26 @@ int immedaccess;
 	 trackstart = blkno;
       }
    }
-   latency = (rotdistance / blkspertrack) * currdisk->rotatetime;
+   *trackstartptr = trackstart;
+   latency = (rotdistance / blkspertrack) * currdisk->model->rotatetime;
    return(latency);
 }
 
 
-double diskxfertime(currdisk, currband, blkno, reqsize)
+/* Returns the media transfer time for reqsize sectors starting at blkno, */
+/* given the sector (trackstart) at which disk_head_latency said the      */
+/* access begins.  If the access starts mid-request and wraps around the  */
+/* track, *addtolatencyptr is set to the extra rotation that adds.  The   */
+/* head is left at the angle where the transfer ends.                     */
+
+double disk_head_xfertime(currdisk, currband, head, blkno, reqsize, trackstart, addtolatencyptr)
 disk *currdisk;
 band *currband;
+diskhead *head;
 int blkno;
 int reqsize;
+int trackstart;
+double *addtolatencyptr;
 {
    double xfertime;
    int blks_on_track;
@@ -479,24 +629,33 @@ int reqsize;
       fprintf(stderr, "Request %d goes beyond end of track, in diskxfertime: %d + %d >= %d\n", blkno, reqsize, blkno, blks_on_track);
       exit(0);
    }
-   xfertime = ((double) reqsize / (double) blks_on_track) * currdisk->rotatetime;
+   xfertime = ((double) reqsize / (double) blks_on_track) * currdisk->model->rotatetime;
    if (trackstart != blkno) {
       physblkno = trackstart;
-      addtolatency = (double) (blks_on_track - reqsize);
-      addtolatency *= currdisk->rotatetime / (double) blks_on_track;
+      *addtolatencyptr = (double) (blks_on_track - reqsize);
+      *addtolatencyptr *= currdisk->model->rotatetime / (double) blks_on_track;
    } else {
       physblkno = (blkno + reqsize) % blks_on_track;
-      addtolatency = (double) 0;
+      *addtolatencyptr = (double) 0;
    }
-   disk_reset_currangle(currdisk, currband, physblkno);
+   head->angle = disk_pbn_angle(currdisk, currband, head->cylno, head->surface, physblkno);
 
    return(xfertime);
 }
 
-      
-double diskacctime(currdisk, currband, type, rw, reqtime, cylno, surfaceno, blkno, bcount, immedaccess)
+
+/* The mechanical positioning model.  Computes the time for the access    */
+/* described by type (see diskacctime) for a head starting in state *head */
+/* and fills in *timing.  Uses no state other than currdisk's parameters  */
+/* and the arguments, so it can be used speculatively.  On return, *head  */
+/* holds where the head ends up: on the target track after a seek, at     */
+/* the start of the media access for DISKPOS, and at the end of the      */
+/* transfer once the transfer time has been computed.                    */
+
+double disk_position(currdisk, currband, head, type, rw, reqtime, cylno, surfaceno, blkno, bcount, immedaccess, timing)
 disk *currdisk;
 band *currband;
+diskhead *head;
 int type;
 int rw;
 double reqtime;
@@ -505,59 +664,47 @@ int surfaceno;
 int blkno;
 int bcount;
 int immedaccess;
+disktiming *timing;
 {
    int distance;
    int headswitch;
-   double seektime;
-   double latency;
-   double xfertime;
    double acctime;
 
-   if (currdisk->acctime >= 0.0) {
-      return(currdisk->acctime);
-   }
-   currcylno = currdisk->currcylno;
-   currsurface = currdisk->currsurface;
-   currangle = currdisk->currangle;
-   currtime = currdisk->currtime;
-   distance = cylno - currcylno;
-   headswitch = surfaceno - currsurface;
+   disk_positionings++;
+   distance = cylno - head->cylno;
+   headswitch = surfaceno - head->surface;
 
-   seektime = 0.0;
-   seekdistance = abs(distance);
+   timing->seekdistance = abs(distance);
+   timing->trackstart = -1;
+   timing->seektime = 0.0;
+   timing->latency = 0.0;
+   timing->addtolatency = 0.0;
+   timing->xfertime = 0.0;
    if ((type != DISKPOS) && (type != DISKACCESS)) {
-      seektime = diskseektime(currdisk, distance, headswitch, rw);
-      reqtime += seektime;
-      currcylno = cylno;
-      currsurface = surfaceno;
-      if (type == DISKSEEKTIME) {
-         return(seektime);
-      } else if (type == DISKSEEK) {
-         currdisk->currcylno = cylno;
-         currdisk->currsurface = surfaceno;
-         return(seektime);
+      timing->seektime = diskseektime(currdisk, distance, headswitch, rw);
+      reqtime += timing->seektime;
+      head->cylno = cylno;
+      head->surface = surfaceno;
+      if ((type == DISKSEEKTIME) || (type == DISKSEEK)) {
+         return(timing->seektime);
       }
    }
-   latency = disklatency(currdisk, currband, reqtime, blkno, bcount, immedaccess);
-   reqtime += latency;
+   timing->latency = disk_head_latency(currdisk, currband, head, reqtime, blkno, bcount, immedaccess, &timing->trackstart);
+   reqtime += timing->latency;
    if (type == DISKPOSTIME) {
-      return(seektime + latency);
+      return(timing->seektime + timing->latency);
    } else if (type == DISKPOS) {
-      currdisk->currcylno = cylno;
-      currdisk->currsurface = surfaceno;
-      currdisk->currtime = reqtime;
-      disk_reset_currangle(currdisk, currband, trackstart);
-      currdisk->currangle = currangle;
-      return(seektime + latency);
-   }
-   xfertime = diskxfertime(currdisk, currband, blkno, bcount);
-   latency += addtolatency;
-   acctime = seektime + latency + xfertime;
+      head->angle = disk_pbn_angle(currdisk, currband, head->cylno, head->surface, timing->trackstart);
+      head->cylno = cylno;
+      head->surface = surfaceno;
+      head->time = reqtime;
+      return(timing->seektime + timing->latency);
+   }
+   timing->xfertime = disk_head_xfertime(currdisk, currband, head, blkno, bcount, timing->trackstart, &timing->addtolatency);
+   head->time = reqtime + timing->addtolatency + timing->xfertime;
+   timing->latency += timing->addtolatency;
+   acctime = timing->seektime + timing->latency + timing->xfertime;
    if (type == DISKACCESS) {
-      currdisk->currcylno = currcylno;
-      currdisk->currsurface = currsurface;
-      currdisk->currangle = currangle;
-      currdisk->currtime = reqtime + addtolatency + xfertime;
       if (distance | headswitch) {
 	 fprintf(stderr, "Shouldn't have non-zero seek for DISKACCESS\n");
 	 exit(0);
@@ -565,7 +712,7 @@ int immedaccess;
       return(acctime);
    }
    if (type == DISKSERVTIME) {
-      return(seektime + latency);
+      return(timing->seektime + timing->latency);
    } else if (type == DISKACCTIME) {
       return(acctime);
    }
@@ -573,3 +720,236 @@ int immedaccess;
    exit(0);
 }
 
+
+/* Returns currdisk's diskbatch, grown if need be to hold count entries. */
+
+diskbatch * disk_batch_reserve(currdisk, count)
+disk *currdisk;
+int count;
+{
+   diskbatch *batch = currdisk->posbatch;
+
+   if (batch == NULL) {
+      batch = (diskbatch *) malloc(sizeof(diskbatch));
+      ASSERT(batch != NULL);
+      batch->size = 0;
+      currdisk->posbatch = batch;
+   }
+   if (count > batch->size) {
+      if (batch->size) {
+	 free(batch->ids);
+	 free(batch->bands);
+	 free(batch->cylnos);
+	 free(batch->surfaces);
+	 free(batch->blknos);
+	 free(batch->bcounts);
+	 free(batch->reads);
+	 free(batch->immeds);
+	 free(batch->starttimes);
+	 free(batch->seektimes);
+	 free(batch->postimes);
+      }
+      batch->size = max(count, (2 * batch->size));
+      batch->ids = (int *) malloc(batch->size * sizeof(int));
+      batch->bands = (band **) malloc(batch->size * sizeof(band *));
+      batch->cylnos = (int *) malloc(batch->size * sizeof(int));
+      batch->surfaces = (int *) malloc(batch->size * sizeof(int));
+      batch->blknos = (int *) malloc(batch->size * sizeof(int));
+      batch->bcounts = (int *) malloc(batch->size * sizeof(int));
+      batch->reads = (int *) malloc(batch->size * sizeof(int));
+      batch->immeds = (int *) malloc(batch->size * sizeof(int));
+      batch->starttimes = (double *) malloc(batch->size * sizeof(double));
+      batch->seektimes = (double *) malloc(batch->size * sizeof(double));
+      batch->postimes = (double *) malloc(batch->size * sizeof(double));
+      ASSERT((batch->ids != NULL) && (batch->bands != NULL) && (batch->cylnos != NULL) && (batch->surfaces != NULL) && (batch->blknos != NULL) && (batch->bcounts != NULL) && (batch->reads != NULL) && (batch->immeds != NULL) && (batch->starttimes != NULL) && (batch->seektimes != NULL) && (batch->postimes != NULL));
+   }
+   batch->count = 0;
+   return(batch);
+}
+
+
+/* Fills in postimes[i] from seektimes[i]: the rotational half of        */
+/* disk_position(..., DISKSERVTIME, ...) for batch entry i.               */
+
+void disk_position_batch_latency(currdisk, head, batch, i)
+disk *currdisk;
+diskhead *head;
+diskbatch *batch;
+int i;
+{
+   int trackstart;
+   double latency;
+   double addtolatency;
+   double blkspertrack;
+   diskhead pos;
+
+   disk_positionings++;
+   pos.cylno = batch->cylnos[i];
+   pos.surface = batch->surfaces[i];
+   pos.angle = head->angle;
+   pos.time = head->time;
+   latency = disk_head_latency(currdisk, batch->bands[i], &pos, (batch->starttimes[i] + batch->seektimes[i]), batch->blknos[i], batch->bcounts[i], batch->immeds[i], &trackstart);
+   /* as in disk_head_xfertime */
+   addtolatency = 0.0;
+   if (trackstart != batch->blknos[i]) {
+      blkspertrack = (double) batch->bands[i]->blkspertrack;
+      addtolatency = blkspertrack - (double) batch->bcounts[i];
+      addtolatency *= currdisk->model->rotatetime / blkspertrack;
+   }
+   latency += addtolatency;
+   batch->postimes[i] = batch->seektimes[i] + latency;
+}
+
+
+/* Computes what disk_position(..., DISKSERVTIME, ...) would return for   */
+/* each candidate in the batch, all from the same starting head state     */
+/* (which is left unchanged).  The seeks are all done in one pass over    */
+/* the arrays (a table lookup each, see diskseektime) and the rotational  */
+/* waits in a second, so the per-candidate work is just the arithmetic.   */
+
+void disk_position_batch(currdisk, head, batch)
+disk *currdisk;
+diskhead *head;
+diskbatch *batch;
+{
+   int i;
+
+   for (i=0; i<batch->count; i++) {
+      batch->seektimes[i] = diskseektime(currdisk, (batch->cylnos[i] - head->cylno), (batch->surfaces[i] - head->surface), batch->reads[i]);
+   }
+   for (i=0; i<batch->count; i++) {
+      disk_position_batch_latency(currdisk, head, batch, i);
+   }
+}
+
+
+/* As disk_position_batch, for batch entry i alone. */
+
+void disk_position_batch_entry(currdisk, head, batch, i)
+disk *currdisk;
+diskhead *head;
+diskbatch *batch;
+int i;
+{
+   batch->seektimes[i] = diskseektime(currdisk, (batch->cylnos[i] - head->cylno), (batch->surfaces[i] - head->surface), batch->reads[i]);
+   disk_position_batch_latency(currdisk, head, batch, i);
+}
+
+
+/* The remaining functions are the original entry points, kept as thin    */
+/* wrappers around the above.  They still work on (and update) the        */
+/* scratch head state in currcylno, currsurface, currangle and currtime,   */
+/* and report through trackstart, addtolatency and seekdistance, which     */
+/* the disk controller code reads after calling them.                     */
+
+void disk_reset_currangle(currdisk, currband, physblkno)
+disk *currdisk;
+band *currband;
+int physblkno;
+{
+   currangle = disk_pbn_angle(currdisk, currband, currcylno, currsurface, physblkno);
+}
+
+
+double disk_get_blkno_from_currangle(currdisk, currband)
+disk *currdisk;
+band *currband;
+{
+   diskhead head;
+
+   head.cylno = currcylno;
+   head.surface = currsurface;
+   head.angle = currangle;
+   head.time = currtime;
+   return(disk_head_get_blkno(currdisk, currband, &head));
+}
+
+
+double disklatency(currdisk, currband, rotstarttime, blkno, bcount, immedaccess)
+disk *currdisk;
+band *currband;
+double rotstarttime;
+int blkno;
+int bcount;
+int immedaccess;
+{
+   diskhead head;
+   double latency;
+
+   head.cylno = currcylno;
+   head.surface = currsurface;
+   head.angle = currangle;
+   head.time = currtime;
+   latency = disk_head_latency(currdisk, currband, &head, rotstarttime, blkno, bcount, immedaccess, &trackstart);
+   currangle = head.angle;
+   return(latency);
+}
+
+
+double diskxfertime(currdisk, currband, blkno, reqsize)
+disk *currdisk;
+band *currband;
+int blkno;
+int reqsize;
+{
+   diskhead head;
+   double xfertime;
+
+   head.cylno = currcylno;
+   head.surface = currsurface;
+   head.angle = currangle;
+   head.time = currtime;
+   xfertime = disk_head_xfertime(currdisk, currband, &head, blkno, reqsize, trackstart, &addtolatency);
+   currangle = head.angle;
+   return(xfertime);
+}
+
+
+double diskacctime(currdisk, currband, type, rw, reqtime, cylno, surfaceno, blkno, bcount, immedaccess)
+disk *currdisk;
+band *currband;
+int type;
+int rw;
+double reqtime;
+int cylno;
+int surfaceno;
+int blkno;
+int bcount;
+int immedaccess;
+{
+   diskhead head;
+   disktiming timing;
+   double acctime;
+
+   if (currdisk->model->acctime >= 0.0) {
+      return(currdisk->model->acctime);
+   }
+   head.cylno = currdisk->currcylno;
+   head.surface = currdisk->currsurface;
+   head.angle = currdisk->currangle;
+   head.time = currdisk->currtime;
+   acctime = disk_position(currdisk, currband, &head, type, rw, reqtime, cylno, surfaceno, blkno, bcount, immedaccess, &timing);
+
+   currcylno = head.cylno;
+   currsurface = head.surface;
+   currangle = head.angle;
+   currtime = currdisk->currtime;
+   seekdistance = timing.seekdistance;
+   if ((type != DISKSEEKTIME) && (type != DISKSEEK)) {
+      trackstart = timing.trackstart;
+   }
+   if ((type == DISKACCESS) || (type == DISKSERVTIME) || (type == DISKACCTIME)) {
+      addtolatency = timing.addtolatency;
+   }
+
+   if (type == DISKSEEK) {
+      currdisk->currcylno = head.cylno;
+      currdisk->currsurface = head.surface;
+   } else if ((type == DISKPOS) || (type == DISKACCESS)) {
+      currdisk->currcylno = head.cylno;
+      currdisk->currsurface = head.surface;
+      currdisk->currangle = head.angle;
+      currdisk->currtime = head.time;
+   }
+   return(acctime);
+}
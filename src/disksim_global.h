@@ -50,6 +50,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 #include <strings.h>
 #include <math.h>
@@ -104,6 +105,7 @@
 #define SYNCHRONOUS	0x00000080
 #define ASYNCHRONOUS	0x00000100
 #define IO_FLAG_PAGEIO	0x00000200
+#define IO_FLAG_TIMED	0x00000400
 #define SEQ		0x40000000
 #define LOCAL		0x20000000
 
@@ -137,6 +139,13 @@ typedef union {
    char		byte[4];
 } intchar;
 
+/* Logical block numbers, and anything that can hold one (device and   */
+/* partition capacities, stripe addresses, and so on), are 64 bits so    */
+/* that multi-terabyte devices and arrays can be modelled.  Per-request  */
+/* block counts remain ints, which keeps ioreq_event within an event.    */
+
+typedef long long lbn_t;
+
 #define StaticAssert(c) switch (c) case 0: case (c):
 
 typedef struct foo {
@@ -164,8 +173,8 @@ typedef struct ioreq_ev {
    int    type;
    struct ioreq_ev *next;
    struct ioreq_ev *prev;
+   lbn_t  blkno;
    int    bcount;
-   int    blkno;
    u_int  flags;
    u_int  busno;
    u_int  slotno;
@@ -177,6 +186,9 @@ typedef struct ioreq_ev {
    int    tempint2;
    void  *tempptr1;
    void  *tempptr2;
+   void  *timing;      /* latency breakdown record, if IO_FLAG_TIMED */
+   int    timingid;
+   int    flow;        /* workload it belongs to, for fair queueing */
 } ioreq_event;
 
 typedef struct timer_ev {
@@ -235,6 +247,7 @@ extern void addtointq();
 extern int removefromintq();
 extern void scanparam_int();
 extern void getparam_int();
+extern void getparam_lbn();
 extern void getparam_double();
 extern void getparam_bool();
 
@@ -253,9 +253,10 @@ fprintf (stderr, "disksim_request_arrive\n");
    new->busno = 0;
    new->devno = requestdesc->devno;
    new->blkno = requestdesc->blkno;
-   new->bcount = requestdesc->bytecount / 512;
+   new->bcount = requestdesc->bytecount / io_sectsize;
    new->flags = isread(requestdesc) ? READ : WRITE;
    new->cause = 0;
+   new->flow = 0;
    new->opid = 0;
    new->buf = requestdesc;
 
@@ -49,6 +49,7 @@
 #include "disksim_iodriver.h"
 #include "disksim_orgface.h"
 #include "disksim_ioqueue.h"
+#include "disksim_timeline.h"
 
 int numiodrivers = 0;
 iodriver *iodrivers = NULL;
@@ -67,12 +68,44 @@ int drv_printintarrstats;
 int drv_printstreakstats;
 int drv_printstampstats;
 int drv_printperdiskstats;
+int drv_printbreakdownstats = FALSE;
+
+/* Stopping rule: when drv_stoptarget is non-zero, the run ends once the */
+/* batch-means confidence intervals on the mean and tail response time  */
+/* are both narrower than that fraction of the estimate.                */
+
+double drv_stoptarget = 0.0;
+int drv_stopbatchsize = 1000;
+int drv_stopminbatches = 10;
+statbatch respbatch;
 
 statgen emptyqueuestats;
 statgen initiatenextstats;
+statgen breakdownrespstats;
+statgen breakdownstats[BREAKDOWN_COMPONENTS];
 
 char *statdesc_emptyqueue	=  "Empty queue delay";
 char *statdesc_initiatenext	=  "Initiate next delay";
+char *statdesc_breakdownresp	=  "Breakdown response time";
+char *statdesc_breakdown[BREAKDOWN_COMPONENTS] = {
+   "Breakdown queue time",
+   "Breakdown bus wait time",
+   "Breakdown seek time",
+   "Breakdown rotational latency",
+   "Breakdown media transfer time",
+   "Breakdown controller/other time"
+};
+
+/* Per response-time bucket: count, summed response time, and summed time */
+/* in each breakdown component, for the attribution report.               */
+
+#define BREAKDOWN_STRIDE	(BREAKDOWN_COMPONENTS + 2)
+
+double *breakdownsums = NULL;
+int breakdownbuckets = 0;
+
+reqtiming *timingfreelist = NULL;
+int timingids = 0;
 
 extern FILE *outios;
 
@@ -103,7 +136,7 @@ double iodriver_raise_priority(iodriverno, opid, devno, blkno, chan)
 int iodriverno;
 int opid;
 int devno;
-int blkno;
+lbn_t blkno;
 void *chan;
 {
    logorg_raise_priority(sysorgs, numsysorgs, opid, devno, blkno, chan);
@@ -150,6 +183,135 @@ fprintf (outputfile, "Check send_out_req: queuectlr %d, numout %d, maxout %d, se
 }
 
 
+void iodriver_timing_attach(curr)
+ioreq_event *curr;
+{
+   reqtiming *timing;
+
+   if ((drv_printbreakdownstats == FALSE) && (!TIMELINE_ON)) {
+      curr->flags &= ~IO_FLAG_TIMED;
+      return;
+   }
+   if ((timing = timingfreelist)) {
+      timingfreelist = timing->next;
+   } else {
+      timing = (reqtiming *) malloc(sizeof(reqtiming));
+      ASSERT(timing != NULL);
+   }
+   timing->reqid = ++timingids;
+   timing->arrtime = simtime;
+   timing->dispatchtime = -1.0;
+   timing->buswait = 0.0;
+   timing->seektime = 0.0;
+   timing->latency = 0.0;
+   timing->xfertime = 0.0;
+   timing->next = NULL;
+   curr->timing = timing;
+   curr->timingid = timing->reqid;
+   curr->flags |= IO_FLAG_TIMED;
+}
+
+
+void iodriver_timing_free(timing)
+reqtiming *timing;
+{
+   timing->reqid = 0;
+   timing->next = timingfreelist;
+   timingfreelist = timing;
+}
+
+
+void iodriver_timing_dispatch(curr)
+ioreq_event *curr;
+{
+   reqtiming *timing = IO_TIMING(curr);
+
+   if (timing == NULL) {
+      /* e.g., a request built by the queue from several concatenated ones */
+      iodriver_timing_attach(curr);
+      timing = (reqtiming *) curr->timing;
+   }
+   if (timing->dispatchtime < 0.0) {
+      timing->dispatchtime = simtime;
+      if (TIMELINE_ON) {
+         timeline_async(TIMELINE_DRIVER, curr->devno, "queue", timing->arrtime, simtime, timeline_sampled(curr));
+      }
+   }
+}
+
+
+/* Fold a completed request's timing record into the breakdown stats.    */
+/* phys is the record of the physical access that satisfied it, which    */
+/* differs from the request's own record when the queue concatenated or  */
+/* combined requests.  Components can overlap (e.g., media transfer      */
+/* continues while the disk arbitrates for the bus), so the residual     */
+/* "controller/other" component is clamped at zero.                      */
+
+void iodriver_timing_complete(curr, phys)
+ioreq_event *curr;
+reqtiming *phys;
+{
+   reqtiming *timing = IO_TIMING(curr);
+   double comp[BREAKDOWN_COMPONENTS];
+   double resptime;
+   double *sums;
+   int i;
+
+   if (timing == NULL) {
+      return;
+   }
+   if ((phys) && (phys != timing)) {
+      if (timing->dispatchtime < 0.0) {
+         timing->dispatchtime = phys->dispatchtime;
+      }
+      timing->buswait += phys->buswait;
+      timing->seektime += phys->seektime;
+      timing->latency += phys->latency;
+      timing->xfertime += phys->xfertime;
+   }
+   if (timing->dispatchtime < 0.0) {
+      timing->dispatchtime = simtime;
+   }
+   if (TIMELINE_ON) {
+      timeline_async(TIMELINE_DRIVER, curr->devno, ((curr->flags & READ) ? "read" : "write"), timing->arrtime, simtime, timeline_sampled(curr));
+   }
+   if (drv_printbreakdownstats == FALSE) {
+      curr->flags &= ~IO_FLAG_TIMED;
+      if (timing != phys) {
+         iodriver_timing_free(timing);
+      }
+      return;
+   }
+   resptime = simtime - timing->arrtime;
+   comp[BREAKDOWN_QUEUE] = timing->dispatchtime - timing->arrtime;
+   comp[BREAKDOWN_BUSWAIT] = timing->buswait;
+   comp[BREAKDOWN_SEEK] = timing->seektime;
+   comp[BREAKDOWN_LATENCY] = timing->latency;
+   comp[BREAKDOWN_XFER] = timing->xfertime;
+   comp[BREAKDOWN_OTHER] = resptime;
+   for (i=0; i<BREAKDOWN_OTHER; i++) {
+      comp[BREAKDOWN_OTHER] -= comp[i];
+   }
+   if (comp[BREAKDOWN_OTHER] < 0.0) {
+      comp[BREAKDOWN_OTHER] = 0.0;
+   }
+
+   stat_update(&breakdownrespstats, resptime);
+   sums = &breakdownsums[(stat_get_bucket(&breakdownrespstats, resptime) * BREAKDOWN_STRIDE)];
+   sums[0] += 1.0;
+   sums[1] += resptime;
+   for (i=0; i<BREAKDOWN_COMPONENTS; i++) {
+      stat_update(&breakdownstats[i], comp[i]);
+      sums[(i+2)] += comp[i];
+   }
+
+   curr->flags &= ~IO_FLAG_TIMED;
+   if (timing != phys) {
+      iodriver_timing_free(timing);
+   }
+}
+
+
 ioreq_event * handle_new_request(curriodriver, curr)
 iodriver *curriodriver;
 ioreq_event *curr;
@@ -157,16 +319,41 @@ ioreq_event *curr;
    struct ioq *queue = curriodriver->devices[(curr->devno)].queue;
    ioreq_event *ret = NULL;
 
+   iodriver_timing_attach(curr);
    ioqueue_add_new_request(queue, curr);
    if (check_send_out_request(curriodriver, curr->devno)) {
-      ret = ioqueue_get_next_request(queue, NULL);
-      schedule_disk_access(curriodriver, ret);
-      ret->time = IODRIVER_IMMEDSCHED_TIME * curriodriver->scale;
+      if ((ret = ioqueue_get_next_request(queue, NULL))) {
+         schedule_disk_access(curriodriver, ret);
+         ret->time = IODRIVER_IMMEDSCHED_TIME * curriodriver->scale;
+      }
    }
    return(ret);
 }
 
 
+/* Called by a device's queue when its scheduler, having held requests */
+/* back while the device was free, is ready to let one go.  The access */
+/* is scheduled directly, without charging any CPU time for it.        */
+
+void iodriver_queue_wakeup(curriodriver, devno)
+iodriver *curriodriver;
+int devno;
+{
+   ioreq_event *req;
+
+   if (!(check_send_out_request(curriodriver, devno))) {
+      return;
+   }
+   if ((req = ioqueue_get_next_request(curriodriver->devices[devno].queue, NULL))) {
+      schedule_disk_access(curriodriver, req);
+      req->type = IO_ACCESS_ARRIVE;
+      req->next = NULL;
+      req->time = simtime;
+      addtointq((event *) req);
+   }
+}
+
+
 void iodriver_schedule(iodriverno, curr)
 int iodriverno;
 ioreq_event *curr;
@@ -177,6 +364,9 @@ fprintf (outputfile, "Entered iodriver_schedule - devno %d, blkno %d, bcount %d,
 */
    ASSERT1(curr->type == IO_ACCESS_ARRIVE, "curr->type", curr->type);
 
+   if ((drv_printbreakdownstats) || (TIMELINE_ON)) {
+      iodriver_timing_dispatch(curr);
+   }
    if ((iodrivers[iodriverno].consttime != 0.0) && (iodrivers[iodriverno].consttime != IODRIVER_TRACED_QUEUE_TIMES)) {
       curr->type = IO_INTERRUPT;
       if (iodrivers[iodriverno].consttime > 0.0) {
@@ -241,7 +431,7 @@ iodriver *curriodriver;
 int devno;
 int cause;
 int type;
-int blkno;
+lbn_t blkno;
 {
    ctlr *ctl;
    ioreq_event *tmp;
@@ -350,6 +540,7 @@ intr_event *intrp;
    int devno;
    int skip = 0;
    ctlr *ctl = NULL;
+   reqtiming *phys;
 
    if (iodrivers[iodriverno].type == STANDALONE) {
       req = ioreq_copy((ioreq_event *) intrp->infoptr);
@@ -373,11 +564,11 @@ fprintf (outputfile, "oversized request in list: opid %d, blkno %d, bcount %d\n"
          tmp = tmp->next;
       }
       if ((tmp) && (tmp->next->devno == req->devno) && (tmp->next->opid == req->opid) && (req->blkno >= tmp->next->blkno) && (req->blkno < (tmp->next->blkno + tmp->next->bcount))) {
-fprintf (outputfile, "%f, part of oversized request completed: opid %d, blkno %d, bcount %d, maxreqsize %d\n", simtime, req->opid, req->blkno, req->bcount, ctl->maxreqsize);
+fprintf (outputfile, "%f, part of oversized request completed: opid %d, blkno %lld, bcount %d, maxreqsize %d\n", simtime, req->opid, req->blkno, req->bcount, ctl->maxreqsize);
          if ((req->blkno + ctl->maxreqsize) < (tmp->next->blkno + tmp->next->bcount)) {
 fprintf (outputfile, "more to go\n");
             req->blkno += ctl->maxreqsize;
-            req->bcount = min(ctl->maxreqsize, (tmp->next->blkno + tmp->next->bcount - req->blkno));
+            req->bcount = (int) min(ctl->maxreqsize, (tmp->next->blkno + tmp->next->bcount - req->blkno));
             goto schedule_next;
          } else {
 fprintf (outputfile, "done for real\n");
@@ -392,7 +583,11 @@ fprintf (outputfile, "done for real\n");
       }
    }
    devno = req->devno;
+   phys = IO_TIMING(req);
    req = ioqueue_physical_access_done(iodrivers[iodriverno].devices[devno].queue, req);
+   if ((drv_stoptarget > 0.0) && (respbatch.converged)) {
+      simstop();
+   }
    if (ctl) {
       ctl->numoutstanding--;
    }
@@ -431,6 +626,7 @@ fprintf (outputfile, "done for real\n");
       req = req->next;
       tmp->next = NULL;
       update_iodriver_statistics();
+      iodriver_timing_complete(tmp, phys);
       if ((numreqs = logorg_mapcomplete(sysorgs, numsysorgs, tmp)) == COMPLETE) {
          if (iodrivers[iodriverno].type != STANDALONE) {
             iodriver_add_to_intrp_eventlist(intrp, io_done_notify(tmp), iodrivers[iodriverno].scale);
@@ -455,6 +651,9 @@ fprintf (outputfile, "done for real\n");
       }
       addtoextraq((event *) tmp);
    }
+   if (phys) {
+      iodriver_timing_free(phys);
+   }
    if ((iodrivers[iodriverno].consttime == IODRIVER_TRACED_QUEUE_TIMES) || (iodrivers[iodriverno].consttime == IODRIVER_TRACED_BOTH_TIMES)) {
       if (ioqueue_get_number_in_queue(iodrivers[iodriverno].devices[devno].queue) > 0) {
          iodrivers[iodriverno].devices[devno].flag = 1;
@@ -524,7 +723,7 @@ fprintf (outputfile, "%f, Responding to device - cause = %d, blkno %d\n", simtim
                fprintf(stderr, "Unknown io_interrupt cause - %d\n", req->cause);
                exit(0);
    }
-   iodriver_check_c700_based_status(&iodrivers[iodriverno], devno, cause, IO_INTERRUPT_COMPLETE, 0);
+   iodriver_check_c700_based_status(&iodrivers[iodriverno], devno, cause, IO_INTERRUPT_COMPLETE, (lbn_t) 0);
 }
 
 
@@ -654,7 +853,7 @@ ioreq_event *curr;
 fprintf (outputfile, "Entered iodriver_request - simtime %f, devno %d, blkno %d, cause %d\n", simtime, curr->devno, curr->blkno, curr->cause);
 */
    if (outios) {
-      fprintf(outios, "%.6f\t%d\t%d\t%d\t%x\n", curr->time, curr->devno, curr->blkno, curr->bcount, curr->flags);
+      fprintf(outios, "%.6f\t%d\t%lld\t%d\t%x\n", curr->time, curr->devno, curr->blkno, curr->bcount, curr->flags);
    }
    totalreqs++;
    if (totalreqs == warmup_iocnt) {
@@ -899,8 +1098,44 @@ int last;
    }
    i = first;
    for (i=first; i<=last; i++) {
-      if ((strcmp(paramname, "ioqueue_schedalg") == 0) || (strcmp(paramname, "ioqueue_seqscheme") == 0) || (strcmp(paramname, "ioqueue_cylmaptype") == 0) || (strcmp(paramname, "ioqueue_to_time") == 0) || (strcmp(paramname, "ioqueue_timeout_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_schedalg") == 0) || (strcmp(paramname, "ioqueue_priority_mix") == 0)) {
+      if (strncmp(paramname, "ioqueue_", 8) == 0) {
          ioqueue_param_override(iodrivers[i].queue, paramname, paramval);
+      } else if (strcmp(paramname, "printbreakdownstats") == 0) {
+         if (sscanf(paramval, "%d\n", &drv_printbreakdownstats) != 1) {
+            fprintf(stderr, "Error reading printbreakdownstats in iodriver_param_override\n");
+            exit(0);
+         }
+         if ((drv_printbreakdownstats != TRUE) && (drv_printbreakdownstats != FALSE)) {
+            fprintf(stderr, "Invalid value for printbreakdownstats in iodriver_param_override: %d\n", drv_printbreakdownstats);
+            exit(0);
+         }
+      } else if (strcmp(paramname, "stoptarget") == 0) {
+         if (sscanf(paramval, "%lf\n", &drv_stoptarget) != 1) {
+            fprintf(stderr, "Error reading stoptarget in iodriver_param_override\n");
+            exit(0);
+         }
+         if ((drv_stoptarget < 0.0) || (drv_stoptarget >= 1.0)) {
+            fprintf(stderr, "Invalid value for stoptarget in iodriver_param_override: %f\n", drv_stoptarget);
+            exit(0);
+         }
+      } else if (strcmp(paramname, "stopbatchsize") == 0) {
+         if (sscanf(paramval, "%d\n", &drv_stopbatchsize) != 1) {
+            fprintf(stderr, "Error reading stopbatchsize in iodriver_param_override\n");
+            exit(0);
+         }
+         if (drv_stopbatchsize < 100) {
+            fprintf(stderr, "Invalid value for stopbatchsize in iodriver_param_override: %d\n", drv_stopbatchsize);
+            exit(0);
+         }
+      } else if (strcmp(paramname, "stopminbatches") == 0) {
+         if (sscanf(paramval, "%d\n", &drv_stopminbatches) != 1) {
+            fprintf(stderr, "Error reading stopminbatches in iodriver_param_override\n");
+            exit(0);
+         }
+         if (drv_stopminbatches < 2) {
+            fprintf(stderr, "Invalid value for stopminbatches in iodriver_param_override: %d\n", drv_stopminbatches);
+            exit(0);
+         }
       } else if (strcmp(paramname, "usequeue") == 0) {
          if (sscanf(paramval, "%d\n", &iodrivers[i].usequeue) != 1) {
             fprintf(stderr, "Error reading usequeue in iodriver_param_override\n");
@@ -982,12 +1217,16 @@ fprintf (outputfile, "This one is c700_based - %d\n", j);
          currdev->flag = 0;
          currdev->queue = ioqueue_copy(curriodriver->queue);
          ioqueue_initialize(currdev->queue, j);
+         ioqueue_set_wakeup_function(currdev->queue, iodriver_queue_wakeup, curriodriver);
          queueset[j] = currdev->queue;
          currdev->buspath.value = 0;
          currdev->slotpath.value = 0;
          iodriver_get_path_to_device(i, currdev);
          iodriver_set_ctl_to_device(i, currdev);
          get_device_maxoutstanding(curriodriver, currdev);
+         if (drv_stoptarget > 0.0) {
+            ioqueue_set_batch_stats(currdev->queue, &respbatch);
+         }
       }
       logorg_initialize(sysorgs, numsysorgs, queueset);
 /*
@@ -996,6 +1235,21 @@ fprintf (outputfile, "Back from logorg_initialize\n");
    }
    stat_initialize(statdeffile, statdesc_emptyqueue, &emptyqueuestats);
    stat_initialize(statdeffile, statdesc_initiatenext, &initiatenextstats);
+   if (drv_stoptarget > 0.0) {
+      stat_batch_initialize(&respbatch, drv_stopbatchsize, drv_stopminbatches, drv_stoptarget);
+   }
+   if (drv_printbreakdownstats) {
+      stat_initialize(statdeffile, statdesc_breakdownresp, &breakdownrespstats);
+      for (i=0; i<BREAKDOWN_COMPONENTS; i++) {
+         stat_initialize(statdeffile, statdesc_breakdown[i], &breakdownstats[i]);
+      }
+      breakdownbuckets = max(DISTSIZE, breakdownrespstats.distbrks[(DISTSIZE-1)]);
+      breakdownsums = (double *) malloc(breakdownbuckets * BREAKDOWN_STRIDE * sizeof(double));
+      ASSERT(breakdownsums != NULL);
+      for (i=0; i<(breakdownbuckets * BREAKDOWN_STRIDE); i++) {
+         breakdownsums[i] = 0.0;
+      }
+   }
 /*
 print_paths_to_devices();
 print_paths_to_ctlrs();
@@ -1016,6 +1270,18 @@ void iodriver_resetstats()
    logorg_resetstats(sysorgs, numsysorgs);
    stat_reset(&emptyqueuestats);
    stat_reset(&initiatenextstats);
+   if (drv_stoptarget > 0.0) {
+      stat_batch_reset(&respbatch);
+   }
+   if (drv_printbreakdownstats) {
+      stat_reset(&breakdownrespstats);
+      for (i=0; i<BREAKDOWN_COMPONENTS; i++) {
+         stat_reset(&breakdownstats[i]);
+      }
+      for (i=0; i<(breakdownbuckets * BREAKDOWN_STRIDE); i++) {
+         breakdownsums[i] = 0.0;
+      }
+   }
 }
 
 
@@ -1214,6 +1480,77 @@ FILE *parfile;
 }
 
 
+void iodriver_print_breakdown_row(prefix, label, sums)
+char *prefix;
+char *label;
+double *sums;
+{
+   int i;
+
+   fprintf(outputfile, "%sLatency attribution %s:\t%d", prefix, label, (int) sums[0]);
+   for (i=0; i<BREAKDOWN_COMPONENTS; i++) {
+      fprintf(outputfile, "\t%5.3f", ((sums[1] > 0.0) ? (sums[(i+2)] / sums[1]) : 0.0));
+   }
+   fprintf(outputfile, "\n");
+}
+
+
+/* Report, for all requests and for the slowest tail of them, the fraction */
+/* of total response time spent in each breakdown component.  Tails are    */
+/* resolved to the bucket boundaries of the "Breakdown response time"      */
+/* distribution, so the reported tail fraction is the nearest one that     */
+/* the buckets allow.                                                      */
+
+void iodriver_print_breakdown(prefix)
+char *prefix;
+{
+   static double tailfracs[] = { 0.5, 0.1, 0.01 };
+   double rowsums[BREAKDOWN_STRIDE];
+   char label[80];
+   int count = stat_get_count(&breakdownrespstats);
+   int cnt;
+   int i, j, k;
+
+   stat_print(&breakdownrespstats, prefix);
+   for (i=0; i<BREAKDOWN_COMPONENTS; i++) {
+      stat_print(&breakdownstats[i], prefix);
+   }
+   fprintf(outputfile, "%sLatency attribution (fraction of response time):\tCount\tQueue\tBuswait\tSeek\tRotate\tXfer\tOther\n", prefix);
+   for (j=0; j<BREAKDOWN_STRIDE; j++) {
+      rowsums[j] = 0.0;
+   }
+   for (i=0; i<breakdownbuckets; i++) {
+      for (j=0; j<BREAKDOWN_STRIDE; j++) {
+         rowsums[j] += breakdownsums[(i * BREAKDOWN_STRIDE + j)];
+      }
+   }
+   iodriver_print_breakdown_row(prefix, "all requests", rowsums);
+   for (k=0; k<(sizeof(tailfracs)/sizeof(double)); k++) {
+      for (j=0; j<BREAKDOWN_STRIDE; j++) {
+         rowsums[j] = 0.0;
+      }
+      cnt = 0;
+      for (i=(breakdownbuckets-1); i>=0; i--) {
+         for (j=0; j<BREAKDOWN_STRIDE; j++) {
+            rowsums[j] += breakdownsums[(i * BREAKDOWN_STRIDE + j)];
+         }
+         cnt += (int) breakdownsums[(i * BREAKDOWN_STRIDE)];
+         if ((double) cnt >= (tailfracs[k] * (double) count)) {
+            break;
+         }
+      }
+      sprintf(label, "slowest %4.1f%% (>= %.3f)", (100.0 * (double) cnt / (double) count), stat_get_bucket_start(&breakdownrespstats, max(i, 0)));
+      iodriver_print_breakdown_row(prefix, label, rowsums);
+   }
+   for (i=0; i<breakdownbuckets; i++) {
+      if (breakdownsums[(i * BREAKDOWN_STRIDE)] > 0.0) {
+         sprintf(label, "bucket >= %.3f", stat_get_bucket_start(&breakdownrespstats, i));
+         iodriver_print_breakdown_row(prefix, label, &breakdownsums[(i * BREAKDOWN_STRIDE)]);
+      }
+   }
+}
+
+
 void iodriver_printstats()
 {
    int i;
@@ -1232,7 +1569,7 @@ void iodriver_printstats()
    for (i = 0; i < numiodrivers; i++) {
       setsize += iodrivers[i].numdevices;
    }
-   queueset = (struct ioq **)malloc(setsize*sizeof(int));
+   queueset = (struct ioq **)malloc(setsize*sizeof(struct ioq *));
    ASSERT(queueset != NULL);
    setsize = 0;
    for (i = 0; i < numiodrivers; i++) {
@@ -1249,6 +1586,12 @@ void iodriver_printstats()
       stat_print(&initiatenextstats, prefix);
    }
    ioqueue_printstats(queueset, setsize, prefix);
+   if ((drv_printbreakdownstats) && (stat_get_count(&breakdownrespstats) > 0)) {
+      iodriver_print_breakdown(prefix);
+   }
+   if (drv_stoptarget > 0.0) {
+      stat_batch_print(&respbatch, "IOdriver Response time ");
+   }
    if ((drv_printperdiskstats == TRUE) && ((numiodrivers > 1) || (iodrivers[0].numdevices > 1))) {
       for (i = 0; i < numiodrivers; i++) {
          for (j = 0; j < iodrivers[i].numdevices; j++) {
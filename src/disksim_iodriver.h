@@ -82,6 +82,16 @@
 #define IODRIVER_TRACED_QUEUE_TIMES	-2.0
 #define IODRIVER_TRACED_BOTH_TIMES	-3.0
 
+/* Latency breakdown components (see iodriver_timing_complete) */
+
+#define BREAKDOWN_QUEUE		0
+#define BREAKDOWN_BUSWAIT	1
+#define BREAKDOWN_SEEK		2
+#define BREAKDOWN_LATENCY	3
+#define BREAKDOWN_XFER		4
+#define BREAKDOWN_OTHER		5
+#define BREAKDOWN_COMPONENTS	6
+
 typedef struct {
    int		type;
    int		usequeue;
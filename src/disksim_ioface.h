@@ -83,5 +83,7 @@ extern void    io_catch_stray_events();
 extern void    io_param_override();
 extern void    io_map_trace_request();
 
+extern int     io_sectsize;
+
 #endif   /* DISKSIM_IOFACE_H */
 
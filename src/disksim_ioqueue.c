@@ -43,6 +43,8 @@
  * holders.
  */
 
+#include <time.h>
+
 #include "disksim_global.h"
 #include "disksim_ioqueue.h"
 #include "disksim_iosim.h"
@@ -54,15 +56,39 @@ int global_surfoverforw = FALSE;
 
 int priority_mix = 1;
 
+/* Deadline and anticipatory scheduling parameters (times in ms) */
+
+double deadline_read_expire = 500.0;
+double deadline_write_expire = 5000.0;
+int deadline_fifo_batch = 16;
+int deadline_writes_starved = 2;
+double antic_expire = 6.0;
+
+/* Fair queueing parameters, with per-flow weights set by override */
+
+int fq_budget = 1024;
+double fq_slice = 0.0;
+double *fq_weights = NULL;
+int fq_numweights = 0;
+
+/* Lookahead SPTF parameters */
+
+int lookahead_depth = 3;
+int lookahead_beam = 4;
+
 int force_absolute_fcfs = FALSE;
 
 int (*enablement)() = NULL;
 
+/* Waiting requests offered to the scheduling policies in the current */
+/* decision (see ioqueue_decision_begin)                              */
+
+int decision_offered = 0;
+
 #define READY_TO_GO(iobufptr) ((iobufptr->state == WAITING) && ((enablement == NULL) || ((*enablement)(iobufptr->iolist))))
 
 /* Request scheduling algorithms */
 
-#define MINSCHED	1
 #define FCFS            1
 #define ELEVATOR_LBN    2
 #define CYCLE_LBN       3
@@ -84,7 +110,10 @@ int (*enablement)() = NULL;
 #define PRI_VSCAN_LBN   19
 #define PRI_ASPTF_OPT   20
 #define PRI_ASPCTF_OPT  21
-#define MAXSCHED        21
+#define DEADLINE        22
+#define ANTICIPATORY    23
+#define FAIR_QUEUE      24
+#define LOOKAHEAD_SPTF  25
 
 /* Sequential Stream Schemes */
 
@@ -134,18 +163,19 @@ char *statdesc_reqsizestats	=	"Request size";
 char *statdesc_readsizestats	=	"Read request size";
 char *statdesc_writesizestats	=	"Write request size";
 char *statdesc_instqueuelen	=	"Instantaneous queue length";
+char *statdesc_decisiontime	=	"Scheduling decision time";
 
 typedef struct iob {
    double    starttime;
+   lbn_t     blkno;
    int       state;
+   int       totalsize;
    struct iob *next;
    struct iob *prev;
-   int       totalsize;
-   int       blkno;
    int       flags;
    union {
       struct {
- 	 int       waittime;
+ 	 int       arrtick;	/* ioqueue tick count on arrival */
          ioreq_event *concat;
       } pend;
       double time;
@@ -155,20 +185,120 @@ typedef struct iob {
    int       cylinder;
    int       surface;
    int       opid;
+   struct iob *left;		/* ordered subqueue index, see IOQUEUE_ORDERED */
+   struct iob *right;
+   lbn_t     maxblkno;
+   unsigned int treeseq;
+   int       height;
+   int       heapidx;		/* position in the subqueue's deadline heap */
+   int       schedslot;		/* the policy's own index for it, see iosched */
 } iobuf;
 
 struct ioq;
 
+/* Completion index: each subqueue hashes its iobufs on (blkno, opid),  */
+/* once for the iobuf itself and once for each request concatenated    */
+/* behind the first one on its iolist (whose key is the iobuf's own),  */
+/* so that completing and specifically requested requests are found    */
+/* without walking the list.  Entries come from a private free list.   */
+
+#define IOQUEUE_HASH_SIZE	128
+#define IOQUEUE_HASH(blkno, opid)	((((u_int) (blkno)) ^ (((u_int) (opid)) << 4)) % IOQUEUE_HASH_SIZE)
+
+typedef struct iohash {
+   lbn_t	blkno;
+   int		opid;
+   iobuf *	buf;
+   struct iohash *next;
+} iohashent;
+
+iohashent *iohashfreelist = NULL;
+
+/* LBN index: subqueues that concatenate or combine overlapping requests */
+/* also keep their iobufs in an AVL tree on (blkno, treeseq), whatever   */
+/* order the list is in, with each node recording the highest end       */
+/* (blkno + totalsize) in its subtree.  Requests that abut or overlap a */
+/* range are then found without walking the list.  Nodes come from a    */
+/* private free list and are found again by their key.                  */
+
+typedef struct iolbn {
+   iobuf *	buf;
+   lbn_t	blkno;
+   lbn_t	end;
+   lbn_t	maxend;
+   unsigned int	seq;
+   int		height;
+   struct iolbn *left;
+   struct iolbn *right;
+} iolbnent;
+
+iolbnent *iolbnfreelist = NULL;
+
+/* Timeout deadlines: each subqueue that ioqueue_tick ages (see         */
+/* ioqueue_timeout_limit) keeps its requests in a min-heap on the tick  */
+/* at which they will have waited too long, so a tick only has to look */
+/* at the requests whose time is up rather than at the whole queue.    */
+
+typedef struct {
+   int		deadline;
+   iobuf *	buf;
+} iodeadline;
+
+/* Scheduler interface.  A subqueue's policy is reached only through its */
+/* entry in ioqueue_scheds, which "Scheduling policy" and the like name  */
+/* by number or by name.  peek chooses among two or more iobufs without  */
+/* committing to the choice (it may move queue->dir, which the caller    */
+/* puts back when only showing the request), and pop is told which one   */
+/* is being dispatched, by whatever route.  The remaining hooks, all     */
+/* optional, let a policy keep its own structures in schedpriv: insert   */
+/* and remove bracket an iobuf's stay in the list (a concatenated iobuf  */
+/* is removed as it merges into its neighbour, through concat instead   */
+/* if the policy gives one), complete follows the access, and tick      */
+/* follows ioqueue_tick.  A policy that holds sets holds, as its peek    */
+/* may then return NULL with requests ready to go (even a lone one),     */
+/* and gets the queue owner to ask again through ioqueue's wakeup.       */
+
+typedef struct iosched {
+   int		number;
+   char *	name;
+   int		ordered;	/* list in positional order (IOQUEUE_ORDERED) */
+   int		cylmap;		/* mapping for new requests, -1 for cylmaptype */
+   int		travel;		/* direction kept by LBN or cylinder, if any */
+   struct iob *	(*peek)();	/* (queue) */
+   void		(*pop)();	/* (queue, iobuf) */
+   void		(*insert)();	/* (queue, iobuf) */
+   void		(*remove)();	/* (queue, iobuf) */
+   void		(*complete)();	/* (queue, iobuf) */
+   void		(*tick)();	/* (queue) */
+   void		(*initialize)();	/* (queue, devno) */
+   void		(*resetstats)();	/* (queue) */
+   void		(*printstats)();	/* (set, setsize, prefix) */
+   void		(*concat)();	/* (queue, iobuf, iobuf merging into it) */
+   int		holds;		/* peek may keep ready requests waiting */
+} iosched;
+
+#define TRAVEL_LBN	1
+#define TRAVEL_CYL	2
+
 typedef struct subq {
    struct ioq *	bigqueue;
    int		sched_alg;
+   iosched *	sched;
+   void *	schedpriv;
    int		surfoverforw;
    iobuf *	list;
+   iobuf *	tree;
+   unsigned int	treeseq;
+   iohashent *	hash[IOQUEUE_HASH_SIZE];
+   iolbnent *	lbnindex;
+   iodeadline *	heap;
+   int		heaplen;
+   int		heapsize;
    iobuf *	current;
    int		prior;
    int		dir;
    int		vscan_cyls;
-   u_int	lastblkno;
+   lbn_t	lastblkno;
    int		lastsurface;
    int		lastcylno;
    int		optcylno;
@@ -185,13 +315,10 @@ typedef struct subq {
    int		maxlistlen;
    double	runlistlen;
    int		readlen;
-   int		maxreadlen;
    double	runreadlen;
-   int		maxwritelen;
    int		numcomplete;
    int		reqoutstanding;
    int		numoutstanding;
-   int		maxoutstanding;
    double	runoutstanding;
    statgen	outtimestats;
    statgen	critreadstats;
@@ -204,6 +331,23 @@ typedef struct subq {
    statgen	infopenalty;
 } subqueue;
 
+/* Scratch space for ioqueue_get_request_from_opt_sptf_queue: the ready */
+/* candidates, with their delays and ages, the batch of requests handed  */
+/* to the disk for estimates, and the candidates' visiting order.        */
+
+typedef struct {
+   double	bound;
+   int		index;
+} sptfcand;
+
+typedef struct {
+   servbatch	reqs;
+   iobuf **	bufs;
+   double *	delays;
+   double *	ages;
+   sptfcand *	order;
+} sptfscratch;
+
 typedef struct ioq {
    subqueue	base;
    subqueue	timeout;
@@ -213,6 +357,8 @@ typedef struct ioq {
    void	*	idleworkparam;
    int		idledelay;
    timer_event *idledetect;
+   void		(*wakeup)();
+   void *	wakeupparam;
    int		(*concatok)();
    void *	concatokparam;
    int		concatmax;
@@ -221,6 +367,7 @@ typedef struct ioq {
    int 		seqstreamdiff;
    int		to_scheme;
    int		to_time;
+   int		ticks;
    int		pri_scheme;
    int		cylmaptype;
    double	writedelay;
@@ -244,12 +391,11 @@ typedef struct ioq {
    statgen	writesizestats;
    int		maxlistlen;
    int		maxqlen;
-   int		maxoutstanding;
    int		maxreadlen;
    int		maxwritelen;
    int		overlapscombed;
    int		readoverlapscombed;
-   int		seqblkno;
+   lbn_t	seqblkno;
    int		seqflags;
    int		seqreads;
    int		seqwrites;
@@ -258,6 +404,14 @@ typedef struct ioq {
    int		printidlestats;
    int		printintarrstats;
    int		printsizestats;
+   int		printdecisionstats;
+   double	decisions;
+   double	candidates;
+   double	estimates;
+   double	positionings;
+   statgen	decisiontime;
+   statbatch *	respbatch;
+   sptfscratch *sptf;
 } ioqueue;
 
 
@@ -270,21 +424,21 @@ ioqueue *queue;
    tmp = queue->base.list->next;
    fprintf (outputfile, "Contents of base queue: listlen %d\n", queue->base.listlen);
    for (i = 0; i < queue->base.iobufcnt; i++) {
-      fprintf(outputfile, "State: %d, blkno: %d\n", tmp->state, tmp->blkno);
+      fprintf(outputfile, "State: %d, blkno: %lld\n", tmp->state, tmp->blkno);
       tmp = tmp->next;
    }
 
    tmp = queue->timeout.list->next;
    fprintf(outputfile, "Contents of timeout queue: listlen %d\n", queue->timeout.listlen);
    for (i = 0; i < queue->timeout.iobufcnt; i++) {
-      fprintf(outputfile, "State: %d, blkno: %d\n", tmp->state, tmp->blkno);
+      fprintf(outputfile, "State: %d, blkno: %lld\n", tmp->state, tmp->blkno);
       tmp = tmp->next;
    }
 
    tmp = queue->priority.list->next;
    fprintf(outputfile, "Contents of priority queue: listlen %d\n", queue->priority.listlen);
    for (i = 0; i < queue->priority.iobufcnt; i++) {
-      fprintf(outputfile, "State: %d, blkno: %d\n", tmp->state, tmp->blkno);
+      fprintf(outputfile, "State: %d, blkno: %lld\n", tmp->state, tmp->blkno);
       tmp = tmp->next;
    }
 }
@@ -298,9 +452,9 @@ subqueue *queue;
 
    tmp = queue->list->next;
    fprintf(outputfile, "\nContents of subqueue: listlen %d\n", queue->listlen);
-   fprintf(outputfile, "Subqueue state: lastblkno %d, lastcylno %d, lastsurface %d, dir %d\n", queue->lastblkno, queue->lastcylno, queue->lastsurface, queue->dir);
+   fprintf(outputfile, "Subqueue state: lastblkno %lld, lastcylno %d, lastsurface %d, dir %d\n", queue->lastblkno, queue->lastcylno, queue->lastsurface, queue->dir);
    for (i = 0; i < queue->iobufcnt; i++) {
-      fprintf(outputfile, "State: %d, blkno: %d, cylno %d, surface %d\n", tmp->state, tmp->blkno, tmp->cylinder, tmp->surface);
+      fprintf(outputfile, "State: %d, blkno: %lld, cylno %d, surface %d\n", tmp->state, tmp->blkno, tmp->cylinder, tmp->surface);
       tmp = tmp->next;
    }
 }
@@ -361,11 +515,11 @@ ioqueue *queue;
 }
 
 
-int ioqueue_get_dist(queue, blkno)
+lbn_t ioqueue_get_dist(queue, blkno)
 ioqueue *queue;
-int blkno;
+lbn_t blkno;
 {
-   int lastblkno;
+   lbn_t lastblkno;
 
    if (queue->lastsubqueue == IOQUEUE_BASE) {
       lastblkno = queue->base.lastblkno;
@@ -377,14 +531,14 @@ int blkno;
       fprintf(stderr, "Unknown queue identification at ioqueue_get_dist - %d\n", queue->lastsubqueue);
       exit(0);
    }
-   return(abs(blkno - lastblkno));
+   return(diff(blkno, lastblkno));
 }
 
 
 void ioqueue_get_cylinder_mapping(queue, curr, blkno, cylptr, surfptr, cylmaptype)
 ioqueue *queue;
 iobuf *curr;
-int blkno;
+lbn_t blkno;
 int *cylptr;
 int *surfptr;
 int cylmaptype;
@@ -411,7 +565,7 @@ int cylmaptype;
          break;
 
       case MAP_AVGCYLMAP:
-         *cylptr = blkno / queue->sectpercyl;
+         *cylptr = (int) (blkno / queue->sectpercyl);
          *surfptr = 0;
          break;
 
@@ -445,6 +599,27 @@ double idledelay;
 }
 
 
+/* Lets a scheduler that has held requests back (see iosched) get the */
+/* owner to ask for the next request again.                           */
+
+void ioqueue_set_wakeup_function(queue, wakeup, wakeupparam)
+ioqueue *queue;
+void (*wakeup)();
+void *wakeupparam;
+{
+   queue->wakeup = wakeup;
+   queue->wakeupparam = wakeupparam;
+}
+
+
+void ioqueue_set_batch_stats(queue, respbatch)
+ioqueue *queue;
+statbatch *respbatch;
+{
+   queue->respbatch = respbatch;
+}
+
+
 void ioqueue_idledetected(timereq)
 timer_event *timereq;
 {
@@ -523,820 +698,3263 @@ ioreq_event *curr;
 }
 
 
+/* The time-weighted lengths are integrated one interval at a time:    */
+/* callers close the interval just before altering a subqueue's        */
+/* lengths, and ioqueue_cleanstats closes the last one.  Intervals of  */
+/* zero width add nothing, and queues whose statistics are never       */
+/* printed keep nothing.  The lengths only grow on insertion, so that   */
+/* is the one place the maxima need to be checked.                      */
+
 void ioqueue_update_queue_statistics(queue)
 subqueue *queue;
 {
-   double tdiff = simtime - queue->lastalt;
+   double tdiff;
 
+   if ((queue->bigqueue->printqueuestats == FALSE) || (simtime == queue->lastalt)) {
+      return;
+   }
+   tdiff = simtime - queue->lastalt;
    queue->runlistlen += tdiff * queue->listlen;
    queue->runreadlen += tdiff * queue->readlen;
-   if (queue->readlen > queue->maxreadlen) {
-      queue->maxreadlen = queue->readlen;
-   }
-   if ((queue->listlen - queue->readlen) > queue->maxwritelen) {
-      queue->maxwritelen = queue->listlen - queue->readlen;
-   }
    queue->runoutstanding += tdiff * queue->numoutstanding;
-   if (queue->numoutstanding > queue->maxoutstanding) {
-      queue->maxoutstanding = queue->numoutstanding;
-   }
+   queue->lastalt = simtime;
+}
+
+
+void ioqueue_update_queue_maxima(queue)
+subqueue *queue;
+{
    if (queue->listlen > queue->maxlistlen) {
       queue->maxlistlen = queue->listlen;
    }
    if ((queue->listlen - queue->numoutstanding) > queue->maxqlen) {
       queue->maxqlen = queue->listlen - queue->numoutstanding;
    }
-   queue->lastalt = simtime;
 }
 
 
-void ioqueue_remove_from_subqueue(queue, tmp)
-subqueue *queue;
-iobuf *tmp;
+/* Subqueues kept in positional order (the policies marked ordered in  */
+/* ioqueue_scheds, i.e., all built-in ones but FCFS and PRI_VSCAN_LBN)  */
+/* are also indexed by an AVL tree on (cylinder, surface, blkno), with   */
+/* ties broken by order of insertion, so that the list position of a    */
+/* new request and the schedulers' starting points near the last        */
+/* position take O(log n) rather than walks of the list.  Each node     */
+/* also records the highest blkno in its subtree, for                   */
+/* ioqueue_tree_find_blkno.  The list itself is still what the          */
+/* schedulers scan from there.                                          */
+
+#define IOQUEUE_ORDERED(queue)	((queue)->sched->ordered)
+
+int ioqueue_tree_compare(a, b)
+iobuf *a;
+iobuf *b;
 {
-   if ((queue->list == tmp) && (tmp == tmp->next)) {
-      queue->list = NULL;
-   } else {
-      tmp->next->prev = tmp->prev;
-      tmp->prev->next = tmp->next;
-      if (queue->list == tmp) {
-         queue->list = tmp->prev;
-      }
+   if (a->cylinder != b->cylinder) {
+      return((a->cylinder < b->cylinder) ? -1 : 1);
    }
-   tmp->next = NULL;
-   tmp->prev = NULL;
+   if (a->surface != b->surface) {
+      return((a->surface < b->surface) ? -1 : 1);
+   }
+   if (a->blkno != b->blkno) {
+      return((a->blkno < b->blkno) ? -1 : 1);
+   }
+   return((int) (a->treeseq - b->treeseq));
 }
 
 
-/* queue->list not NULL when entered */
+void ioqueue_tree_update(node)
+iobuf *node;
+{
+   int lheight = (node->left) ? node->left->height : 0;
+   int rheight = (node->right) ? node->right->height : 0;
 
-void ioqueue_insert_fcfs_to_queue(queue, temp)
-subqueue *queue;
-iobuf *temp;
+   node->height = max(lheight, rheight) + 1;
+   node->maxblkno = node->blkno;
+   if ((node->left) && (node->left->maxblkno > node->maxblkno)) {
+      node->maxblkno = node->left->maxblkno;
+   }
+   if ((node->right) && (node->right->maxblkno > node->maxblkno)) {
+      node->maxblkno = node->right->maxblkno;
+   }
+}
+
+
+/* Restores the AVL balance at node, whose subtrees are balanced and     */
+/* differ in height by at most two, and returns the subtree's new root.  */
+
+iobuf * ioqueue_tree_balance(node)
+iobuf *node;
 {
-   temp->next = queue->list->next;
-   temp->prev = queue->list;
-   temp->next->prev = temp;
-   temp->prev->next = temp;
-   queue->list = temp;
+   iobuf *child;
+   iobuf *grandchild;
+   int lheight = (node->left) ? node->left->height : 0;
+   int rheight = (node->right) ? node->right->height : 0;
+
+   if (lheight > (rheight + 1)) {
+      child = node->left;
+      if (((child->left) ? child->left->height : 0) < ((child->right) ? child->right->height : 0)) {
+         grandchild = child->right;
+         child->right = grandchild->left;
+         grandchild->left = child;
+         ioqueue_tree_update(child);
+         child = grandchild;
+      }
+      node->left = child->right;
+      child->right = node;
+      ioqueue_tree_update(node);
+      node = child;
+   } else if (rheight > (lheight + 1)) {
+      child = node->right;
+      if (((child->right) ? child->right->height : 0) < ((child->left) ? child->left->height : 0)) {
+         grandchild = child->left;
+         child->left = grandchild->right;
+         grandchild->right = child;
+         ioqueue_tree_update(child);
+         child = grandchild;
+      }
+      node->right = child->left;
+      child->left = node;
+      ioqueue_tree_update(node);
+      node = child;
+   }
+   ioqueue_tree_update(node);
+   return(node);
 }
 
 
-/* queue->list not NULL when entered */
+/* Adds node to the tree rooted at root, returning the new root.  *predptr */
+/* is set to node's in-order predecessor, if it has one.                 */
 
-void ioqueue_insert_ordered_to_queue(queue, temp)
-subqueue *queue;
-iobuf *temp;
+iobuf * ioqueue_tree_insert(root, node, predptr)
+iobuf *root;
+iobuf *node;
+iobuf **predptr;
 {
-   iobuf *head;
-   iobuf *run;
+   if (root == NULL) {
+      node->left = NULL;
+      node->right = NULL;
+      ioqueue_tree_update(node);
+      return(node);
+   }
+   if (ioqueue_tree_compare(node, root) < 0) {
+      root->left = ioqueue_tree_insert(root->left, node, predptr);
+   } else {
+      *predptr = root;
+      root->right = ioqueue_tree_insert(root->right, node, predptr);
+   }
+   return(ioqueue_tree_balance(root));
+}
 
-   head = queue->list->next;
 
-   if ((temp->cylinder < head->cylinder)       ||
-       ((temp->cylinder == head->cylinder) && 
-        (temp->surface < head->surface))       ||
-       ((temp->cylinder == head->cylinder) && 
-        (temp->surface == head->surface)   && 
-        (temp->blkno < head->blkno))) {
-      queue->list->next = temp;
-      temp->next = head;
-      temp->prev = queue->list;
-      head->prev = temp;
-
-   } else if ((temp->cylinder > queue->list->cylinder)       ||
-              ((temp->cylinder == queue->list->cylinder) && 
-               (temp->surface > queue->list->surface))       ||
-              ((temp->cylinder == queue->list->cylinder) && 
-               (temp->surface == queue->list->surface)   && 
-               (temp->blkno >= queue->list->blkno))) {
-      temp->next = head;
-      temp->prev = queue->list;
-      head->prev = temp;
-      queue->list->next = temp;
-      queue->list = temp;
+iobuf * ioqueue_tree_remove_min(root, minptr)
+iobuf *root;
+iobuf **minptr;
+{
+   if (root->left == NULL) {
+      *minptr = root;
+      return(root->right);
+   }
+   root->left = ioqueue_tree_remove_min(root->left, minptr);
+   return(ioqueue_tree_balance(root));
+}
+
+
+iobuf * ioqueue_tree_remove(root, node)
+iobuf *root;
+iobuf *node;
+{
+   iobuf *min;
+   int cmp;
+
+   ASSERT(root != NULL);
+   cmp = ioqueue_tree_compare(node, root);
+   if (cmp < 0) {
+      root->left = ioqueue_tree_remove(root->left, node);
+   } else if (cmp > 0) {
+      root->right = ioqueue_tree_remove(root->right, node);
    } else {
-      run = head;
-      while ((temp->cylinder > run->next->cylinder)     ||
-             ((temp->cylinder == run->next->cylinder)  && 
-              (temp->surface > run->next->surface))     ||
-             ((temp->cylinder == run->next->cylinder)  && 
-              (temp->surface == run->next->surface)    && 
-              (temp->blkno >= run->next->blkno))) {
-         run = run->next;
+      ASSERT(root == node);
+      if (root->right == NULL) {
+         return(root->left);
       }
-      temp->next = run->next;
-      temp->prev = run;
-      temp->next->prev = temp;
-      run->next = temp;
+      root->right = ioqueue_tree_remove_min(root->right, &min);
+      min->left = root->left;
+      min->right = root->right;
+      root = min;
    }
+   return(ioqueue_tree_balance(root));
 }
 
 
-int ioqueue_check_concat(queue, req1, req2, concatmax)
-subqueue *queue;
-iobuf *req1;
-iobuf *req2;
-int concatmax;
+/* Returns the first request (in list order) at or beyond the given track */
+/* (cylno, surface), or NULL if there is none.                           */
+
+iobuf * ioqueue_tree_find_track(root, cylno, surface)
+iobuf *root;
+int cylno;
+int surface;
 {
-   ioreq_event *tmp;
-   int seqscheme = queue->bigqueue->seqscheme;
-   int (*concatok)() = queue->bigqueue->concatok;
-   void *concatokparam = queue->bigqueue->concatokparam;
+   iobuf *ret = NULL;
 
-   if (req1->next != req2) {
-      fprintf(stderr, "Non-adjacent requests sent to ioqueue_check_concat\n");
-      exit(0);
-   }
-   if (req1->flags & READ) {
-      if (!(seqscheme & IOQUEUE_CONCAT_READS) || !(req2->flags & READ)) {
-	 return(0);
-      }
-   } else {
-      if (!(seqscheme & IOQUEUE_CONCAT_WRITES) || (req2->flags & READ)) {
-	 return(0);
+   while (root) {
+      if ((root->cylinder > cylno) || ((root->cylinder == cylno) && (root->surface >= surface))) {
+         ret = root;
+         root = root->left;
+      } else {
+         root = root->right;
       }
    }
-   if ((req1 == queue->list) || (req1 == req2) || !READY_TO_GO(req1) || !READY_TO_GO(req2) || ((req1->blkno + req1->totalsize) != req2->blkno) || ((req1->totalsize + req2->totalsize) > concatmax)) {
-      return(0);
+   return(ret);
+}
+
+
+/* Returns the first request (in list order) after "after" whose blkno is */
+/* at least blkno, or NULL if there is none.  after may be NULL, to       */
+/* search the whole list.  Since the list is ordered by cylinder rather   */
+/* than blkno, this relies on the subtrees' maxblkno rather than on the   */
+/* blknos being sorted.                                                   */
+
+iobuf * ioqueue_tree_find_blkno(root, blkno, after)
+iobuf *root;
+lbn_t blkno;
+iobuf *after;
+{
+   iobuf *ret;
+
+   if ((root == NULL) || (root->maxblkno < blkno)) {
+      return(NULL);
    }
-   if (concatok) {
-      if (concatok(concatokparam, req1->blkno, req1->totalsize, req2->blkno, req2->totalsize) == 0) {
-	 return(0);
-      }
+   if ((after) && (ioqueue_tree_compare(root, after) <= 0)) {
+      return(ioqueue_tree_find_blkno(root->right, blkno, after));
    }
-   tmp = req1->iolist;
-   if (tmp == NULL) {
-      req1->iolist = req2->iolist;
-   } else {
-      while (tmp->next) {
-         tmp = tmp->next;
-      }
-      tmp->next = req2->iolist;
+   if ((ret = ioqueue_tree_find_blkno(root->left, blkno, after))) {
+      return(ret);
    }
-   req1->next = req2->next;
-   req1->next->prev = req1;
-   req1->reqcnt += req2->reqcnt;
-   req1->totalsize += req2->totalsize;
-   if (queue->list == req2) {
-      queue->list = req1;
+   if (root->blkno >= blkno) {
+      return(root);
    }
-   queue->iobufcnt--;
-   addtoextraq((event *) req2);
-   return(1);
+   return(ioqueue_tree_find_blkno(root->right, blkno, (iobuf *) NULL));
 }
 
 
-void ioqueue_insert_new_request(queue, temp)
+void ioqueue_hash_add(queue, blkno, opid, buf)
 subqueue *queue;
-iobuf *temp;
+lbn_t blkno;
+int opid;
+iobuf *buf;
 {
-   int concatmax;
+   iohashent **head = &queue->hash[IOQUEUE_HASH(blkno, opid)];
+   iohashent *ent;
 
-   ioqueue_update_queue_statistics(queue);
-   queue->iobufcnt++;
-   if (queue->list == NULL) {
-      queue->list = temp;
-      temp->next = temp;
-      temp->prev = temp;
+   if ((ent = iohashfreelist)) {
+      iohashfreelist = ent->next;
    } else {
-      if ((queue->sched_alg == FCFS) || (queue->sched_alg == PRI_VSCAN_LBN)) {
-         ioqueue_insert_fcfs_to_queue(queue, temp);
-      } else {
-         ioqueue_insert_ordered_to_queue(queue, temp);
-      }
-   }
-   concatmax = queue->bigqueue->concatmax;
-   if (concatmax) {
-      temp = temp->prev;
-      if (!(ioqueue_check_concat(queue, temp, temp->next, concatmax))) {
-	 temp = temp->next;
-      }
-      ioqueue_check_concat(queue, temp, temp->next, concatmax);
+      ent = (iohashent *) malloc(sizeof(iohashent));
+      ASSERT(ent != NULL);
+   }
+   ent->blkno = blkno;
+   ent->opid = opid;
+   ent->buf = buf;
+   ent->next = *head;
+   *head = ent;
+}
+
+
+iohashent ** ioqueue_hash_locate(queue, blkno, opid, buf)
+subqueue *queue;
+lbn_t blkno;
+int opid;
+iobuf *buf;
+{
+   iohashent **entptr = &queue->hash[IOQUEUE_HASH(blkno, opid)];
+
+   while ((*entptr) && (((*entptr)->buf != buf) || ((*entptr)->blkno != blkno) || ((*entptr)->opid != opid))) {
+      entptr = &(*entptr)->next;
    }
-   queue->listlen++;
-   if (temp->flags & READ) {
-      queue->readlen++;
-      queue->numreads++;
-   } else {
-      queue->numwrites++;
+   if (*entptr == NULL) {
+      fprintf(stderr, "Request missing from ioqueue hash - blkno %lld, opid %d\n", blkno, opid);
+      exit(0);
    }
+   return(entptr);
 }
 
 
-/* Returns 0 if request is sequential from a previous request (and detection */
-/* enabled).  Otherwise returns 1.				             */
-/* Assuming no command queueing.					     */
-
-int ioqueue_seqstream_head(queue, listhead, current)
-ioqueue *queue;
-iobuf *listhead;
-iobuf *current;
+void ioqueue_hash_insert(queue, buf)
+subqueue *queue;
+iobuf *buf;
 {
-   int idiff;
-   int ret = 0;
+   ioreq_event *trv;
 
-   if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_READS|IOQUEUE_SEQSTREAM_WRITES|IOQUEUE_SEQSTREAM_EITHER))) {
-      return(1);
-   }
-   idiff = queue->seqstreamdiff;
-   if ((current == listhead) || !READY_TO_GO(current->prev)) {
-      ret = 1;
+   ASSERT((buf->iolist == NULL) || ((buf->iolist->blkno == buf->blkno) && (buf->iolist->opid == buf->opid)));
+   ioqueue_hash_add(queue, buf->blkno, buf->opid, buf);
+   trv = (buf->iolist) ? buf->iolist->next : NULL;
+   while (trv) {
+      ioqueue_hash_add(queue, trv->blkno, trv->opid, buf);
+      trv = trv->next;
    }
-   if (ret == 0) {
-      if (current->flags & READ) {
-         if (current->prev->flags & READ) {
-	    if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_READS|IOQUEUE_SEQSTREAM_EITHER))) {
-	       ret = 1;
-	    }
-         } else {
-	    if (!(queue->seqscheme & IOQUEUE_SEQSTREAM_EITHER)) {
-	       ret = 1;
-	    }
-         }
-	 if ((current->prev->blkno != current->blkno) && (((current->prev->blkno + current->prev->totalsize + idiff) < current->blkno))) {
-	    ret = 1;
-	 }
-      } else {
-         if (current->prev->flags & READ) {
-	    if (!(queue->seqscheme & IOQUEUE_SEQSTREAM_EITHER)) {
-	       ret = 1;
-	    }
-         } else {
-	    if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_WRITES|IOQUEUE_SEQSTREAM_EITHER))) {
-	       ret = 1;
-	    }
-         }
-	 if ((current->prev->blkno != current->blkno) && ((current->prev->blkno + current->prev->totalsize) != current->blkno)) {
-	    ret = 1;
-	 }
+}
+
+
+void ioqueue_hash_remove(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   iohashent **entptr;
+   iohashent *ent;
+   ioreq_event *trv;
+
+   entptr = ioqueue_hash_locate(queue, buf->blkno, buf->opid, buf);
+   trv = (buf->iolist) ? buf->iolist->next : NULL;
+   while (TRUE) {
+      ent = *entptr;
+      *entptr = ent->next;
+      ent->next = iohashfreelist;
+      iohashfreelist = ent;
+      if (trv == NULL) {
+         break;
       }
+      entptr = ioqueue_hash_locate(queue, trv->blkno, trv->opid, buf);
+      trv = trv->next;
    }
-   return(ret);
 }
 
 
-/* Queue contains >= 2 items when called */
+/* The requests of req2 now belong to req1 */
 
-iobuf * ioqueue_get_request_from_fcfs_queue(queue)
+void ioqueue_hash_concat(queue, req1, req2)
 subqueue *queue;
+iobuf *req1;
+iobuf *req2;
 {
-   iobuf *tmp;
+   ioreq_event *trv = req2->iolist;
+
+   while (trv) {
+      (*ioqueue_hash_locate(queue, trv->blkno, trv->opid, req2))->buf = req1;
+      trv = trv->next;
+   }
+}
+
+
+void ioqueue_hash_clear(queue)
+subqueue *queue;
+{
+   iohashent *ent;
    int i;
 
-   tmp = queue->list->next;
-   for (i = 0; i < queue->iobufcnt; i++) {
-      if (force_absolute_fcfs) {
-         if (tmp->state == WAITING) {
-            if (READY_TO_GO(tmp)) {
-               return(tmp);
-            } else {
-               return(NULL);
-            }
-         }
-      } else {
-         if (READY_TO_GO(tmp)) {
-            return(tmp);
-         }
+   for (i = 0; i < IOQUEUE_HASH_SIZE; i++) {
+      while ((ent = queue->hash[i])) {
+         queue->hash[i] = ent->next;
+         ent->next = iohashfreelist;
+         iohashfreelist = ent;
       }
-      tmp = tmp->next;
    }
-   return(NULL);
 }
 
 
-/* Queue contains >= 2 items when called */
+#define IOQUEUE_LBNINDEXED(queue)	(((queue)->bigqueue->concatmax) || ((queue)->bigqueue->comboverlaps))
+
+int ioqueue_lbn_compare(blkno, seq, node)
+lbn_t blkno;
+unsigned int seq;
+iolbnent *node;
+{
+   if (blkno != node->blkno) {
+      return((blkno < node->blkno) ? -1 : 1);
+   }
+   return((int) (seq - node->seq));
+}
+
+
+void ioqueue_lbn_update(node)
+iolbnent *node;
+{
+   int lheight = (node->left) ? node->left->height : 0;
+   int rheight = (node->right) ? node->right->height : 0;
+
+   node->height = max(lheight, rheight) + 1;
+   node->maxend = node->end;
+   if ((node->left) && (node->left->maxend > node->maxend)) {
+      node->maxend = node->left->maxend;
+   }
+   if ((node->right) && (node->right->maxend > node->maxend)) {
+      node->maxend = node->right->maxend;
+   }
+}
+
+
+/* As ioqueue_tree_balance */
+
+iolbnent * ioqueue_lbn_balance(node)
+iolbnent *node;
+{
+   iolbnent *child;
+   iolbnent *grandchild;
+   int lheight = (node->left) ? node->left->height : 0;
+   int rheight = (node->right) ? node->right->height : 0;
+
+   if (lheight > (rheight + 1)) {
+      child = node->left;
+      if (((child->left) ? child->left->height : 0) < ((child->right) ? child->right->height : 0)) {
+         grandchild = child->right;
+         child->right = grandchild->left;
+         grandchild->left = child;
+         ioqueue_lbn_update(child);
+         child = grandchild;
+      }
+      node->left = child->right;
+      child->right = node;
+      ioqueue_lbn_update(node);
+      node = child;
+   } else if (rheight > (lheight + 1)) {
+      child = node->right;
+      if (((child->right) ? child->right->height : 0) < ((child->left) ? child->left->height : 0)) {
+         grandchild = child->left;
+         child->left = grandchild->right;
+         grandchild->right = child;
+         ioqueue_lbn_update(child);
+         child = grandchild;
+      }
+      node->right = child->left;
+      child->left = node;
+      ioqueue_lbn_update(node);
+      node = child;
+   }
+   ioqueue_lbn_update(node);
+   return(node);
+}
+
+
+iolbnent * ioqueue_lbn_add(root, node)
+iolbnent *root;
+iolbnent *node;
+{
+   if (root == NULL) {
+      node->left = NULL;
+      node->right = NULL;
+      ioqueue_lbn_update(node);
+      return(node);
+   }
+   if (ioqueue_lbn_compare(node->blkno, node->seq, root) < 0) {
+      root->left = ioqueue_lbn_add(root->left, node);
+   } else {
+      root->right = ioqueue_lbn_add(root->right, node);
+   }
+   return(ioqueue_lbn_balance(root));
+}
+
+
+iolbnent * ioqueue_lbn_remove_min(root, minptr)
+iolbnent *root;
+iolbnent **minptr;
+{
+   if (root->left == NULL) {
+      *minptr = root;
+      return(root->right);
+   }
+   root->left = ioqueue_lbn_remove_min(root->left, minptr);
+   return(ioqueue_lbn_balance(root));
+}
+
+
+/* Takes the node keyed (blkno, seq) out of the tree, returning the new */
+/* root and the node itself in *nodeptr.                                */
+
+iolbnent * ioqueue_lbn_delete(root, blkno, seq, nodeptr)
+iolbnent *root;
+lbn_t blkno;
+unsigned int seq;
+iolbnent **nodeptr;
+{
+   iolbnent *min;
+   int cmp;
+
+   if (root == NULL) {
+      fprintf(stderr, "Request missing from ioqueue LBN index - blkno %lld\n", blkno);
+      exit(0);
+   }
+   cmp = ioqueue_lbn_compare(blkno, seq, root);
+   if (cmp < 0) {
+      root->left = ioqueue_lbn_delete(root->left, blkno, seq, nodeptr);
+   } else if (cmp > 0) {
+      root->right = ioqueue_lbn_delete(root->right, blkno, seq, nodeptr);
+   } else {
+      *nodeptr = root;
+      if (root->right == NULL) {
+         return(root->left);
+      }
+      root->right = ioqueue_lbn_remove_min(root->right, &min);
+      min->left = root->left;
+      min->right = root->right;
+      root = min;
+   }
+   return(ioqueue_lbn_balance(root));
+}
+
+
+void ioqueue_lbn_insert(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   iolbnent *node;
+
+   if (!(IOQUEUE_LBNINDEXED(queue))) {
+      return;
+   }
+   if ((node = iolbnfreelist)) {
+      iolbnfreelist = node->right;
+   } else {
+      node = (iolbnent *) malloc(sizeof(iolbnent));
+      ASSERT(node != NULL);
+   }
+   node->buf = buf;
+   node->blkno = buf->blkno;
+   node->end = buf->blkno + buf->totalsize;
+   node->seq = buf->treeseq;
+   queue->lbnindex = ioqueue_lbn_add(queue->lbnindex, node);
+}
+
+
+void ioqueue_lbn_remove(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   iolbnent *node;
+
+   if (!(IOQUEUE_LBNINDEXED(queue))) {
+      return;
+   }
+   queue->lbnindex = ioqueue_lbn_delete(queue->lbnindex, buf->blkno, buf->treeseq, &node);
+   ASSERT(node->buf == buf);
+   node->right = iolbnfreelist;
+   iolbnfreelist = node;
+}
+
+
+/* Returns the first entry (in LBN order) after "after" whose extent   */
+/* meets [lo, hi], counting extents that merely abut it, or NULL if    */
+/* there is none.  after may be NULL, to search the whole index.       */
+
+iolbnent * ioqueue_lbn_find(root, lo, hi, after)
+iolbnent *root;
+lbn_t lo;
+lbn_t hi;
+iolbnent *after;
+{
+   iolbnent *ret;
+
+   if ((root == NULL) || (root->maxend < lo)) {
+      return(NULL);
+   }
+   if ((after) && (ioqueue_lbn_compare(root->blkno, root->seq, after) <= 0)) {
+      return(ioqueue_lbn_find(root->right, lo, hi, after));
+   }
+   if ((ret = ioqueue_lbn_find(root->left, lo, hi, after))) {
+      return(ret);
+   }
+   if (root->blkno > hi) {
+      return(NULL);
+   }
+   if (root->end >= lo) {
+      return(root);
+   }
+   return(ioqueue_lbn_find(root->right, lo, hi, (iolbnent *) NULL));
+}
+
+
+void ioqueue_lbn_free(node)
+iolbnent *node;
+{
+   if (node) {
+      ioqueue_lbn_free(node->left);
+      ioqueue_lbn_free(node->right);
+      node->right = iolbnfreelist;
+      iolbnfreelist = node;
+   }
+}
+
+
+void ioqueue_lbn_clear(queue)
+subqueue *queue;
+{
+   ioqueue_lbn_free(queue->lbnindex);
+   queue->lbnindex = NULL;
+}
+
+
+/* Number of ticks a request may wait in queue before ioqueue_tick moves */
+/* it on, or -1 if ioqueue_tick does not age the subqueue.              */
+
+int ioqueue_timeout_limit(queue)
+subqueue *queue;
+{
+   ioqueue *bigqueue = queue->bigqueue;
+
+   if (queue == &bigqueue->base) {
+      if (bigqueue->to_scheme == BASETIMEOUT) {
+         return(bigqueue->to_time);
+      } else if (bigqueue->to_scheme == HALFTIMEOUT) {
+         return(bigqueue->to_time / 2);
+      }
+   } else if ((queue == &bigqueue->timeout) && (bigqueue->to_scheme == HALFTIMEOUT)) {
+      return(bigqueue->to_time);
+   }
+   return(-1);
+}
+
+
+void ioqueue_deadline_place(queue, i, entry)
+subqueue *queue;
+int i;
+iodeadline entry;
+{
+   iodeadline *heap = queue->heap;
+   int child;
+
+   while ((i > 0) && (heap[((i-1) / 2)].deadline > entry.deadline)) {
+      heap[i] = heap[((i-1) / 2)];
+      heap[i].buf->heapidx = i;
+      i = (i-1) / 2;
+   }
+   while ((child = (2 * i) + 1) < queue->heaplen) {
+      if (((child + 1) < queue->heaplen) && (heap[(child+1)].deadline < heap[child].deadline)) {
+         child++;
+      }
+      if (heap[child].deadline >= entry.deadline) {
+         break;
+      }
+      heap[i] = heap[child];
+      heap[i].buf->heapidx = i;
+      i = child;
+   }
+   heap[i] = entry;
+   entry.buf->heapidx = i;
+}
+
+
+void ioqueue_deadline_insert(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   iodeadline entry;
+   int limit = ioqueue_timeout_limit(queue);
+
+   buf->heapidx = -1;
+   if (limit < 0) {
+      return;
+   }
+   if (queue->heaplen == queue->heapsize) {
+      queue->heapsize = max(16, (2 * queue->heapsize));
+      queue->heap = (iodeadline *) realloc(queue->heap, (queue->heapsize * sizeof(iodeadline)));
+      ASSERT(queue->heap != NULL);
+   }
+   entry.deadline = buf->iob_un.pend.arrtick + limit + 1;
+   entry.buf = buf;
+   queue->heaplen++;
+   ioqueue_deadline_place(queue, (queue->heaplen - 1), entry);
+}
+
+
+void ioqueue_deadline_remove(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   int i = buf->heapidx;
+
+   if (i < 0) {
+      return;
+   }
+   ASSERT(queue->heap[i].buf == buf);
+   buf->heapidx = -1;
+   queue->heaplen--;
+   if (i < queue->heaplen) {
+      ioqueue_deadline_place(queue, i, queue->heap[queue->heaplen]);
+   }
+}
+
+
+void ioqueue_remove_from_subqueue(queue, tmp)
+subqueue *queue;
+iobuf *tmp;
+{
+   if (queue->sched->remove) {
+      (*queue->sched->remove)(queue, tmp);
+   }
+   ioqueue_hash_remove(queue, tmp);
+   ioqueue_lbn_remove(queue, tmp);
+   ioqueue_deadline_remove(queue, tmp);
+   if (IOQUEUE_ORDERED(queue)) {
+      queue->tree = ioqueue_tree_remove(queue->tree, tmp);
+   }
+   if ((queue->list == tmp) && (tmp == tmp->next)) {
+      queue->list = NULL;
+   } else {
+      tmp->next->prev = tmp->prev;
+      tmp->prev->next = tmp->next;
+      if (queue->list == tmp) {
+         queue->list = tmp->prev;
+      }
+   }
+   tmp->next = NULL;
+   tmp->prev = NULL;
+}
+
+
+/* queue->list not NULL when entered */
+
+void ioqueue_insert_fcfs_to_queue(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   temp->next = queue->list->next;
+   temp->prev = queue->list;
+   temp->next->prev = temp;
+   temp->prev->next = temp;
+   queue->list = temp;
+}
+
+
+/* queue->list not NULL when entered */
+
+void ioqueue_insert_ordered_to_queue(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   iobuf *pred = NULL;
+
+   queue->tree = ioqueue_tree_insert(queue->tree, temp, &pred);
+   if (pred == NULL) {
+      pred = queue->list;
+   } else if (pred == queue->list) {
+      queue->list = temp;
+   }
+   temp->next = pred->next;
+   temp->prev = pred;
+   temp->next->prev = temp;
+   pred->next = temp;
+}
+
+
+/* Puts new, which is not on the list, in old's place on it */
+
+void ioqueue_list_replace(queue, old, new)
+subqueue *queue;
+iobuf *old;
+iobuf *new;
+{
+   if (old->next == old) {
+      new->next = new;
+      new->prev = new;
+   } else {
+      new->next = old->next;
+      new->prev = old->prev;
+      new->next->prev = new;
+      new->prev->next = new;
+   }
+   if (queue->list == old) {
+      queue->list = new;
+   }
+}
+
+
+/* Merges req2 into req1 if it starts where req1 ends and the two may   */
+/* be combined.  They need not be neighbours on the list: in subqueues  */
+/* kept in positional order req1 keeps its place, and otherwise the     */
+/* result takes the place (and timeout) of whichever arrived first.     */
+
+int ioqueue_check_concat(queue, req1, req2, concatmax)
+subqueue *queue;
+iobuf *req1;
+iobuf *req2;
+int concatmax;
+{
+   ioreq_event *tmp;
+   int seqscheme = queue->bigqueue->seqscheme;
+   int (*concatok)() = queue->bigqueue->concatok;
+   void *concatokparam = queue->bigqueue->concatokparam;
+
+   if (req1->flags & READ) {
+      if (!(seqscheme & IOQUEUE_CONCAT_READS) || !(req2->flags & READ)) {
+	 return(0);
+      }
+   } else {
+      if (!(seqscheme & IOQUEUE_CONCAT_WRITES) || (req2->flags & READ)) {
+	 return(0);
+      }
+   }
+   if ((req1 == req2) || !READY_TO_GO(req1) || !READY_TO_GO(req2) || ((req1->blkno + req1->totalsize) != req2->blkno) || ((req1->totalsize + req2->totalsize) > concatmax)) {
+      return(0);
+   }
+   if (concatok) {
+      if (concatok(concatokparam, req1->blkno, req1->totalsize, req2->blkno, req2->totalsize) == 0) {
+	 return(0);
+      }
+   }
+   tmp = req1->iolist;
+   if (tmp == NULL) {
+      req1->iolist = req2->iolist;
+   } else {
+      while (tmp->next) {
+         tmp = tmp->next;
+      }
+      tmp->next = req2->iolist;
+   }
+   if (queue->sched->concat) {
+      (*queue->sched->concat)(queue, req1, req2);
+   } else if (queue->sched->remove) {
+      (*queue->sched->remove)(queue, req2);
+   }
+   ioqueue_hash_concat(queue, req1, req2);
+   ioqueue_lbn_remove(queue, req1);
+   ioqueue_lbn_remove(queue, req2);
+   ioqueue_deadline_remove(queue, req2);
+   if (IOQUEUE_ORDERED(queue)) {
+      queue->tree = ioqueue_tree_remove(queue->tree, req2);
+   }
+   if ((!(IOQUEUE_ORDERED(queue))) && ((int) (req2->treeseq - req1->treeseq) < 0)) {
+      req1->next->prev = req1->prev;
+      req1->prev->next = req1->next;
+      if (queue->list == req1) {
+         queue->list = req1->prev;
+      }
+      ioqueue_list_replace(queue, req2, req1);
+      ioqueue_deadline_remove(queue, req1);
+      req1->iob_un.pend.arrtick = req2->iob_un.pend.arrtick;
+      ioqueue_deadline_insert(queue, req1);
+   } else {
+      req2->next->prev = req2->prev;
+      req2->prev->next = req2->next;
+      if (queue->list == req2) {
+         queue->list = req2->prev;
+      }
+   }
+   req1->reqcnt += req2->reqcnt;
+   req1->totalsize += req2->totalsize;
+   ioqueue_lbn_insert(queue, req1);
+   queue->iobufcnt--;
+   addtoextraq((event *) req2);
+   return(1);
+}
+
+
+/* Merges the new request temp with a waiting request that ends where  */
+/* it starts, and then with one that starts where the result ends,     */
+/* returning the iobuf now holding temp's request.                     */
+
+iobuf * ioqueue_concat_new_request(queue, temp, concatmax)
+subqueue *queue;
+iobuf *temp;
+int concatmax;
+{
+   iolbnent *ent = NULL;
+   lbn_t end;
+
+   while ((ent = ioqueue_lbn_find(queue->lbnindex, temp->blkno, temp->blkno, ent))) {
+      if ((ent->end == temp->blkno) && (ioqueue_check_concat(queue, ent->buf, temp, concatmax))) {
+         temp = ent->buf;
+         break;
+      }
+   }
+   end = temp->blkno + temp->totalsize;
+   ent = NULL;
+   while ((ent = ioqueue_lbn_find(queue->lbnindex, end, end, ent))) {
+      if ((ent->blkno == end) && (ioqueue_check_concat(queue, temp, ent->buf, concatmax))) {
+         break;
+      }
+   }
+   return(temp);
+}
+
+
+void ioqueue_insert_new_request(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   int concatmax;
+
+   ioqueue_update_queue_statistics(queue);
+   queue->iobufcnt++;
+   temp->treeseq = queue->treeseq++;
+   ioqueue_hash_insert(queue, temp);
+   ioqueue_lbn_insert(queue, temp);
+   ioqueue_deadline_insert(queue, temp);
+   if (queue->list == NULL) {
+      queue->list = temp;
+      temp->next = temp;
+      temp->prev = temp;
+      if (IOQUEUE_ORDERED(queue)) {
+         temp->left = NULL;
+         temp->right = NULL;
+         ioqueue_tree_update(temp);
+         queue->tree = temp;
+      }
+   } else {
+      if (IOQUEUE_ORDERED(queue)) {
+         ioqueue_insert_ordered_to_queue(queue, temp);
+      } else {
+         ioqueue_insert_fcfs_to_queue(queue, temp);
+      }
+   }
+   if (queue->sched->insert) {
+      (*queue->sched->insert)(queue, temp);
+   }
+   concatmax = queue->bigqueue->concatmax;
+   if (concatmax) {
+      temp = ioqueue_concat_new_request(queue, temp, concatmax);
+   }
+   queue->listlen++;
+   if (temp->flags & READ) {
+      queue->readlen++;
+      queue->numreads++;
+   } else {
+      queue->numwrites++;
+   }
+   ioqueue_update_queue_maxima(queue);
+}
+
+
+/* Returns 0 if request is sequential from a previous request (and detection */
+/* enabled).  Otherwise returns 1.				             */
+/* Assuming no command queueing.					     */
+
+int ioqueue_seqstream_head(queue, listhead, current)
+ioqueue *queue;
+iobuf *listhead;
+iobuf *current;
+{
+   int idiff;
+   int ret = 0;
+
+   if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_READS|IOQUEUE_SEQSTREAM_WRITES|IOQUEUE_SEQSTREAM_EITHER))) {
+      return(1);
+   }
+   idiff = queue->seqstreamdiff;
+   if ((current == listhead) || !READY_TO_GO(current->prev)) {
+      ret = 1;
+   }
+   if (ret == 0) {
+      if (current->flags & READ) {
+         if (current->prev->flags & READ) {
+	    if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_READS|IOQUEUE_SEQSTREAM_EITHER))) {
+	       ret = 1;
+	    }
+         } else {
+	    if (!(queue->seqscheme & IOQUEUE_SEQSTREAM_EITHER)) {
+	       ret = 1;
+	    }
+         }
+	 if ((current->prev->blkno != current->blkno) && (((current->prev->blkno + current->prev->totalsize + idiff) < current->blkno))) {
+	    ret = 1;
+	 }
+      } else {
+         if (current->prev->flags & READ) {
+	    if (!(queue->seqscheme & IOQUEUE_SEQSTREAM_EITHER)) {
+	       ret = 1;
+	    }
+         } else {
+	    if (!(queue->seqscheme & (IOQUEUE_SEQSTREAM_WRITES|IOQUEUE_SEQSTREAM_EITHER))) {
+	       ret = 1;
+	    }
+         }
+	 if ((current->prev->blkno != current->blkno) && ((current->prev->blkno + current->prev->totalsize) != current->blkno)) {
+	    ret = 1;
+	 }
+      }
+   }
+   return(ret);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+iobuf * ioqueue_get_request_from_fcfs_queue(queue)
+subqueue *queue;
+{
+   iobuf *tmp;
+   int i;
+
+   tmp = queue->list->next;
+   for (i = 0; i < queue->iobufcnt; i++) {
+      if (force_absolute_fcfs) {
+         if (tmp->state == WAITING) {
+            if (READY_TO_GO(tmp)) {
+               return(tmp);
+            } else {
+               return(NULL);
+            }
+         }
+      } else {
+         if (READY_TO_GO(tmp)) {
+            return(tmp);
+         }
+      }
+      tmp = tmp->next;
+   }
+   return(NULL);
+}
+
+
+/* Queue contains >= 2 items when called */
 
 int ioqueue_get_priority_level(req)
 iobuf *req;
 {
-   int ret = 0;
+   int ret = 0;
+
+   if (priority_mix == 1) {
+      if ((req->flags & TIME_CRITICAL) || (req->flags & READ)) {
+	 ret = 1;
+      }
+   } else if (priority_mix == 2) {
+      if (req->flags & TIME_CRITICAL) {
+	 ret = 2;
+      } else if (req->flags & READ) {
+	 ret = 1;
+      }
+   } else if (priority_mix == 3) {
+      if (req->flags & READ) {
+	 ret = 2;
+      } else if (req->flags & TIME_CRITICAL) {
+	 ret = 1;
+      }
+   } else if (priority_mix == 4) {
+      if (req->flags & TIME_CRITICAL) {
+	 ret = (req->flags & READ) ? 2 : 3;
+      } else {
+	 ret = (req->flags & READ) ? 1 : 0;
+      }
+   } else if (priority_mix == 5) {
+      if (req->flags & READ) {
+	 ret = 1;
+      }
+   } else if (priority_mix == 6) {
+      if (req->flags & TIME_CRITICAL) {
+	 ret = 1;
+      }
+   }
+   return(ret);
+}
+
+
+iobuf * ioqueue_get_request_from_pri_lbn_vscan_queue(queue, numlbns, vscan_value)
+subqueue *queue;
+lbn_t numlbns;
+lbn_t vscan_value;
+{
+   int schedalg;
+   int priority_factor;
+   int age_factor;
+   lbn_t curr_effpri, best_effpri;
+   iobuf *tmp;
+   iobuf *ret = NULL;
+   int i;
+
+   schedalg = queue->bigqueue->timeout.sched_alg;
+   priority_factor = queue->bigqueue->priority.sched_alg;
+   age_factor = queue->bigqueue->to_time;
+   if (schedalg == ELEVATOR_LBN) {
+      vscan_value = numlbns;
+   } else if (schedalg == SSTF_LBN) {
+      vscan_value = 0;
+   }
+   tmp = queue->list->next;
+   for (i = 0; i < queue->iobufcnt; i++) {
+      if (READY_TO_GO(tmp)) {
+	 curr_effpri = tmp->blkno - queue->lastblkno;
+	 if (schedalg == CYCLE_LBN) {
+	    if (curr_effpri < 0) {
+	       curr_effpri += numlbns;
+	    }
+	 } else if (curr_effpri) {
+	    if (curr_effpri < 0) {
+	       curr_effpri = -curr_effpri;
+	       if (queue->dir == ASC) {
+		  curr_effpri += vscan_value;
+	       }
+	    } else {
+	       if (queue->dir == DESC) {
+		  curr_effpri += vscan_value;
+	       }
+	    }
+	 }
+	 curr_effpri = numlbns - curr_effpri;
+	 curr_effpri += (priority_factor * numlbns * ioqueue_get_priority_level(tmp)) / 100;
+	 curr_effpri += (age_factor * (int) (simtime - tmp->starttime)) / 1280;
+	 if ((ret == NULL) || (curr_effpri > best_effpri)) {
+	    ret = tmp;
+	    best_effpri = curr_effpri;
+	 }
+      }
+      tmp = tmp->next;
+   }
+   return(ret);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+iobuf * ioqueue_get_request_from_lbn_scan_queue(queue)
+subqueue *queue;
+{
+   iobuf *temp;
+   iobuf *stop;
+
+   temp = queue->list->next;
+   stop = temp;
+   if (queue->lastblkno > temp->blkno) {
+      temp = ioqueue_tree_find_blkno(queue->tree, queue->lastblkno, stop);
+      if (temp == NULL) {
+         temp = stop;
+      }
+   }
+   stop = temp;
+   while ((temp->next != stop) && !READY_TO_GO(temp)) {
+      temp = temp->next;
+   }
+   if ((temp->next == stop) && !READY_TO_GO(temp)) {
+      temp = NULL;
+   }
+   return(temp);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+iobuf * ioqueue_get_request_from_lbn_vscan_queue(queue, value)
+subqueue *queue;
+lbn_t value;
+{
+   iobuf *temp;
+   iobuf *head;
+   iobuf *top = NULL;
+   iobuf *bottom = NULL;
+   lbn_t diff1, diff2;
+   int tmpdir;
+   iobuf *bestbottom;
+
+   tmpdir = queue->dir;
+   temp = queue->list->next;
+   head = queue->list->next;
+
+   temp = ioqueue_tree_find_blkno(queue->tree, queue->lastblkno, head);
+   temp = (temp) ? temp->prev : queue->list;
+   if (temp->blkno < queue->lastblkno) {
+      bottom = temp;
+      while ((bottom != head) && !READY_TO_GO(bottom)) {
+         bottom = bottom->prev;
+      }
+      if ((bottom == head) && !READY_TO_GO(bottom)) {
+	 bottom = NULL;
+      } else {
+         bestbottom = bottom;
+         while ((bottom != head) && ((bottom->prev->blkno == bestbottom->blkno) || (!(ioqueue_seqstream_head(queue->bigqueue, head, bottom))))) {
+	    bottom = bottom->prev;
+	    bestbottom = (READY_TO_GO(bottom)) ? bottom : bestbottom;
+         }
+         bottom = bestbottom;
+      }
+   }
+   if (temp->next != head) {
+      if (temp->blkno >= queue->lastblkno) {
+	 top = temp;
+      } else {
+         top = temp->next;
+      }
+      while ((top->next != head) && !READY_TO_GO(top)) {
+         top = top->next;
+      }
+   }
+   if ((top == NULL) || !READY_TO_GO(top) || (!(ioqueue_seqstream_head(queue->bigqueue, head, top)))) {
+      temp = bottom;
+   } else if ((bottom == NULL) || !READY_TO_GO(bottom)) {
+      temp = top;
+   } else {
+      diff1 = diff(top->blkno, queue->lastblkno);
+      diff2 = diff(queue->lastblkno, bottom->blkno);
+      if (queue->dir == ASC) {
+	 diff2 = (diff2) ? (diff2 + value) : diff2;
+      } else {
+	 diff1 = (diff1) ? (diff1 + value) : diff1;
+      }
+      if (diff1 < diff2) {
+         temp = top;
+      } else if ((diff1 > diff2) || (queue->sstfupdown)) {
+         temp = bottom;
+      } else {
+	 temp = top;
+      }
+      if (diff1 == diff2) {
+	 queue->sstfupdown = (queue->sstfupdown) ? 0 : 1;
+	 queue->sstfupdowncnt++;
+      }
+   }
+   if (temp->blkno != queue->lastblkno) {
+      queue->dir = (temp->blkno > queue->lastblkno) ? ASC : DESC;
+   }
+   top = (temp == top) ? bottom : top;
+   if ((top) && READY_TO_GO(top)) {
+      int cylno1, cylno2;
+      int surface1, surface2;
+
+      ioqueue_get_cylinder_mapping(queue->bigqueue, temp, temp->blkno, &cylno1, &surface1, MAP_FULL);
+      ioqueue_get_cylinder_mapping(queue->bigqueue, top, top->blkno, &cylno2, &surface2, MAP_FULL);
+      diff1 = abs(cylno1 - queue->optcylno);
+      diff2 = abs(cylno2 - queue->optcylno);
+      if (((tmpdir == ASC) && (temp != bottom)) || ((tmpdir == DESC) && (temp == bottom))) {
+	 if (diff2) {
+	    diff2 += (int) (vscan_value * (double) disk_get_numcyls(temp->iolist->devno));
+	 }
+      } else if (diff1) {
+	 if (diff1) {
+	    diff1 += (int) (vscan_value * (double) disk_get_numcyls(temp->iolist->devno));
+	 }
+      }
+      if (diff1 > diff2) {
+         stat_update(&queue->infopenalty, (double) (diff1 - diff2));
+/*
+fprintf (outputfile, "diff1 %d, diff2 %d, diffdiff %d\n", diff1, diff2, (diff1 - diff2));
+*/
+      } else if ((diff1 == diff2) && (diff1 == 0)) {
+         if ((queue->optsurface == surface2) && (surface1 != surface2)) {
+            stat_update(&queue->infopenalty, (double) 0);
+         }
+      }
+   }
+   return(temp);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+/* Returns pointer to "best" request on queue->lastcylno, or first request
+   on next available forward cylinder, or head (in priority order). */
+
+iobuf *ioqueue_identify_request_on_cylinder(queue)
+subqueue *queue;
+{
+   iobuf *temp;
+   iobuf *head;
+   iobuf *cylstop;
+   iobuf *surfstop;
+
+   int lastcylno;
+   int lastsurface;
+   lbn_t lastblkno;
+
+   lastcylno = queue->lastcylno;
+   lastsurface = queue->lastsurface;
+   lastblkno = queue->lastblkno;
+
+   head = queue->list->next;
+   temp = ioqueue_tree_find_track(queue->tree, lastcylno, 0);
+   if (temp == NULL) {
+      temp = head;
+   }
+
+   if (temp->cylinder != lastcylno) {
+      return(temp);
+   }
+
+   cylstop = temp;      /* first req on cylinder */
+
+   temp = ioqueue_tree_find_track(queue->tree, lastcylno, lastsurface);
+   if ((temp == NULL) || (temp->cylinder != lastcylno)) {
+      temp = ((temp) ? temp : head)->prev;     /* last req on cylinder */
+   }
+
+   if (lastsurface > temp->surface) {
+      temp = cylstop;   /* drop out and try from first req on cylinder */
+
+   } else if (!queue->surfoverforw) {
+      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && (!READY_TO_GO(temp) || (temp->blkno < lastblkno))) {
+         temp = temp->next;
+      }
+      if (READY_TO_GO(temp) && (temp->blkno >= lastblkno)) {
+        return(temp);
+      } else {
+         temp = cylstop;   /* drop out and try from first req on cylinder */
+      }
+
+   } else {    /* surfoverforw */
+
+      surfstop = temp;     /* first req on surface */
+
+      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && (lastsurface == temp->next->surface) && (!READY_TO_GO(temp) || (temp->blkno < lastblkno))) {
+         temp = temp->next;
+      }
+      if (READY_TO_GO(temp) && (temp->blkno >= lastblkno) && (temp->surface == lastsurface)) {
+         return(temp);
+      }
+
+      temp = surfstop;
+
+      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && !READY_TO_GO(temp)) {
+         temp = temp->next;
+      }
+      if (READY_TO_GO(temp)) {
+         return(temp);
+      }
+
+      temp = cylstop;   /* drop out and try from first req on cylinder */
+   }
+
+   /* drop out recovery point */
+
+   if (!READY_TO_GO(temp)) {
+      while (!READY_TO_GO(temp) && (temp->next != head) && (temp->next->cylinder == lastcylno)) {
+         temp = temp->next;
+      }
+      temp = temp->next;
+   }
+   return(temp);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+iobuf * ioqueue_get_request_from_cyl_scan_queue(queue)
+subqueue *queue;
+{
+   iobuf *temp;
+   iobuf *stop;
+
+   temp = queue->list->next;
+   if (queue->lastcylno >= temp->cylinder) {
+      temp = ioqueue_identify_request_on_cylinder(queue);
+   }
+   stop = temp;
+   while (!READY_TO_GO(temp) && (temp->next != stop)) {
+      temp = temp->next;
+   }
+   if ((temp->next == stop) && !READY_TO_GO(temp)) {
+      temp = NULL;
+   }
+   return(temp);
+}
+
+
+/* Queue contains >= 2 items when called */
+
+iobuf * ioqueue_get_request_from_cyl_vscan_queue(queue, value)
+subqueue *queue;
+int value;
+{
+   iobuf *temp;
+   iobuf *head;
+   iobuf *top = NULL;
+   iobuf *bottom = NULL;
+   iobuf *bottom2 = NULL;
+   iobuf *bestone;
+   int diff1, diff2, diff3;
+   int tmpdir;
+   int cylno1, cylno2, cylno3;
+   int surface1, surface2, surface3;
+
+   tmpdir = queue->dir;
+   temp = queue->list->next;
+   head = queue->list->next;
+
+   bestone = ioqueue_identify_request_on_cylinder(queue);
+   if (!READY_TO_GO(bestone) || (bestone->cylinder != queue->lastcylno)) {
+      bestone = NULL;
+   }
+   temp = ioqueue_tree_find_blkno(queue->tree, queue->lastblkno, head);
+   temp = (temp) ? temp->prev : queue->list;
+   if (temp->blkno < queue->lastblkno) {
+      bottom = temp;
+      while ((bottom != head) && !READY_TO_GO(bottom)) {
+         bottom = bottom->prev;
+      }
+      bottom2 = temp;
+      if (READY_TO_GO(bottom) && (!bestone)) {
+         while ((bottom != head) && (bottom->prev->cylinder == bottom->cylinder)) {
+	    bottom = bottom->prev;
+         }
+         while ((bottom != temp) && !READY_TO_GO(bottom)) {
+	    bottom = bottom->next;
+         }
+      }
+   }
+   if (temp->next != head) {
+      top = (temp->blkno >= queue->lastblkno) ? temp : temp->next;
+      while ((top->next != head) && !READY_TO_GO(top)) {
+         top = top->next;
+      }
+   }
+   if (!bestone) {
+      if ((top == NULL) || !READY_TO_GO(top)) {
+         temp = bottom;
+      } else if ((bottom == NULL) || !READY_TO_GO(bottom)) {
+         temp = top;
+      } else {
+         diff1 = diff(top->cylinder, queue->lastcylno);
+         diff2 = diff(queue->lastcylno, bottom->cylinder);
+         if (queue->dir == ASC) {
+	    diff2 += value;
+         } else {
+	    diff1 += value;
+         }
+         if (diff1 < diff2) {
+	    temp = top;
+         } else if ((diff1 > diff2) || (queue->sstfupdown)) {
+            temp = bottom;
+         } else {
+	    temp = top;
+         }
+         if (diff1 == diff2) {
+	    queue->sstfupdown = (queue->sstfupdown) ? 0 : 1;
+	    queue->sstfupdowncnt++;
+         }
+      }
+   } else {
+      temp = bestone;
+   }
+   if (temp->cylinder != queue->lastcylno) {
+      queue->dir = (temp->cylinder > queue->lastcylno) ? ASC : DESC;
+   }
+   ioqueue_get_cylinder_mapping(queue->bigqueue, temp, temp->blkno, &cylno1, &surface1, MAP_FULL);
+   diff1 = abs(cylno1 - queue->optcylno);
+   if ((top == NULL) || !READY_TO_GO(top)) {
+      top = temp;
+   }
+   ioqueue_get_cylinder_mapping(queue->bigqueue, top, top->blkno, &cylno2, &surface2, MAP_FULL);
+   diff2 = abs(cylno2 - queue->optcylno);
+   if ((bottom2 == NULL) || !READY_TO_GO(bottom2)) {
+      bottom2 = temp;
+   }
+   ioqueue_get_cylinder_mapping(queue->bigqueue, bottom2, bottom2->blkno, &cylno3, &surface3, MAP_FULL);
+   diff3 = abs(cylno3 - queue->optcylno);
+   if (tmpdir == ASC) {
+      diff3 = (diff3) ? (diff3 + value) : diff3;
+      diff1 = (temp->cylinder < queue->lastcylno) ? (diff1 + value) : diff1;
+   } else {
+      diff2 = (diff2) ? (diff2 + value) : diff2;
+      diff1 = (temp->cylinder > queue->lastcylno) ? (diff1 + value) : diff1;
+   }
+   if ((diff3 < diff2) || ((!diff3) && (surface3 == queue->optsurface))) {
+      surface2 = surface3;
+      diff2 = diff3;
+   }
+   if (diff1 > diff2) {
+      stat_update(&queue->infopenalty, (double) (diff1 - diff2));
+/*
+fprintf (outputfile, "diff1 %d, diff2 %d, diffdiff %d, value %d\n", diff1, diff2, (diff1 - diff2), value);
+*/
+   } else if ((diff1 == diff2) && (diff1 == 0)) {
+      if ((queue->optsurface == surface2) && (surface1 != surface2)) {
+         stat_update(&queue->infopenalty, (double) 0);
+      }
+   }
+   return(temp);
+}
+
+
+/* Returns queue's SPTF scratch space, grown if need be to hold count   */
+/* candidates.                                                           */
+
+sptfscratch * ioqueue_sptf_reserve(queue, count)
+ioqueue *queue;
+int count;
+{
+   sptfscratch *scratch = queue->sptf;
+
+   if (scratch == NULL) {
+      scratch = (sptfscratch *) malloc(sizeof(sptfscratch));
+      ASSERT(scratch != NULL);
+      scratch->reqs.size = 0;
+      queue->sptf = scratch;
+   }
+   if (count > scratch->reqs.size) {
+      if (scratch->reqs.size) {
+	 free(scratch->reqs.blknos);
+	 free(scratch->reqs.bcounts);
+	 free(scratch->reqs.flags);
+	 free(scratch->reqs.times);
+	 free(scratch->reqs.seektimes);
+	 free(scratch->reqs.servtimes);
+	 free(scratch->reqs.bounds);
+	 free(scratch->reqs.entries);
+	 free(scratch->bufs);
+	 free(scratch->delays);
+	 free(scratch->ages);
+	 free(scratch->order);
+      }
+      scratch->reqs.size = max(count, (2 * scratch->reqs.size));
+      scratch->reqs.blknos = (lbn_t *) malloc(scratch->reqs.size * sizeof(lbn_t));
+      scratch->reqs.bcounts = (int *) malloc(scratch->reqs.size * sizeof(int));
+      scratch->reqs.flags = (int *) malloc(scratch->reqs.size * sizeof(int));
+      scratch->reqs.times = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->reqs.seektimes = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->reqs.servtimes = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->reqs.bounds = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->reqs.entries = (int *) malloc(scratch->reqs.size * sizeof(int));
+      scratch->bufs = (iobuf **) malloc(scratch->reqs.size * sizeof(iobuf *));
+      scratch->delays = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->ages = (double *) malloc(scratch->reqs.size * sizeof(double));
+      scratch->order = (sptfcand *) malloc(scratch->reqs.size * sizeof(sptfcand));
+      ASSERT((scratch->reqs.blknos != NULL) && (scratch->reqs.bcounts != NULL) && (scratch->reqs.flags != NULL) && (scratch->reqs.times != NULL) && (scratch->reqs.seektimes != NULL) && (scratch->reqs.servtimes != NULL) && (scratch->reqs.bounds != NULL) && (scratch->reqs.entries != NULL) && (scratch->bufs != NULL) && (scratch->delays != NULL) && (scratch->ages != NULL) && (scratch->order != NULL));
+   }
+   scratch->reqs.count = 0;
+   return(scratch);
+}
+
+
+int ioqueue_sptf_compare(a, b)
+const void *a;
+const void *b;
+{
+   sptfcand *cand1 = (sptfcand *) a;
+   sptfcand *cand2 = (sptfcand *) b;
+
+   if (cand1->bound != cand2->bound) {
+      return((cand1->bound < cand2->bound) ? -1 : 1);
+   }
+   return(cand1->index - cand2->index);
+}
+
+
+/* Picks the request with the smallest delay plus service time estimate */
+/* (ties going to the earliest in the queue, as with a scan in queue    */
+/* order) without estimating them all.  The candidates are visited in   */
+/* order of a lower bound on their totals, the delay plus the shortest  */
+/* seek to their cylinder, and the visit stops at the first bound that  */
+/* exceeds the best total found so far.                                 */
+
+iobuf *ioqueue_get_request_from_sptf_candidates(scratch, checkcache)
+sptfscratch *scratch;
+int checkcache;
+{
+   servbatch *reqs = &scratch->reqs;
+   int best = -1;
+   double mintime = 100000.0;
+   double delay;
+   int i, k;
+
+   disk_bound_servtime_batch(reqs->devno, reqs, checkcache);
+   for (i=0; i<reqs->count; i++) {
+      scratch->order[i].bound = scratch->delays[i] + reqs->bounds[i];
+      scratch->order[i].index = i;
+   }
+   qsort(scratch->order, reqs->count, sizeof(sptfcand), ioqueue_sptf_compare);
+   for (k=0; k<reqs->count; k++) {
+      if (scratch->order[k].bound > mintime) {
+	 break;
+      }
+      i = scratch->order[k].index;
+      delay = scratch->delays[i];
+      if (delay <= mintime) {
+	 delay += disk_get_servtime_batch_entry(reqs->devno, reqs, i);
+	 if ((delay < mintime) || ((delay == mintime) && (i < best))) {
+	    best = i;
+	    mintime = delay;
+	 }
+      }
+   }
+   return((best >= 0) ? scratch->bufs[best] : NULL);
+}
+
+
+/* Gathers the ready candidates of queue (which contains >= 2 items)   */
+/* into the queue's SPTF scratch space, with their delays (the age     */
+/* weighting of the ASPTF variants included) and ages, and returns the */
+/* scratch space.                                                      */
+
+sptfscratch * ioqueue_sptf_gather(queue, ageweight)
+subqueue *queue;
+int ageweight;
+{
+   int i;
+   int count;
+   iobuf *temp;
+   sptfscratch *scratch;
+   servbatch *reqs;
+   double readdelay;
+   double writedelay;
+   double delay;
+   double age = 0.0;
+   double weight;
+   ioreq_event *tmp;
+
+   readdelay = queue->bigqueue->readdelay;
+   writedelay = queue->bigqueue->writedelay;
+   weight = (double) queue->bigqueue->to_time;
+   scratch = ioqueue_sptf_reserve(queue->bigqueue, queue->listlen);
+   reqs = &scratch->reqs;
+   count = 0;
+   temp = queue->list->next;
+   for (i=0; i<queue->listlen; i++) {
+      if (READY_TO_GO(temp) && (ioqueue_seqstream_head(queue->bigqueue, queue->list->next, temp))) {
+	 if (count == 0) {
+	    reqs->devno = temp->iolist->devno;
+	 }
+	 ASSERT(temp->iolist->devno == reqs->devno);
+	 scratch->bufs[count] = temp;
+	 reqs->blknos[count] = temp->blkno;
+	 reqs->bcounts[count] = temp->totalsize;
+	 reqs->flags[count] = temp->flags;
+	 delay = (temp->flags & READ) ? readdelay : writedelay;
+	 reqs->times[count] = simtime + delay;
+	 if (ageweight) {
+	    tmp = temp->iolist;
+	    age = tmp->time;
+	    while (tmp) {
+	       if (tmp->time < age) {
+		  age = tmp->time;
+	       }
+	       tmp = tmp->next;
+	    }
+	    age = simtime - age;
+	 }
+	 if ((ageweight == 2) || 
+	     ((ageweight == 3) && 
+	      (temp->flags & (TIME_CRITICAL | TIME_LIMITED)))) {
+	    delay -= age * weight * (double) 0.001;
+         }
+	 scratch->delays[count] = delay;
+	 scratch->ages[count] = age;
+	 count++;
+      }
+      temp = temp->next;
+   }
+   reqs->count = count;
+   return(scratch);
+}
+
+
+/* Queue contains >= 2 items when called.  The ready candidates are     */
+/* gathered first.  Except for the WPTF variants (whose age weighting   */
+/* does not give a usable bound), the positioning-time variants then    */
+/* leave the choice to ioqueue_get_request_from_sptf_candidates.  The   */
+/* WPTF variants get all their estimates from the disk in one batch,    */
+/* and the selection proceeds exactly as if each estimate had been      */
+/* requested in turn with the running minimum as the cutoff (an         */
+/* estimate whose seek alone is past the cutoff counts as just beyond   */
+/* it).                                                                 */
+
+iobuf *ioqueue_get_request_from_opt_sptf_queue(queue, checkcache, ageweight, posonly)
+subqueue *queue;
+int checkcache;
+int ageweight;
+int posonly;
+{
+   int i;
+   int count;
+   iobuf *best = NULL;
+   ioreq_event *test = NULL;
+   sptfscratch *scratch;
+   servbatch *reqs;
+   double mintime = 100000.0;
+   double delay;
+   double servtime;
+   double weight;
+
+   ASSERT((ageweight >= 0) && (ageweight <= 3));
+   weight = (double) queue->bigqueue->to_time;
+   scratch = ioqueue_sptf_gather(queue, ageweight);
+   reqs = &scratch->reqs;
+   count = reqs->count;
+   if (count == 0) {
+      return(NULL);
+   }
+   if ((posonly) && (ageweight != 1)) {
+      return(ioqueue_get_request_from_sptf_candidates(scratch, checkcache));
+   } else if (posonly) {
+      disk_get_servtime_batch(reqs->devno, reqs, checkcache);
+   } else {
+      test = (ioreq_event *) getfromextraq();
+      test->devno = reqs->devno;
+   }
+   for (i=0; i<count; i++) {
+      delay = scratch->delays[i];
+      if (delay < mintime) {
+	 if (posonly) {
+	    servtime = (reqs->seektimes[i] < (mintime - delay)) ? reqs->servtimes[i] : ((mintime - delay) + 1.0);
+	 } else {
+	    test->blkno = reqs->blknos[i];
+	    test->bcount = reqs->bcounts[i];
+	    test->flags = reqs->flags[i];
+	    test->time = reqs->times[i];
+	    servtime = disk_get_acctime(test->devno, test, (mintime - delay));
+	 }
+	 delay += servtime;
+	 if (ageweight == 1) {
+	    delay *= (weight - scratch->ages[i]) / weight;
+	 }
+	 if (delay < mintime) {
+	    best = scratch->bufs[i];
+	    mintime = delay;
+	 }
+      }
+   }
+   if (test) {
+      addtoextraq((event *) test);
+   }
+/*
+fprintf (outputfile, "Selected request: %f, cylno %d, blkno %d, read %d, devno %d\n", mintime, best->cylinder, best->blkno, (best->flags & READ), best->iolist->devno);
+*/
+   return(best);
+}
+
+
+/* The built-in policies, as seen through iosched */
+
+iobuf * ioqueue_peek_pri_vscan_lbn(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_pri_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno), (lbn_t) queue->vscan_cyls));
+}
 
-   if (priority_mix == 1) {
-      if ((req->flags & TIME_CRITICAL) || (req->flags & READ)) {
-	 ret = 1;
+
+iobuf * ioqueue_peek_elevator_lbn(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno)));
+}
+
+
+iobuf * ioqueue_peek_sstf_lbn(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_lbn_vscan_queue(queue, (lbn_t) 0));
+}
+
+
+iobuf * ioqueue_peek_vscan_lbn(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_lbn_vscan_queue(queue, (lbn_t) queue->vscan_cyls));
+}
+
+
+iobuf * ioqueue_peek_elevator_cyl(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_cyl_vscan_queue(queue, disk_get_numcyls(queue->list->iolist->devno)));
+}
+
+
+iobuf * ioqueue_peek_sstf_cyl(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_cyl_vscan_queue(queue, 0));
+}
+
+
+iobuf * ioqueue_peek_vscan_cyl(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_cyl_vscan_queue(queue, queue->vscan_cyls));
+}
+
+
+iobuf * ioqueue_peek_sptf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 0, TRUE));
+}
+
+
+iobuf * ioqueue_peek_spctf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 0, TRUE));
+}
+
+
+iobuf * ioqueue_peek_satf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, 0, 0, FALSE));
+}
+
+
+iobuf * ioqueue_peek_wptf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 1, TRUE));
+}
+
+
+iobuf * ioqueue_peek_wpctf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 1, TRUE));
+}
+
+
+iobuf * ioqueue_peek_watf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, 0, 1, FALSE));
+}
+
+
+iobuf * ioqueue_peek_asptf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 2, TRUE));
+}
+
+
+iobuf * ioqueue_peek_aspctf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 2, TRUE));
+}
+
+
+iobuf * ioqueue_peek_asatf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, 0, 2, FALSE));
+}
+
+
+iobuf * ioqueue_peek_pri_asptf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 3, TRUE));
+}
+
+
+iobuf * ioqueue_peek_pri_aspctf(queue)
+subqueue *queue;
+{
+   return(ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 3, TRUE));
+}
+
+
+/* Where the built-in policies consider the last request to have left */
+/* the head: its first block, the block after it, or its last block.   */
+
+void ioqueue_pop_first(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   queue->lastblkno = temp->blkno;
+}
+
+
+void ioqueue_pop_last(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   queue->lastblkno = temp->blkno + temp->totalsize - 1;
+}
+
+
+void ioqueue_pop_after(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   queue->lastblkno = temp->blkno + temp->totalsize;
+   if (queue->lastblkno == disk_get_number_of_blocks(temp->iolist->devno)) {
+      queue->lastblkno--;
+   }
+}
+
+
+void ioqueue_pop_vscan_lbn(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   if (queue->vscan_cyls > 0) {
+      ioqueue_pop_first(queue, temp);
+   } else {
+      ioqueue_pop_after(queue, temp);
+   }
+}
+
+
+void ioqueue_pop_vscan_cyl(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   if (queue->vscan_cyls > 0) {
+      ioqueue_pop_first(queue, temp);
+   } else {
+      ioqueue_pop_last(queue, temp);
+   }
+}
+
+
+void ioqueue_vscan_lbn_initialize(queue, devno)
+subqueue *queue;
+int devno;
+{
+   queue->vscan_cyls = vscan_value * (double) disk_get_number_of_blocks(devno);
+}
+
+
+/* Bounded-lookahead SPTF.  Rather than the request with the smallest  */
+/* delay plus positioning time, picks the first request of the sequence */
+/* of lookahead_depth requests with the smallest total, each positioned */
+/* from where the one before it leaves the head (see                    */
+/* disk_get_servtime_from).  The sequences are built by a beam search:  */
+/* only the lookahead_beam cheapest at each length are extended, so a   */
+/* decision costs at most (1 + (lookahead_depth - 1) * lookahead_beam)  */
+/* estimates per candidate.  At a depth of 1 the choice is SPTF's.      */
+/* Buffer contents are not considered, as with plain SPTF.  Between the */
+/* end of one media access and the start of the next come the rest of  */
+/* the first request's handling and the dispatch of the second (the    */
+/* read data going out, for one).  That turnaround is taken to be what  */
+/* it was the last time a request of the same direction and size went  */
+/* straight from one choice to the next (or, failing that, any request */
+/* of the same direction).                                             */
+
+#define LOOKAHEAD_MAXDEPTH	8
+#define LOOKAHEAD_SIZES		256
+
+typedef struct {
+   double	cost;
+   int		path[LOOKAHEAD_MAXDEPTH];	/* candidate indices */
+   diskhead	head;		/* where the last request leaves the head */
+   double	firstend;	/* when the first one's media access ends */
+} lanode;
+
+typedef struct {
+   lanode *	beam;
+   lanode *	next;
+   iobuf *	choice;		/* what the last peek picked */
+   iobuf *	greedy;		/* and what SPTF would have */
+   double	choiceend;
+   double	lastend;	/* of the last choice dispatched, or -1 */
+   int		lastread;
+   int		lastsize;
+   double	turnaround[2][(LOOKAHEAD_SIZES+1)];	/* -1 if unknown */
+   int		decisions;
+   int		overrides;
+} lasched;
+
+#define LASCHED(queue)		((lasched *) (queue)->schedpriv)
+
+
+void ioqueue_lookahead_initialize(queue, devno)
+subqueue *queue;
+int devno;
+{
+   lasched *priv = (lasched *) malloc(sizeof(lasched));
+   int i;
+   ASSERT(priv != NULL);
+
+   bzero((char *) priv, sizeof(lasched));
+   priv->beam = (lanode *) malloc(lookahead_beam * sizeof(lanode));
+   priv->next = (lanode *) malloc(lookahead_beam * sizeof(lanode));
+   ASSERT((priv->beam != NULL) && (priv->next != NULL));
+   for (i=0; i<=LOOKAHEAD_SIZES; i++) {
+      priv->turnaround[0][i] = -1.0;
+      priv->turnaround[1][i] = -1.0;
+   }
+   priv->lastend = -1.0;
+   queue->schedpriv = priv;
+}
+
+
+/* Makes room for a sequence costing cost among the *lenptr (at most    */
+/* lookahead_beam) kept in nodes in ascending order of cost, after any  */
+/* of equal cost, and returns its slot, or NULL if it does not make it. */
+
+lanode * ioqueue_lookahead_slot(nodes, lenptr, cost)
+lanode *nodes;
+int *lenptr;
+double cost;
+{
+   int i = *lenptr;
+
+   if (i == lookahead_beam) {
+      if (cost >= nodes[(i-1)].cost) {
+         return(NULL);
       }
-   } else if (priority_mix == 2) {
-      if (req->flags & TIME_CRITICAL) {
-	 ret = 2;
-      } else if (req->flags & READ) {
-	 ret = 1;
+      i--;
+   } else {
+      (*lenptr)++;
+   }
+   while ((i > 0) && (cost < nodes[(i-1)].cost)) {
+      nodes[i] = nodes[(i-1)];
+      i--;
+   }
+   return(&nodes[i]);
+}
+
+
+/* Returns the turnaround expected after a request of flags and bcount. */
+
+double ioqueue_lookahead_turnaround(priv, flags, bcount)
+lasched *priv;
+int flags;
+int bcount;
+{
+   double *turnaround = priv->turnaround[((flags & READ) ? 1 : 0)];
+
+   if ((bcount < LOOKAHEAD_SIZES) && (turnaround[bcount] >= 0.0)) {
+      return(turnaround[bcount]);
+   }
+   return(max(0.0, turnaround[LOOKAHEAD_SIZES]));
+}
+
+
+iobuf * ioqueue_peek_lookahead(queue)
+subqueue *queue;
+{
+   lasched *priv = LASCHED(queue);
+   lanode *beam = priv->beam;
+   lanode *next = priv->next;
+   lanode *node;
+   lanode *slot;
+   sptfscratch *scratch;
+   servbatch *reqs;
+   diskhead head;
+   diskhead endhead;
+   int beamlen = 0;
+   int nextlen;
+   int depth;
+   int i, j, k;
+   double cost;
+   double start;
+
+   if ((priv->lastend >= 0.0) && (queue->reqoutstanding == 0)) {
+      priv->turnaround[priv->lastread][LOOKAHEAD_SIZES] = simtime - priv->lastend;
+      if (priv->lastsize < LOOKAHEAD_SIZES) {
+         priv->turnaround[priv->lastread][priv->lastsize] = simtime - priv->lastend;
       }
-   } else if (priority_mix == 3) {
-      if (req->flags & READ) {
-	 ret = 2;
-      } else if (req->flags & TIME_CRITICAL) {
-	 ret = 1;
+   }
+   priv->lastend = -1.0;
+   scratch = ioqueue_sptf_gather(queue, 0);
+   reqs = &scratch->reqs;
+   if (reqs->count == 0) {
+      return(NULL);
+   }
+   disk_get_servtime_batch(reqs->devno, reqs, FALSE);
+   for (i=0; i<reqs->count; i++) {
+      if ((slot = ioqueue_lookahead_slot(beam, &beamlen, (scratch->delays[i] + reqs->servtimes[i])))) {
+         slot->cost = scratch->delays[i] + reqs->servtimes[i];
+         slot->path[0] = i;
       }
-   } else if (priority_mix == 4) {
-      if (req->flags & TIME_CRITICAL) {
-	 ret = (req->flags & READ) ? 2 : 3;
-      } else {
-	 ret = (req->flags & READ) ? 1 : 0;
+   }
+   priv->greedy = scratch->bufs[beam[0].path[0]];
+   disk_get_servtime_head(reqs->devno, &head);
+   for (k=0; k<beamlen; k++) {
+      i = beam[k].path[0];
+      disk_get_servtime_from(reqs->devno, &head, reqs->blknos[i], reqs->bcounts[i], reqs->flags[i], reqs->times[i], &beam[k].head);
+      beam[k].firstend = beam[k].head.time;
+   }
+   for (depth=1; depth<lookahead_depth; depth++) {
+      nextlen = 0;
+      for (k=0; k<beamlen; k++) {
+         node = &beam[k];
+         i = node->path[(depth-1)];
+         start = node->head.time + ioqueue_lookahead_turnaround(priv, reqs->flags[i], reqs->bcounts[i]);
+         for (i=0; i<reqs->count; i++) {
+            for (j=0; j<depth; j++) {
+               if (node->path[j] == i) {
+                  break;
+               }
+            }
+            cost = node->cost + scratch->delays[i];
+            if ((j < depth) || ((nextlen == lookahead_beam) && (cost >= next[(nextlen-1)].cost))) {
+               continue;
+            }
+            cost += disk_get_servtime_from(reqs->devno, &node->head, reqs->blknos[i], reqs->bcounts[i], reqs->flags[i], (start + scratch->delays[i]), &endhead);
+            if ((slot = ioqueue_lookahead_slot(next, &nextlen, cost))) {
+               *slot = *node;
+               slot->cost = cost;
+               slot->path[depth] = i;
+               slot->head = endhead;
+            }
+         }
       }
-   } else if (priority_mix == 5) {
-      if (req->flags & READ) {
-	 ret = 1;
+      if (nextlen == 0) {
+         break;
       }
-   } else if (priority_mix == 6) {
-      if (req->flags & TIME_CRITICAL) {
-	 ret = 1;
+      node = beam;
+      beam = next;
+      next = node;
+      beamlen = nextlen;
+   }
+   priv->choice = scratch->bufs[beam[0].path[0]];
+   priv->choiceend = beam[0].firstend;
+   return(priv->choice);
+}
+
+
+void ioqueue_pop_lookahead(queue, temp)
+subqueue *queue;
+iobuf *temp;
+{
+   lasched *priv = LASCHED(queue);
+
+   ioqueue_pop_last(queue, temp);
+   priv->lastend = -1.0;
+   if (temp == priv->choice) {
+      priv->decisions++;
+      if (temp != priv->greedy) {
+         priv->overrides++;
+      }
+      priv->lastend = priv->choiceend;
+      priv->lastread = (temp->flags & READ) ? 1 : 0;
+      priv->lastsize = temp->totalsize;
+   }
+   priv->choice = NULL;
+}
+
+
+void ioqueue_lookahead_resetstats(queue)
+subqueue *queue;
+{
+   LASCHED(queue)->decisions = 0;
+   LASCHED(queue)->overrides = 0;
+}
+
+
+void ioqueue_lookahead_printstats(set, setsize, prefix)
+subqueue **set;
+int setsize;
+char *prefix;
+{
+   int decisions = 0;
+   int overrides = 0;
+   int i;
+
+   for (i=0; i<setsize; i++) {
+      if (set[i]->sched_alg == LOOKAHEAD_SPTF) {
+         decisions += LASCHED(set[i])->decisions;
+         overrides += LASCHED(set[i])->overrides;
+      }
+   }
+   fprintf(outputfile, "%sLookahead decisions:     %d\n", prefix, decisions);
+   fprintf(outputfile, "%sOverriding SPTF:         %d  \t%f\n", prefix, overrides, ((double) overrides / (double) max(decisions,1)));
+}
+
+
+/* Deadline and anticipatory scheduling, after the Linux schedulers of */
+/* the same names.  Requests go in LBN order in batches of up to       */
+/* deadline_fifo_batch, reads in preference to writes unless writes    */
+/* have been passed over deadline_writes_starved times, and a batch    */
+/* starts instead from the oldest request of its direction once that  */
+/* request has waited out its expiry.  Each direction's waiting        */
+/* requests are kept in arrival order (the FIFO) in an array of        */
+/* entries indexed by their iobufs' schedslot.  The anticipatory       */
+/* variant also keeps the disk idle for up to antic_expire after a     */
+/* read completes, when nothing is queued close to it, in the hope      */
+/* that the process that issued it (its cause) is about to ask for     */
+/* another nearby block, unless that process's think time so far says */
+/* otherwise.  (As in Linux, every read counts as synchronous.)  It   */
+/* needs an owner that can be woken (see ioqueue_set_wakeup_function), */
+/* and otherwise behaves like deadline.                                */
+
+#define DLSCHED_WRITES		0
+#define DLSCHED_READS		1
+#define DLSCHED_DIR(buf)	(((buf)->flags & READ) ? DLSCHED_READS : DLSCHED_WRITES)
+#define DLSCHED_MAXPROCS	1024
+#define ANTIC_CLOSE		8192	/* blocks from the last read */
+
+typedef struct {
+   iobuf *	buf;
+   double	expire;
+   int		dir;
+   int		cause;
+   int		infifo;
+   int		prev;		/* FIFO neighbours, or -1 */
+   int		next;		/* also links the free slots */
+} dlentry;
+
+typedef struct {
+   double	lastdone;	/* completion of its last read, or -1.0 */
+   double	thinkmean;
+   int		thinkcnt;
+} dlproc;
+
+typedef struct {
+   dlentry *	entries;
+   int		size;
+   int		freeslot;
+   int		head[2];
+   int		tail[2];
+   int		batchdir;	/* direction of the batch, or -1 */
+   int		batching;	/* requests dispatched in it */
+   lbn_t	nextpos;	/* the block after the last one dispatched */
+   int		starved;
+   iobuf *	chosen;		/* peek's choice, and what popping it means */
+   int		chosenbatch;
+   int		chosenstarved;
+   dlproc *	procs;
+   int		numprocs;
+   int		anticause;	/* process anticipated, or -1 */
+   lbn_t	antipos;
+   double	antiend;
+   iobuf *	antibuf;	/* read it has since issued */
+   timer_event *antitimer;
+   int		antics;
+   int		antihits;
+   int		antitimeouts;
+} dlsched;
+
+#define DLSCHED(queue)		((dlsched *) (queue)->schedpriv)
+
+
+void ioqueue_dlsched_initialize(queue, devno)
+subqueue *queue;
+int devno;
+{
+   dlsched *priv = (dlsched *) malloc(sizeof(dlsched));
+   ASSERT(priv != NULL);
+
+   bzero((char *) priv, sizeof(dlsched));
+   priv->freeslot = -1;
+   priv->head[DLSCHED_READS] = -1;
+   priv->head[DLSCHED_WRITES] = -1;
+   priv->tail[DLSCHED_READS] = -1;
+   priv->tail[DLSCHED_WRITES] = -1;
+   priv->batchdir = -1;
+   priv->anticause = -1;
+   queue->schedpriv = priv;
+}
+
+
+dlproc * ioqueue_dlsched_proc(priv, cause)
+dlsched *priv;
+int cause;
+{
+   int size;
+   int i;
+
+   if ((cause < 0) || (cause >= DLSCHED_MAXPROCS)) {
+      return(NULL);
+   }
+   if (cause >= priv->numprocs) {
+      size = max((cause + 1), (2 * priv->numprocs));
+      priv->procs = (dlproc *) realloc(priv->procs, (size * sizeof(dlproc)));
+      ASSERT(priv->procs != NULL);
+      for (i = priv->numprocs; i < size; i++) {
+         priv->procs[i].lastdone = -1.0;
+         priv->procs[i].thinkmean = 0.0;
+         priv->procs[i].thinkcnt = 0;
       }
+      priv->numprocs = size;
+   }
+   return(&priv->procs[cause]);
+}
+
+
+/* Links an entry into its direction's FIFO, behind those that expire */
+/* no later than it does.                                             */
+
+void ioqueue_dlsched_link(priv, slot)
+dlsched *priv;
+int slot;
+{
+   dlentry *entry = &priv->entries[slot];
+   int prev = priv->tail[entry->dir];
+
+   while ((prev != -1) && (priv->entries[prev].expire > entry->expire)) {
+      prev = priv->entries[prev].prev;
    }
-   return(ret);
+   entry->prev = prev;
+   if (prev == -1) {
+      entry->next = priv->head[entry->dir];
+      priv->head[entry->dir] = slot;
+   } else {
+      entry->next = priv->entries[prev].next;
+      priv->entries[prev].next = slot;
+   }
+   if (entry->next == -1) {
+      priv->tail[entry->dir] = slot;
+   } else {
+      priv->entries[entry->next].prev = slot;
+   }
+   entry->infifo = TRUE;
 }
 
 
-iobuf * ioqueue_get_request_from_pri_lbn_vscan_queue(queue, numlbns, vscan_value)
+void ioqueue_dlsched_unlink(priv, slot)
+dlsched *priv;
+int slot;
+{
+   dlentry *entry = &priv->entries[slot];
+
+   if (entry->prev == -1) {
+      priv->head[entry->dir] = entry->next;
+   } else {
+      priv->entries[entry->prev].next = entry->next;
+   }
+   if (entry->next == -1) {
+      priv->tail[entry->dir] = entry->prev;
+   } else {
+      priv->entries[entry->next].prev = entry->prev;
+   }
+   entry->infifo = FALSE;
+}
+
+
+void ioqueue_dlsched_insert(queue, buf)
 subqueue *queue;
-int numlbns;
-int vscan_value;
+iobuf *buf;
 {
-   int schedalg;
-   int priority_factor;
-   int age_factor;
-   int curr_effpri, best_effpri;
-   iobuf *tmp;
-   iobuf *ret = NULL;
+   dlsched *priv = DLSCHED(queue);
+   dlentry *entry;
+   ioreq_event *tmp;
+   double arrtime = simtime;
+   int slot;
    int i;
 
-   schedalg = queue->bigqueue->timeout.sched_alg;
-   priority_factor = queue->bigqueue->priority.sched_alg;
-   age_factor = queue->bigqueue->to_time;
-   if (schedalg == ELEVATOR_LBN) {
-      vscan_value = numlbns;
-   } else if (schedalg == SSTF_LBN) {
-      vscan_value = 0;
+   if (priv->freeslot == -1) {
+      slot = max(16, (2 * priv->size));
+      priv->entries = (dlentry *) realloc(priv->entries, (slot * sizeof(dlentry)));
+      ASSERT(priv->entries != NULL);
+      for (i = (slot - 1); i >= priv->size; i--) {
+         priv->entries[i].next = priv->freeslot;
+         priv->freeslot = i;
+      }
+      priv->size = slot;
+   }
+   slot = priv->freeslot;
+   entry = &priv->entries[slot];
+   priv->freeslot = entry->next;
+   for (tmp = buf->iolist; tmp; tmp = tmp->next) {
+      arrtime = min(arrtime, tmp->time);
+   }
+   entry->buf = buf;
+   entry->dir = DLSCHED_DIR(buf);
+   entry->expire = arrtime + ((entry->dir == DLSCHED_READS) ? deadline_read_expire : deadline_write_expire);
+   entry->cause = buf->iolist->cause;
+   buf->schedslot = slot;
+   ioqueue_dlsched_link(priv, slot);
+}
+
+
+void ioqueue_dlsched_remove(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   dlsched *priv = DLSCHED(queue);
+   int slot = buf->schedslot;
+
+   if (priv->entries[slot].infifo) {
+      ioqueue_dlsched_unlink(priv, slot);
    }
-   tmp = queue->list->next;
-   for (i = 0; i < queue->iobufcnt; i++) {
-      if (READY_TO_GO(tmp)) {
-	 curr_effpri = tmp->blkno - queue->lastblkno;
-	 if (schedalg == CYCLE_LBN) {
-	    if (curr_effpri < 0) {
-	       curr_effpri += numlbns;
-	    }
-	 } else if (curr_effpri) {
-	    if (curr_effpri < 0) {
-	       curr_effpri = -curr_effpri;
-	       if (queue->dir == ASC) {
-		  curr_effpri += vscan_value;
-	       }
-	    } else {
-	       if (queue->dir == DESC) {
-		  curr_effpri += vscan_value;
-	       }
-	    }
-	 }
-	 curr_effpri = numlbns - curr_effpri;
-	 curr_effpri += (priority_factor * numlbns * ioqueue_get_priority_level(tmp)) / 100;
-	 curr_effpri += (age_factor * (int) (simtime - tmp->starttime)) / 1280;
-	 if ((ret == NULL) || (curr_effpri > best_effpri)) {
-	    ret = tmp;
-	    best_effpri = curr_effpri;
-	 }
+   priv->entries[slot].buf = NULL;
+   priv->entries[slot].next = priv->freeslot;
+   priv->freeslot = slot;
+   buf->schedslot = -1;
+   if (priv->chosen == buf) {
+      priv->chosen = NULL;
+   }
+   if (priv->antibuf == buf) {
+      priv->antibuf = NULL;
+   }
+}
+
+
+/* req2 is merging into req1, which takes over its place in the FIFO */
+/* if it is the older of the two.                                    */
+
+void ioqueue_dlsched_concat(queue, req1, req2)
+subqueue *queue;
+iobuf *req1;
+iobuf *req2;
+{
+   dlsched *priv = DLSCHED(queue);
+   dlentry *entry1 = &priv->entries[req1->schedslot];
+   dlentry *entry2 = &priv->entries[req2->schedslot];
+
+   if (entry2->expire < entry1->expire) {
+      ioqueue_dlsched_unlink(priv, req1->schedslot);
+      entry1->expire = entry2->expire;
+      ioqueue_dlsched_link(priv, req1->schedslot);
+   }
+   if (priv->antibuf == req2) {
+      priv->antibuf = req1;
+   }
+   ioqueue_dlsched_remove(queue, req2);
+}
+
+
+/* The oldest request of the given direction that can go now */
+
+iobuf * ioqueue_dlsched_oldest(priv, dir)
+dlsched *priv;
+int dir;
+{
+   int slot;
+
+   for (slot = priv->head[dir]; slot != -1; slot = priv->entries[slot].next) {
+      if (READY_TO_GO(priv->entries[slot].buf)) {
+         return(priv->entries[slot].buf);
       }
-      tmp = tmp->next;
    }
-   return(ret);
+   return(NULL);
 }
 
 
-/* Queue contains >= 2 items when called */
+/* The first request of the given direction that can go now, in LBN   */
+/* order from blkno up to limit (or to the end, if limit is negative). */
 
-iobuf * ioqueue_get_request_from_lbn_scan_queue(queue)
+iobuf * ioqueue_dlsched_sorted(queue, dir, blkno, limit)
+subqueue *queue;
+int dir;
+lbn_t blkno;
+lbn_t limit;
+{
+   iobuf *tmp = ioqueue_tree_find_blkno(queue->tree, blkno, (iobuf *) NULL);
+
+   while ((tmp) && ((limit < 0) || (tmp->blkno <= limit))) {
+      if ((DLSCHED_DIR(tmp) == dir) && (READY_TO_GO(tmp))) {
+         return(tmp);
+      }
+      tmp = (tmp == queue->list) ? NULL : tmp->next;
+   }
+   return(NULL);
+}
+
+
+iobuf * ioqueue_peek_deadline(queue)
 subqueue *queue;
 {
+   dlsched *priv = DLSCHED(queue);
+   iobuf *reads;
+   iobuf *writes;
    iobuf *temp;
-   iobuf *stop;
+   iobuf *next;
 
-   temp = queue->list->next;
-   stop = temp;
-   if (queue->lastblkno > temp->blkno) {
-      while ((temp->next != stop) && (queue->lastblkno > temp->next->blkno)) {
-         temp = temp->next;
+   if ((priv->batchdir != -1) && (priv->batching < deadline_fifo_batch)) {
+      if ((temp = ioqueue_dlsched_sorted(queue, priv->batchdir, priv->nextpos, (lbn_t) -1))) {
+         priv->chosen = temp;
+         priv->chosenbatch = priv->batching;
+         priv->chosenstarved = priv->starved;
+         return(temp);
       }
-      temp = temp->next;
    }
-   stop = temp;
-   while ((temp->next != stop) && !READY_TO_GO(temp)) {
-      temp = temp->next;
+   reads = ioqueue_dlsched_oldest(priv, DLSCHED_READS);
+   writes = ioqueue_dlsched_oldest(priv, DLSCHED_WRITES);
+   if ((reads) && ((writes == NULL) || (priv->starved < deadline_writes_starved))) {
+      temp = reads;
+      priv->chosenstarved = (writes) ? (priv->starved + 1) : priv->starved;
+   } else if (writes) {
+      temp = writes;
+      priv->chosenstarved = 0;
+   } else {
+      return(NULL);
    }
-   if ((temp->next == stop) && !READY_TO_GO(temp)) {
-      temp = NULL;
+   if ((DLSCHED_DIR(temp) == priv->batchdir) && (simtime < priv->entries[temp->schedslot].expire)) {
+      if ((next = ioqueue_dlsched_sorted(queue, priv->batchdir, priv->nextpos, (lbn_t) -1))) {
+         temp = next;
+      }
    }
+   priv->chosen = temp;
+   priv->chosenbatch = 0;
    return(temp);
 }
 
 
-/* Queue contains >= 2 items when called */
-
-iobuf * ioqueue_get_request_from_lbn_vscan_queue(queue, value)
+void ioqueue_pop_deadline(queue, temp)
 subqueue *queue;
-int value;
+iobuf *temp;
 {
-   iobuf *temp;
-   iobuf *head;
-   iobuf *top = NULL;
-   iobuf *bottom = NULL;
-   int diff1, diff2;
-   int tmpdir;
-   iobuf *bestbottom;
+   dlsched *priv = DLSCHED(queue);
+   int slot = temp->schedslot;
+
+   if (temp == priv->chosen) {
+      priv->batching = priv->chosenbatch;
+      priv->starved = priv->chosenstarved;
+   } else if (priv->entries[slot].dir != priv->batchdir) {
+      priv->batching = 0;
+   }
+   priv->chosen = NULL;
+   priv->batching++;
+   priv->batchdir = priv->entries[slot].dir;
+   priv->nextpos = temp->blkno + temp->totalsize;
+   if (priv->entries[slot].infifo) {
+      ioqueue_dlsched_unlink(priv, slot);
+   }
+   ioqueue_pop_last(queue, temp);
+}
 
-   tmpdir = queue->dir;
-   temp = queue->list->next;
-   head = queue->list->next;
 
-   while ((temp->next != head) && (queue->lastblkno > temp->next->blkno)) {
-      temp = temp->next;
-   }
-   if (temp->blkno < queue->lastblkno) {
-      bottom = temp;
-      while ((bottom != head) && !READY_TO_GO(bottom)) {
-         bottom = bottom->prev;
-      }
-      if ((bottom == head) && !READY_TO_GO(bottom)) {
-	 bottom = NULL;
-      } else {
-         bestbottom = bottom;
-         while ((bottom != head) && ((bottom->prev->blkno == bestbottom->blkno) || (!(ioqueue_seqstream_head(queue->bigqueue, head, bottom))))) {
-	    bottom = bottom->prev;
-	    bestbottom = (READY_TO_GO(bottom)) ? bottom : bestbottom;
-         }
-         bottom = bestbottom;
+void ioqueue_antic_stop(priv)
+dlsched *priv;
+{
+   priv->anticause = -1;
+   priv->antibuf = NULL;
+   if (priv->antitimer) {
+      if (!(removefromintq((event *) priv->antitimer))) {
+         fprintf(stderr, "existing anticipation timer not on intq in ioqueue_antic_stop\n");
+         exit(0);
       }
+      addtoextraq((event *) priv->antitimer);
+      priv->antitimer = NULL;
    }
-   if (temp->next != head) {
-      if (temp->blkno >= queue->lastblkno) {
-	 top = temp;
-      } else {
-         top = temp->next;
-      }
-      while ((top->next != head) && !READY_TO_GO(top)) {
-         top = top->next;
-      }
+}
+
+
+void ioqueue_antic_expired(timereq)
+timer_event *timereq;
+{
+   subqueue *queue = (subqueue *) timereq->ptr;
+   ioqueue *bigqueue = queue->bigqueue;
+   dlsched *priv = DLSCHED(queue);
+
+   priv->antitimer = NULL;
+   priv->anticause = -1;
+   priv->antibuf = NULL;
+   priv->antitimeouts++;
+   addtoextraq((event *) timereq);
+   (*bigqueue->wakeup)(bigqueue->wakeupparam, bigqueue->devno);
+}
+
+
+iobuf * ioqueue_peek_anticipatory(queue)
+subqueue *queue;
+{
+   dlsched *priv = DLSCHED(queue);
+   iobuf *temp = NULL;
+   iobuf *reads;
+
+   if (priv->anticause == -1) {
+      return(ioqueue_peek_deadline(queue));
    }
-   if ((top == NULL) || !READY_TO_GO(top) || (!(ioqueue_seqstream_head(queue->bigqueue, head, top)))) {
-      temp = bottom;
-   } else if ((bottom == NULL) || !READY_TO_GO(bottom)) {
-      temp = top;
+   if ((priv->antibuf) && (READY_TO_GO(priv->antibuf))) {
+      temp = priv->antibuf;
    } else {
-      diff1 = diff(top->blkno, queue->lastblkno);
-      diff2 = diff(queue->lastblkno, bottom->blkno);
-      if (queue->dir == ASC) {
-	 diff2 = (diff2) ? (diff2 + value) : diff2;
-      } else {
-	 diff1 = (diff1) ? (diff1 + value) : diff1;
-      }
-      if (diff1 < diff2) {
-         temp = top;
-      } else if ((diff1 > diff2) || (queue->sstfupdown)) {
-         temp = bottom;
-      } else {
-	 temp = top;
-      }
-      if (diff1 == diff2) {
-	 queue->sstfupdown = (queue->sstfupdown) ? 0 : 1;
-	 queue->sstfupdowncnt++;
+      temp = ioqueue_dlsched_sorted(queue, DLSCHED_READS, max(0, (priv->antipos - ANTIC_CLOSE)), (priv->antipos + ANTIC_CLOSE));
+   }
+   if (temp) {
+      priv->antihits++;
+   } else if (simtime < priv->antiend) {
+      reads = ioqueue_dlsched_oldest(priv, DLSCHED_READS);
+      if ((reads == NULL) || (simtime < priv->entries[reads->schedslot].expire)) {
+         if (priv->antitimer == NULL) {
+            priv->antitimer = (timer_event *) getfromextraq();
+            priv->antitimer->type = TIMER_EXPIRED;
+            priv->antitimer->func = ioqueue_antic_expired;
+            priv->antitimer->ptr = queue;
+            priv->antitimer->time = priv->antiend;
+            addtointq((event *) priv->antitimer);
+         }
+         return(NULL);
       }
    }
-   if (temp->blkno != queue->lastblkno) {
-      queue->dir = (temp->blkno > queue->lastblkno) ? ASC : DESC;
+   ioqueue_antic_stop(priv);
+   if (temp == NULL) {
+      return(ioqueue_peek_deadline(queue));
    }
-   top = (temp == top) ? bottom : top;
-   if ((top) && READY_TO_GO(top)) {
-      int cylno1, cylno2;
-      int surface1, surface2;
+   priv->chosen = temp;
+   priv->chosenbatch = ((priv->batchdir == DLSCHED_READS) && (priv->batching < deadline_fifo_batch)) ? priv->batching : 0;
+   priv->chosenstarved = priv->starved;
+   return(temp);
+}
 
-      ioqueue_get_cylinder_mapping(queue->bigqueue, temp, temp->blkno, &cylno1, &surface1, MAP_FULL);
-      ioqueue_get_cylinder_mapping(queue->bigqueue, top, top->blkno, &cylno2, &surface2, MAP_FULL);
-      diff1 = abs(cylno1 - queue->optcylno);
-      diff2 = abs(cylno2 - queue->optcylno);
-      if (((tmpdir == ASC) && (temp != bottom)) || ((tmpdir == DESC) && (temp == bottom))) {
-	 if (diff2) {
-	    diff2 += (int) (vscan_value * (double) disk_get_numcyls(temp->iolist->devno));
-	 }
-      } else if (diff1) {
-	 if (diff1) {
-	    diff1 += (int) (vscan_value * (double) disk_get_numcyls(temp->iolist->devno));
-	 }
-      }
-      if (diff1 > diff2) {
-         stat_update(&queue->infopenalty, (double) (diff1 - diff2));
-/*
-fprintf (outputfile, "diff1 %d, diff2 %d, diffdiff %d\n", diff1, diff2, (diff1 - diff2));
-*/
-      } else if ((diff1 == diff2) && (diff1 == 0)) {
-         if ((queue->optsurface == surface2) && (surface1 != surface2)) {
-            stat_update(&queue->infopenalty, (double) 0);
-         }
+
+void ioqueue_antic_insert(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   dlsched *priv = DLSCHED(queue);
+   dlproc *proc;
+   int cause;
+   double think;
+
+   ioqueue_dlsched_insert(queue, buf);
+   cause = priv->entries[buf->schedslot].cause;
+   if (((proc = ioqueue_dlsched_proc(priv, cause))) && (proc->lastdone >= 0.0)) {
+      think = simtime - proc->lastdone;
+      proc->thinkmean = (proc->thinkcnt) ? (((7.0 * proc->thinkmean) + think) / 8.0) : think;
+      proc->thinkcnt++;
+      proc->lastdone = -1.0;
+   }
+   if ((cause == priv->anticause) && (buf->flags & READ)) {
+      priv->antibuf = buf;
+   }
+}
+
+
+/* Decides whether to wait for the process whose read is completing */
+
+void ioqueue_antic_complete(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   dlsched *priv = DLSCHED(queue);
+   dlproc *proc;
+   int cause = priv->entries[buf->schedslot].cause;
+
+   if ((!(buf->flags & READ)) || ((proc = ioqueue_dlsched_proc(priv, cause)) == NULL)) {
+      return;
+   }
+   proc->lastdone = simtime;
+   if ((queue->bigqueue->wakeup == NULL) || (antic_expire <= 0.0) || (queue->reqoutstanding > 1)) {
+      return;
+   }
+   if ((proc->thinkcnt) && (proc->thinkmean > antic_expire)) {
+      return;
+   }
+   ioqueue_antic_stop(priv);
+   priv->anticause = cause;
+   priv->antipos = buf->blkno + buf->totalsize;
+   priv->antiend = simtime + antic_expire;
+   priv->antics++;
+}
+
+
+void ioqueue_antic_resetstats(queue)
+subqueue *queue;
+{
+   dlsched *priv = DLSCHED(queue);
+
+   priv->antics = 0;
+   priv->antihits = 0;
+   priv->antitimeouts = 0;
+}
+
+
+void ioqueue_antic_printstats(set, setsize, prefix)
+subqueue **set;
+int setsize;
+char *prefix;
+{
+   int antics = 0;
+   int antihits = 0;
+   int antitimeouts = 0;
+   int i;
+
+   for (i=0; i<setsize; i++) {
+      if (set[i]->sched_alg == ANTICIPATORY) {
+         antics += DLSCHED(set[i])->antics;
+         antihits += DLSCHED(set[i])->antihits;
+         antitimeouts += DLSCHED(set[i])->antitimeouts;
       }
    }
-   return(temp);
+   fprintf(outputfile, "%sAnticipated reads:       %d\n", prefix, antics);
+   fprintf(outputfile, "%sAnticipation hits:       %d\n", prefix, antihits);
+   fprintf(outputfile, "%sAnticipation timeouts:   %d\n", prefix, antitimeouts);
+}
+
+
+/* Proportional-share fair queueing (start-time fair queueing with     */
+/* budgets, in the manner of CFQ and BFQ).  Requests belong to flows   */
+/* (the synthetic generator that issued them, or the optional flow     */
+/* field of an ASCII trace).  One flow at a time is in service, its    */
+/* requests going in arrival order until it runs out of them or has    */
+/* used its budget, fq_budget sectors or, if fq_slice is set, fq_slice */
+/* ms of access time (charged as each access completes).  Its virtual  */
+/* time then advances by what it used over its weight (fq_weights, 1.0 */
+/* by default), and the backlogged flow with the earliest virtual      */
+/* start goes next, from a heap of flows.  A flow that goes idle       */
+/* restarts no earlier than the virtual time of the flow in service.   */
+/* Response times are kept per flow, in buckets a quarter octave wide, */
+/* for the percentiles printed with the stats.                         */
+
+#define FQ_MAXFLOWS	65536
+#define FQ_FLOW(flow)	((((flow) >= 0) && ((flow) < FQ_MAXFLOWS)) ? (flow) : (int) (((u_int) (flow)) % FQ_MAXFLOWS))
+#define FQ_HISTSIZE	64
+#define FQ_HISTBASE	0.1	/* ms, upper edge of the first bucket */
+
+typedef struct {
+   iobuf *	buf;
+   double	arrtime;
+   int		flow;
+   int		infifo;
+   int		prev;		/* its flow's FIFO, or -1 */
+   int		next;		/* also links the free slots */
+} fqentry;
+
+typedef struct {
+   double	weight;
+   double	start;		/* virtual start of its turn */
+   double	lastfinish;	/* virtual end of its last turn */
+   double	used;		/* sectors or ms of this turn */
+   int		head;
+   int		tail;
+   int		pending;
+   int		heapidx;	/* -1 unless waiting for a turn */
+   int		numcomplete;
+   double	blocks;
+   double	runresp;
+   double	maxresp;
+   int		hist[FQ_HISTSIZE];
+} fqflow;
+
+typedef struct {
+   fqentry *	entries;
+   int		size;
+   int		freeslot;
+   fqflow **	flows;
+   int		numflows;
+   int *	heap;
+   int		heaplen;
+   int		heapsize;
+   int		inservice;	/* flow in service, or -1 */
+   double	vtime;
+} fqsched;
+
+#define FQSCHED(queue)		((fqsched *) (queue)->schedpriv)
+
+double fq_histedges[FQ_HISTSIZE];
+
+
+void ioqueue_fq_initialize(queue, devno)
+subqueue *queue;
+int devno;
+{
+   fqsched *priv = (fqsched *) malloc(sizeof(fqsched));
+   int i;
+   ASSERT(priv != NULL);
+
+   bzero((char *) priv, sizeof(fqsched));
+   priv->freeslot = -1;
+   priv->inservice = -1;
+   queue->schedpriv = priv;
+   fq_histedges[0] = FQ_HISTBASE;
+   for (i = 1; i < FQ_HISTSIZE; i++) {
+      fq_histedges[i] = fq_histedges[(i-1)] * 1.189207115;	/* 2^(1/4) */
+   }
 }
 
 
-/* Queue contains >= 2 items when called */
+double ioqueue_fq_weight(flow)
+int flow;
+{
+   if ((flow < fq_numweights) && (fq_weights[flow] > 0.0)) {
+      return(fq_weights[flow]);
+   }
+   return(1.0);
+}
 
-/* Returns pointer to "best" request on queue->lastcylno, or first request
-   on next available forward cylinder, or head (in priority order). */
 
-iobuf *ioqueue_identify_request_on_cylinder(queue)
-subqueue *queue;
+fqflow * ioqueue_fq_flow(priv, id)
+fqsched *priv;
+int id;
 {
-   iobuf *temp;
-   iobuf *head;
-   iobuf *cylstop;
-   iobuf *surfstop;
+   fqflow *flow;
+   int size;
+   int i;
 
-   int lastcylno;
-   int lastsurface;
-   int lastblkno;
+   if (id >= priv->numflows) {
+      size = max((id + 1), (2 * priv->numflows));
+      priv->flows = (fqflow **) realloc(priv->flows, (size * sizeof(fqflow *)));
+      ASSERT(priv->flows != NULL);
+      for (i = priv->numflows; i < size; i++) {
+         priv->flows[i] = NULL;
+      }
+      priv->numflows = size;
+   }
+   if ((flow = priv->flows[id]) == NULL) {
+      flow = (fqflow *) malloc(sizeof(fqflow));
+      ASSERT(flow != NULL);
+      bzero((char *) flow, sizeof(fqflow));
+      flow->weight = ioqueue_fq_weight(id);
+      flow->head = -1;
+      flow->tail = -1;
+      flow->heapidx = -1;
+      priv->flows[id] = flow;
+   }
+   return(flow);
+}
 
-   lastcylno = queue->lastcylno;
-   lastsurface = queue->lastsurface;
-   lastblkno = queue->lastblkno;
 
-   head = queue->list->next;
-   temp = head;
+/* Orders the heap on virtual start, ties going to the lower flow id */
 
-   if ((head->cylinder < lastcylno) && (lastcylno <= queue->list->cylinder)) {
-      while ((temp->next != head) && (lastcylno > temp->next->cylinder)) {
-         temp = temp->next;
+int ioqueue_fq_before(priv, a, b)
+fqsched *priv;
+int a;
+int b;
+{
+   double starta = priv->flows[a]->start;
+   double startb = priv->flows[b]->start;
+
+   return((starta < startb) || ((starta == startb) && (a < b)));
+}
+
+
+void ioqueue_fq_place(priv, i, id)
+fqsched *priv;
+int i;
+int id;
+{
+   int *heap = priv->heap;
+   int child;
+
+   while ((i > 0) && (ioqueue_fq_before(priv, id, heap[((i-1) / 2)]))) {
+      heap[i] = heap[((i-1) / 2)];
+      priv->flows[heap[i]]->heapidx = i;
+      i = (i-1) / 2;
+   }
+   while ((child = (2 * i) + 1) < priv->heaplen) {
+      if (((child + 1) < priv->heaplen) && (ioqueue_fq_before(priv, heap[(child+1)], heap[child]))) {
+         child++;
       }
-      temp = temp->next;
+      if (!(ioqueue_fq_before(priv, heap[child], id))) {
+         break;
+      }
+      heap[i] = heap[child];
+      priv->flows[heap[i]]->heapidx = i;
+      i = child;
    }
+   heap[i] = id;
+   priv->flows[id]->heapidx = i;
+}
 
-   if (temp->cylinder != lastcylno) {
-      return(temp);
+
+void ioqueue_fq_heap_insert(priv, id)
+fqsched *priv;
+int id;
+{
+   if (priv->heaplen == priv->heapsize) {
+      priv->heapsize = max(16, (2 * priv->heapsize));
+      priv->heap = (int *) realloc(priv->heap, (priv->heapsize * sizeof(int)));
+      ASSERT(priv->heap != NULL);
    }
+   priv->heaplen++;
+   ioqueue_fq_place(priv, (priv->heaplen - 1), id);
+}
 
-   cylstop = temp;      /* first req on cylinder */
 
-   while ((temp->next != head) && (lastcylno == temp->next->cylinder) && (lastsurface > temp->surface)) {
-      temp = temp->next;
+void ioqueue_fq_heap_remove(priv, id)
+fqsched *priv;
+int id;
+{
+   int i = priv->flows[id]->heapidx;
+
+   ASSERT(priv->heap[i] == id);
+   priv->flows[id]->heapidx = -1;
+   priv->heaplen--;
+   if (i < priv->heaplen) {
+      ioqueue_fq_place(priv, i, priv->heap[priv->heaplen]);
    }
+}
 
-   if (lastsurface > temp->surface) {
-      temp = cylstop;   /* drop out and try from first req on cylinder */
 
-   } else if (!queue->surfoverforw) {
-      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && (!READY_TO_GO(temp) || (temp->blkno < lastblkno))) {
-         temp = temp->next;
-      }
-      if (READY_TO_GO(temp) && (temp->blkno >= lastblkno)) {
-        return(temp);
-      } else {
-         temp = cylstop;   /* drop out and try from first req on cylinder */
-      }
+/* Ends the turn of the flow in service */
 
-   } else {    /* surfoverforw */
+void ioqueue_fq_expire(priv)
+fqsched *priv;
+{
+   int id = priv->inservice;
+   fqflow *flow = priv->flows[id];
 
-      surfstop = temp;     /* first req on surface */
+   flow->lastfinish = flow->start + (flow->used / flow->weight);
+   flow->used = 0.0;
+   priv->inservice = -1;
+   if (flow->pending) {
+      flow->start = flow->lastfinish;
+      ioqueue_fq_heap_insert(priv, id);
+   }
+}
 
-      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && (lastsurface == temp->next->surface) && (!READY_TO_GO(temp) || (temp->blkno < lastblkno))) {
-         temp = temp->next;
-      }
-      if (READY_TO_GO(temp) && (temp->blkno >= lastblkno) && (temp->surface == lastsurface)) {
-         return(temp);
-      }
 
-      temp = surfstop;
+void ioqueue_fq_insert(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   fqsched *priv = FQSCHED(queue);
+   fqentry *entry;
+   fqflow *flow;
+   ioreq_event *tmp;
+   double arrtime = simtime;
+   int id = FQ_FLOW(buf->iolist->flow);
+   int slot;
+   int i;
 
-      while ((temp->next != head) && (lastcylno == temp->next->cylinder) && !READY_TO_GO(temp)) {
-         temp = temp->next;
-      }
-      if (READY_TO_GO(temp)) {
-         return(temp);
+   flow = ioqueue_fq_flow(priv, id);
+   if (priv->freeslot == -1) {
+      slot = max(16, (2 * priv->size));
+      priv->entries = (fqentry *) realloc(priv->entries, (slot * sizeof(fqentry)));
+      ASSERT(priv->entries != NULL);
+      for (i = (slot - 1); i >= priv->size; i--) {
+         priv->entries[i].next = priv->freeslot;
+         priv->freeslot = i;
       }
+      priv->size = slot;
+   }
+   slot = priv->freeslot;
+   entry = &priv->entries[slot];
+   priv->freeslot = entry->next;
+   for (tmp = buf->iolist; tmp; tmp = tmp->next) {
+      arrtime = min(arrtime, tmp->time);
+   }
+   entry->buf = buf;
+   entry->arrtime = arrtime;
+   entry->flow = id;
+   entry->infifo = TRUE;
+   entry->prev = flow->tail;
+   entry->next = -1;
+   if (flow->tail == -1) {
+      flow->head = slot;
+   } else {
+      priv->entries[flow->tail].next = slot;
+   }
+   flow->tail = slot;
+   buf->schedslot = slot;
+   if ((flow->pending++ == 0) && (id != priv->inservice)) {
+      flow->start = max(priv->vtime, flow->lastfinish);
+      ioqueue_fq_heap_insert(priv, id);
+   }
+}
 
-      temp = cylstop;   /* drop out and try from first req on cylinder */
+
+void ioqueue_fq_unlink(priv, slot)
+fqsched *priv;
+int slot;
+{
+   fqentry *entry = &priv->entries[slot];
+   fqflow *flow = priv->flows[entry->flow];
+
+   if (entry->prev == -1) {
+      flow->head = entry->next;
+   } else {
+      priv->entries[entry->prev].next = entry->next;
    }
+   if (entry->next == -1) {
+      flow->tail = entry->prev;
+   } else {
+      priv->entries[entry->next].prev = entry->prev;
+   }
+   entry->infifo = FALSE;
+   flow->pending--;
+}
 
-   /* drop out recovery point */
 
-   if (!READY_TO_GO(temp)) {
-      while (!READY_TO_GO(temp) && (temp->next != head) && (temp->next->cylinder == lastcylno)) {
-         temp = temp->next;
+void ioqueue_fq_remove(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   fqsched *priv = FQSCHED(queue);
+   int slot = buf->schedslot;
+   fqflow *flow = priv->flows[priv->entries[slot].flow];
+
+   if (priv->entries[slot].infifo) {
+      ioqueue_fq_unlink(priv, slot);
+      if ((flow->pending == 0) && (flow->heapidx != -1)) {
+         ioqueue_fq_heap_remove(priv, priv->entries[slot].flow);
       }
-      temp = temp->next;
    }
-   return(temp);
+   priv->entries[slot].buf = NULL;
+   priv->entries[slot].next = priv->freeslot;
+   priv->freeslot = slot;
+   buf->schedslot = -1;
 }
 
 
-/* Queue contains >= 2 items when called */
+iobuf * ioqueue_fq_first(priv, id)
+fqsched *priv;
+int id;
+{
+   int slot;
 
-iobuf * ioqueue_get_request_from_cyl_scan_queue(queue)
+   for (slot = priv->flows[id]->head; slot != -1; slot = priv->entries[slot].next) {
+      if (READY_TO_GO(priv->entries[slot].buf)) {
+         return(priv->entries[slot].buf);
+      }
+   }
+   return(NULL);
+}
+
+
+iobuf * ioqueue_peek_fq(queue)
 subqueue *queue;
 {
+   fqsched *priv = FQSCHED(queue);
+   fqflow *flow;
    iobuf *temp;
-   iobuf *stop;
+   int i;
 
-   temp = queue->list->next;
-   if (queue->lastcylno >= temp->cylinder) {
-      temp = ioqueue_identify_request_on_cylinder(queue);
+   if (priv->inservice != -1) {
+      flow = priv->flows[priv->inservice];
+      if ((flow->pending == 0) || (flow->used >= ((fq_slice > 0.0) ? fq_slice : (double) fq_budget))) {
+         ioqueue_fq_expire(priv);
+      }
    }
-   stop = temp;
-   while (!READY_TO_GO(temp) && (temp->next != stop)) {
-      temp = temp->next;
+   if (priv->inservice == -1) {
+      if (priv->heaplen == 0) {
+         return(NULL);
+      }
+      priv->inservice = priv->heap[0];
+      ioqueue_fq_heap_remove(priv, priv->inservice);
+      priv->vtime = max(priv->vtime, priv->flows[priv->inservice]->start);
    }
-   if ((temp->next == stop) && !READY_TO_GO(temp)) {
-      temp = NULL;
+   if ((temp = ioqueue_fq_first(priv, priv->inservice))) {
+      return(temp);
    }
-   return(temp);
+         /* nothing in service can go now, so try the others in any order */
+   for (i = 0; i < priv->heaplen; i++) {
+      if ((temp = ioqueue_fq_first(priv, priv->heap[i]))) {
+         return(temp);
+      }
+   }
+   return(NULL);
 }
 
 
-/* Queue contains >= 2 items when called */
+/* Requests dispatched by some other route than peek put their flow in */
+/* service.                                                            */
 
-iobuf * ioqueue_get_request_from_cyl_vscan_queue(queue, value)
+void ioqueue_pop_fq(queue, temp)
 subqueue *queue;
-int value;
+iobuf *temp;
 {
-   iobuf *temp;
-   iobuf *head;
-   iobuf *top = NULL;
-   iobuf *bottom = NULL;
-   iobuf *bottom2 = NULL;
-   iobuf *bestone;
-   int diff1, diff2, diff3;
-   int tmpdir;
-   int cylno1, cylno2, cylno3;
-   int surface1, surface2, surface3;
+   fqsched *priv = FQSCHED(queue);
+   int id = priv->entries[temp->schedslot].flow;
+   fqflow *flow = priv->flows[id];
 
-   tmpdir = queue->dir;
-   temp = queue->list->next;
-   head = queue->list->next;
-
-   bestone = ioqueue_identify_request_on_cylinder(queue);
-   if (!READY_TO_GO(bestone) || (bestone->cylinder != queue->lastcylno)) {
-      bestone = NULL;
-   }
-   while ((temp->next != head) && (queue->lastblkno > temp->next->blkno)) {
-      temp = temp->next;
-   }
-   if (temp->blkno < queue->lastblkno) {
-      bottom = temp;
-      while ((bottom != head) && !READY_TO_GO(bottom)) {
-         bottom = bottom->prev;
+   if (id != priv->inservice) {
+      if (priv->inservice != -1) {
+         ioqueue_fq_expire(priv);
       }
-      bottom2 = temp;
-      if (READY_TO_GO(bottom) && (!bestone)) {
-         while ((bottom != head) && (bottom->prev->cylinder == bottom->cylinder)) {
-	    bottom = bottom->prev;
-         }
-         while ((bottom != temp) && !READY_TO_GO(bottom)) {
-	    bottom = bottom->next;
-         }
+      if (flow->heapidx != -1) {
+         ioqueue_fq_heap_remove(priv, id);
       }
+      priv->inservice = id;
+      priv->vtime = max(priv->vtime, flow->start);
    }
-   if (temp->next != head) {
-      top = (temp->blkno >= queue->lastblkno) ? temp : temp->next;
-      while ((top->next != head) && !READY_TO_GO(top)) {
-         top = top->next;
-      }
+   ioqueue_fq_unlink(priv, temp->schedslot);
+   if (fq_slice <= 0.0) {
+      flow->used += (double) temp->totalsize;
    }
-   if (!bestone) {
-      if ((top == NULL) || !READY_TO_GO(top)) {
-         temp = bottom;
-      } else if ((bottom == NULL) || !READY_TO_GO(bottom)) {
-         temp = top;
+   ioqueue_pop_last(queue, temp);
+}
+
+
+void ioqueue_fq_account(priv, id, blocks, resptime)
+fqsched *priv;
+int id;
+int blocks;
+double resptime;
+{
+   fqflow *flow = ioqueue_fq_flow(priv, id);
+   int bottom = 0;
+   int top = FQ_HISTSIZE - 1;
+   int i;
+
+   flow->numcomplete++;
+   flow->blocks += (double) blocks;
+   flow->runresp += resptime;
+   flow->maxresp = max(flow->maxresp, resptime);
+   while (bottom != top) {
+      i = bottom + ((top - bottom) / 2);
+      if (resptime <= fq_histedges[i]) {
+         top = i;
       } else {
-         diff1 = diff(top->cylinder, queue->lastcylno);
-         diff2 = diff(queue->lastcylno, bottom->cylinder);
-         if (queue->dir == ASC) {
-	    diff2 += value;
-         } else {
-	    diff1 += value;
-         }
-         if (diff1 < diff2) {
-	    temp = top;
-         } else if ((diff1 > diff2) || (queue->sstfupdown)) {
-            temp = bottom;
-         } else {
-	    temp = top;
-         }
-         if (diff1 == diff2) {
-	    queue->sstfupdown = (queue->sstfupdown) ? 0 : 1;
-	    queue->sstfupdowncnt++;
-         }
+         bottom = i + 1;
       }
-   } else {
-      temp = bestone;
    }
-   if (temp->cylinder != queue->lastcylno) {
-      queue->dir = (temp->cylinder > queue->lastcylno) ? ASC : DESC;
+   flow->hist[top]++;
+}
+
+
+void ioqueue_fq_complete(queue, buf)
+subqueue *queue;
+iobuf *buf;
+{
+   fqsched *priv = FQSCHED(queue);
+   fqentry *entry = &priv->entries[buf->schedslot];
+   ioreq_event *tmp;
+
+   if (fq_slice > 0.0) {
+      priv->flows[entry->flow]->used += simtime - buf->starttime;
    }
-   ioqueue_get_cylinder_mapping(queue->bigqueue, temp, temp->blkno, &cylno1, &surface1, MAP_FULL);
-   diff1 = abs(cylno1 - queue->optcylno);
-   if ((top == NULL) || !READY_TO_GO(top)) {
-      top = temp;
+   if (buf->reqcnt == 1) {
+      ioqueue_fq_account(priv, entry->flow, buf->totalsize, (simtime - entry->arrtime));
+   } else {
+      for (tmp = buf->iolist; tmp; tmp = tmp->next) {
+         ioqueue_fq_account(priv, entry->flow, tmp->bcount, (simtime - tmp->time));
+      }
    }
-   ioqueue_get_cylinder_mapping(queue->bigqueue, top, top->blkno, &cylno2, &surface2, MAP_FULL);
-   diff2 = abs(cylno2 - queue->optcylno);
-   if ((bottom2 == NULL) || !READY_TO_GO(bottom2)) {
-      bottom2 = temp;
+}
+
+
+void ioqueue_fq_resetstats(queue)
+subqueue *queue;
+{
+   fqsched *priv = FQSCHED(queue);
+   fqflow *flow;
+   int i;
+
+   for (i = 0; i < priv->numflows; i++) {
+      if ((flow = priv->flows[i])) {
+         flow->numcomplete = 0;
+         flow->blocks = 0.0;
+         flow->runresp = 0.0;
+         flow->maxresp = 0.0;
+         bzero((char *) flow->hist, sizeof(flow->hist));
+      }
    }
-   ioqueue_get_cylinder_mapping(queue->bigqueue, bottom2, bottom2->blkno, &cylno3, &surface3, MAP_FULL);
-   diff3 = abs(cylno3 - queue->optcylno);
-   if (tmpdir == ASC) {
-      diff3 = (diff3) ? (diff3 + value) : diff3;
-      diff1 = (temp->cylinder < queue->lastcylno) ? (diff1 + value) : diff1;
-   } else {
-      diff2 = (diff2) ? (diff2 + value) : diff2;
-      diff1 = (temp->cylinder > queue->lastcylno) ? (diff1 + value) : diff1;
+}
+
+
+/* Returns the upper edge of the bucket holding the response time */
+/* below which the given fraction of hist's count fall.           */
+
+double ioqueue_fq_percentile(hist, count, maxresp, fraction)
+int *hist;
+int count;
+double maxresp;
+double fraction;
+{
+   int target = (int) ((fraction * (double) count) + 0.999999);
+   int sum = 0;
+   int i;
+
+   for (i = 0; i < (FQ_HISTSIZE - 1); i++) {
+      sum += hist[i];
+      if (sum >= target) {
+         return(min(fq_histedges[i], maxresp));
+      }
+   }
+   return(maxresp);
+}
+
+
+void ioqueue_fq_printstats(set, setsize, prefix)
+subqueue **set;
+int setsize;
+char *prefix;
+{
+   fqflow *flow;
+   int hist[FQ_HISTSIZE];
+   int numflows = 0;
+   int numcomplete;
+   double blocks;
+   double runresp;
+   double maxresp;
+   double weight;
+   double secs = (simtime - warmuptime) / (double) 1000;
+   double share;
+   double sharesum = 0.0;
+   double sharesquares = 0.0;
+   int active = 0;
+   int id, i, j;
+
+   for (i=0; i<setsize; i++) {
+      if (set[i]->sched_alg == FAIR_QUEUE) {
+         numflows = max(numflows, FQSCHED(set[i])->numflows);
+      }
    }
-   if ((diff3 < diff2) || ((!diff3) && (surface3 == queue->optsurface))) {
-      surface2 = surface3;
-      diff2 = diff3;
+   for (id = 0; id < numflows; id++) {
+      numcomplete = 0;
+      blocks = 0.0;
+      runresp = 0.0;
+      maxresp = 0.0;
+      bzero((char *) hist, sizeof(hist));
+      for (i=0; i<setsize; i++) {
+         if ((set[i]->sched_alg != FAIR_QUEUE) || (id >= FQSCHED(set[i])->numflows) || ((flow = FQSCHED(set[i])->flows[id]) == NULL)) {
+            continue;
+         }
+         numcomplete += flow->numcomplete;
+         blocks += flow->blocks;
+         runresp += flow->runresp;
+         maxresp = max(maxresp, flow->maxresp);
+         for (j = 0; j < FQ_HISTSIZE; j++) {
+            hist[j] += flow->hist[j];
+         }
+      }
+      if (numcomplete == 0) {
+         continue;
+      }
+      weight = ioqueue_fq_weight(id);
+      fprintf(outputfile, "%sFlow %d weight %f: %d requests, %f req/sec, %f blocks/sec\n", prefix, id, weight, numcomplete, ((double) numcomplete / secs), (blocks / secs));
+      fprintf(outputfile, "%sFlow %d response time: avg %f, 50%% %f, 90%% %f, 99%% %f, max %f\n", prefix, id, (runresp / (double) numcomplete), ioqueue_fq_percentile(hist, numcomplete, maxresp, 0.5), ioqueue_fq_percentile(hist, numcomplete, maxresp, 0.9), ioqueue_fq_percentile(hist, numcomplete, maxresp, 0.99), maxresp);
+      share = blocks / weight;
+      sharesum += share;
+      sharesquares += share * share;
+      active++;
+   }
+   if (active) {
+      fprintf(outputfile, "%sFlows served:            %d\n", prefix, active);
+      fprintf(outputfile, "%sFairness index:          %f\n", prefix, ((sharesquares > 0.0) ? ((sharesum * sharesum) / ((double) active * sharesquares)) : 1.0));
    }
-   if (diff1 > diff2) {
-      stat_update(&queue->infopenalty, (double) (diff1 - diff2));
-/*
-fprintf (outputfile, "diff1 %d, diff2 %d, diffdiff %d, value %d\n", diff1, diff2, (diff1 - diff2), value);
-*/
-   } else if ((diff1 == diff2) && (diff1 == 0)) {
-      if ((queue->optsurface == surface2) && (surface1 != surface2)) {
-         stat_update(&queue->infopenalty, (double) 0);
+}
+
+
+/* The scheduler registry.  A new policy adds its entry here, with a */
+/* number and a name by which parameter files can select it.         */
+
+iosched ioqueue_scheds[] = {
+   { FCFS, "fcfs", FALSE, -1, 0, ioqueue_get_request_from_fcfs_queue, ioqueue_pop_last },
+   { ELEVATOR_LBN, "elevator_lbn", TRUE, MAP_NONE, TRAVEL_LBN, ioqueue_peek_elevator_lbn, ioqueue_pop_first },
+   { CYCLE_LBN, "cycle_lbn", TRUE, MAP_NONE, 0, ioqueue_get_request_from_lbn_scan_queue, ioqueue_pop_first },
+   { SSTF_LBN, "sstf_lbn", TRUE, MAP_NONE, 0, ioqueue_peek_sstf_lbn, ioqueue_pop_after },
+   { ELEVATOR_CYL, "elevator_cyl", TRUE, -1, TRAVEL_CYL, ioqueue_peek_elevator_cyl, ioqueue_pop_first },
+   { CYCLE_CYL, "cycle_cyl", TRUE, -1, 0, ioqueue_get_request_from_cyl_scan_queue, ioqueue_pop_first },
+   { SSTF_CYL, "sstf_cyl", TRUE, -1, 0, ioqueue_peek_sstf_cyl, ioqueue_pop_last },
+   { SPTF_OPT, "sptf", TRUE, -1, 0, ioqueue_peek_sptf, ioqueue_pop_last },
+   { SPCTF_OPT, "spctf", TRUE, -1, 0, ioqueue_peek_spctf, ioqueue_pop_last },
+   { SATF_OPT, "satf", TRUE, -1, 0, ioqueue_peek_satf, ioqueue_pop_last },
+   { WPTF_OPT, "wptf", TRUE, -1, 0, ioqueue_peek_wptf, ioqueue_pop_last },
+   { WPCTF_OPT, "wpctf", TRUE, -1, 0, ioqueue_peek_wpctf, ioqueue_pop_last },
+   { WATF_OPT, "watf", TRUE, -1, 0, ioqueue_peek_watf, ioqueue_pop_last },
+   { ASPTF_OPT, "asptf", TRUE, -1, 0, ioqueue_peek_asptf, ioqueue_pop_last },
+   { ASPCTF_OPT, "aspctf", TRUE, -1, 0, ioqueue_peek_aspctf, ioqueue_pop_last },
+   { ASATF_OPT, "asatf", TRUE, -1, 0, ioqueue_peek_asatf, ioqueue_pop_last },
+   { VSCAN_LBN, "vscan_lbn", TRUE, MAP_NONE, TRAVEL_LBN, ioqueue_peek_vscan_lbn, ioqueue_pop_vscan_lbn, NULL, NULL, NULL, NULL, ioqueue_vscan_lbn_initialize },
+   { VSCAN_CYL, "vscan_cyl", TRUE, -1, TRAVEL_CYL, ioqueue_peek_vscan_cyl, ioqueue_pop_vscan_cyl },
+   { PRI_VSCAN_LBN, "pri_vscan_lbn", FALSE, -1, TRAVEL_LBN, ioqueue_peek_pri_vscan_lbn, ioqueue_pop_first, NULL, NULL, NULL, NULL, ioqueue_vscan_lbn_initialize },
+   { PRI_ASPTF_OPT, "pri_asptf", TRUE, -1, 0, ioqueue_peek_pri_asptf, ioqueue_pop_last },
+   { PRI_ASPCTF_OPT, "pri_aspctf", TRUE, -1, 0, ioqueue_peek_pri_aspctf, ioqueue_pop_last },
+   { DEADLINE, "deadline", TRUE, MAP_NONE, 0, ioqueue_peek_deadline, ioqueue_pop_deadline, ioqueue_dlsched_insert, ioqueue_dlsched_remove, NULL, NULL, ioqueue_dlsched_initialize, NULL, NULL, ioqueue_dlsched_concat, FALSE },
+   { ANTICIPATORY, "anticipatory", TRUE, MAP_NONE, 0, ioqueue_peek_anticipatory, ioqueue_pop_deadline, ioqueue_antic_insert, ioqueue_dlsched_remove, ioqueue_antic_complete, NULL, ioqueue_dlsched_initialize, ioqueue_antic_resetstats, ioqueue_antic_printstats, ioqueue_dlsched_concat, TRUE },
+   { FAIR_QUEUE, "fair", FALSE, -1, 0, ioqueue_peek_fq, ioqueue_pop_fq, ioqueue_fq_insert, ioqueue_fq_remove, ioqueue_fq_complete, NULL, ioqueue_fq_initialize, ioqueue_fq_resetstats, ioqueue_fq_printstats, NULL, FALSE },
+   { LOOKAHEAD_SPTF, "lookahead_sptf", TRUE, -1, 0, ioqueue_peek_lookahead, ioqueue_pop_lookahead, NULL, NULL, NULL, NULL, ioqueue_lookahead_initialize, ioqueue_lookahead_resetstats, ioqueue_lookahead_printstats, NULL, FALSE },
+   { 0, NULL }
+};
+
+
+iosched * ioqueue_sched(number)
+int number;
+{
+   iosched *sched;
+
+   for (sched = ioqueue_scheds; sched->name; sched++) {
+      if (sched->number == number) {
+         return(sched);
       }
    }
-   return(temp);
+   return(NULL);
 }
 
 
-/* Queue contains >= 2 items when called */
+/* Reads a scheduling policy given by number or by name into *numptr */
 
-iobuf *ioqueue_get_request_from_opt_sptf_queue(queue, checkcache, ageweight, posonly)
-subqueue *queue;
-int checkcache;
-int ageweight;
-int posonly;
+void ioqueue_scanparam_sched(parline, parname, numptr, required)
+char *parline;
+char *parname;
+int *numptr;
+int required;
 {
-   int i;
-   iobuf *temp;
-   iobuf *best = NULL;
-   ioreq_event *test;
-   double mintime = 100000.0;
-   double readdelay;
-   double writedelay;
-   double delay;
-   double age;
-   double weight;
-   ioreq_event *tmp;
+   iosched *sched;
 
-   ASSERT((ageweight >= 0) && (ageweight <= 3));
-   readdelay = queue->bigqueue->readdelay;
-   writedelay = queue->bigqueue->writedelay;
-   weight = (double) queue->bigqueue->to_time;
-   test = (ioreq_event *) getfromextraq();
-   temp = queue->list->next;
-   for (i=0; i<queue->listlen; i++) {
-      if (READY_TO_GO(temp) && (ioqueue_seqstream_head(queue->bigqueue, queue->list->next, temp))) {
-	 test->blkno = temp->blkno;
-	 test->bcount = temp->totalsize;
-         test->devno = temp->iolist->devno;
-         test->flags = temp->flags;
-	 delay = (temp->flags & READ) ? readdelay : writedelay;
-	 test->time = simtime + delay;
-	 if (ageweight) {
-	    tmp = temp->iolist;
-	    age = tmp->time;
-	    while (tmp) {
-	       if (tmp->time < age) {
-		  age = tmp->time;
-	       }
-	       tmp = tmp->next;
-	    }
-	    age = simtime - age;
-	 }
-	 if ((ageweight == 2) || 
-	     ((ageweight == 3) && 
-	      (test->flags & (TIME_CRITICAL | TIME_LIMITED)))) {
-	    delay -= age * weight * (double) 0.001;
+   if (sscanf(parline, "%d", numptr) != 1) {
+      for (sched = ioqueue_scheds; sched->name; sched++) {
+         if (strcmp(parline, sched->name) == 0) {
+            break;
          }
-	 if (delay < mintime) {
-	    if (posonly) {
-	       delay += disk_get_servtime(test->devno, test, checkcache, (mintime - delay));
-            } else {
-	       delay += disk_get_acctime(test->devno, test, (mintime - delay));
-	    }
-	    if (ageweight == 1) {
-	       delay *= (weight - age) / weight;
-	    }
-	    if (delay < mintime) {
-	       best = temp;
-	       mintime = delay;
-	    }
-	 }
       }
-      temp = temp->next;
+      if (sched->name == NULL) {
+         fprintf(stderr, "Unknown scheduling policy for '%s': %s\n", parname, parline);
+         exit(0);
+      }
+      *numptr = sched->number;
    }
-   addtoextraq((event *) test);
-/*
-fprintf (outputfile, "Selected request: %f, cylno %d, blkno %d, read %d, devno %d\n", mintime, best->cylinder, best->blkno, (best->flags & READ), best->iolist->devno);
-*/
-   return(best);
+   if ((required) && (ioqueue_sched(*numptr) == NULL)) {
+      fprintf(stderr, "Invalid value for '%s': %d\n", parname, *numptr);
+      exit(0);
+   }
+}
+
+
+void ioqueue_getparam_sched(parfile, parname, numptr, required)
+FILE *parfile;
+char *parname;
+int *numptr;
+int required;
+{
+   char line[201];
+   char value[81];
+
+   sprintf(line, "%s: %s\n", parname, "%80s");
+   if (fscanf(parfile, line, value) != 1) {
+      fprintf(stderr, "Error reading '%s'\n", parname);
+      exit(0);
+   }
+   ioqueue_scanparam_sched(value, parname, numptr, required);
+   fprintf (outputfile, "%s: %s\n", parname, value);
 }
 
 
@@ -1348,58 +3966,17 @@ subqueue *queue;
    int tmpdir;
 
    tmpdir = queue->dir;
+   decision_offered += queue->iobufcnt - queue->reqoutstanding;
    if ((queue->iobufcnt - queue->reqoutstanding) == 0) {
       return(NULL);
-   } else if (queue->iobufcnt == 1) {
+   } else if ((queue->iobufcnt == 1) && (!queue->sched->holds)) {
       if (READY_TO_GO(queue->list)) {
          temp = queue->list;
       } else {
          temp = NULL;
       }
    } else {
-      if (queue->sched_alg == FCFS) {
-         temp = ioqueue_get_request_from_fcfs_queue(queue);
-      } else if (queue->sched_alg == PRI_VSCAN_LBN) {
-         temp = ioqueue_get_request_from_pri_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno), queue->vscan_cyls);
-      } else if (queue->sched_alg == ELEVATOR_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno));
-      } else if (queue->sched_alg == CYCLE_LBN) {
-         temp = ioqueue_get_request_from_lbn_scan_queue(queue);
-      } else if (queue->sched_alg == SSTF_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, 0);
-      } else if (queue->sched_alg == ELEVATOR_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, disk_get_numcyls(queue->list->iolist->devno));
-      } else if (queue->sched_alg == CYCLE_CYL) {
-         temp = ioqueue_get_request_from_cyl_scan_queue(queue);
-      } else if (queue->sched_alg == SSTF_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, 0);
-      } else if (queue->sched_alg == SPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 0, TRUE);
-      } else if (queue->sched_alg == SPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 0, TRUE);
-      } else if (queue->sched_alg == SATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 0, FALSE);
-      } else if (queue->sched_alg == WPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 1, TRUE);
-      } else if (queue->sched_alg == WPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 1, TRUE);
-      } else if (queue->sched_alg == WATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 1, FALSE);
-      } else if (queue->sched_alg == ASPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 2, TRUE);
-      } else if (queue->sched_alg == ASPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 2, TRUE);
-      } else if (queue->sched_alg == PRI_ASPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 3, TRUE);
-      } else if (queue->sched_alg == PRI_ASPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 3, TRUE);
-      } else if (queue->sched_alg == ASATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 2, FALSE);
-      } else if (queue->sched_alg == VSCAN_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, queue->vscan_cyls);
-      } else if (queue->sched_alg == VSCAN_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, queue->vscan_cyls);
-      }
+      temp = (*queue->sched->peek)(queue);
    }
    queue->dir = tmpdir;
    if (temp == NULL) {
@@ -1422,7 +3999,7 @@ subqueue *queue;
       ret->prev = NULL;
       ret->bcount = temp->totalsize;
       ret->blkno = temp->blkno;
-      ret->flags = temp->flags;
+      ret->flags = temp->flags & ~IO_FLAG_TIMED;
       ret->busno = temp->iolist->busno;
       ret->slotno = temp->iolist->slotno;
       ret->devno = temp->iolist->devno;
@@ -1443,75 +4020,26 @@ subqueue *queue;
 /*
    ioqueue_print_subqueue_state(queue);
 */
+   decision_offered += queue->iobufcnt - queue->reqoutstanding;
    if ((queue->iobufcnt - queue->reqoutstanding) == 0) {
       return(NULL);
-   } else if (queue->iobufcnt == 1) {
+   } else if ((queue->iobufcnt == 1) && (!queue->sched->holds)) {
       if (READY_TO_GO(queue->list)) {
          temp = queue->list;
-         switch (queue->sched_alg) {
-	    case ELEVATOR_LBN:
-	    case PRI_VSCAN_LBN:
-	    case VSCAN_LBN:
-	       if (queue->lastblkno != temp->blkno) {
-	          queue->dir = (queue->lastblkno < temp->blkno) ? ASC : DESC;
-	       }
-	       break;
-   
-	    case ELEVATOR_CYL:
-	    case VSCAN_CYL:
-	       if (queue->lastcylno != temp->cylinder) {
-	          queue->dir = (queue->lastcylno < temp->cylinder) ? ASC : DESC;
-	       }
-	       break;
+         if (queue->sched->travel == TRAVEL_LBN) {
+	    if (queue->lastblkno != temp->blkno) {
+	       queue->dir = (queue->lastblkno < temp->blkno) ? ASC : DESC;
+	    }
+         } else if (queue->sched->travel == TRAVEL_CYL) {
+	    if (queue->lastcylno != temp->cylinder) {
+	       queue->dir = (queue->lastcylno < temp->cylinder) ? ASC : DESC;
+	    }
          }
       } else {                      /* !READY_TO_GO */
          temp = NULL;
       }
    } else {
-
-      if (queue->sched_alg == FCFS) {
-         temp = ioqueue_get_request_from_fcfs_queue(queue);
-      } else if (queue->sched_alg == PRI_VSCAN_LBN) {
-         temp = ioqueue_get_request_from_pri_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno), queue->vscan_cyls);
-      } else if (queue->sched_alg == ELEVATOR_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, disk_get_number_of_blocks(queue->list->iolist->devno));
-      } else if (queue->sched_alg == CYCLE_LBN) {
-         temp = ioqueue_get_request_from_lbn_scan_queue(queue);
-      } else if (queue->sched_alg == SSTF_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, 0);
-      } else if (queue->sched_alg == ELEVATOR_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, disk_get_numcyls(queue->list->iolist->devno));
-      } else if (queue->sched_alg == CYCLE_CYL) {
-         temp = ioqueue_get_request_from_cyl_scan_queue(queue);
-      } else if (queue->sched_alg == SSTF_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, 0);
-      } else if (queue->sched_alg == SPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 0, TRUE);
-      } else if (queue->sched_alg == SPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 0, TRUE);
-      } else if (queue->sched_alg == SATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 0, FALSE);
-      } else if (queue->sched_alg == WPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 1, TRUE);
-      } else if (queue->sched_alg == WPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 1, TRUE);
-      } else if (queue->sched_alg == WATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 1, FALSE);
-      } else if (queue->sched_alg == ASPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 2, TRUE);
-      } else if (queue->sched_alg == ASPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 2, TRUE);
-      } else if (queue->sched_alg == PRI_ASPTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, FALSE, 3, TRUE);
-      } else if (queue->sched_alg == PRI_ASPCTF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, TRUE, 3, TRUE);
-      } else if (queue->sched_alg == ASATF_OPT) {
-         temp = ioqueue_get_request_from_opt_sptf_queue(queue, 0, 2, FALSE);
-      } else if (queue->sched_alg == VSCAN_LBN) {
-         temp = ioqueue_get_request_from_lbn_vscan_queue(queue, queue->vscan_cyls);
-      } else if (queue->sched_alg == VSCAN_CYL) {
-         temp = ioqueue_get_request_from_cyl_vscan_queue(queue, queue->vscan_cyls);
-      }
+      temp = (*queue->sched->peek)(queue);
    }
 
    if (temp == NULL) {
@@ -1523,40 +4051,16 @@ subqueue *queue;
 /*
    fprintf (outputfile, "Selected request: blkno %d, cylno %d, surface %d\n", temp->blkno, temp->cylinder, temp->surface);
 */
-   switch (queue->sched_alg) {
-      case ELEVATOR_LBN:
-      case CYCLE_LBN:
-      case PRI_VSCAN_LBN:
-      case ELEVATOR_CYL:
-      case CYCLE_CYL:
-                         queue->lastblkno = temp->blkno;
-			 break;
-
-      case VSCAN_LBN:
-      case VSCAN_CYL:
-			 if (queue->vscan_cyls > 0) {
-                            queue->lastblkno = temp->blkno;
-			    break;
-			 }
-      case SSTF_LBN:
-                         if (queue->sched_alg != VSCAN_CYL) {
-			    queue->lastblkno = temp->blkno + temp->totalsize;
-			    if (queue->lastblkno != disk_get_number_of_blocks(temp->iolist->devno)) {
-			       break;
-			    }
-			 }
-      
-      default:
-                         queue->lastblkno = temp->blkno + temp->totalsize - 1;
-			 break;
-   }
+   (*queue->sched->pop)(queue, temp);
    ioqueue_get_cylinder_mapping(queue->bigqueue, temp, queue->lastblkno, &queue->lastcylno, &queue->lastsurface, -1);
    ioqueue_get_cylinder_mapping(queue->bigqueue, temp, queue->lastblkno, &queue->optcylno, &queue->optsurface, MAP_FULL);
    if (temp->starttime == -1.0) {
       temp->starttime = simtime;
    }
    ret = temp->iolist;
-   stat_update(&queue->instqueuelen, (double)(queue->iobufcnt - queue->reqoutstanding));
+   if (queue->bigqueue->printqueuestats) {
+      stat_update(&queue->instqueuelen, (double)(queue->iobufcnt - queue->reqoutstanding));
+   }
    queue->reqoutstanding++;
    queue->numoutstanding += temp->reqcnt;
    while (ret) {
@@ -1585,7 +4089,7 @@ subqueue *queue;
       ret->prev = NULL;
       ret->bcount = temp->totalsize;
       ret->blkno = temp->blkno;
-      ret->flags = temp->flags;
+      ret->flags = temp->flags & ~IO_FLAG_TIMED;
       ret->busno = temp->iolist->busno;
       ret->slotno = temp->iolist->slotno;
       ret->devno = temp->iolist->devno;
@@ -1621,6 +4125,34 @@ iobuf *curr;
 }
 
 
+/* Returns the first iobuf, in list order from start, that matches wanted */
+/* (or NULL).  The hash names every candidate, so the list is only walked */
+/* when more than one of them matches.                                    */
+
+iobuf * ioqueue_find_request(queue, wanted, start)
+subqueue *queue;
+ioreq_event *wanted;
+iobuf *start;
+{
+   iohashent *ent = queue->hash[IOQUEUE_HASH(wanted->blkno, wanted->opid)];
+   iobuf *found = NULL;
+
+   while (ent) {
+      if ((ent->blkno == wanted->blkno) && (ent->opid == wanted->opid) && (ent->buf != found) && (ioqueue_request_match(wanted, ent->buf))) {
+         if (found) {
+            while (ioqueue_request_match(wanted, start) == 0) {
+               start = start->next;
+            }
+            return(start);
+         }
+         found = ent->buf;
+      }
+      ent = ent->next;
+   }
+   return(found);
+}
+
+
 /* Note: use of this function with concat will result in iobuf containing
    the specified request */
 
@@ -1634,51 +4166,21 @@ ioreq_event *wanted;
    ioqueue_update_queue_statistics(queue);
    if ((queue->iobufcnt - queue->reqoutstanding) == 0) {
       return(NULL);
-   } else {
-      temp = queue->list;
-      while ((temp->next != queue->list) && (ioqueue_request_match(wanted, temp) == 0)) {
-	 temp = temp->next;
-      }
-   }
-   if (ioqueue_request_match(wanted, temp) == 0) {
+   } else if ((temp = ioqueue_find_request(queue, wanted, queue->list)) == NULL) {
       return(NULL);
    }
    ASSERT(READY_TO_GO(temp));
 
-   switch (queue->sched_alg) {
-      case ELEVATOR_LBN:
-      case CYCLE_LBN:
-      case PRI_VSCAN_LBN:
-      case ELEVATOR_CYL:
-      case CYCLE_CYL:
-                         queue->lastblkno = temp->blkno;
-                         break;
-
-      case VSCAN_LBN:
-      case VSCAN_CYL:
-                         if (queue->vscan_cyls > 0) {
-                            queue->lastblkno = temp->blkno;
-                            break;
-                         }
-      case SSTF_LBN:
-                         if (queue->sched_alg != VSCAN_CYL) {
-                            queue->lastblkno = temp->blkno + temp->totalsize;
-                            if (queue->lastblkno != disk_get_number_of_blocks(temp->iolist->devno)) {
-                               break;
-                            }
-                         }
-
-      default:
-                         queue->lastblkno = temp->blkno + temp->totalsize - 1;
-                         break;
-   }
+   (*queue->sched->pop)(queue, temp);
    ioqueue_get_cylinder_mapping(queue->bigqueue, temp, queue->lastblkno, &queue->lastcylno, &queue->lastsurface, -1);
    ioqueue_get_cylinder_mapping(queue->bigqueue, temp, queue->lastblkno, &queue->optcylno, &queue->optsurface, MAP_FULL);
    if (temp->starttime == -1.0) {
       temp->starttime = simtime;
    }
    ret = temp->iolist;
-   stat_update(&queue->instqueuelen, (double)(queue->iobufcnt - queue->reqoutstanding));
+   if (queue->bigqueue->printqueuestats) {
+      stat_update(&queue->instqueuelen, (double)(queue->iobufcnt - queue->reqoutstanding));
+   }
    queue->reqoutstanding++;
    queue->numoutstanding += temp->reqcnt;
    while (ret) {
@@ -1701,7 +4203,7 @@ ioreq_event *wanted;
       ret->prev = NULL;
       ret->bcount = temp->totalsize;
       ret->blkno = temp->blkno;
-      ret->flags = temp->flags;
+      ret->flags = temp->flags & ~IO_FLAG_TIMED;
       ret->busno = temp->iolist->busno;
       ret->slotno = temp->iolist->slotno;
       ret->devno = temp->iolist->devno;
@@ -1718,17 +4220,12 @@ ioreq_event * ioqueue_set_starttime_in_subqueue(queue, target)
 subqueue *queue;
 ioreq_event *target;
 {
-   iobuf *temp = queue->list;
+   iobuf *temp;
    ioreq_event *ret;
 
    if ((queue->iobufcnt - queue->reqoutstanding) == 0) {
       return(NULL);
-   } else {
-      while ((temp->next != queue->list) && (!ioqueue_request_match(target, temp))) {
-         temp = temp->next;
-      }
-   }
-   if (!ioqueue_request_match(target, temp)) {
+   } else if ((temp = ioqueue_find_request(queue, target, queue->list)) == NULL) {
       return(NULL);
    }
    ASSERT(temp->state == WAITING);
@@ -1745,7 +4242,6 @@ subqueue *queue;
 ioreq_event *done;
 {
    iobuf *tmp;
-   iobuf *tail;
    ioreq_event *trv;
 /*
 fprintf (outputfile, "Entering remove_completed_request - %d\n", queue->listlen);
@@ -1754,16 +4250,15 @@ fprintf (outputfile, "Entering remove_completed_request - %d\n", queue->listlen)
    tmp = queue->current;
    /* NOTE- the following match will fail with concat unless fixed properly */
    if ((tmp->state != PENDING) || (ioqueue_request_match(done, tmp) == 0)) {
-      tmp = queue->list->next;
-      tail = queue->list;
-      while ((tmp != tail) && (ioqueue_request_match(done, tmp) == 0)) {
-	 tmp = tmp->next;
-      }
-      if ((tmp->state != PENDING) || (ioqueue_request_match(done, tmp) == 0)) {
-	 fprintf(stderr, "Completed event not found pending in ioqueue - blkno %d, tmp->blkno %d, tmp->totalsize %d, %d, %d, %d, %d\n", done->blkno, tmp->blkno, tmp->totalsize, (tmp == NULL), done->opid, tmp->opid, done->bcount);
+      tmp = ioqueue_find_request(queue, done, queue->list->next);
+      if ((tmp == NULL) || (tmp->state != PENDING)) {
+	 fprintf(stderr, "Completed event not found pending in ioqueue - blkno %lld, %d, %d, %d\n", done->blkno, (tmp == NULL), done->opid, done->bcount);
 	 exit(0);
       }
    }
+   if (queue->sched->complete) {
+      (*queue->sched->complete)(queue, tmp);
+   }
    ioqueue_remove_from_subqueue(queue, tmp);
    if (tmp->reqcnt == 1) {
       trv = done;
@@ -1781,6 +4276,9 @@ fprintf (outputfile, "Entering remove_completed_request - %d\n", queue->listlen)
       stat_update(&queue->accstats, (simtime - tmp->starttime));
       lastphystime = simtime - tmp->starttime;
       stat_update(&queue->outtimestats, (simtime - tmp->iob_un.time));
+      if (queue->bigqueue->respbatch) {
+         stat_batch_update(queue->bigqueue->respbatch, (simtime - tmp->iob_un.time));
+      }
       if (tmp->flags & READ) {
          if (tmp->flags & TIME_CRITICAL) {
             stat_update(&queue->critreadstats, (simtime - tmp->iob_un.time));
@@ -1808,6 +4306,9 @@ fprintf (outputfile, "Entering remove_completed_request - %d\n", queue->listlen)
          stat_update(&queue->accstats, (simtime - tmp->starttime));
          lastphystime = simtime - tmp->starttime;
          stat_update(&queue->outtimestats, (simtime - trv->time));
+         if (queue->bigqueue->respbatch) {
+            stat_batch_update(queue->bigqueue->respbatch, (simtime - trv->time));
+         }
          if (trv->flags & READ) {
             if (trv->flags & TIME_CRITICAL) {
                stat_update(&queue->critreadstats, (simtime - trv->time));
@@ -1907,16 +4408,72 @@ fprintf (outputfile, "Exiting ioqueue_set_starttime: %x\n", tmp);
 }
 
 
+/* Scheduling decision cost accounting.  Each call to show or get the  */
+/* next request that offers the policies at least one waiting request  */
+/* counts as a decision.  Its candidates are the waiting requests of   */
+/* the subqueues consulted, and its estimates and positionings are     */
+/* the disk's counts of the service time estimates handed out and the  */
+/* mechanical positionings computed meanwhile (including any done by   */
+/* the owner's enablement check), so the SPTF family's pruning shows   */
+/* up as fewer positionings per candidate.  The wall time of the       */
+/* decision is taken from the monotonic clock (not the heartbeat's     */
+/* time of day, whose resolution is far too coarse) and recorded in    */
+/* microseconds.  The counts are doubles, as over a long run they can  */
+/* exceed an int.                                                      */
+
+typedef struct {
+   struct timespec	start;
+   double		estimates;
+   double		positionings;
+} decisioncost;
+
+
+void ioqueue_decision_begin(queue, cost)
+ioqueue *queue;
+decisioncost *cost;
+{
+   decision_offered = 0;
+   if (queue->printdecisionstats) {
+      disk_get_estimate_counts(&cost->estimates, &cost->positionings);
+      clock_gettime(CLOCK_MONOTONIC, &cost->start);
+   }
+}
+
+
+void ioqueue_decision_end(queue, cost)
+ioqueue *queue;
+decisioncost *cost;
+{
+   struct timespec end;
+   long long nsecs;
+   double estimates;
+   double positionings;
+
+   if ((queue->printdecisionstats) && (decision_offered > 0)) {
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      nsecs = ((long long) (end.tv_sec - cost->start.tv_sec) * 1000000000LL) + (long long) (end.tv_nsec - cost->start.tv_nsec);
+      disk_get_estimate_counts(&estimates, &positionings);
+      queue->decisions += 1.0;
+      queue->candidates += (double) decision_offered;
+      queue->estimates += estimates - cost->estimates;
+      queue->positionings += positionings - cost->positionings;
+      stat_update(&queue->decisiontime, ((double) nsecs / (double) 1000.0));
+   }
+}
+
+
 ioreq_event * ioqueue_show_next_request(queue, enablement_in)
 ioqueue *queue;
 int (*enablement_in)();
 {
    ioreq_event *tmp = NULL;
+   decisioncost cost;
 
 /*
 fprintf (outputfile, "Entering ioqueue_show_next_request\n");
 */
    enablement = enablement_in;
+   ioqueue_decision_begin(queue, &cost);
 
    if ((queue->priority.listlen - queue->priority.numoutstanding) > 0) {
       tmp = ioqueue_show_next_request_from_subqueue(&queue->priority);
@@ -1930,6 +4487,7 @@ fprintf (outputfile, "Entering ioqueue_show_next_request\n");
 /*
 fprintf (outputfile, "Exiting ioqueue_show_next_request: %d\n", ((tmp) ? tmp->blkno : -1));
 */
+   ioqueue_decision_end(queue, &cost);
    enablement = NULL;
    return(tmp);
 }
@@ -1940,10 +4498,12 @@ ioqueue *queue;
 int (*enablement_in)();
 {
    ioreq_event *tmp = NULL;
+   decisioncost cost;
 /*
 fprintf (outputfile, "Entering ioqueue_get_next_request\n");
 */
    enablement = enablement_in;
+   ioqueue_decision_begin(queue, &cost);
 
    if ((queue->priority.listlen - queue->priority.numoutstanding) > 0) {
       if ((tmp = ioqueue_get_next_request_from_subqueue(&queue->priority))) {
@@ -1961,15 +4521,12 @@ fprintf (outputfile, "Entering ioqueue_get_next_request\n");
       }
    }
    if (tmp) {
-      int numout = queue->base.numoutstanding + queue->timeout.numoutstanding + queue->priority.numoutstanding;
-      if (numout > queue->maxoutstanding) {
-         queue->maxoutstanding = numout;
-      }
       tmp->time = 0.0;
    }
 /*
 fprintf (outputfile, "Exiting ioqueue_get_next_request: %d\n", ((tmp) ? tmp->blkno : -1));
 */
+   ioqueue_decision_end(queue, &cost);
    enablement = NULL;
    return(tmp);
 }
@@ -1999,42 +4556,21 @@ fprintf (outputfile, "Entering ioqueue_add_new_request: %d\n", new->blkno);
    tmp->flags = new->flags;
    tmp->iolist = new;
    new->next = NULL;
-   tmp->iob_un.pend.waittime = 0;
+   tmp->iob_un.pend.arrtick = queue->ticks;
    tmp->iob_un.pend.concat = NULL;
    tmp->reqcnt = 1;
    tmp->opid = new->opid;
    switch(queue->pri_scheme) {
       case ALLEQUAL:
-         if ((queue->base.sched_alg == ELEVATOR_LBN) || 
-             (queue->base.sched_alg == CYCLE_LBN)    || 
-             (queue->base.sched_alg == SSTF_LBN)     || 
-             (queue->base.sched_alg == VSCAN_LBN)) {
-           ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, MAP_NONE);
-         } else {
-           ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, -1);
-         }
+         ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, queue->base.sched->cylmap);
 	 ioqueue_insert_new_request(&queue->base, tmp);
 	 break;
       case TWOQUEUE:
          if (new->flags & (TIME_CRITICAL|TIME_LIMITED)) {
-            if ((queue->priority.sched_alg == ELEVATOR_LBN) || 
-                (queue->priority.sched_alg == CYCLE_LBN)    || 
-                (queue->priority.sched_alg == SSTF_LBN)     || 
-                (queue->priority.sched_alg == VSCAN_LBN)) {
-              ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, MAP_NONE);
-            } else {
-              ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, -1);
-            }
+            ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, queue->priority.sched->cylmap);
             ioqueue_insert_new_request(&queue->priority, tmp);
          } else {
-            if ((queue->base.sched_alg == ELEVATOR_LBN) || 
-                (queue->base.sched_alg == CYCLE_LBN)    || 
-                (queue->base.sched_alg == SSTF_LBN)     || 
-                (queue->base.sched_alg == VSCAN_LBN)) {
-              ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, MAP_NONE);
-            } else {
-              ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, -1);
-            }
+            ioqueue_get_cylinder_mapping(queue, tmp, tmp->blkno, &tmp->cylinder, &tmp->surface, queue->base.sched->cylmap);
 	    ioqueue_insert_new_request(&queue->base, tmp);
          }
 	 break;
@@ -2043,12 +4579,14 @@ fprintf (outputfile, "Entering ioqueue_add_new_request: %d\n", new->blkno);
 	 exit(0);
    }
    listlen = queue->base.listlen + queue->timeout.listlen + queue->priority.listlen;
-   qlen = listlen - (queue->base.numoutstanding + queue->timeout.numoutstanding + queue->priority.numoutstanding);
-   readlen = queue->base.readlen + queue->timeout.readlen + queue->priority.readlen;
-   queue->maxlistlen = max(listlen, queue->maxlistlen);
-   queue->maxqlen = max(qlen, queue->maxqlen);
-   queue->maxreadlen = max(readlen, queue->maxreadlen);
-   queue->maxwritelen = max((listlen - readlen), queue->maxwritelen);
+   if (queue->printqueuestats) {
+      qlen = listlen - (queue->base.numoutstanding + queue->timeout.numoutstanding + queue->priority.numoutstanding);
+      readlen = queue->base.readlen + queue->timeout.readlen + queue->priority.readlen;
+      queue->maxlistlen = max(listlen, queue->maxlistlen);
+      queue->maxqlen = max(qlen, queue->maxqlen);
+      queue->maxreadlen = max(readlen, queue->maxreadlen);
+      queue->maxwritelen = max((listlen - readlen), queue->maxwritelen);
+   }
    if (listlen == 1) {
       stat_update(&queue->idlestats, (simtime - queue->idlestart));
    }
@@ -2162,109 +4700,108 @@ int opid;
 }
 
 
-int ioqueue_implement_timeouts(queue, timeout, maxtime, flag)
+/* Returns < 0 if a comes before b in queue's list, > 0 if after */
+
+int ioqueue_list_compare(queue, a, b)
+subqueue *queue;
+iobuf *a;
+iobuf *b;
+{
+   if (IOQUEUE_ORDERED(queue)) {
+      return(ioqueue_tree_compare(a, b));
+   }
+   return((int) (a->treeseq - b->treeseq));
+}
+
+
+/* Moves the waiting requests whose deadlines have passed from queue to   */
+/* timeout, in list order.  The expired entries are collected in the heap */
+/* slots they vacate, from queue->heaplen up.                             */
+
+int ioqueue_implement_timeouts(queue, timeout, flag)
 subqueue *queue;
 subqueue *timeout;
-int maxtime;
 u_int flag;
 {
-   iobuf *tmp;
+   iodeadline *expired;
+   iodeadline entry;
    iobuf *done;
    ioreq_event *trv;
    int timeouts = 0;
    int iocnt;
-
-   if (queue->list == NULL) {
-      return (0);
-   }
-   tmp = queue->list->next;
-   while (tmp != queue->list) {
-      tmp->iob_un.pend.waittime++;
-/*
-fprintf (outputfile, "New waittime for opid %d is %d, maxtime %d\n", tmp->opid, tmp->iob_un.pend.waittime, maxtime);
-*/
-      if ((tmp->iob_un.pend.waittime > maxtime) && (tmp->state == WAITING)) {
-/*
-fprintf (outputfile, "Inside one of the request moving sections 1 - blkno %d, state %d\n", tmp->blkno, tmp->state);
-*/
-	 done = tmp;
-	 tmp = tmp->next;
-         ioqueue_update_queue_statistics(queue);
-	 ioqueue_remove_from_subqueue(queue, done);
-	 ioqueue_insert_new_request(timeout, done);
-         done->flags |= flag;
-	 trv = done->iolist;
-	 while (trv != NULL) {
-	    trv->flags |= flag;
-	    trv = trv->next;
-	 }
-	 iocnt = done->reqcnt;
-	 queue->iobufcnt--;
-	 queue->listlen -= iocnt;
-	 if (done->flags & READ) {
-	    queue->numreads -= iocnt;
-	    queue->readlen -= iocnt;
-         } else {
-	    queue->numwrites -= iocnt;
-	 }
-	 timeouts += iocnt;
-	 timeout->switches += iocnt;
-	 if (queue->listlen == 0) {
-	    tmp = NULL;
-	 }
-      } else {
-         tmp = tmp->next;
+   int count = 0;
+   int i, j;
+
+   while ((queue->heaplen > 0) && (queue->heap[0].deadline <= queue->bigqueue->ticks)) {
+      entry = queue->heap[0];
+      ioqueue_deadline_remove(queue, entry.buf);
+      queue->heap[queue->heaplen] = entry;
+      count++;
+   }
+   expired = &queue->heap[queue->heaplen];
+   for (i = 1; i < count; i++) {
+      entry = expired[i];
+      for (j = i; (j > 0) && (ioqueue_list_compare(queue, expired[(j-1)].buf, entry.buf) > 0); j--) {
+         expired[j] = expired[(j-1)];
       }
+      expired[j] = entry;
    }
-   if (tmp != NULL) {
-      tmp->iob_un.pend.waittime++;
-/*
-fprintf (outputfile, "New waittime for opid %d is %d, maxtime %d\n", tmp->opid, tmp->iob_un.pend.waittime, maxtime);
-*/
-      if ((tmp->iob_un.pend.waittime > maxtime) && (tmp->state == WAITING)) {
+   for (i = 0; i < count; i++) {
+      done = expired[i].buf;
+      if (done->state != WAITING) {
+         continue;
+      }
 /*
-fprintf (outputfile, "Inside one of the request moving sections 2 - blkno %d, state %d\n", tmp->blkno, tmp->state);
+fprintf (outputfile, "Moving timed out request - blkno %d, deadline %d\n", done->blkno, expired[i].deadline);
 */
-	 done = tmp;
-         ioqueue_update_queue_statistics(queue);
-	 ioqueue_remove_from_subqueue(queue, done);
-	 ioqueue_insert_new_request(timeout, done);
-	 done->flags |= flag;
-	 trv = done->iolist;
-	 while (trv != NULL) {
-	    trv->flags |= flag;
-	    trv = trv->next;
-	 }
-	 iocnt = done->reqcnt;
-	 queue->iobufcnt--;
-	 queue->listlen -= iocnt;
-	 if (done->flags & READ) {
-	    queue->numreads -= iocnt;
-	    queue->readlen -= iocnt;
-         } else {
-	    queue->numwrites -= iocnt;
-	 }
-	 timeouts += iocnt;
-         timeout->switches += iocnt;
+      ioqueue_update_queue_statistics(queue);
+      ioqueue_remove_from_subqueue(queue, done);
+      ioqueue_insert_new_request(timeout, done);
+      done->flags |= flag;
+      trv = done->iolist;
+      while (trv != NULL) {
+         trv->flags |= flag;
+         trv = trv->next;
+      }
+      iocnt = done->reqcnt;
+      queue->iobufcnt--;
+      queue->listlen -= iocnt;
+      if (done->flags & READ) {
+         queue->numreads -= iocnt;
+         queue->readlen -= iocnt;
+      } else {
+         queue->numwrites -= iocnt;
       }
+      timeouts += iocnt;
+      timeout->switches += iocnt;
    }
    return(timeouts);
 }
 
 
+void ioqueue_sched_tick(queue)
+subqueue *queue;
+{
+   if ((queue->sched) && (queue->sched->tick)) {
+      (*queue->sched->tick)(queue);
+   }
+}
+
+
 double ioqueue_tick(queue)
 ioqueue *queue;
 {
    int timeouts;
    int readcnt;
 
+   queue->ticks++;
    if (queue->to_scheme == BASETIMEOUT) {
       if (queue->pri_scheme == ALLEQUAL) {
 /*
 fprintf(outputfile, "base queue to timeout queue\n");
 */
          readcnt = queue->timeout.numreads;
-         timeouts = ioqueue_implement_timeouts(&queue->base, &queue->timeout, queue->to_time, TIMED_OUT);
+         timeouts = ioqueue_implement_timeouts(&queue->base, &queue->timeout, TIMED_OUT);
          queue->timeouts += timeouts;
          queue->timeoutreads += queue->timeout.numreads - readcnt;
       } else {
@@ -2272,7 +4809,7 @@ fprintf(outputfile, "base queue to timeout queue\n");
 fprintf(outputfile, "base queue to priority queue\n");
 */
          readcnt = queue->priority.numreads;
-         timeouts = ioqueue_implement_timeouts(&queue->base, &queue->priority, queue->to_time, TIMED_OUT);
+         timeouts = ioqueue_implement_timeouts(&queue->base, &queue->priority, TIMED_OUT);
          queue->timeouts += timeouts;
          queue->timeoutreads += queue->priority.numreads - readcnt;
       }
@@ -2281,40 +4818,52 @@ fprintf(outputfile, "base queue to priority queue\n");
 fprintf(outputfile, "timeout queue to priority queue\n");
 */
       readcnt = queue->priority.numreads;
-      timeouts = ioqueue_implement_timeouts(&queue->timeout, &queue->priority, queue->to_time, TIMED_OUT);
+      timeouts = ioqueue_implement_timeouts(&queue->timeout, &queue->priority, TIMED_OUT);
       queue->timeouts += timeouts;
       queue->timeoutreads += queue->priority.numreads - readcnt;
 /*
 fprintf(outputfile, "base queue to timeout queue\n");
 */
       readcnt = queue->timeout.numreads;
-      timeouts = ioqueue_implement_timeouts(&queue->base, &queue->timeout, (queue->to_time / 2), HALF_OUT);
+      timeouts = ioqueue_implement_timeouts(&queue->base, &queue->timeout, HALF_OUT);
       queue->halfouts += timeouts;
       queue->halfoutreads += queue->timeout.numreads - readcnt;
    }
+   ioqueue_sched_tick(&queue->base);
+   ioqueue_sched_tick(&queue->timeout);
+   ioqueue_sched_tick(&queue->priority);
    return(0.0);
 }
 
 
+/* Completes along with ret the waiting requests for exactly its       */
+/* blocks (only reads, if it is a read) that arrived by arrtimemax,    */
+/* finding them through the LBN index.  Only iobufs holding a single   */
+/* request qualify: one with others concatenated onto it (as happens   */
+/* readily while a policy such as ANTICIPATORY holds the queue idle)   */
+/* can cover ret's blocks without any of its requests matching them.   */
+
 void ioqueue_clobber_overlaps_subqueue(queue, ret, arrtimemax)
 subqueue *queue;
 ioreq_event *ret;
 double arrtimemax;
 {
    iobuf *tmp;
+   iolbnent *ent;
    ioreq_event *done;
    int read = ret->flags & READ;
-   while ((tmp = queue->list)) {
-      if ((tmp->state != WAITING) || (tmp->blkno != ret->blkno) || (tmp->totalsize != ret->bcount) || ((read) && !(tmp->flags & READ)) || (tmp->iolist->time > arrtimemax)) {
-         tmp = tmp->next;
-         while ((tmp != queue->list) && ((tmp->state != WAITING) || (tmp->blkno != ret->blkno) || (tmp->totalsize != ret->bcount) || ((read) && !(tmp->flags & READ)) || (tmp->iolist->time > arrtimemax))) {
-            tmp = tmp->next;
-         }
-         if (tmp == queue->list) {
-            return;
+
+   while (TRUE) {
+      ent = NULL;
+      while ((ent = ioqueue_lbn_find(queue->lbnindex, ret->blkno, ret->blkno, ent))) {
+         tmp = ent->buf;
+         if ((tmp->state == WAITING) && (tmp->reqcnt == 1) && (tmp->blkno == ret->blkno) && (tmp->totalsize == ret->bcount) && ((!read) || (tmp->flags & READ)) && (tmp->iolist->time <= arrtimemax)) {
+            break;
          }
       }
-      ASSERT(tmp->reqcnt == 1);
+      if (ent == NULL) {
+         return;
+      }
       done = ioqueue_get_specific_request_from_subqueue(queue, tmp->iolist);
       ASSERT(done != NULL);
       done = ioqueue_remove_completed_request(queue, done);
@@ -2380,8 +4929,15 @@ subqueue *queue;
 subqueue *new;
 {
    new->sched_alg = queue->sched_alg;
+   new->sched = NULL;
+   new->schedpriv = NULL;
    new->surfoverforw = queue->surfoverforw;
    new->list = NULL;
+   new->tree = NULL;
+   bzero((char *) new->hash, sizeof(new->hash));
+   new->lbnindex = NULL;
+   new->heap = NULL;
+   new->heapsize = 0;
    new->current = NULL;
 }
 
@@ -2411,17 +4967,66 @@ ioqueue *queue;
    new->printidlestats = queue->printidlestats;
    new->printintarrstats = queue->printintarrstats;
    new->printsizestats = queue->printsizestats;
+   new->printdecisionstats = queue->printdecisionstats;
    return(new);
 }
 
 
+/* Reads a non-negative time (in ms) for a parameter override */
+
+void ioqueue_scanparam_time(parline, parname, parptr)
+char *parline;
+char *parname;
+double *parptr;
+{
+   if (sscanf(parline, "%lf", parptr) != 1) {
+      fprintf(stderr, "Error reading '%s'\n", parname);
+      exit(0);
+   }
+   if (*parptr < 0.0) {
+      fprintf(stderr, "Invalid value for '%s': %f\n", parname, *parptr);
+      exit(0);
+   }
+}
+
+
+/* Reads a "flow:weight" pair into the fair queueing weight table */
+
+void ioqueue_scanparam_weight(parline, parname)
+char *parline;
+char *parname;
+{
+   int flow;
+   double weight;
+   int size;
+
+   if (sscanf(parline, "%d:%lf", &flow, &weight) != 2) {
+      fprintf(stderr, "Error reading '%s'\n", parname);
+      exit(0);
+   }
+   if ((flow < 0) || (flow >= FQ_MAXFLOWS) || (weight <= 0.0)) {
+      fprintf(stderr, "Invalid value for '%s': %s\n", parname, parline);
+      exit(0);
+   }
+   if (flow >= fq_numweights) {
+      size = max((flow + 1), (2 * fq_numweights));
+      fq_weights = (double *) realloc(fq_weights, (size * sizeof(double)));
+      ASSERT(fq_weights != NULL);
+      while (fq_numweights < size) {
+         fq_weights[fq_numweights++] = 0.0;
+      }
+   }
+   fq_weights[flow] = weight;
+}
+
+
 void ioqueue_param_override(queue, paramname, paramval)
 ioqueue *queue;
 char *paramname;
 char *paramval;
 {
    if (strcmp(paramname, "ioqueue_schedalg") == 0) {
-      scanparam_int(paramval, paramname, &queue->base.sched_alg, 3, MINSCHED, MAXSCHED);
+      ioqueue_scanparam_sched(paramval, paramname, &queue->base.sched_alg, TRUE);
    } else if (strcmp(paramname, "ioqueue_cylmaptype") == 0) {
       scanparam_int(paramval, paramname, &queue->cylmaptype, 3, MAP_NONE, MAXMAPTYPE);
    } else if (strcmp(paramname, "ioqueue_seqscheme") == 0) {
@@ -2429,11 +5034,33 @@ char *paramval;
    } else if (strcmp(paramname, "ioqueue_to_time") == 0) {
       scanparam_int(paramval, paramname, &queue->to_time, 1, 0, 0);
    } else if (strcmp(paramname, "ioqueue_priority_schedalg") == 0) {
-      scanparam_int(paramval, paramname, &queue->priority.sched_alg, 3, MINSCHED, MAXSCHED);
+      ioqueue_scanparam_sched(paramval, paramname, &queue->priority.sched_alg, TRUE);
    } else if (strcmp(paramname, "ioqueue_timeout_schedalg") == 0) {
-      scanparam_int(paramval, paramname, &queue->timeout.sched_alg, 3, MINSCHED, MAXSCHED);
+      ioqueue_scanparam_sched(paramval, paramname, &queue->timeout.sched_alg, TRUE);
    } else if (strcmp(paramname, "ioqueue_priority_mix") == 0) {
       scanparam_int(paramval, paramname, &priority_mix, 1, 0, 0);
+   } else if (strcmp(paramname, "ioqueue_read_expire") == 0) {
+      ioqueue_scanparam_time(paramval, paramname, &deadline_read_expire);
+   } else if (strcmp(paramname, "ioqueue_write_expire") == 0) {
+      ioqueue_scanparam_time(paramval, paramname, &deadline_write_expire);
+   } else if (strcmp(paramname, "ioqueue_fifo_batch") == 0) {
+      scanparam_int(paramval, paramname, &deadline_fifo_batch, 1, 1, 0);
+   } else if (strcmp(paramname, "ioqueue_writes_starved") == 0) {
+      scanparam_int(paramval, paramname, &deadline_writes_starved, 1, 0, 0);
+   } else if (strcmp(paramname, "ioqueue_antic_expire") == 0) {
+      ioqueue_scanparam_time(paramval, paramname, &antic_expire);
+   } else if (strcmp(paramname, "ioqueue_fq_budget") == 0) {
+      scanparam_int(paramval, paramname, &fq_budget, 1, 1, 0);
+   } else if (strcmp(paramname, "ioqueue_fq_slice") == 0) {
+      ioqueue_scanparam_time(paramval, paramname, &fq_slice);
+   } else if (strcmp(paramname, "ioqueue_fq_weight") == 0) {
+      ioqueue_scanparam_weight(paramval, paramname);
+   } else if (strcmp(paramname, "ioqueue_lookahead_depth") == 0) {
+      scanparam_int(paramval, paramname, &lookahead_depth, 3, 1, LOOKAHEAD_MAXDEPTH);
+   } else if (strcmp(paramname, "ioqueue_lookahead_beam") == 0) {
+      scanparam_int(paramval, paramname, &lookahead_beam, 1, 1, 0);
+   } else if (strcmp(paramname, "ioqueue_printdecisionstats") == 0) {
+      scanparam_int(paramval, paramname, &queue->printdecisionstats, 3, 0, 1);
    } else {
       fprintf(stderr, "Unsupported param override at ioqueue_param_override: %s\n", paramname);
       exit(0);
@@ -2448,13 +5075,11 @@ subqueue *queue;
    queue->numwrites = 0;
    queue->switches = 0;
    queue->runreadlen = 0.0;
-   queue->maxreadlen = 0;
-   queue->maxwritelen = 0;
    queue->maxlistlen = 0;
    queue->runlistlen = 0.0;
    queue->maxqlen = 0;
+   ioqueue_update_queue_maxima(queue);
    queue->numcomplete = 0;
-   queue->maxoutstanding = 0;
    queue->runoutstanding = 0.0;
    queue->sstfupdowncnt = 0;
    queue->lastalt = simtime;
@@ -2467,6 +5092,9 @@ subqueue *queue;
    stat_reset(&queue->nocritwritestats);
    stat_reset(&queue->instqueuelen);
    stat_reset(&queue->infopenalty);
+   if ((queue->sched) && (queue->sched->resetstats)) {
+      (*queue->sched->resetstats)(queue);
+   }
 }
 
 
@@ -2475,6 +5103,11 @@ subqueue *queue;
 int devno;
 {
    addlisttoextraq(&queue->list);
+   ioqueue_hash_clear(queue);
+   ioqueue_lbn_clear(queue);
+   queue->heaplen = 0;
+   queue->tree = NULL;
+   queue->treeseq = 0;
    queue->dir = ASC;
    queue->lastblkno = 0;
    queue->lastsurface = 0;
@@ -2496,10 +5129,11 @@ int devno;
    stat_initialize(statdeffile, statdesc_outtimestats, &queue->nocritwritestats);
    stat_initialize(statdeffile, statdesc_instqueuelen, &queue->instqueuelen);
    stat_initialize(statdeffile, statdesc_infopenalty, &queue->infopenalty);
-   if ((queue->sched_alg == VSCAN_LBN) || (queue->sched_alg == PRI_VSCAN_LBN)) {
-      queue->vscan_cyls = vscan_value * (double) disk_get_number_of_blocks(devno);
-   } else {
-      queue->vscan_cyls = vscan_value * (double) disk_get_numcyls(devno);
+   queue->vscan_cyls = vscan_value * (double) disk_get_numcyls(devno);
+   queue->sched = ioqueue_sched(queue->sched_alg);
+   queue->schedpriv = NULL;
+   if ((queue->sched) && (queue->sched->initialize)) {
+      (*queue->sched->initialize)(queue, devno);
    }
 }
 
@@ -2514,7 +5148,6 @@ ioqueue *queue;
    queue->idlestart = simtime;
    queue->maxlistlen = 0;
    queue->maxqlen = 0;
-   queue->maxoutstanding = 0;
    queue->maxreadlen = 0;
    queue->maxwritelen = 0;
    queue->overlapscombed = 0;
@@ -2528,6 +5161,13 @@ ioqueue *queue;
    stat_reset(&queue->reqsizestats);
    stat_reset(&queue->readsizestats);
    stat_reset(&queue->writesizestats);
+   queue->decisions = 0.0;
+   queue->candidates = 0.0;
+   queue->estimates = 0.0;
+   queue->positionings = 0.0;
+   if (queue->printdecisionstats) {
+      stat_reset(&queue->decisiontime);
+   }
    ioqueue_subqueue_resetstats(&queue->base);
    ioqueue_subqueue_resetstats(&queue->timeout);
    ioqueue_subqueue_resetstats(&queue->priority);
@@ -2550,8 +5190,12 @@ int devno;
    queue->idlework = NULL;
    queue->idledelay = 0.0;
    queue->idledetect = NULL;
+   queue->wakeup = NULL;
+   queue->respbatch = NULL;
+   queue->sptf = NULL;
    queue->sectpercyl = disk_get_avg_sectpercyl(devno);
    queue->lastsubqueue = IOQUEUE_BASE;
+   queue->ticks = 0;
    queue->lastarr = 0.0;
    queue->lastread = 0.0;
    queue->lastwrite = 0.0;
@@ -2563,6 +5207,10 @@ int devno;
    stat_initialize(statdeffile, statdesc_reqsizestats, &queue->reqsizestats);
    stat_initialize(statdeffile, statdesc_readsizestats, &queue->readsizestats);
    stat_initialize(statdeffile, statdesc_writesizestats, &queue->writesizestats);
+   if (queue->printdecisionstats) {
+      stat_initialize(statdeffile, statdesc_decisiontime, &queue->decisiontime);
+   }
+   ioqueue_resetstats(queue);
 }
 
 
@@ -2598,14 +5246,33 @@ int printsizestats;
    queue->printidlestats = printidlestats;
    queue->printintarrstats = printintarrstats;
    queue->printsizestats = printsizestats;
+   queue->printdecisionstats = FALSE;
    queue->base.list = NULL;
    queue->timeout.list = NULL;
    queue->priority.list = NULL;
+   queue->base.tree = NULL;
+   queue->timeout.tree = NULL;
+   queue->priority.tree = NULL;
+   queue->base.lbnindex = NULL;
+   queue->timeout.lbnindex = NULL;
+   queue->priority.lbnindex = NULL;
+   queue->base.sched = NULL;
+   queue->timeout.sched = NULL;
+   queue->priority.sched = NULL;
+   bzero((char *) queue->base.hash, sizeof(queue->base.hash));
+   bzero((char *) queue->timeout.hash, sizeof(queue->timeout.hash));
+   bzero((char *) queue->priority.hash, sizeof(queue->priority.hash));
+   queue->base.heap = NULL;
+   queue->timeout.heap = NULL;
+   queue->priority.heap = NULL;
+   queue->base.heapsize = 0;
+   queue->timeout.heapsize = 0;
+   queue->priority.heapsize = 0;
    queue->base.surfoverforw = global_surfoverforw;
    queue->timeout.surfoverforw = global_surfoverforw;
    queue->priority.surfoverforw = global_surfoverforw;
 
-   getparam_int(parfile, "Scheduling policy", &queue->base.sched_alg, 3, MINSCHED, MAXSCHED);
+   ioqueue_getparam_sched(parfile, "Scheduling policy", &queue->base.sched_alg, TRUE);
    getparam_int(parfile, "Cylinder mapping strategy", &queue->cylmaptype, 3, MAP_NONE, MAXMAPTYPE);
    getparam_double(parfile, "Write initiation delay", &queue->writedelay, 1, (double) 0.0, (double) 0.0);
    getparam_double(parfile, "Read initiation delay", &queue->readdelay, 1, (double) 0.0, (double) 0.0);
@@ -2616,18 +5283,10 @@ int printsizestats;
    getparam_int(parfile, "Scheduling timeout scheme", &queue->to_scheme, 1, 0, 0);
    getparam_int(parfile, "Timeout time/weight", &queue->to_time, 1, 0, 0);
 
-   getparam_int(parfile, "Timeout scheduling", &queue->timeout.sched_alg, 0, 0, 0);
-   if ((queue->to_scheme != NOTIMEOUT) && ((queue->timeout.sched_alg < MINSCHED) || (queue->timeout.sched_alg > MAXSCHED))) {
-      fprintf(stderr, "Invalid value for 'Timeout scheduling': %d\n", queue->timeout.sched_alg);
-      exit(0);
-   }
+   ioqueue_getparam_sched(parfile, "Timeout scheduling", &queue->timeout.sched_alg, (queue->to_scheme != NOTIMEOUT));
 
    getparam_int(parfile, "Scheduling priority scheme", &queue->pri_scheme, 1, 0, 0);
-   getparam_int(parfile, "Priority scheduling", &queue->priority.sched_alg, 0, 0, 0);
-   if ((queue->pri_scheme != ALLEQUAL) && ((queue->priority.sched_alg < MINSCHED) || (queue->priority.sched_alg > MAXSCHED))) {
-      fprintf(stderr, "Invalid value for 'Priority scheduling': %d\n", queue->priority.sched_alg);
-      exit(0);
-   }
+   ioqueue_getparam_sched(parfile, "Priority scheduling", &queue->priority.sched_alg, (queue->pri_scheme != ALLEQUAL));
 
    return(queue);
 }
@@ -2753,6 +5412,39 @@ char *prefix;
 }
 
 
+void ioqueue_printdecisionstats(set, setsize, prefix)
+ioqueue **set;
+int setsize;
+char *prefix;
+{
+   int i;
+   double decisions = 0.0;
+   double candidates = 0.0;
+   double estimates = 0.0;
+   double positionings = 0.0;
+   double walltime = 0.0;
+   statgen * statset[MAXDISKS];
+
+   for (i=0; i<setsize; i++) {
+      statset[i] = &set[i]->decisiontime;
+      if (set[i]->printdecisionstats == FALSE) {
+         return;
+      }
+      decisions += set[i]->decisions;
+      candidates += set[i]->candidates;
+      estimates += set[i]->estimates;
+      positionings += set[i]->positionings;
+      walltime += stat_get_runval(&set[i]->decisiontime);
+   }
+   fprintf(outputfile, "%sScheduling decisions:    %.0f\n", prefix, decisions);
+   fprintf(outputfile, "%sDecision candidates:     %.0f  \t%f\n", prefix, candidates, (candidates / max(decisions,1.0)));
+   fprintf(outputfile, "%sDecision estimates:      %.0f  \t%f\n", prefix, estimates, (estimates / max(decisions,1.0)));
+   fprintf(outputfile, "%sDecision positionings:   %.0f  \t%f  \t%f\n", prefix, positionings, (positionings / max(decisions,1.0)), (positionings / max(candidates,1.0)));
+   fprintf(outputfile, "%sTotal decision time:     %f\n", prefix, (walltime / (double) 1000.0));
+   stat_print_set(statset, setsize, prefix);
+}
+
+
 void ioqueue_printidlestats(set, setsize, prefix)
 ioqueue **set;
 int setsize;
@@ -2880,6 +5572,20 @@ int printcritstats;
 }
 
 
+/* Lets the policy of a set of subqueues report on them (those of other */
+/* policies included, for the hook to pass over).                      */
+
+void ioqueue_sched_printstats(subset, setsize, prefix)
+subqueue **subset;
+int setsize;
+char *prefix;
+{
+   if ((subset[0]->sched) && (subset[0]->sched->printstats)) {
+      (*subset[0]->sched->printstats)(subset, setsize, prefix);
+   }
+}
+
+
 void ioqueue_printstats(set, setsize, sourcestr)
 ioqueue **set;
 int setsize;
@@ -2909,8 +5615,10 @@ char *sourcestr;
 
    for (i=0; i<setsize; i++) {
 
-      if (set[i]->printqueuestats == FALSE)
+      if (set[i]->printqueuestats == FALSE) {
+         ioqueue_printdecisionstats(set, setsize, sourcestr);
          return;
+      }
 
       if ((set[i]->to_scheme != NOTIMEOUT) || (set[i]->pri_scheme != ALLEQUAL)) {
 	 to_scheme = set[i]->to_scheme;
@@ -2969,6 +5677,7 @@ char *sourcestr;
    ioqueue_printintarrstats(set, setsize, sourcestr);
    ioqueue_printidlestats(set, setsize, sourcestr);
    ioqueue_printsizestats(set, setsize, sourcestr);
+   ioqueue_printdecisionstats(set, setsize, sourcestr);
    for (i=0; i<setsize; i++) {
       statset[(3*i)] = &set[i]->base.instqueuelen;
       statset[((3*i)+1)] = &set[i]->timeout.instqueuelen;
@@ -3002,6 +5711,7 @@ char *sourcestr;
 	 fprintf(outputfile, "%sTimed out requests:                   %d\n", sourcestr, timeouts);
 	 fprintf(outputfile, "%sHalfway timed out requests:           %d\n", sourcestr, halfouts);
          ioqueue_subqueue_printstats(subset, setsize, prefix, printcritstats);
+         ioqueue_sched_printstats(subset, setsize, prefix);
       }
       if (pri_scheme != ALLEQUAL) {
          fprintf(outputfile, "%sPriority queue statistics\n", sourcestr);
@@ -3013,7 +5723,12 @@ char *sourcestr;
 	 sprintf(prefix, "%spriority ", sourcestr);
 	 fprintf (outputfile, "%sRequests switched to priority queue:   %d\n", sourcestr, switches);
          ioqueue_subqueue_printstats(subset, setsize, prefix, printcritstats);
+         ioqueue_sched_printstats(subset, setsize, prefix);
       }
    }
+   for (i=0; i<setsize; i++) {
+      subset[i] = &set[i]->base;
+   }
+   ioqueue_sched_printstats(subset, setsize, sourcestr);
 }
 
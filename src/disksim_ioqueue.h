@@ -67,9 +67,11 @@ extern int		ioqueue_get_number_in_queue();
 extern int		ioqueue_get_number_of_requests();
 extern int		ioqueue_get_number_of_requests_initiated();
 extern int		ioqueue_get_reqoutstanding();
-extern int		ioqueue_get_dist();
+extern lbn_t		ioqueue_get_dist();
 extern void		ioqueue_set_concatok_function();
 extern void		ioqueue_set_idlework_function();
+extern void		ioqueue_set_wakeup_function();
+extern void		ioqueue_set_batch_stats();
 extern void		ioqueue_reset_idledetecter();
 extern void		ioqueue_print_contents();
 
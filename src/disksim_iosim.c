@@ -48,6 +48,7 @@
 #include "disksim_orgface.h"
 #include "disksim_iosim.h"
 #include "disksim_stat.h"
+#include "disksim_timeline.h"
 
 #define TRACEMAPPINGS	MAXDISKS
 
@@ -59,6 +60,10 @@ double ioscale = 1.0;
 double last_request_arrive = 0.0;
 double constintarrtime = 0.0;
 
+/* Bytes per simulated sector (512 unless overridden, e.g. 4096 for 4Kn).  */
+/* Byte counts and byte-sized trace sectors are converted with this.       */
+int io_sectsize = 512;
+
 int tracemappings = 0;
 int tracemap[TRACEMAPPINGS];
 int tracemap1[TRACEMAPPINGS];
@@ -141,7 +146,7 @@ double io_tick()
 double io_raise_priority(opid, devno, blkno, chan)
 int opid;
 int devno;
-int blkno;
+lbn_t blkno;
 void *chan;
 {
    return (iodriver_raise_priority(0, opid, devno, blkno, chan));
@@ -262,18 +267,11 @@ FILE *parfile;
          fprintf(stderr, "Error reading I/O mappings #%d\n", i);
          exit(0);
       }
-      if ((tracemap1[i] < 0) || (tracemap2[i] <= 0) || ((tracemap2[i] % 512) && (512 % tracemap2[i])) || (tracemap3[i] <= 0) || (tracemap4[i] < 0)) {
+      if ((tracemap1[i] < 0) || (tracemap2[i] <= 0) || (tracemap3[i] <= 0) || (tracemap4[i] < 0)) {
          fprintf(stderr, "Invalid value for I/O mapping #%d - %x %d\n", i, tracemap1[i], tracemap2[i]);
          exit(0);
       }
       fprintf (outputfile, "Mapping: %x %x %d %d %d\n", tracemap[i], tracemap1[i], tracemap2[i], tracemap3[i], tracemap4[i]);
-      if (tracemap2[i] == 512) {
-	 tracemap2[i] = 0;
-      } else if (tracemap2[i] > 512) {
-	 tracemap2[i] = -(tracemap2[i] / 512);
-      } else {
-	 tracemap2[i] = 512 / tracemap2[i];
-      }
    }
 }
 
@@ -439,19 +437,16 @@ ioreq_event *temp;
    for (i=0; i<tracemappings; i++) {
       if (temp->devno == tracemap[i]) {
 	 temp->devno = tracemap1[i];
-	 if (tracemap2[i]) {
-	    if (tracemap2[i] < 1) {
-	       temp->blkno *= -tracemap2[i];
-	    } else {
-	       if (temp->blkno % tracemap2[i]) {
-	          fprintf(stderr, "Small sector size disk using odd sector number: %d\n", temp->blkno);
-	          exit(0);
-	       }
+	 if (tracemap2[i] != io_sectsize) {
+	    lbn_t bytes = temp->blkno * tracemap2[i];
+	    if (bytes % io_sectsize) {
+	       fprintf(stderr, "Small sector size disk using odd sector number: %lld\n", temp->blkno);
+	       exit(0);
+	    }
 /*
-	       fprintf (outputfile, "mapping block number %d to %d\n", temp->blkno, (temp->blkno / tracemap2[i]));
+	    fprintf (outputfile, "mapping block number %lld to %lld\n", temp->blkno, (bytes / io_sectsize));
 */
-	       temp->blkno /= tracemap2[i];
-	    }
+	    temp->blkno = bytes / io_sectsize;
 	 }
 	 temp->bcount *= tracemap3[i];
 	 temp->blkno += tracemap4[i];
@@ -506,7 +501,7 @@ fprintf (outputfile, "Near beginning of io_get_next_external_event\n");
       if ((temp->time < simtime) && (!closedios)) {
          fprintf(stderr, "Trace event appears out of time order in trace - simtime %f, time %f\n", simtime, temp->time);
 	 fprintf(stderr, "ioscale %f, tracebasetime %f\n", ioscale, tracebasetime);
-	 fprintf(stderr, "devno %d, blkno %d, bcount %d, flags %d\n", ((ioreq_event *)temp)->devno, ((ioreq_event *)temp)->blkno, ((ioreq_event *)temp)->bcount, ((ioreq_event *)temp)->flags);
+	 fprintf(stderr, "devno %d, blkno %lld, bcount %d, flags %d\n", ((ioreq_event *)temp)->devno, ((ioreq_event *)temp)->blkno, ((ioreq_event *)temp)->bcount, ((ioreq_event *)temp)->flags);
          exit(0);
       }
       if (tracemappings) {
@@ -608,6 +603,17 @@ int last;
 			    fprintf(stderr, "Invalid value for ioscale in io_param_override: %f\n", ioscale);
 			    exit(0);
 			 }
+		      } else if (strcmp(paramname, "sectsize") == 0) {
+			 if (sscanf(paramval, "%d", &io_sectsize) != 1) {
+			    fprintf(stderr, "Error reading sectsize in io_param_override\n");
+			    exit(0);
+			 }
+			 if ((io_sectsize < 512) || (io_sectsize % 512)) {
+			    fprintf(stderr, "Invalid value for sectsize in io_param_override: %d\n", io_sectsize);
+			    exit(0);
+			 }
+		      } else if (strncmp(paramname, "timeline", 8) == 0) {
+			 timeline_param_override(paramname, paramval);
 		      } else {
 			 fprintf(stderr, "Upsupported IOSIM name at io_param_override: %s\n", paramname);
 			 exit(0);
@@ -664,5 +670,6 @@ void io_cleanstats()
    disk_cleanstats();
    bus_cleanstats();
    controller_cleanstats();
+   timeline_flush();
 }
 
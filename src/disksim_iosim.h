@@ -147,6 +147,58 @@ typedef struct {
    struct ioq   *queue;
 } device;
 
+/* Per-request latency breakdown record.  The device driver attaches one  */
+/* to each request it queues (see iodriver_timing_attach) and every copy  */
+/* of that request made further down the path shares it.  Records come   */
+/* from a private pool and are stamped with a fresh reqid each time they */
+/* are handed out, so stale copies that outlive the request (e.g., the   */
+/* completion interrupt being acknowledged) find a mismatched id and are */
+/* simply ignored.                                                       */
+
+typedef struct reqtime {
+   int     reqid;
+   double  arrtime;
+   double  dispatchtime;
+   double  buswait;
+   double  seektime;
+   double  latency;
+   double  xfertime;
+   struct reqtime *next;
+} reqtiming;
+
+#define IO_TIMING(req)	((((req)->flags & IO_FLAG_TIMED) && (((reqtiming *) (req)->timing)->reqid == (req)->timingid)) ? (reqtiming *) (req)->timing : (reqtiming *) NULL)
+
+/* Candidate requests for disk_get_servtime_batch, as parallel arrays.  */
+/* The caller fills in count entries of the request fields; the disk    */
+/* fills in seektimes and servtimes.  disk_bound_servtime_batch instead */
+/* fills in bounds, leaving servtimes to disk_get_servtime_batch_entry  */
+/* except where they are already known (entries[i] == -1).              */
+
+typedef struct {
+   int      count;
+   int      size;		/* allocated length of each array */
+   int      devno;
+   lbn_t   *blknos;
+   int     *bcounts;
+   int     *flags;
+   double  *times;
+   double  *seektimes;		/* 0.0 for buffer hits */
+   double  *servtimes;
+   double  *bounds;		/* lower bounds on servtimes */
+   int     *entries;		/* for the disk's use */
+} servbatch;
+
+/* Mechanical state of a disk's head assembly: the track it is on and its */
+/* rotational offset (from logical zero) as of a given time.  Schedulers  */
+/* carry these between speculative estimates (disk_get_servtime_from).    */
+
+typedef struct {
+   int     cylno;
+   int     surface;
+   double  angle;
+   double  time;
+} diskhead;
+
 /* functions provided external to I/O subsystem */
 
 extern event * io_done_notify();
@@ -240,7 +292,7 @@ extern int     disk_get_depth();
 extern int     disk_get_inbus();
 extern int     disk_get_busno();
 extern int     disk_get_slotno();
-extern int     disk_get_number_of_blocks();
+extern lbn_t   disk_get_number_of_blocks();
 extern int     disk_get_maxoutstanding();
 extern int     disk_get_numdisks();
 extern int     disk_get_numcyls();
@@ -250,7 +302,13 @@ extern void    disk_get_mapping();
 extern void    disk_event_arrive();
 extern void    disk_timestamp();
 extern double  disk_get_servtime();
+extern void    disk_get_servtime_batch();
+extern void    disk_bound_servtime_batch();
+extern double  disk_get_servtime_batch_entry();
+extern void    disk_get_servtime_head();
+extern double  disk_get_servtime_from();
 extern double  disk_get_acctime();
+extern void    disk_get_estimate_counts();
 
 #endif   /* DISKSIM_IOSIM_H */
 
@@ -47,11 +47,13 @@
 #include "disksim_hptrace.h"
 
 double tracebasetime = 0.0;
+int iotrace_records = 0;
 
 extern int traceheader;  /* From disksim.c: hack for combined HPL trace files */
 extern int endian;
 extern int traceformat;
 extern int traceendian;
+extern int io_sectsize;
 
 int syncreads = 0;
 int syncwrites = 0;
@@ -75,7 +77,7 @@ int basesmalltime = -1;
 double basesimtime = 0.0;
 
 double validate_lastserv = 0.0;
-int validate_lastblkno = 0;
+lbn_t validate_lastblkno = 0;
 int validate_lastbcount = 0;
 int validate_lastread = 0;
 double validate_nextinter = 0.0;
@@ -194,7 +196,7 @@ ioreq_event *new;
       return(NULL);
    }
    new->time = simtime + (validate_nextinter / (double) 1000);
-   if (sscanf(line, "%c %s %d %d %lf %lf\n", &rw, validate_buffaction, &new->blkno, &new->bcount, &servtime, &validate_nextinter) != 6) {
+   if (sscanf(line, "%c %s %lld %d %lf %lf\n", &rw, validate_buffaction, &new->blkno, &new->bcount, &servtime, &validate_nextinter) != 6) {
       fprintf(stderr, "Wrong number of arguments for I/O trace event type\n");
       exit(0);
    }
@@ -211,6 +213,7 @@ ioreq_event *new;
    new->buf = 0;
    new->opid = 0;
    new->cause = 0;
+   new->flow = 0;
    new->busno = 0;
    new->tempint2 = 0;
    new->tempint1 = 0;
@@ -305,11 +308,11 @@ ioreq_event *new;
       new->tempint2 -= new->tempint1;
       failure |= iotrace_read_int32(iotracefile, &val);
       new->bcount = val;
-      if (new->bcount & 0x000001FF) {
-         fprintf(stderr, "HPL request for non-512B multiple size: %d\n", new->bcount);
+      if (new->bcount % io_sectsize) {
+         fprintf(stderr, "HPL request for non-%dB multiple size: %d\n", io_sectsize, new->bcount);
          exit(0);
       }
-      new->bcount = new->bcount >> 9;
+      new->bcount = new->bcount / io_sectsize;
       failure |= iotrace_read_int32(iotracefile, &val);
       new->blkno = val;
       failure |= iotrace_read_int32(iotracefile, &val);
@@ -344,6 +347,7 @@ ioreq_event *new;
          exit(0);
       }
       new->cause = 0;
+      new->flow = 0;
       new->opid = 0;
       new->busno = 0;
       if ((id & 0xFFFF) == HPL_SHORTIO) {
@@ -447,7 +451,7 @@ ioreq_event *new;
       new->flags |= TIME_CRITICAL;
    }
    failure |= iotrace_read_int32(iotracefile, &val);
-   new->bcount = val >> 9;
+   new->bcount = val / io_sectsize;
    failure |= iotrace_read_int32(iotracefile, &val);
    new->blkno = val;
    failure |= iotrace_read_int32(iotracefile, &val);
@@ -455,6 +459,7 @@ ioreq_event *new;
    failure |= iotrace_read_int32(iotracefile, &val);
    new->flags = val & READ;
    new->cause = 0;
+   new->flow = 0;
    new->buf = 0;
    new->opid = 0;
    new->busno = 0;
@@ -468,6 +473,9 @@ ioreq_event *new;
 }
 
 
+/* Each line holds time, devno, blkno, bcount and flags, and optionally */
+/* a flow id for the fair queueing scheduler.                           */
+
 event * iotrace_ascii_get_ioreq_event(iotracefile, new)
 FILE *iotracefile;
 ioreq_event *new;
@@ -478,11 +486,16 @@ ioreq_event *new;
       addtoextraq((event *) new);
       return(NULL);
    }
-   if (sscanf(line, "%lf %d %d %d %x\n", &new->time, &new->devno, &new->blkno, &new->bcount, &new->flags) != 5) {
+   new->flow = 0;
+   if (sscanf(line, "%lf %d %lld %d %x %d\n", &new->time, &new->devno, &new->blkno, &new->bcount, &new->flags, &new->flow) < 5) {
       fprintf(stderr, "Wrong number of arguments for I/O trace event type\n");
       fprintf(stderr, "line: %s", line);
       exit(0);
    }
+   if (new->flow < 0) {
+      fprintf(stderr, "Invalid flow id in I/O trace: %d\n", new->flow);
+      exit(0);
+   }
    if (new->flags & ASYNCHRONOUS) {
       new->flags |= (new->flags & READ) ? TIME_LIMITED : 0;
    } else {
@@ -521,6 +534,9 @@ event *temp;
       default:  fprintf(stderr, "Unknown traceformat in iotrace_get_ioreq_event - %d\n", traceformat);
 		exit(0);
    }
+   if (temp) {
+      iotrace_records++;
+   }
    return(temp);
 }
 
@@ -73,9 +73,9 @@ int logorg_overlap(currlogorg, devno, curr, blksperpart)
 logorg *currlogorg;
 int devno;
 ioreq_event *curr;
-int blksperpart;
+lbn_t blksperpart;
 {
-   int calc;
+   lbn_t calc;
 
    calc = curr->blkno - currlogorg->devs[devno].startblkno;
    if ((calc >= 0) && (calc < blksperpart)) {
@@ -147,8 +147,8 @@ ioreq_event *curr;
 {
    int i;
    int first;
-   int *lastreq = currlogorg->stat.lastreq;
-   int diffblkno;
+   lbn_t *lastreq = currlogorg->stat.lastreq;
+   lbn_t diffblkno;
 
    if (currlogorg->printinterferestats == FALSE) {
       return;
@@ -218,7 +218,7 @@ ioreq_event *curr;
          currlogorg->stat.blocked[i]++;
       }
    }
-   maxval = min(BLOCKINGMAX, curr->blkno);
+   maxval = (int) min(BLOCKINGMAX, curr->blkno);
    for (i=0; i<maxval; i++) {
       if ((curr->blkno % (i+1)) == 0) {
          currlogorg->stat.aligned[i]++;
@@ -363,7 +363,7 @@ fprintf (outputfile, "Midway through stats\n");
       fprintf(stderr,"Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, totalreqs);
       fflush(stderr);
       fprintf (outputfile, "Stopping simulation because of saturation: simtime %f, totalreqs %d\n", simtime, totalreqs);
-      fprintf (outputfile, "last request:  dev=%d, blk=%d, cnt=%d, %d (R==1)\n",curr->devno, curr->blkno, curr->bcount, (curr->flags & READ));
+      fprintf (outputfile, "last request:  dev=%d, blk=%lld, cnt=%d, %d (R==1)\n",curr->devno, curr->blkno, curr->bcount, (curr->flags & READ));
       for (j=0;j<MAXDISKS;j++) {
          fprintf(outputfile, "last read arrival for dev %d =    %12.6f\n",j,disk_last_read_arrival[j]);
          fprintf(outputfile, "last read completion for dev %d = %12.6f\n",j,disk_last_read_completion[j]);
@@ -563,13 +563,13 @@ logorg *currlogorg;
 ioreq_event *curr;
 {
    int numdisks;
-   int blkno;
+   lbn_t blkno;
    int i;
    ioreq_event *temp;
 
    numdisks = currlogorg->numdisks;
    blkno = curr->blkno / numdisks;
-   curr->bcount += curr->blkno - (blkno * numdisks);
+   curr->bcount += (int) (curr->blkno - (blkno * numdisks));
    curr->bcount = (curr->bcount + numdisks - 1) / numdisks;
    curr->blkno = blkno;
    curr->devno = 0;
@@ -590,8 +590,8 @@ ioreq_event *curr;
 {
    int numdisks;
    int stripeunit;
-   int unitno;
-   int stripeno;
+   lbn_t unitno;
+   lbn_t stripeno;
    int reqsize;
    int numstripes = 2;
    int numreqs = 1;
@@ -600,7 +600,7 @@ ioreq_event *curr;
    int startdevno;
    ioreq_event *newreq;
    ioreq_event *temp;
-   int blkno;
+   lbn_t blkno;
    int i;
    int last = FALSE;
 
@@ -618,15 +618,15 @@ ioreq_event *curr;
    stripeno = unitno / numdisks;
    if (stripeno == currlogorg->numfull) {
       last = TRUE;
-      stripeunit = currlogorg->blksperpart - (currlogorg->numfull * stripeunit);
+      stripeunit = (int) (currlogorg->blksperpart - (currlogorg->numfull * stripeunit));
       unitno = stripeno * numdisks;
       unitno += (curr->blkno - (unitno * currlogorg->stripeunit)) / stripeunit;
       curr->blkno -= stripeno * numdisks * currlogorg->stripeunit;
    }
-   devno = unitno % numdisks;
+   devno = (int) (unitno % numdisks);
    curr->devno = devno;
    curr->blkno = curr->blkno % stripeunit;
-   startslop = stripeunit - curr->blkno;
+   startslop = stripeunit - (int) curr->blkno;
    curr->blkno += stripeno * currlogorg->stripeunit;
    if (startslop < curr->bcount) {
       blkno = stripeno * currlogorg->stripeunit;
@@ -644,7 +644,7 @@ fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, strip
 	 devno = 0;
 	 stripeno++;
 	 if (stripeno == currlogorg->numfull) {
-	    stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
+	    stripeunit = (int) (currlogorg->blksperpart - (stripeno * stripeunit));
 	 }
       }
       while (reqsize > stripeunit) {
@@ -656,7 +656,7 @@ fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, strip
 	    devno = 0;
 	    stripeno++;
 	    if (stripeno == currlogorg->numfull) {
-	       stripeunit = currlogorg->blksperpart - (stripeno * stripeunit);
+	       stripeunit = (int) (currlogorg->blksperpart - (stripeno * stripeunit));
 	    }
 	 }
       }
@@ -675,6 +675,8 @@ fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, strip
 	 newreq->prev = NULL;
 	 newreq->type = curr->type;
 	 newreq->opid = curr->opid;
+	 newreq->cause = curr->cause;
+	 newreq->flow = curr->flow;
 	 newreq->buf = curr->buf;
          temp->next = newreq;
 	 temp = newreq;
@@ -685,6 +687,29 @@ fprintf (outputfile, "Have a multi-disk request - bcount %d, startslop %d, strip
 }
 
 
+/* Requests held back on dependencies (e.g., parity updates) are made */
+/* well before they are issued, so they take the flow of the request  */
+/* they serve now.                                                     */
+
+void logorg_set_dependents_flow(depend, flow)
+depends *depend;
+int flow;
+{
+   depends *tmpdep;
+   int i;
+
+   for (; depend; depend = depend->next) {
+      tmpdep = depend;
+      for (i = 0; i < depend->numdeps; i++) {
+         if ((i) && ((i % 10) == 0)) {
+            tmpdep = tmpdep->cont;
+         }
+         tmpdep->deps[(i % 10)]->flow = flow;
+      }
+   }
+}
+
+
 int logorg_maprequest(logorgs, numlogorgs, curr)
 logorg *logorgs;
 int numlogorgs;
@@ -742,7 +767,7 @@ fprintf (outputfile, "flags %x\n", curr->flags);
 
    /* Every request must be covered by a logorg */
    if (logorgno == -1) {
-      fprintf (stderr, "unexpected request location: devno %x, blkno %d, bcount %d\n", curr->devno, curr->blkno, curr->bcount);
+      fprintf (stderr, "unexpected request location: devno %x, blkno %lld, bcount %d\n", curr->devno, curr->blkno, curr->bcount);
    }
    ASSERT(logorgno != -1);
    maptype = logorgs[logorgno].maptype;
@@ -784,6 +809,7 @@ fprintf (outputfile, "back from logorging: numreqs %d\n", numreqs);
 */
    orgdevno = curr->devno;
    req->depend = (depends *) curr->prev;
+   logorg_set_dependents_flow(req->depend, curr->flow);
    curr->blkno += logorgs[logorgno].devs[orgdevno].startblkno;
    curr->devno = logorgs[logorgno].devs[orgdevno].devno;
    temp = curr->next;
@@ -792,6 +818,7 @@ fprintf (outputfile, "back from logorging: numreqs %d\n", numreqs);
       temp->blkno += logorgs[logorgno].devs[(temp->devno - logorgs[logorgno].devs[0].devno)].startblkno;
       temp->devno = logorgs[logorgno].devs[(temp->devno - logorgs[logorgno].devs[0].devno)].devno;
       temp->opid = curr->opid;
+      temp->flow = curr->flow;
       temp = temp->next;
       i++;
    }
@@ -893,12 +920,12 @@ logorg *logorgs;
 int numlogorgs;
 int opid;
 int devno;
-int blkno;
+lbn_t blkno;
 void *buf;
 {
    int i, j;
    int logorgno = -1;
-   int calc;
+   lbn_t calc;
    outstand *tmp;
    int found = 0;
 /*
@@ -1049,7 +1076,7 @@ int printsizestats;
 	 exit(0);
       }
 
-      getparam_int(parfile, "Stripe unit (in sectors)", &logorgs[i].stripeunit, 3, 0, logorgs[i].blksperpart);
+      getparam_int(parfile, "Stripe unit (in sectors)", &logorgs[i].stripeunit, 3, 0, (int) min(logorgs[i].blksperpart, INT_MAX));
 
       if (strcmp(redun, "Noredun") == 0) {
 	 logorgs[i].reduntype = NO_REDUN;
@@ -1071,7 +1098,7 @@ int printsizestats;
       getparam_double(parfile, "RMW vs. reconstruct", &rmwpoint, 3, (double) 0.0, (double) 1.0);
       logorgs[i].rmwpoint = (int) (rmwpoint * (double) logorgs[i].actualnumdisks);
 
-      getparam_int(parfile, "Parity stripe unit", &logorgs[i].parityunit, 3, 1, logorgs[i].blksperpart);
+      getparam_int(parfile, "Parity stripe unit", &logorgs[i].parityunit, 3, 1, (int) min(logorgs[i].blksperpart, INT_MAX));
       getparam_int(parfile, "Parity rotation type", &logorgs[i].rottype, 3, 1, 4);
 
       getparam_double(parfile, "Time stamp interval", &logorgs[i].stampinterval, 1, (double) 0.0, (double) 0.0);
@@ -1239,9 +1266,9 @@ struct ioq **queueset;
 	 logorg_create_table(&logorgs[i]);
 	 logorgs[i].maptype = ASIS;
 	 logorgs[i].reduntype = PARITY_TABLE;
-	 logorgs[i].blksperpart = (int) ((double) logorgs[i].blksperpart * (double) (logorgs[i].numdisks - 1) / (double) logorgs[i].numdisks);
+	 logorgs[i].blksperpart = (lbn_t) ((double) logorgs[i].blksperpart * (double) (logorgs[i].numdisks - 1) / (double) logorgs[i].numdisks);
       } else if (logorgs[i].reduntype == PARITY_ROTATED) {
-	 logorgs[i].blksperpart = (int) ((double) logorgs[i].blksperpart * (double) (logorgs[i].numdisks - 1) / (double) logorgs[i].numdisks) - logorgs[i].parityunit;
+	 logorgs[i].blksperpart = (lbn_t) ((double) logorgs[i].blksperpart * (double) (logorgs[i].numdisks - 1) / (double) logorgs[i].numdisks) - logorgs[i].parityunit;
       }
       logorgs[i].opid = 0;
       logorgs[i].idealno = 0;
@@ -1283,7 +1310,7 @@ struct ioq **queueset;
       logorgs[i].redunsizes = (int *) malloc(logorgs[i].actualnumdisks*sizeof(int));
       ASSERT(logorgs[i].redunsizes != NULL);
       if (logorgs[i].printinterferestats) {
-         logorgs[i].stat.lastreq = (int *) malloc(2*INTERFEREMAX*sizeof(int));
+         logorgs[i].stat.lastreq = (lbn_t *) malloc(2*INTERFEREMAX*sizeof(lbn_t));
          ASSERT(logorgs[i].stat.lastreq != NULL);
          for (j=0; j<(2*INTERFEREMAX); j++) {
             logorgs[i].stat.lastreq[j] = 0;
@@ -1328,6 +1355,8 @@ struct ioq **queueset;
          ioreq_event *tmp = (ioreq_event *) getfromextraq();
          tmp->time = logorgs[i].stampstart;
          tmp->type = TIMESTAMP_LOGORG;
+         tmp->cause = 0;
+         tmp->flow = 0;
          tmp->tempptr1 = &logorgs[i];
          addtointq((event *) tmp);
       }
@@ -87,8 +87,8 @@
 #define INTDISTMAX	8
 
 typedef struct dep {
+   lbn_t  blkno;
    int    devno;
-   int    blkno;
    int    numdeps;
    struct dep *next;
    struct dep *cont;
@@ -97,11 +97,11 @@ typedef struct dep {
 
 typedef struct os {
    double arrtime;
+   lbn_t  blkno;
    int    type;
    struct os *next;
    struct os *prev;
    u_int  bcount;
-   u_int  blkno;
    u_int  flags;
    u_int  busno;
    int    numreqs;
@@ -136,7 +136,7 @@ typedef struct {
    double       lastwrite;
    int          *blocked;
    int          *aligned;
-   int		*lastreq;
+   lbn_t	*lastreq;
    int		*intdist;
    statgen      resptimestats;
    statgen	idlestats;
@@ -150,12 +150,12 @@ typedef struct {
 
 typedef struct {
    int    devno;
-   int    startblkno;
+   lbn_t  startblkno;
    struct ioq * queue;
-   int    lastblkno;
+   lbn_t  lastblkno;
    int    seqreads;
    int    seqwrites;
-   int    lastblkno2;
+   lbn_t  lastblkno2;
    int    intreads;
    int    intwrites;
    int    numout;
@@ -167,7 +167,7 @@ typedef struct {
 
 typedef struct {
    int    devno;
-   int    blkno;
+   lbn_t  blkno;
 } tableentry;
 
 typedef struct logorg {
@@ -186,8 +186,8 @@ typedef struct logorg {
    int    rmwpoint;
    int    parityunit;
    int    rottype;
-   int    blksperpart;
-   int    actualblksperpart;
+   lbn_t  blksperpart;
+   lbn_t  actualblksperpart;
    int    stripeunit;
    int    sectionunit;
    int    tablestripes;
@@ -197,7 +197,7 @@ typedef struct logorg {
    int    idealno;
    int    reduntoggle;
    int    lastdiskaccessed;
-   int    numfull;
+   lbn_t  numfull;
    int   *sizes;
    int   *redunsizes;
    int    printlocalitystats;
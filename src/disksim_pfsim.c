@@ -238,7 +238,7 @@ ioreq_event *curr;
    wakeup_event *tmpwake = NULL;
 
 if (pf_printhack) {
-   fprintf (outputfile, "pf_io_done_notify: curr->buf %p, curr->opid %x, curr->blkno %d\n", curr->buf, curr->opid, curr->blkno);
+   fprintf (outputfile, "pf_io_done_notify: curr->buf %p, curr->opid %x, curr->blkno %lld\n", curr->buf, curr->opid, curr->blkno);
 }
    ASSERT(pendiolist != NULL);
    if ((tmp->buf == curr->buf) && (tmp->opid == curr->opid)) {
@@ -311,7 +311,7 @@ process *procp;
    }
 
 if (pf_printhack)
-fprintf (outputfile, "pf_iowait: chan %p, read %d, crit %d, opid %d, blkno %x\n", tmp->buf, (tmp->flags & READ), (tmp->flags & (TIME_LIMITED|TIME_CRITICAL)), tmp->opid, tmp->blkno);
+fprintf (outputfile, "pf_iowait: chan %p, read %d, crit %d, opid %d, blkno %llx\n", tmp->buf, (tmp->flags & READ), (tmp->flags & (TIME_LIMITED|TIME_CRITICAL)), tmp->opid, tmp->blkno);
 
    if (tmp->flags & TIME_LIMITED) {
       if (tmp->flags & READ) {
@@ -537,7 +537,7 @@ cpu_event *cpu_ev;
    curr->next = NULL;
 
    if (pf_printhack)
-   fprintf (outputfile, "%f\tIOREQ cpu=%d opid=%d buf=%p blkno=%x flags=%x, bcount=%d\n", simtime, cpu_ev->cpunum, curr->opid, curr->buf, curr->blkno, curr->flags, curr->bcount);
+   fprintf (outputfile, "%f\tIOREQ cpu=%d opid=%d buf=%p blkno=%llx flags=%x, bcount=%d\n", simtime, cpu_ev->cpunum, curr->opid, curr->buf, curr->blkno, curr->flags, curr->bcount);
 
    curr->flags &= ~(TIMED_OUT|HALF_OUT); /* hack to help out ioqueue.c */
 
@@ -567,7 +567,7 @@ ioreq_event *curr;
 cpu_event *cpu_ev;
 {
    if (pf_printhack)
-   fprintf (outputfile, "%f\tIOACC cpu=%d opid=%d blkno=%x\n", simtime, cpu_ev->cpunum, curr->opid, curr->blkno);
+   fprintf (outputfile, "%f\tIOACC cpu=%d opid=%d blkno=%llx\n", simtime, cpu_ev->cpunum, curr->opid, curr->blkno);
 
    io_schedule(curr);
 }
@@ -578,7 +578,7 @@ ioreq_event *curr;
 cpu_event *cpu_ev;
 {
    if (pf_printhack)
-   fprintf (outputfile, "%f\tIO INTERNAL cpu=%d type %d opid=%d blkno=%x buf=%p\n", simtime, cpu_ev->cpunum, curr->type, curr->opid, curr->blkno, curr->buf);
+   fprintf (outputfile, "%f\tIO INTERNAL cpu=%d type %d opid=%d blkno=%llx buf=%p\n", simtime, cpu_ev->cpunum, curr->type, curr->opid, curr->blkno, curr->buf);
 
    if (curr->type == IO_REQUEST_ARRIVE) {
       ioreq_event *new = (ioreq_event *) io_request (curr);
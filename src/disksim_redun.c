@@ -128,9 +128,9 @@ int numtocheck;
 int *checklist;
 {
    int i, j;
-   int dist;
+   lbn_t dist;
    int shortdev = -1;
-   int shortdist = 999999999;
+   lbn_t shortdist = LLONG_MAX;
    int ties[MAXCOPIES];
    int no;
 
@@ -138,10 +138,6 @@ int *checklist;
    for (i = 0; i < numtocheck; i++) {
       no = checklist[i];
       dist = ioqueue_get_dist(currlogorg->devs[(curr->devno + (no * currlogorg->numdisks))].queue, (curr->blkno + currlogorg->devs[(curr->devno + (no * currlogorg->numdisks))].startblkno));
-      if (dist >= 999999999) {
-	 fprintf(stderr, "Haven't allowed for large enough 'dist's in logorg_shadowed_get_short_dist - %d\n", dist);
-	 exit(0);
-      }
       if (dist == shortdist) {
 	 j++;
 	 if (j >= MAXCOPIES) {
@@ -342,13 +338,13 @@ int inc;
    int parityunit;
    int numdisks;
    int devno;
-   int parityblock;
+   lbn_t parityblock;
 
    parityunit = currlogorg->parityunit;
    numdisks = currlogorg->numdisks;
 
    parityblock = curr->blkno / (parityunit * (numdisks - 1));
-   parityno = (curr->blkno % (parityunit * (numdisks - 1))) / parityunit;
+   parityno = (int) ((curr->blkno % (parityunit * (numdisks - 1))) / parityunit);
    curr->blkno += parityblock * parityunit;
    if (inc == -1) {
       devno = numdisks - (parityno % numdisks) - 1;
@@ -360,7 +356,7 @@ int inc;
       devno = logorg_modulus_update(inc, devno, numdisks);
       parityno++;
    }
-   blksleft = parityunit - (curr->blkno % currlogorg->parityunit);
+   blksleft = parityunit - (int) (curr->blkno % currlogorg->parityunit);
    bcount = curr->bcount;
    if ((parityunit != currlogorg->parityunit) && ((bcount > blksleft) || (parityunit > currlogorg->parityunit))) {
       fprintf(stderr, "Failed integrity check in logorg_parity_rotate_left\n");
@@ -548,7 +544,7 @@ int seqgive;
    ioreq_event *temp;
    ioreq_event *del;
    int numreqs = 0;
-   int distance;
+   lbn_t distance;
 
    temp = reqlist;
    if (temp) {
@@ -558,13 +554,13 @@ int seqgive;
 fprintf (outputfile, "In logorg_join_seqreqs, devno %d, blkno %d, bcount %d, read %d, distance %d\n", temp->devno, temp->blkno, temp->bcount, (temp->flags & READ), distance);
 */
          if (distance < 0) {
-            fprintf(stderr, "Integrity check failure at logorg_join_seqreqs - blkno %d, bcount %d, blkno %d, read %d\n", temp->blkno, temp->bcount, temp->next->blkno, (temp->flags & READ));
+            fprintf(stderr, "Integrity check failure at logorg_join_seqreqs - blkno %lld, bcount %d, blkno %lld, read %d\n", temp->blkno, temp->bcount, temp->next->blkno, (temp->flags & READ));
             exit(0);
          }
          if (((temp->flags & READ) == (temp->next->flags & READ)) && (distance <= seqgive)) {
             del = temp->next;
             temp->next = del->next;
-            temp->bcount += del->bcount + distance;
+            temp->bcount += del->bcount + (int) distance;
 	    temp->opid |= del->opid;
             addtoextraq((event *) del);
          } else {
@@ -625,6 +621,8 @@ int opid;
       newreq->bcount = temp->bcount;
       newreq->flags = temp->flags | READ;
       newreq->opid = opid;
+      newreq->cause = temp->cause;
+      newreq->flow = temp->flow;
       logorg_parity_table_insert(&reqlist[newreq->devno], newreq);
       newreq->prev = prev;
       prev = newreq;
@@ -643,7 +641,7 @@ ioreq_event *rowhead;
 ioreq_event **reqlist;
 int stripeno;
 int unitno;
-int tableadd;
+lbn_t tableadd;
 int opid;
 {
    ioreq_event *temp;
@@ -653,7 +651,7 @@ int opid;
    int maxblkno;
    int lastentry;
    int i;
-   int blkno;
+   lbn_t blkno;
    int offset;
 
    temp = rowhead;
@@ -666,7 +664,7 @@ int opid;
       temp = temp->prev;
    }
    temp->opid = opid;
-   minblkno = temp->blkno - currlogorg->table[lastentry].blkno - tableadd;
+   minblkno = (int) (temp->blkno - currlogorg->table[lastentry].blkno - tableadd);
    maxblkno = minblkno + temp->bcount;
    entryno = stripeno * currlogorg->partsperstripe + stripeno;
    for (i = 0; i < unitno; i++) {
@@ -676,13 +674,15 @@ int opid;
       newreq->bcount = maxblkno - minblkno;
       newreq->flags = rowhead->flags | READ;
       newreq->opid = opid;
+      newreq->cause = rowhead->cause;
+      newreq->flow = rowhead->flow;
       logorg_parity_table_insert(&reqlist[newreq->devno], newreq);
       entryno++;
    }
    temp = rowhead;
    while (temp->prev) {
       blkno = currlogorg->table[entryno].blkno;
-      offset = temp->blkno - tableadd - blkno;
+      offset = (int) (temp->blkno - tableadd - blkno);
       if (offset > minblkno) {
          newreq = (ioreq_event *) getfromextraq();
          newreq->devno = temp->devno;
@@ -690,6 +690,8 @@ int opid;
          newreq->bcount = offset - minblkno;
          newreq->flags = temp->flags | READ;
 	 newreq->opid = opid;
+	 newreq->cause = temp->cause;
+	 newreq->flow = temp->flow;
          logorg_parity_table_insert(&reqlist[newreq->devno], newreq);
       }
       if ((offset + temp->bcount) < maxblkno) {
@@ -699,6 +701,8 @@ int opid;
          newreq->bcount = maxblkno - offset - temp->bcount;
          newreq->flags = temp->flags | READ;
 	 newreq->opid = opid;
+	 newreq->cause = temp->cause;
+	 newreq->flow = temp->flow;
          logorg_parity_table_insert(&reqlist[newreq->devno], newreq);
       }
       entryno++;
@@ -711,6 +715,8 @@ int opid;
       newreq->bcount = maxblkno - minblkno;
       newreq->flags = rowhead->flags | READ;
       newreq->opid = opid;
+      newreq->cause = rowhead->cause;
+      newreq->flow = rowhead->flow;
       logorg_parity_table_insert(&reqlist[newreq->devno], newreq);
    }
 }
@@ -908,10 +914,11 @@ int numreqs;
    int stripeunit;
    ioreq_event *temp;
    ioreq_event *newreq;
+   lbn_t units;
    int unitno;
    int stripeno;
    int entryno;
-   int blkno;
+   lbn_t blkno;
    int blksinpart;
    int reqsize;
    int partsperstripe;
@@ -920,7 +927,7 @@ int numreqs;
    int opid = 0x1;
    int blkscovered;
    tableentry *table;
-   int tablestart;
+   lbn_t tablestart;
    int preventryno;
 /*
 fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %d, read %d\n", curr->devno, curr->blkno, curr->bcount, (curr->flags & READ));
@@ -939,32 +946,31 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
    for (i=0; i<currlogorg->actualnumdisks; i++) {
       reqs[i] = NULL;
    }
-   unitno = curr->blkno / stripeunit;
-   stripeno = unitno / partsperstripe;
-   tablestart = (stripeno / currlogorg->tablestripes) * currlogorg->tablesize;
-   stripeno = stripeno % currlogorg->tablestripes;
+   units = curr->blkno / stripeunit;
+   tablestart = (units / partsperstripe / currlogorg->tablestripes) * currlogorg->tablesize;
+   stripeno = (int) ((units / partsperstripe) % currlogorg->tablestripes);
    blkno = tablestart + table[(stripeno*(partsperstripe+1))].blkno;
    if (blkno == currlogorg->numfull) {
-      stripeunit = currlogorg->actualblksperpart - blkno;
+      stripeunit = (int) (currlogorg->actualblksperpart - blkno);
       curr->blkno -= blkno;
-      unitno = curr->blkno / stripeunit;
+      units = curr->blkno / stripeunit;
    }
    blksinpart = stripeunit;
-   unitno = unitno % partsperstripe;
+   unitno = (int) (units % partsperstripe);
    curr->blkno = curr->blkno % stripeunit;
    reqsize = curr->bcount;
    entryno = stripeno * partsperstripe + stripeno + unitno;
    blkno = tablestart + table[entryno].blkno;
-   blksinpart -= curr->blkno;
+   blksinpart -= (int) curr->blkno;
    temp = ioreq_copy(curr);
    curr->next = temp;
    temp->blkno = blkno + curr->blkno;
    temp->devno = table[entryno].devno;
    temp->opid = 0;
    blkscovered = curr->bcount;
-   curr->blkno = stripeno;
+   curr->blkno = tablestart;
    curr->devno = unitno;
-   curr->bcount = tablestart;
+   curr->bcount = stripeno;
    reqs[temp->devno] = curr->next;
    temp->next = NULL;
    temp->prev = NULL;
@@ -982,6 +988,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
 	    newreq->bcount = blkscovered;
 	    newreq->flags = curr->flags;
             newreq->opid = 0;
+            newreq->cause = curr->cause;
+            newreq->flow = curr->flow;
 	    reqs[newreq->devno] = newreq;
 	    newreq->next = NULL;
 	    temp->prev = newreq;
@@ -1002,7 +1010,7 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
       }
       entryno = (stripeno * partsperstripe) + stripeno + unitno;
       blkno = tablestart + table[entryno].blkno;
-      blksinpart = (blkno != currlogorg->numfull) ? stripeunit : currlogorg->actualblksperpart - blkno;
+      blksinpart = (blkno != currlogorg->numfull) ? stripeunit : (int) (currlogorg->actualblksperpart - blkno);
       while (reqsize > blksinpart) {
 	 rowcnt++;
 	 newreq = (ioreq_event *) getfromextraq();
@@ -1012,6 +1020,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
 	 blkscovered = max(blkscovered, blksinpart);
 	 newreq->flags = curr->flags;
          newreq->opid = 0;
+         newreq->cause = curr->cause;
+         newreq->flow = curr->flow;
 	 newreq->prev = NULL;
 	 if (temp) {
 	    temp->prev = newreq;
@@ -1030,6 +1040,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
 	       newreq->bcount = blkscovered;
 	       newreq->flags = curr->flags;
                newreq->opid = 0;
+               newreq->cause = curr->cause;
+               newreq->flow = curr->flow;
                temp->prev = newreq;
 	       newreq->prev = NULL;
 	       logorg_parity_table_insert(&reqs[newreq->devno], newreq);
@@ -1049,7 +1061,7 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
          }
          entryno = (stripeno * partsperstripe) + stripeno + unitno;
          blkno = tablestart + table[entryno].blkno;
-         blksinpart = (blkno != currlogorg->numfull) ? stripeunit : currlogorg->actualblksperpart - blkno;
+         blksinpart = (blkno != currlogorg->numfull) ? stripeunit : (int) (currlogorg->actualblksperpart - blkno);
       }
       newreq = (ioreq_event *) getfromextraq();
       newreq->blkno = blkno;
@@ -1059,6 +1071,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
       blkscovered = max(blkscovered, blksinpart);
       newreq->flags = curr->flags;
       newreq->opid = 0;
+      newreq->cause = curr->cause;
+      newreq->flow = curr->flow;
       newreq->prev = NULL;
       if (temp) {
 	 temp->prev = newreq;
@@ -1082,6 +1096,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
       newreq->bcount = (rowcnt == 1) ? temp->bcount : blkscovered;
       newreq->flags = curr->flags;
       newreq->opid = 0;
+      newreq->cause = curr->cause;
+      newreq->flow = curr->flow;
       temp->prev = newreq;
       newreq->prev = NULL;
       logorg_parity_table_insert(&reqs[newreq->devno], newreq);
@@ -1096,6 +1112,8 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
 	    newreq->bcount = temp->bcount;
 	    newreq->flags = curr->flags;
 	    newreq->opid = 0;
+	    newreq->cause = curr->cause;
+	    newreq->flow = curr->flow;
 	    temp->prev = newreq;
 	    newreq->prev = NULL;
             logorg_parity_table_insert(&reqs[newreq->devno], newreq);
@@ -1113,7 +1131,7 @@ fprintf (outputfile, "Entered logorg_parity_table - devno %d, blkno %d, bcount %
 	 if (firstrow < currlogorg->rmwpoint) {
 	    logorg_parity_table_read_old(currlogorg, curr->next, redunreqs, opid);
 	 } else {
-	    logorg_parity_table_recon(currlogorg, curr->next, redunreqs, curr->blkno, curr->devno, curr->bcount, opid);
+	    logorg_parity_table_recon(currlogorg, curr->next, redunreqs, curr->bcount, curr->devno, curr->blkno, opid);
 	 }
 	 opid = opid << 1;
       }
@@ -76,7 +76,7 @@ statgen *statptr;
 }
 
 
-void stat_update(statptr, value)
+int stat_get_bucket(statptr, value)
 statgen *statptr;
 double value;
 {
@@ -88,12 +88,6 @@ double value;
    int  buckets = statptr->distbrks[(DISTSIZE-1)];
    int  intval = (int) (value * (double) statptr->scale);
 
-   statptr->count++;
-   if (statptr->maxval < value) {
-      statptr->maxval = value;
-   }
-   statptr->runval += value;
-   statptr->runsquares += (value*value);
    if (buckets > DISTSIZE) {
       if (intval < start) {
       } else if (!grow) {
@@ -130,9 +124,7 @@ double value;
             i = top + 1;
          }
       }
-      statptr->largedistvals[i]++;
    } else {
-      i = 0;
       while (i<(DISTSIZE-1)) {
          if ((i < equals) && (value == (double) statptr->distbrks[i])) {
             break;
@@ -141,6 +133,69 @@ double value;
          }
          i++;
       }
+   }
+   return(i);
+}
+
+
+/* Returns the value printed as the label of the given bucket (i.e., the */
+/* lower edge of the bucket, as scaled back into the stat's own units).  */
+
+double stat_get_bucket_start(statptr, bucket)
+statgen *statptr;
+int bucket;
+{
+   int  i;
+   int  step = statptr->distbrks[1];
+   int  grow = statptr->distbrks[2];
+   int  buckets = statptr->distbrks[(DISTSIZE-1)];
+   int  bucketno = statptr->distbrks[0];
+
+   if (buckets > DISTSIZE) {
+      for (i=0; i<bucket; i++) {
+         bucketno += step + (int)((double) (abs(bucketno) * grow) / (double) 100);
+      }
+      return((double) bucketno / (double) statptr->scale);
+   }
+   if (bucket == 0) {
+      return(0.0);
+   }
+   return((double) statptr->distbrks[(bucket-1)] / (double) statptr->scale);
+}
+
+
+void stat_alloc_large_dist(statptr)
+statgen *statptr;
+{
+   int buckets = statptr->distbrks[(DISTSIZE-1)];
+   int i;
+
+   statptr->largedistvals = (int *) malloc(buckets*sizeof(int));
+   ASSERT(statptr->largedistvals != NULL);
+   for (i=0; i<buckets; i++) {
+      statptr->largedistvals[i] = 0;
+   }
+}
+
+
+void stat_update(statptr, value)
+statgen *statptr;
+double value;
+{
+   int  i = stat_get_bucket(statptr, value);
+
+   statptr->count++;
+   if (statptr->maxval < value) {
+      statptr->maxval = value;
+   }
+   statptr->runval += value;
+   statptr->runsquares += (value*value);
+   if (statptr->distbrks[(DISTSIZE-1)] > DISTSIZE) {
+      if (statptr->largedistvals == NULL) {
+         stat_alloc_large_dist(statptr);
+      }
+      statptr->largedistvals[i]++;
+   } else {
       statptr->smalldistvals[i]++;
    }
 }
@@ -173,7 +228,9 @@ char *identstr;
          bucketcnt = 0;
          for (j=0; j<statcnt; j++) {
             statptr = statset[j];
-            bucketcnt += statptr->largedistvals[i];
+            if (statptr->largedistvals) {
+               bucketcnt += statptr->largedistvals[i];
+            }
          }
       } else {
          bucketcnt = statptr->largedistvals[i];
@@ -325,19 +382,27 @@ char *identstr;
 }
 
 
+/* A statistic with no samples since its last reset is already clear, so  */
+/* only live statistics (and only their allocated arrays) are touched.    */
+
 void stat_reset(statptr)
 statgen *statptr;
 {
    int buckets = statptr->distbrks[(DISTSIZE-1)];
    int i;
 
+   if (statptr->count == 0) {
+      return;
+   }
    statptr->count = 0;
    statptr->runval = 0.0;
    statptr->runsquares = 0.0;
    statptr->maxval = 0.0;
    if (buckets > DISTSIZE) {
-      for (i=0; i<buckets; i++) {
-         statptr->largedistvals[i] = 0;
+      if (statptr->largedistvals) {
+         for (i=0; i<buckets; i++) {
+            statptr->largedistvals[i] = 0;
+         }
       }
    } else {
       for (i=0; i<DISTSIZE; i++) {
@@ -347,64 +412,65 @@ statgen *statptr;
 }
 
 
-void stat_get_large_dist(statdeffile, statptr, buckets)
+/* Parsed statdefs entries, one per distinct description.  Every statgen */
+/* initialized from the same description copies its bucket breaks and   */
+/* shares its largediststarts array, so the statdeffile is scanned only  */
+/* once per description rather than once per disk, queue or logorg.      */
+
+typedef struct statdef {
+   char   *statdesc;
+   int     scale;
+   int     equals;
+   int     distbrks[DISTSIZE];
+   int    *largediststarts;
+   struct statdef *next;
+} statdef;
+
+statdef *statdefs = NULL;
+
+
+void stat_get_large_dist(statdeffile, def, buckets)
 FILE *statdeffile;
-statgen *statptr;
+statdef *def;
 int buckets;
 {
-   int i;
    char line[201];
 
-   statptr->largedistvals = (int *) malloc(buckets*sizeof(int));
-   ASSERT(statptr->largedistvals != NULL);
-
    if (fgets(line, 200, statdeffile) == NULL) {
       fprintf(stderr, "Can't get line describing large dist\n");
       exit(0);
    }
-   if (sscanf(line, "Start %d  step %d  grow %d", &statptr->distbrks[0], &statptr->distbrks[1], &statptr->distbrks[2]) != 3) {
+   if (sscanf(line, "Start %d  step %d  grow %d", &def->distbrks[0], &def->distbrks[1], &def->distbrks[2]) != 3) {
       fprintf(stderr, "Bad format for line describing large dist - %s\n", line);
       exit(0);
    }
-   for (i=0; i<buckets; i++) {
-      statptr->largedistvals[i] = 0;
-   }
-   if (statptr->distbrks[2]) {
-      int grow = statptr->distbrks[2];
-      int step = statptr->distbrks[1];
-      int bucketval = statptr->distbrks[0];
+   if (def->distbrks[2]) {
+      int grow = def->distbrks[2];
+      int step = def->distbrks[1];
+      int bucketval = def->distbrks[0];
       int i;
 
-      statptr->largediststarts = (int *) malloc(buckets*sizeof(int));
-      ASSERT(statptr->largediststarts != NULL);
+      def->largediststarts = (int *) malloc(buckets*sizeof(int));
+      ASSERT(def->largediststarts != NULL);
 
       for (i=0; i < buckets; i++) {
-         statptr->largediststarts[i] = bucketval;
+         def->largediststarts[i] = bucketval;
          bucketval += step + (int)((double) (abs(bucketval) * grow) / (double) 100);
       }
    }
 }
 
 
-void stat_initialize(statdeffile, statdesc, statptr)
+statdef * stat_read_definition(statdeffile, statdesc)
 FILE *statdeffile;
 char *statdesc;
-statgen *statptr;
 {
    int i;
    int buckets;
    char line[201];
    char line2[201];
+   statdef *def;
 
-   statptr->count = 0;
-   statptr->runval = 0.0;
-   statptr->runsquares = 0.0;
-   statptr->maxval = 0.0;
-   statptr->statdesc = statdesc;
-   for (i=0; i<DISTSIZE; i++) {
-      statptr->distbrks[i] = 0;
-      statptr->smalldistvals[i] = 0;
-   }
    if (fseek(statdeffile, 0L, 0)) {
       fprintf(stderr, "Can't rewind the statdeffile\n");
       exit(0);
@@ -431,22 +497,203 @@ statgen *statptr;
       fprintf(stderr, "Stat definition only partially found: %s\n", statdesc);
       exit(0);
    }
-   if (sscanf(line, "Scale/Equals: %d/%d\n", &statptr->scale, &statptr->equals) != 2) {
+   def = (statdef *) malloc(sizeof(statdef));
+   ASSERT(def != NULL);
+   if (sscanf(line, "Scale/Equals: %d/%d\n", &def->scale, &def->equals) != 2) {
       fprintf(stderr, "Invalid format for 'scale/equals': %s\n", statdesc);
       exit(0);
    }
-   statptr->distbrks[(DISTSIZE-1)] = buckets;
-   statptr->largedistvals = NULL;
-   statptr->largediststarts = NULL;
+   for (i=0; i<DISTSIZE; i++) {
+      def->distbrks[i] = 0;
+   }
+   def->distbrks[(DISTSIZE-1)] = buckets;
+   def->largediststarts = NULL;
    if (buckets > DISTSIZE) {
-      stat_get_large_dist(statdeffile, statptr, buckets);
+      stat_get_large_dist(statdeffile, def, buckets);
    } else {
       for (i=0; i<(DISTSIZE-1); i++) {
-         if (fscanf(statdeffile, "%d", &statptr->distbrks[i]) != 1) {
+         if (fscanf(statdeffile, "%d", &def->distbrks[i]) != 1) {
             fprintf(stderr, "Distribution buckets only partially specified: %s %d\n", statdesc, i);
             exit(0);
          }
       }
    }
+   def->statdesc = statdesc;
+   def->next = statdefs;
+   statdefs = def;
+   return(def);
+}
+
+
+/* Large distribution counters are allocated on a statistic's first      */
+/* sample, so statistics that are never updated (typically because the  */
+/* matching print flag is off) cost no distribution storage.            */
+
+void stat_initialize(statdeffile, statdesc, statptr)
+FILE *statdeffile;
+char *statdesc;
+statgen *statptr;
+{
+   int i;
+   statdef *def = statdefs;
+
+   while ((def) && (strcmp(def->statdesc, statdesc) != 0)) {
+      def = def->next;
+   }
+   if (def == NULL) {
+      def = stat_read_definition(statdeffile, statdesc);
+   }
+   statptr->count = 0;
+   statptr->runval = 0.0;
+   statptr->runsquares = 0.0;
+   statptr->maxval = 0.0;
+   statptr->statdesc = statdesc;
+   statptr->scale = def->scale;
+   statptr->equals = def->equals;
+   for (i=0; i<DISTSIZE; i++) {
+      statptr->distbrks[i] = def->distbrks[i];
+      statptr->smalldistvals[i] = 0;
+   }
+   statptr->largedistvals = NULL;
+   statptr->largediststarts = def->largediststarts;
+}
+
+
+void stat_batch_reset(batch)
+statbatch *batch;
+{
+   batch->count = 0;
+   batch->sum = 0.0;
+   batch->batches = 0;
+   batch->meansum = 0.0;
+   batch->meansquares = 0.0;
+   batch->tailsum = 0.0;
+   batch->tailsquares = 0.0;
+   batch->converged = FALSE;
+   batch->convergetime = 0.0;
+}
+
+
+void stat_batch_initialize(batch, batchsize, minbatches, target)
+statbatch *batch;
+int batchsize;
+int minbatches;
+double target;
+{
+   batch->batchsize = batchsize;
+   batch->minbatches = max(2, minbatches);
+   batch->target = target;
+   batch->samples = (double *) malloc(batchsize * sizeof(double));
+   ASSERT(batch->samples != NULL);
+   stat_batch_reset(batch);
+}
+
+
+int stat_batch_compare(a, b)
+const void *a;
+const void *b;
+{
+   double diff = *((double *) a) - *((double *) b);
+
+   return((diff < 0.0) ? -1 : ((diff > 0.0) ? 1 : 0));
+}
+
+
+/* Two-sided 95% Student t quantiles for 1..30 degrees of freedom */
+
+double stat_batch_tvalues[30] = {
+   12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+   2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+   2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+
+/* Returns the confidence interval half-width of the mean of the batch  */
+/* values whose sum and sum of squares are given.                       */
+
+double stat_batch_halfwidth(batches, sum, squares)
+int batches;
+double sum;
+double squares;
+{
+   double mean;
+   double var;
+   double t;
+
+   if (batches < 2) {
+      return(0.0);
+   }
+   mean = sum / (double) batches;
+   var = (squares - ((double) batches * mean * mean)) / (double) (batches - 1);
+   if (var < 0.0) {
+      var = 0.0;
+   }
+   t = (batches <= 30) ? stat_batch_tvalues[(batches-2)] : 1.960;
+   return(t * sqrt(var / (double) batches));
+}
+
+
+/* Adds a sample to the current batch.  When a batch fills, its mean and */
+/* BATCH_QUANTILE are folded into the running batch sums and convergence */
+/* is re-checked, so the cost of the check is paid once per batch.       */
+/* Returns TRUE once both half-widths are within the target fraction.   */
+
+int stat_batch_update(batch, value)
+statbatch *batch;
+double value;
+{
+   double mean;
+   double tail;
+
+   batch->samples[batch->count] = value;
+   batch->sum += value;
+   batch->count++;
+   if (batch->count < batch->batchsize) {
+      return(batch->converged);
+   }
+   qsort(batch->samples, batch->batchsize, sizeof(double), stat_batch_compare);
+   mean = batch->sum / (double) batch->batchsize;
+   tail = batch->samples[((int) ceil(BATCH_QUANTILE * (double) batch->batchsize) - 1)];
+   batch->batches++;
+   batch->meansum += mean;
+   batch->meansquares += mean * mean;
+   batch->tailsum += tail;
+   batch->tailsquares += tail * tail;
+   batch->count = 0;
+   batch->sum = 0.0;
+   if ((!batch->converged) && (batch->batches >= batch->minbatches)) {
+      mean = batch->meansum / (double) batch->batches;
+      tail = batch->tailsum / (double) batch->batches;
+      if ((stat_batch_halfwidth(batch->batches, batch->meansum, batch->meansquares) <= (batch->target * mean)) && (stat_batch_halfwidth(batch->batches, batch->tailsum, batch->tailsquares) <= (batch->target * tail))) {
+         batch->converged = TRUE;
+         batch->convergetime = simtime;
+      }
+   }
+   return(batch->converged);
 }
 
+
+void stat_batch_print(batch, identstr)
+statbatch *batch;
+char *identstr;
+{
+   double mean = 0.0;
+   double tail = 0.0;
+   double meanwidth;
+   double tailwidth;
+
+   if (batch->batches > 0) {
+      mean = batch->meansum / (double) batch->batches;
+      tail = batch->tailsum / (double) batch->batches;
+   }
+   meanwidth = stat_batch_halfwidth(batch->batches, batch->meansum, batch->meansquares);
+   tailwidth = stat_batch_halfwidth(batch->batches, batch->tailsum, batch->tailsquares);
+   fprintf(outputfile, "%sbatches:        \t%d (size %d, minimum %d)\n", identstr, batch->batches, batch->batchsize, batch->minbatches);
+   fprintf(outputfile, "%smean:           \t%f +/- %f (%.2f%%)\n", identstr, mean, meanwidth, ((mean > 0.0) ? (100.0 * meanwidth / mean) : 0.0));
+   fprintf(outputfile, "%s%g%% quantile:   \t%f +/- %f (%.2f%%)\n", identstr, (100.0 * BATCH_QUANTILE), tail, tailwidth, ((tail > 0.0) ? (100.0 * tailwidth / tail) : 0.0));
+   if (batch->converged) {
+      fprintf(outputfile, "%sconverged:      \t%f (target %.2f%%)\n", identstr, batch->convergetime, (100.0 * batch->target));
+   } else {
+      fprintf(outputfile, "%sconverged:      \tno (target %.2f%%)\n", identstr, (100.0 * batch->target));
+   }
+}
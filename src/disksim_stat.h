@@ -64,14 +64,41 @@ typedef struct {
    int     smalldistvals[DISTSIZE];
 } statgen;
 
+/* Batch-means confidence tracking, used to stop a run once a metric's  */
+/* mean and tail quantile are known to within a target relative width. */
+
+#define BATCH_QUANTILE	0.99
+
+typedef struct {
+   int     batchsize;
+   int     minbatches;
+   double  target;
+   int     count;
+   double  sum;
+   double *samples;
+   int     batches;
+   double  meansum;
+   double  meansquares;
+   double  tailsum;
+   double  tailsquares;
+   int     converged;
+   double  convergetime;
+} statbatch;
+
 extern void   stat_initialize();
 extern void   stat_reset();
 extern void   stat_update();
+extern int    stat_get_bucket();
+extern double stat_get_bucket_start();
 extern int    stat_get_count();
 extern double stat_get_runval();
 extern void   stat_print();
 extern void   stat_print_set();
 extern int    stat_get_count_set();
+extern void   stat_batch_initialize();
+extern void   stat_batch_reset();
+extern int    stat_batch_update();
+extern void   stat_batch_print();
 
 #endif DISKSIM_STAT_H
 
@@ -70,9 +70,9 @@ typedef struct gen {
    ioreq_event *  pendio;
    sleep_event *  limits;
    int            numdisks;
-   int            numblocks;
-   int            sectsperdisk;
-   int            blksperdisk;
+   lbn_t          numblocks;
+   lbn_t          sectsperdisk;
+   lbn_t          blksperdisk;
    int            blocksize;
    synthio_distr  tmlimit;
    synthio_distr  genintr;
@@ -199,6 +199,7 @@ ioreq_event *tmp;
    new->bcount = tmp->bcount * blocksize;
    new->flags = tmp->flags;
    new->cause = tmp->cause;
+   new->flow = gennum;
    new->opid = (synthio_endiocnt * gennum) + synthio_iocnt;
 	/* this is being considered "ok" under the assumption that opid will */
 	/* never exceed 2^32.....                                            */
@@ -300,9 +301,10 @@ process *procp;
    tmp->flags = 0;
    tmp->cause = gen->number;
    tmp->devno = (int) (drand48() * (double) gen->numdisks);
-   tmp->blkno = tmp->bcount = gen->blksperdisk;
+   tmp->blkno = gen->blksperdisk;
+   tmp->bcount = 0;
    while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || (tmp->bcount == 0)) {
-      tmp->blkno = (int) (drand48() * (double) gen->blksperdisk);
+      tmp->blkno = (lbn_t) (drand48() * (double) gen->blksperdisk);
       tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + gen->blocksize - 1) / gen->blocksize;
    }
    if (drand48() < gen->probread) {
@@ -327,7 +329,7 @@ synthio_generator *gen;
 {
    double type;
    double reqclass;
-   int blkno;
+   lbn_t blkno;
    ioreq_event *tmp;
 
    tmp = gen->pendio;
@@ -364,9 +366,10 @@ synthio_generator *gen;
       tmp->flags = 0;
       tmp->cause = gen->number;
       tmp->devno = (int) (drand48() * (double) gen->numdisks);
-      tmp->blkno = tmp->bcount = gen->blksperdisk;
+      tmp->blkno = gen->blksperdisk;
+      tmp->bcount = 0;
       while (((tmp->blkno + tmp->bcount) >= gen->blksperdisk) || (tmp->bcount <= 0)) {
-         tmp->blkno = (int) (drand48() * (double) gen->blksperdisk);
+         tmp->blkno = (lbn_t) (drand48() * (double) gen->blksperdisk);
          tmp->bcount = ((int) synthio_getrand(&gen->sizedist) + gen->blocksize - 1) / gen->blocksize;
       }
       if (drand48() < gen->probread) {
@@ -657,7 +660,7 @@ FILE *parfile;
    double probread;
    double probtmcrit;
    double probtmlim;
-   int sectsperdisk;
+   lbn_t sectsperdisk;
    int diskcnt;
    int numgens;
    int blocksize;
@@ -760,15 +763,15 @@ FILE *parfile;
       }
       fprintf (outputfile, "Generators with description: %d\n", descs);
 
-      if (fscanf(parfile, "Storage capacity per device (in blocks): %d\n", &sectsperdisk) != 1) {
+      if (fscanf(parfile, "Storage capacity per device (in blocks): %lld\n", &sectsperdisk) != 1) {
          fprintf(stderr, "Error reading 'storage capacity per device'\n");
          exit(0);
       }
       if (sectsperdisk <= 0) {
-         fprintf(stderr, "Invalid value for 'storage capacity per device' - %d\n", sectsperdisk);
+         fprintf(stderr, "Invalid value for 'storage capacity per device' - %lld\n", sectsperdisk);
          exit(0);
       }
-      fprintf (outputfile, "Storage capacity per device (in blocks): %d\n", sectsperdisk);
+      fprintf (outputfile, "Storage capacity per device (in blocks): %lld\n", sectsperdisk);
       gen->sectsperdisk = sectsperdisk;
    
       if (fscanf(parfile, "Number of storage devices: %d\n", &diskcnt) != 1) {
@@ -0,0 +1,226 @@
+
+/*
+ * DiskSim Storage Subsystem Simulation Environment
+ * Authors: Greg Ganger, Bruce Worthington, Yale Patt
+ *
+ * Copyright (C) 1993, 1995, 1997 The Regents of the University of Michigan 
+ *
+ * This software is being provided by the copyright holders under the
+ * following license. By obtaining, using and/or copying this software,
+ * you agree that you have read, understood, and will comply with the
+ * following terms and conditions:
+ *
+ * Permission to use, copy, modify, distribute, and sell this software
+ * and its documentation for any purpose and without fee or royalty is
+ * hereby granted, provided that the full text of this NOTICE appears on
+ * ALL copies of the software and documentation or portions thereof,
+ * including modifications, that you make.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS," AND COPYRIGHT HOLDERS MAKE NO
+ * REPRESENTATIONS OR WARRANTIES, EXPRESS OR IMPLIED. BY WAY OF EXAMPLE,
+ * BUT NOT LIMITATION, COPYRIGHT HOLDERS MAKE NO REPRESENTATIONS OR
+ * WARRANTIES OF MERCHANTABILITY OR FITNESS FOR ANY PARTICULAR PURPOSE OR
+ * THAT THE USE OF THE SOFTWARE OR DOCUMENTATION WILL NOT INFRINGE ANY
+ * THIRD PARTY PATENTS, COPYRIGHTS, TRADEMARKS OR OTHER RIGHTS. COPYRIGHT
+ * HOLDERS WILL BEAR NO LIABILITY FOR ANY USE OF THIS SOFTWARE OR
+ * DOCUMENTATION.
+ *
+ *  This software is provided AS IS, WITHOUT REPRESENTATION FROM THE
+ * UNIVERSITY OF MICHIGAN AS TO ITS FITNESS FOR ANY PURPOSE, AND
+ * WITHOUT WARRANTY BY THE UNIVERSITY OF MICHIGAN OF ANY KIND, EITHER
+ * EXPRESSED OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. THE REGENTS
+ * OF THE UNIVERSITY OF MICHIGAN SHALL NOT BE LIABLE FOR ANY DAMAGES,
+ * INCLUDING SPECIAL , INDIRECT, INCIDENTAL, OR CONSEQUENTIAL DAMAGES,
+ * WITH RESPECT TO ANY CLAIM ARISING OUT OF OR IN CONNECTION WITH THE
+ * USE OF OR IN CONNECTION WITH THE USE OF THE SOFTWARE, EVEN IF IT HAS
+ * BEEN OR IS HEREAFTER ADVISED OF THE POSSIBILITY OF SUCH DAMAGES
+ *
+ * The names and trademarks of copyright holders or authors may NOT be
+ * used in advertising or publicity pertaining to the software without
+ * specific, written prior permission. Title to copyright in this software
+ * and any associated documentation will at all times remain with copyright
+ * holders.
+ */
+
+/*
+ * Writes a timeline of simulated request activity in the Chrome Trace
+ * Event (JSON array) format, viewable with chrome://tracing or Perfetto.
+ * Only requests carrying a latency breakdown record (see disksim_iosim.h)
+ * can be sampled: every timeline_sample'th such request is traced, and
+ * only spans that overlap [timeline_start, timeline_end] are written.
+ * Once simulated time passes the end of the window the file is closed,
+ * so a windowed capture costs nothing for the rest of the run.  The
+ * array format does not require the closing bracket, so a capture cut
+ * short (e.g., by an external shutdown) still loads.
+ */
+
+#include "disksim_global.h"
+#include "disksim_iosim.h"
+#include "disksim_timeline.h"
+
+FILE *timelinefile = NULL;
+
+double timeline_start = 0.0;
+double timeline_end = -1.0;
+int timeline_sample = 1;
+
+int timeline_events = 0;
+char timeline_named[TIMELINE_KINDS][TIMELINE_MAXTRACKS];
+
+char *timeline_kindnames[TIMELINE_KINDS] = {
+   "Device driver",
+   "Controllers",
+   "Buses",
+   "Disks"
+};
+
+char *timeline_tracknames[TIMELINE_KINDS] = {
+   "Device",
+   "Controller",
+   "Bus",
+   "Disk"
+};
+
+
+void timeline_open(filename)
+char *filename;
+{
+   int i;
+
+   if (timelinefile) {
+      fclose(timelinefile);
+   }
+   if ((timelinefile = fopen(filename, "w")) == NULL) {
+      fprintf(stderr, "Timeline file %s cannot be opened for write access\n", filename);
+      exit(0);
+   }
+   fprintf(timelinefile, "[\n");
+   timeline_events = 0;
+   bzero((char *) timeline_named, sizeof(timeline_named));
+   for (i=0; i<TIMELINE_KINDS; i++) {
+      fprintf(timelinefile, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,\"args\":{\"name\":\"%s\"}}", ((timeline_events++) ? ",\n" : ""), (i+1), timeline_kindnames[i]);
+   }
+}
+
+
+void timeline_close()
+{
+   fprintf(timelinefile, "\n]\n");
+   fclose(timelinefile);
+   timelinefile = NULL;
+}
+
+
+void timeline_param_override(paramname, paramval)
+char *paramname;
+char *paramval;
+{
+   if (strcmp(paramname, "timeline") == 0) {
+      timeline_open(paramval);
+   } else if (strcmp(paramname, "timeline_start") == 0) {
+      if (sscanf(paramval, "%lf", &timeline_start) != 1) {
+         fprintf(stderr, "Error reading timeline_start in timeline_param_override\n");
+         exit(0);
+      }
+   } else if (strcmp(paramname, "timeline_end") == 0) {
+      if (sscanf(paramval, "%lf", &timeline_end) != 1) {
+         fprintf(stderr, "Error reading timeline_end in timeline_param_override\n");
+         exit(0);
+      }
+   } else if (strcmp(paramname, "timeline_sample") == 0) {
+      if ((sscanf(paramval, "%d", &timeline_sample) != 1) || (timeline_sample < 1)) {
+         fprintf(stderr, "Invalid value for timeline_sample in timeline_param_override: %s\n", paramval);
+         exit(0);
+      }
+   } else {
+      fprintf(stderr, "Upsupported IOSIM name at io_param_override: %s\n", paramname);
+      exit(0);
+   }
+}
+
+
+/* Returns the request id to label spans with, or 0 if the request is */
+/* not being traced.                                                  */
+
+int timeline_sampled(req)
+ioreq_event *req;
+{
+   reqtiming *timing;
+
+   if ((timelinefile == NULL) || (req == NULL) || ((timing = IO_TIMING(req)) == NULL)) {
+      return(0);
+   }
+   return((timing->reqid % timeline_sample) ? 0 : timing->reqid);
+}
+
+
+int timeline_in_window(start, end)
+double start;
+double end;
+{
+   if ((timeline_end >= 0.0) && (simtime > timeline_end)) {
+      timeline_close();
+      return(FALSE);
+   }
+   return((end >= timeline_start) && ((timeline_end < 0.0) || (start <= timeline_end)));
+}
+
+
+void timeline_name_track(kind, trackno)
+int kind;
+int trackno;
+{
+   if ((trackno < 0) || (trackno >= TIMELINE_MAXTRACKS) || (timeline_named[(kind-1)][trackno])) {
+      return;
+   }
+   timeline_named[(kind-1)][trackno] = TRUE;
+   fprintf(timelinefile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s #%d\"}}", kind, trackno, timeline_tracknames[(kind-1)], trackno);
+}
+
+
+/* A span that does not overlap others on its track (e.g., a disk's */
+/* mechanical activity or a bus tenure), in simulated milliseconds.  */
+
+void timeline_span(kind, trackno, name, start, end, reqid)
+int kind;
+int trackno;
+char *name;
+double start;
+double end;
+int reqid;
+{
+   if ((reqid == 0) || (!timeline_in_window(start, end))) {
+      return;
+   }
+   timeline_name_track(kind, trackno);
+   fprintf(timelinefile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"req\":%d}}", name, kind, trackno, (start * (double) 1000), ((end - start) * (double) 1000), reqid);
+}
+
+
+/* A span that may overlap others on its track (e.g., requests queued */
+/* at the same device), drawn as an async slice keyed by request id.  */
+
+void timeline_async(kind, trackno, name, start, end, reqid)
+int kind;
+int trackno;
+char *name;
+double start;
+double end;
+int reqid;
+{
+   if ((reqid == 0) || (!timeline_in_window(start, end))) {
+      return;
+   }
+   timeline_name_track(kind, trackno);
+   fprintf(timelinefile, ",\n{\"name\":\"%s\",\"cat\":\"req\",\"ph\":\"b\",\"id\":%d,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}", name, reqid, kind, trackno, (start * (double) 1000));
+   fprintf(timelinefile, ",\n{\"name\":\"%s\",\"cat\":\"req\",\"ph\":\"e\",\"id\":%d,\"pid\":%d,\"tid\":%d,\"ts\":%.3f}", name, reqid, kind, trackno, (end * (double) 1000));
+}
+
+
+void timeline_flush()
+{
+   if (timelinefile) {
+      fflush(timelinefile);
+   }
+}